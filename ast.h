@@ -0,0 +1,198 @@
+#ifndef AST_H_
+#define AST_H_
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "helper.h"
+
+// Tipos de nodos de expresión
+enum class ExprKind : char {
+    IntLit, BoolLit, CharLit, StringLit,
+    Var,        // identificador
+    Assign,     // args[0] = destino (Var o Index), args[1] = valor
+    Binary,     // args[0] op args[1]
+    Unary,      // op args[0]  ('-' o '!')
+    Postfix,    // args[0] op  ('++' o '--')
+    Call,       // name(args...)
+    Index       // args[0][args[1]]
+};
+
+// Tipos de nodos de sentencia
+enum class StmtKind : char {
+    VarDecl, Expr, If, For, While, Return, Print, Block
+};
+
+// Tipo semántico: tipo base y dimensiones (0 si no se conoce el tamaño)
+struct Type {
+    TokenKind base = TokenKind::KwVoid;
+    std::vector<int64_t> dims;
+
+    bool isArray() const { return !dims.empty(); }
+    bool isScalar(TokenKind kind) const { return base == kind && dims.empty(); }
+    bool operator==(const Type &other) const { return base == other.base && dims == other.dims; }
+    bool operator!=(const Type &other) const { return !(*this == other); }
+
+    std::string toString() const {
+        std::string text;
+        switch (base) {
+            case TokenKind::KwInteger: text = "int"; break;
+            case TokenKind::KwBoolean: text = "bool"; break;
+            case TokenKind::KwChar: text = "char"; break;
+            case TokenKind::KwString: text = "string"; break;
+            default: text = "void"; break;
+        }
+        for (int64_t d : dims) text += d > 0 ? "[" + std::to_string(d) + "]" : "[]";
+        return text;
+    }
+};
+
+struct Expr;
+struct Stmt;
+using ExprPtr = std::unique_ptr<Expr>;
+using StmtPtr = std::unique_ptr<Stmt>;
+
+// Tipo declarado: tipo base y dimensiones de arreglo (nullptr si es '[]')
+struct TypeSpec {
+    TokenKind base = TokenKind::KwVoid;
+    std::vector<ExprPtr> dims;
+
+    bool isArray() const { return !dims.empty(); }
+};
+
+// Nodo de expresión
+struct Expr {
+    ExprKind kind;
+    SourceLocation location;
+    TokenKind op = TokenKind::Unknown;  // operador de Binary/Unary/Postfix
+    int64_t intValue = 0;               // valor de IntLit/BoolLit/CharLit
+    std::string name;                   // Var/Call o texto de StringLit
+    std::vector<ExprPtr> args;          // operandos o argumentos
+    Type type;                          // tipo calculado por el análisis semántico
+    int symbol = -1;                    // variable (Var) o función (Call) resuelta
+
+    Expr(ExprKind kind, SourceLocation location) : kind(kind), location(location) {}
+
+    bool isLiteral() const {
+        return kind == ExprKind::IntLit || kind == ExprKind::BoolLit ||
+               kind == ExprKind::CharLit || kind == ExprKind::StringLit;
+    }
+};
+
+// Nodo de sentencia
+struct Stmt {
+    StmtKind kind;
+    SourceLocation location;
+
+    // VarDecl
+    TypeSpec declType;
+    std::string name;
+
+    // expr: valor inicial de VarDecl, expresión de Expr/Return, condición de If/While/For
+    ExprPtr expr;
+    ExprPtr step;                   // incremento del For
+    StmtPtr init;                   // inicialización del For
+    std::vector<ExprPtr> exprs;     // argumentos de Print
+    std::vector<StmtPtr> body;      // cuerpo de Block/If/For/While
+    std::vector<StmtPtr> elseBody;  // rama else (un If anidado para "else if")
+    int symbol = -1;                // variable declarada por VarDecl
+
+    Stmt(StmtKind kind, SourceLocation location) : kind(kind), location(location) {}
+};
+
+struct Param {
+    TypeSpec type;
+    std::string name;
+    SourceLocation location;
+    int symbol = -1;
+};
+
+struct Function {
+    TypeSpec returnType;
+    std::string name;
+    std::vector<Param> params;
+    std::vector<StmtPtr> body;
+    SourceLocation location;
+};
+
+// Variable resuelta por el análisis semántico
+struct Symbol {
+    std::string name;
+    Type type;
+    int function = -1;  // función dueña, -1 para globales
+    int index = 0;      // posición entre las globales o las variables de su función
+};
+
+// Programa completo: funciones y variables globales en orden de declaración
+struct Program {
+    std::vector<Function> functions;
+    std::vector<StmtPtr> globals;
+    std::vector<Symbol> symbols;  // tabla de variables (la llena el análisis semántico)
+};
+
+// Tipo de un literal
+inline Type literalType(ExprKind kind) {
+    Type t;
+    switch (kind) {
+        case ExprKind::BoolLit: t.base = TokenKind::KwBoolean; break;
+        case ExprKind::CharLit: t.base = TokenKind::KwChar; break;
+        case ExprKind::StringLit: t.base = TokenKind::KwString; break;
+        default: t.base = TokenKind::KwInteger; break;
+    }
+    return t;
+}
+
+// Funciones auxiliares para construir nodos
+inline ExprPtr makeExpr(ExprKind kind, SourceLocation location) {
+    return std::make_unique<Expr>(kind, location);
+}
+
+inline ExprPtr makeIntLit(SourceLocation location, int64_t value, ExprKind kind = ExprKind::IntLit) {
+    ExprPtr e = makeExpr(kind, location);
+    e->intValue = value;
+    return e;
+}
+
+inline StmtPtr makeStmt(StmtKind kind, SourceLocation location) {
+    return std::make_unique<Stmt>(kind, location);
+}
+
+// Decodificar un literal de carácter tal como lo entrega el lexer ("a" o "\n")
+inline int64_t decodeCharLiteral(const std::string &text) {
+    if (text.size() == 2 && text[0] == '\\') {
+        switch (text[1]) {
+            case 'n': return '\n';
+            case 't': return '\t';
+            case '0': return '\0';
+            default: return static_cast<unsigned char>(text[1]);
+        }
+    }
+    return text.empty() ? 0 : static_cast<unsigned char>(text[0]);
+}
+
+// ¿La expresión puede tener efectos secundarios? (asignaciones, ++/--, llamadas)
+inline bool hasSideEffects(const Expr &e) {
+    if (e.kind == ExprKind::Assign || e.kind == ExprKind::Postfix || e.kind == ExprKind::Call) {
+        return true;
+    }
+    for (const auto &arg : e.args) {
+        if (hasSideEffects(*arg)) return true;
+    }
+    return false;
+}
+
+// Partes de una concatenación de cadenas ("i: " + i + ", j: " + j da "i: ", i,
+// ", j: ", j) en el orden en que se evalúan; cualquier otra expresión es su
+// única parte. print escribe las partes una tras otra sin armar la cadena.
+inline void concatParts(const Expr &e, std::vector<const Expr *> &parts) {
+    if (e.kind == ExprKind::Binary && e.op == TokenKind::Addition && e.type.isScalar(TokenKind::KwString)) {
+        concatParts(*e.args[0], parts);
+        concatParts(*e.args[1], parts);
+        return;
+    }
+    parts.push_back(&e);
+}
+
+#endif // AST_H_
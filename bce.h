@@ -0,0 +1,330 @@
+#ifndef BCE_H_
+#define BCE_H_
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+#include "ir.h"
+#include "loops.h"
+
+// Estadísticas de la eliminación de verificaciones de límites
+struct BceStats {
+    unsigned int removedChecks = 0;     // demostradas dentro de rango
+    unsigned int hoistedChecks = 0;     // reemplazadas por una verificación a la entrada del bucle
+    unsigned int guardedLoops = 0;      // bucles con verificación de entrada
+};
+
+// Eliminación de verificaciones de límites por análisis de rangos.
+// Un bucle contado tiene una variable de inducción i = phi(inicio, i + paso),
+// paso > 0, y el encabezado sólo entra al cuerpo si i < N (o i <= N); dentro del
+// cuerpo i está en [inicio, N - 1]. Los rangos se propagan por sumas, restas,
+// productos y módulos con constantes, así que a[i][j] (aplanado como i * d1 + j)
+// también queda acotado. Una verificación con el índice dentro de [0, longitud)
+// se elimina; la longitud se conoce si el arreglo es local (newarray de tamaño
+// constante) o global (todas las escrituras de la global en $init son newarray
+// del mismo tamaño: los arreglos no pueden reasignarse).
+// Si N no es constante, el bucle for (i = 0; i < N; i++) que verifica a[i] en cada
+// vuelta fallaría exactamente en i = longitud. Cuando el bucle no tiene otra
+// salida, ni efectos observables (print, llamadas) ni otras operaciones que
+// puedan abortar, fallar antes es indistinguible: la verificación pasa a la
+// entrada como "si N > longitud, error con índice longitud" y el mensaje es el mismo.
+class BoundsCheckEliminator {
+    static const int kMaxDepth = 8;
+
+    struct Range {
+        bool known = false;
+        int64_t lo = 0, hi = 0;
+    };
+
+    struct CountedLoop {
+        const IrLoop *loop;
+        uint32_t phi;
+        uint32_t init;
+        int64_t step;
+        uint32_t bound;         // dentro del cuerpo phi <= bound + boundOffset
+        int64_t boundOffset;
+        uint32_t body;          // primer bloque del cuerpo
+    };
+
+    // Longitud de las verificaciones movidas: una constante conocida, arraylen de
+    // un arreglo de fuera del bucle (todavía no sacado por LICM) que se recalcula
+    // en el pre-encabezado, o un valor de fuera del bucle
+    struct HoistedLength {
+        int64_t constant = -1;
+        uint32_t array = kNoValue;
+        uint32_t value = kNoValue;
+
+        bool operator==(const HoistedLength &other) const {
+            return constant == other.constant && array == other.array && value == other.value;
+        }
+    };
+
+    struct Guard {
+        uint32_t preheader, header, bound;
+        HoistedLength length;
+    };
+
+    BceStats stats;
+    const IrFunction *fn = nullptr;
+    std::vector<int64_t> globalLengths;     // -1 si no se conoce
+    std::vector<CountedLoop> counted;
+    std::unordered_map<uint32_t, size_t> countedByPhi;
+
+    static Range known(int64_t lo, int64_t hi) {
+        Range r;
+        r.known = lo <= hi;
+        r.lo = lo;
+        r.hi = hi;
+        return r;
+    }
+
+    bool isConst(uint32_t v) const {
+        return v != kNoValue && fn->insts[v].op == IrOp::Const;
+    }
+
+    bool definedOutside(const IrLoop &loop, uint32_t v) const {
+        return !loop.contains[fn->blockOf(v)];
+    }
+
+    // Longitud conocida de un arreglo (o de una dimensión constante); -1 si no se conoce
+    int64_t lengthOf(uint32_t v) const {
+        const IrInst &inst = fn->insts[v];
+        if (inst.op == IrOp::Const) return inst.imm;
+        if (inst.op != IrOp::ArrayLen) return -1;
+        const IrInst &array = fn->insts[inst.a];
+        if (array.op == IrOp::NewArray && isConst(array.a)) return fn->insts[array.a].imm;
+        if (array.op == IrOp::LoadGlobal) return globalLengths[static_cast<size_t>(array.imm)];
+        return -1;
+    }
+
+    void findCountedLoop(const IrLoop &loop) {
+        const IrBlock &header = fn->blocks[loop.header];
+        if (loop.latch == kNoBlock || header.predCount != 2) return;
+        const IrInst &branch = fn->terminator(loop.header);
+        if (branch.op != IrOp::Branch || !loop.contains[branch.b] || loop.contains[branch.c]) return;
+
+        const IrInst &cond = fn->insts[branch.a];
+        uint32_t phi, bound;
+        int64_t offset;
+        switch (cond.op) {
+            case IrOp::Lt: phi = cond.a; bound = cond.b; offset = -1; break;
+            case IrOp::Le: phi = cond.a; bound = cond.b; offset = 0; break;
+            case IrOp::Gt: phi = cond.b; bound = cond.a; offset = -1; break;
+            case IrOp::Ge: phi = cond.b; bound = cond.a; offset = 0; break;
+            default: return;
+        }
+        const IrInst &p = fn->insts[phi];
+        if (p.op != IrOp::Phi || p.b != 2 || fn->blockOf(phi) != loop.header || !definedOutside(loop, bound)) return;
+        uint32_t pre = fn->predsOf(loop.header)[0] == loop.preheader ? 0 : 1;
+        uint32_t init = fn->operands[p.a + pre];
+        const IrInst &next = fn->insts[fn->operands[p.a + 1 - pre]];
+        int64_t step = 0;
+        if (next.op == IrOp::Add && next.a == phi && isConst(next.b)) step = fn->insts[next.b].imm;
+        else if (next.op == IrOp::Add && next.b == phi && isConst(next.a)) step = fn->insts[next.a].imm;
+        else if (next.op == IrOp::Sub && next.a == phi && isConst(next.b)) step = -fn->insts[next.b].imm;
+        if (step <= 0) return;
+
+        // Sin desborde: la última vuelta parte de bound + offset y suma step
+        if (isConst(bound)) {
+            int64_t hi = 0, after = 0;
+            if (__builtin_add_overflow(fn->insts[bound].imm, offset, &hi) || __builtin_add_overflow(hi, step, &after)) return;
+        } else if (step != 1 || offset != -1) {
+            return;
+        }
+        countedByPhi[phi] = counted.size();
+        counted.push_back({&loop, phi, init, step, bound, offset, branch.b});
+    }
+
+    Range rangeOf(uint32_t v, uint32_t block, int depth) const {
+        if (depth > kMaxDepth) return Range{};
+        const IrInst &inst = fn->insts[v];
+        switch (inst.op) {
+            case IrOp::Const:
+                return known(inst.imm, inst.imm);
+            case IrOp::Phi: {
+                auto found = countedByPhi.find(v);
+                if (found == countedByPhi.end()) return Range{};
+                const CountedLoop &c = counted[found->second];
+                if (!fn->dominates(c.body, block) || !isConst(c.init) || !isConst(c.bound)) return Range{};
+                return known(fn->insts[c.init].imm, fn->insts[c.bound].imm + c.boundOffset);
+            }
+            case IrOp::Add:
+            case IrOp::Sub:
+            case IrOp::Mul: {
+                Range a = rangeOf(inst.a, block, depth + 1);
+                Range b = a.known ? rangeOf(inst.b, block, depth + 1) : Range{};
+                if (!b.known) return Range{};
+                int64_t lo, hi;
+                if (inst.op == IrOp::Add) {
+                    if (__builtin_add_overflow(a.lo, b.lo, &lo) || __builtin_add_overflow(a.hi, b.hi, &hi)) return Range{};
+                    return known(lo, hi);
+                }
+                if (inst.op == IrOp::Sub) {
+                    if (__builtin_sub_overflow(a.lo, b.hi, &lo) || __builtin_sub_overflow(a.hi, b.lo, &hi)) return Range{};
+                    return known(lo, hi);
+                }
+                int64_t products[4];
+                if (__builtin_mul_overflow(a.lo, b.lo, &products[0]) || __builtin_mul_overflow(a.lo, b.hi, &products[1]) ||
+                    __builtin_mul_overflow(a.hi, b.lo, &products[2]) || __builtin_mul_overflow(a.hi, b.hi, &products[3])) {
+                    return Range{};
+                }
+                lo = hi = products[0];
+                for (int64_t x : products) {
+                    lo = x < lo ? x : lo;
+                    hi = x > hi ? x : hi;
+                }
+                return known(lo, hi);
+            }
+            case IrOp::Mod: {
+                if (!isConst(inst.b) || fn->insts[inst.b].imm <= 0) return Range{};
+                Range a = rangeOf(inst.a, block, depth + 1);
+                if (!a.known || a.lo < 0) return Range{};
+                int64_t limit = fn->insts[inst.b].imm - 1;
+                return known(0, a.hi < limit ? a.hi : limit);
+            }
+            default:
+                return Range{};
+        }
+    }
+
+    // ¿Puede la verificación fallar antes de un efecto observable o de otra salida?
+    bool isQuiet(const IrLoop &loop) const {
+        for (uint32_t b : loop.blocks) {
+            uint32_t succ[2];
+            uint32_t count = fn->successors(b, succ);
+            for (uint32_t k = 0; k < count; ++k) {
+                if (b != loop.header && !loop.contains[succ[k]]) return false;      // otra salida
+                if (succ[k] != loop.header && fn->dominates(succ[k], b)) return false;   // bucle interno
+            }
+            for (uint32_t i = fn->blocks[b].begin; i < fn->blocks[b].end; ++i) {
+                const IrInst &inst = fn->insts[i];
+                switch (inst.op) {
+                    case IrOp::Call: case IrOp::Print: case IrOp::PrintLn: case IrOp::Return:
+                        return false;
+                    case IrOp::Div: case IrOp::Mod:
+                        if (!isConst(inst.b) || fn->insts[inst.b].imm == 0) return false;
+                        break;
+                    default:
+                        break;
+                }
+            }
+        }
+        return true;
+    }
+
+    // Verificaciones a[i] del bucle for (i = 0; i < N; i++) con N no constante
+    void hoistChecks(const CountedLoop &c, std::vector<char> &removed, std::vector<Guard> &guards) {
+        const IrLoop &loop = *c.loop;
+        if (!isConst(c.init) || fn->insts[c.init].imm != 0 || c.step != 1 || c.boundOffset != -1 || isConst(c.bound)) return;
+        HoistedLength length;
+        std::vector<uint32_t> checks;
+        for (uint32_t b : loop.blocks) {
+            for (uint32_t i = fn->blocks[b].begin; i < fn->blocks[b].end; ++i) {
+                const IrInst &inst = fn->insts[i];
+                if (inst.op != IrOp::BoundsCheck || removed[i]) continue;
+                if (inst.a != c.phi) return;
+                HoistedLength checkLength;
+                checkLength.constant = lengthOf(inst.b);
+                if (checkLength.constant < 0) {
+                    const IrInst &len = fn->insts[inst.b];
+                    if (definedOutside(loop, inst.b)) checkLength.value = inst.b;
+                    else if (len.op == IrOp::ArrayLen && definedOutside(loop, len.a)) checkLength.array = len.a;
+                    else return;
+                }
+                if (!checks.empty() && !(checkLength == length)) return;
+                // Se ejecuta en todas las vueltas
+                if (!fn->dominates(c.body, b) || !fn->dominates(b, loop.latch)) return;
+                length = checkLength;
+                checks.push_back(i);
+            }
+        }
+        if (checks.empty() || !isQuiet(loop)) return;
+        for (uint32_t id : checks) removed[id] = 1;
+        stats.hoistedChecks += static_cast<unsigned int>(checks.size());
+        stats.guardedLoops++;
+        guards.push_back({loop.preheader, loop.header, c.bound, length});
+    }
+
+    // pre-encabezado: si N > longitud, bloque que falla con índice longitud;
+    // luego un bloque de entrada nuevo que pasa a ser el pre-encabezado
+    static void addGuard(IrEdit &edit, const Guard &g) {
+        uint32_t failure = edit.newBlock();
+        uint32_t entry = edit.newBlock();
+        edit.lists[g.preheader].pop_back();
+        uint32_t length = g.length.value;
+        if (g.length.constant >= 0) {
+            length = edit.append(g.preheader, makeIrConst(g.length.constant));
+        } else if (g.length.array != kNoValue) {
+            length = edit.append(g.preheader, makeIrInst(IrOp::ArrayLen, IrType::Int, g.length.array));
+        }
+        uint32_t cond = edit.append(g.preheader, makeIrInst(IrOp::Gt, IrType::Bool, g.bound, length));
+        edit.append(g.preheader, makeIrInst(IrOp::Branch, IrType::Void, cond, failure, entry));
+        edit.addEdge(g.preheader, failure);
+        edit.addEdge(g.preheader, entry);
+        edit.append(failure, makeIrInst(IrOp::BoundsCheck, IrType::Void, length, length));
+        edit.append(failure, makeIrInst(IrOp::Jump, IrType::Void, entry));
+        edit.addEdge(failure, entry);
+        edit.append(entry, makeIrInst(IrOp::Jump, IrType::Void, g.header));
+        for (uint32_t &p : edit.preds[g.header]) if (p == g.preheader) p = entry;
+    }
+
+    void runFunction(IrFunction &function) {
+        if (function.blocks.empty()) return;
+        fn = &function;
+        std::vector<IrLoop> loops = findLoops(function);
+        counted.clear();
+        countedByPhi.clear();
+        for (const IrLoop &loop : loops) findCountedLoop(loop);
+
+        std::vector<char> removed(function.insts.size(), 0);
+        bool changed = false;
+        for (uint32_t b = 0; b < function.blocks.size(); ++b) {
+            for (uint32_t i = function.blocks[b].begin; i < function.blocks[b].end; ++i) {
+                const IrInst &inst = function.insts[i];
+                if (inst.op != IrOp::BoundsCheck) continue;
+                int64_t length = lengthOf(inst.b);
+                if (length < 0) continue;
+                Range r = rangeOf(inst.a, b, 0);
+                if (r.known && r.lo >= 0 && r.hi < length) {
+                    removed[i] = 1;
+                    stats.removedChecks++;
+                    changed = true;
+                }
+            }
+        }
+        std::vector<Guard> guards;
+        for (const CountedLoop &c : counted) hoistChecks(c, removed, guards);
+        if (!changed && guards.empty()) return;
+
+        IrEdit edit(function);
+        for (uint32_t i = 0; i < removed.size(); ++i) if (removed[i]) edit.pool[i].op = IrOp::Nop;
+        for (const Guard &g : guards) addGuard(edit, g);
+        edit.commit(function);
+        fn = nullptr;
+    }
+
+public:
+    BceStats run(IrModule &module) {
+        stats = BceStats{};
+        // Longitud de cada global de tipo arreglo según sus escrituras
+        const int64_t unset = -2;
+        globalLengths.assign(module.globals.size(), unset);
+        for (const IrFunction &function : module.functions) {
+            for (const IrInst &inst : function.insts) {
+                if (inst.op != IrOp::StoreGlobal || module.globals[static_cast<size_t>(inst.imm)].type != IrType::Array) continue;
+                int64_t &length = globalLengths[static_cast<size_t>(inst.imm)];
+                const IrInst &value = function.insts[inst.a];
+                int64_t stored = value.op == IrOp::NewArray && function.insts[value.a].op == IrOp::Const
+                    ? function.insts[value.a].imm : -1;
+                length = length == unset || length == stored ? stored : -1;
+            }
+        }
+        for (int64_t &length : globalLengths) if (length == unset) length = -1;
+
+        for (auto &function : module.functions) runFunction(function);
+        return stats;
+    }
+};
+
+#endif // BCE_H_
@@ -0,0 +1,402 @@
+#ifndef BENCHSUITE_H_
+#define BENCHSUITE_H_
+
+#include <algorithm>
+#include <chrono>
+#include <cctype>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <map>
+#include <ostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "cache.h"
+
+// Piezas de --bench-suite: el corpus (archivos de ejemplo y programas generados),
+// las estadísticas de las corridas y la referencia guardada en JSON con la que se
+// comparan.
+
+// Opciones de --bench-suite
+struct BenchSuiteOptions {
+    std::string baselinePath = "bench_baseline.json";
+    unsigned int runs = 21;      // muestras por programa
+    unsigned int warmup = 3;     // corridas descartadas antes de medir
+    double thresholdPct = -1;    // --bench-threshold; negativo: el de la referencia
+    bool update = false;         // escribir los resultados como nueva referencia
+};
+
+// Archivos de ejemplo del repositorio que forman parte del corpus
+static const char *const kBenchSuiteFiles[] = {"PRUEBA_COMPLETA.txt", "ARCHIVO_PRUEBA1_PARSERNUEVO.txt",
+                                               "ARCHIVO_PRUEBA2_PARSERNUEVO.txt", "PRUEBA_CON_FALLO.txt"};
+
+// Entradas lentas que encontró fuzz.cpp, ya reducidas y repetidas: también son
+// parte del corpus, para que la lentitud que revelaron no vuelva
+static const char *const kBenchRegressionsDir = "bench_regressions";
+
+// Umbral de regresión por omisión: la mediana puede ser hasta un 15% más lenta
+static const double kBenchDefaultThresholdPct = 15;
+
+// Mediana y percentiles de las muestras de un programa, en milisegundos
+struct BenchStats {
+    double minMs = 0;
+    double medianMs = 0;
+    double p90Ms = 0;
+    double p99Ms = 0;
+};
+
+// Percentiles por rango más cercano: con 21 muestras, p90 es la 19.ª
+inline BenchStats computeBenchStats(std::vector<double> samples) {
+    BenchStats stats;
+    if (samples.empty()) return stats;
+    std::sort(samples.begin(), samples.end());
+    auto percentile = [&](double p) {
+        size_t rank = static_cast<size_t>(p / 100.0 * static_cast<double>(samples.size()) + 0.999999);
+        return samples[std::min(samples.size(), std::max<size_t>(rank, 1)) - 1];
+    };
+    stats.minMs = samples.front();
+    stats.medianMs = percentile(50);
+    stats.p90Ms = percentile(90);
+    stats.p99Ms = percentile(99);
+    return stats;
+}
+
+// Trabajo fijo, ajeno al compilador (hash de un bloque de memoria e inserciones en
+// un árbol), para comparar la velocidad de esta máquina con la de la referencia.
+// La primera corrida no se mide (páginas nuevas del bloque y del árbol) y se toma
+// el mínimo de las demás: es la medida que menos cambia entre corridas.
+inline double benchCalibrationMs() {
+    static const size_t kBlock = 1 << 22;
+    static const uint64_t kKeys = 100000;
+    std::string block(kBlock, '\0');
+    for (size_t i = 0; i < kBlock; ++i) block[i] = static_cast<char>(i * 2654435761u >> 13);
+    std::vector<double> samples;
+    for (int run = 0; run < 10; ++run) {
+        auto start = std::chrono::steady_clock::now();
+        uint64_t hash = Xxh64::hash(block.data(), block.size(), static_cast<uint64_t>(run));
+        std::map<uint64_t, uint64_t> tree;
+        for (uint64_t k = 0; k < kKeys; ++k) tree[hash ^ (k * 0x9E3779B97F4A7C15ull)] = k;
+        volatile uint64_t sink = tree.begin()->second;
+        (void)sink;
+        if (run) samples.push_back(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+    }
+    return computeBenchStats(samples).minMs;
+}
+
+// Número con una cantidad fija de decimales, para los mensajes
+inline std::string fixedDecimals(double value, int digits) {
+    char text[64];
+    std::snprintf(text, sizeof(text), "%.*f", digits, value);
+    return text;
+}
+
+// Programas grandes generados para el corpus. La semilla es fija y sólo se usa la
+// salida cruda de mt19937 (que el estándar define), así que el texto es el mismo
+// en cualquier máquina.
+class BenchProgramGenerator {
+    std::mt19937 random;
+
+    unsigned int pick(unsigned int n) {
+        return static_cast<unsigned int>(random() % n);
+    }
+
+    // Expresión entera de terms términos sobre las variables dadas
+    std::string intExpr(const std::vector<std::string> &vars, unsigned int terms) {
+        static const char *const ops[] = {" + ", " - ", " * ", " / ", " % "};
+        std::string expr;
+        unsigned int open = 0;
+        for (unsigned int t = 0; t < terms; ++t) {
+            if (t) expr += ops[pick(5)];
+            if (t + 2 < terms && pick(4) == 0) {
+                expr += '(';
+                open++;
+            }
+            if (pick(3) == 0) expr += std::to_string(pick(97) + 1);
+            else expr += vars[pick(static_cast<unsigned int>(vars.size()))];
+            if (open && pick(3) == 0) {
+                expr += ')';
+                open--;
+            }
+        }
+        return expr + std::string(open, ')');
+    }
+
+    std::string condition(const std::vector<std::string> &vars) {
+        static const char *const rel[] = {" < ", " <= ", " > ", " >= ", " == ", " != "};
+        // Un paso por sentencia: el orden de evaluación de los operandos de + no está definido
+        std::string cond = intExpr(vars, 2);
+        cond += rel[pick(6)];
+        cond += intExpr(vars, 2);
+        if (pick(2)) {
+            cond += pick(2) ? " && " : " || ";
+            cond += intExpr(vars, 1);
+            cond += rel[pick(6)];
+            cond += std::to_string(pick(50));
+        }
+        return cond;
+    }
+
+public:
+    explicit BenchProgramGenerator(uint32_t seed) : random(seed) {}
+
+    // Muchas funciones con bucles, condicionales y llamadas a las anteriores
+    std::string functions(unsigned int count) {
+        std::ostringstream out;
+        out << "int tabla[64];\n";
+        for (unsigned int f = 0; f < count; ++f) {
+            std::vector<std::string> vars{"a", "b", "x", "y"};
+            out << "function int f" << f << "(int a, int b) {\n";
+            out << "    int x = " << intExpr({"a", "b"}, 3) << ";\n";
+            out << "    int y = " << intExpr({"a", "b", "x"}, 4) << ";\n";
+            out << "    for (int i = 0; i < " << pick(20) + 2 << "; i++) {\n";
+            vars.push_back("i");
+            out << "        if (" << condition(vars) << ") {\n";
+            if (f > 0) out << "            x = x + f" << pick(f) << "(i, y % 7);\n";
+            else out << "            x = x + i;\n";
+            out << "        } else {\n";
+            out << "            y = " << intExpr(vars, 3) << ";\n";
+            out << "        }\n";
+            out << "        tabla[i % 64] = tabla[i % 64] + x;\n";
+            out << "    }\n";
+            out << "    while (y > " << pick(10) << ") {\n";
+            out << "        y = y - " << pick(5) + 1 << ";\n";
+            out << "    }\n";
+            out << "    return x + y;\n";
+            out << "}\n";
+        }
+        out << "function void main() {\n";
+        out << "    int total = 0;\n";
+        for (unsigned int f = 0; f < count; f += 7) out << "    total = total + f" << f << "(" << f << ", 3);\n";
+        out << "    print(total);\n";
+        out << "}\n";
+        return out.str();
+    }
+
+    // Funciones con expresiones largas: el peso está en la cascada de reglas de
+    // expresión del parser y en el plegado
+    std::string expressions(unsigned int count) {
+        std::ostringstream out;
+        for (unsigned int f = 0; f < count; ++f) {
+            std::vector<std::string> vars{"p", "q"};
+            out << "function int e" << f << "(int p, int q) {\n";
+            for (unsigned int s = 0; s < 8; ++s) {
+                std::string name = "v" + std::to_string(s);
+                out << "    int " << name << " = " << intExpr(vars, 12 + pick(8)) << ";\n";
+                vars.push_back(name);
+            }
+            out << "    bool listo = " << condition(vars) << ";\n";
+            out << "    if (listo) {\n";
+            out << "        return " << intExpr(vars, 6) << ";\n";
+            out << "    }\n";
+            out << "    return " << intExpr(vars, 10) << ";\n";
+            out << "}\n";
+        }
+        out << "function void main() {\n";
+        out << "    int total = 0;\n";
+        for (unsigned int f = 0; f < count; f += 5) out << "    total = total + e" << f << "(" << f + 1 << ", 2);\n";
+        out << "    print(total);\n";
+        out << "}\n";
+        return out.str();
+    }
+
+    // Declaraciones con un error de sintaxis cada tres: mide la recuperación por
+    // pánico y los mensajes de error
+    std::string syntaxErrors(unsigned int count) {
+        std::ostringstream out;
+        for (unsigned int d = 0; d < count; ++d) {
+            std::vector<std::string> vars{"n"};
+            bool broken = d % 3 == 0;
+            out << "function int g" << d << "(int n) {\n";
+            out << "    int r = " << intExpr(vars, 5) << (broken && pick(2) ? "\n" : ";\n");
+            vars.push_back("r");
+            out << "    if (" << condition(vars) << (broken && pick(2) ? " {\n" : ") {\n");
+            out << "        r = " << intExpr(vars, 4) << ";\n";
+            out << "    }\n";
+            out << "    return r;\n";
+            out << "}\n";
+        }
+        return out.str();
+    }
+};
+
+// Programas generados del corpus: nombre y texto
+inline std::vector<std::pair<std::string, std::string>> generatedBenchPrograms() {
+    BenchProgramGenerator generator(20240611);
+    std::vector<std::pair<std::string, std::string>> programs;
+    programs.emplace_back("generado: funciones", generator.functions(1500));
+    programs.emplace_back("generado: expresiones", generator.expressions(600));
+    programs.emplace_back("generado: errores", generator.syntaxErrors(1500));
+    return programs;
+}
+
+// Valor JSON, lo justo para leer la referencia de --bench-suite
+struct JsonValue {
+    enum class Kind { Null, Bool, Number, String, Array, Object };
+    Kind kind = Kind::Null;
+    bool boolean = false;
+    double number = 0;
+    std::string string;
+    std::vector<JsonValue> items;
+    std::vector<std::pair<std::string, JsonValue>> members;
+
+    // Miembro del objeto, o nullptr si no está
+    const JsonValue *get(const std::string &key) const {
+        for (const auto &member : members) {
+            if (member.first == key) return &member.second;
+        }
+        return nullptr;
+    }
+
+    double numberOr(const std::string &key, double fallback) const {
+        const JsonValue *value = get(key);
+        return value && value->kind == Kind::Number ? value->number : fallback;
+    }
+};
+
+// Analizador descendente recursivo de JSON; false si el texto no es válido
+class JsonReader {
+    const std::string &text;
+    size_t pos = 0;
+
+    void skipSpace() {
+        while (pos < text.size() && std::isspace(static_cast<unsigned char>(text[pos]))) pos++;
+    }
+
+    bool literal(const char *word) {
+        size_t length = std::char_traits<char>::length(word);
+        if (text.compare(pos, length, word) != 0) return false;
+        pos += length;
+        return true;
+    }
+
+    bool readString(std::string &out) {
+        if (text[pos] != '"') return false;
+        for (pos++; pos < text.size(); pos++) {
+            char c = text[pos];
+            if (c == '"') {
+                pos++;
+                return true;
+            }
+            if (c == '\\') {
+                if (++pos == text.size()) return false;
+                switch (text[pos]) {
+                    case 'n': c = '\n'; break;
+                    case 't': c = '\t'; break;
+                    case 'r': c = '\r'; break;
+                    case 'b': c = '\b'; break;
+                    case 'f': c = '\f'; break;
+                    case 'u': return false;  // la referencia no usa escapes Unicode
+                    default: c = text[pos];
+                }
+            }
+            out += c;
+        }
+        return false;
+    }
+
+    bool readValue(JsonValue &value, int depth) {
+        static const int kMaxDepth = 64;
+        skipSpace();
+        if (pos == text.size() || depth > kMaxDepth) return false;
+        char c = text[pos];
+        if (c == '{') {
+            value.kind = JsonValue::Kind::Object;
+            pos++;
+            skipSpace();
+            if (pos < text.size() && text[pos] == '}') return ++pos, true;
+            while (true) {
+                skipSpace();
+                std::pair<std::string, JsonValue> member;
+                if (pos == text.size() || !readString(member.first)) return false;
+                skipSpace();
+                if (pos == text.size() || text[pos++] != ':') return false;
+                if (!readValue(member.second, depth + 1)) return false;
+                value.members.push_back(std::move(member));
+                skipSpace();
+                if (pos == text.size()) return false;
+                if (text[pos] == '}') return ++pos, true;
+                if (text[pos++] != ',') return false;
+            }
+        }
+        if (c == '[') {
+            value.kind = JsonValue::Kind::Array;
+            pos++;
+            skipSpace();
+            if (pos < text.size() && text[pos] == ']') return ++pos, true;
+            while (true) {
+                value.items.emplace_back();
+                if (!readValue(value.items.back(), depth + 1)) return false;
+                skipSpace();
+                if (pos == text.size()) return false;
+                if (text[pos] == ']') return ++pos, true;
+                if (text[pos++] != ',') return false;
+            }
+        }
+        if (c == '"') {
+            value.kind = JsonValue::Kind::String;
+            return readString(value.string);
+        }
+        if (literal("true")) {
+            value.kind = JsonValue::Kind::Bool;
+            value.boolean = true;
+            return true;
+        }
+        if (literal("false")) {
+            value.kind = JsonValue::Kind::Bool;
+            return true;
+        }
+        if (literal("null")) return true;
+        const char *start = text.c_str() + pos;
+        char *end = nullptr;
+        value.number = std::strtod(start, &end);
+        if (end == start) return false;
+        value.kind = JsonValue::Kind::Number;
+        pos += static_cast<size_t>(end - start);
+        return true;
+    }
+
+public:
+    explicit JsonReader(const std::string &text) : text(text) {}
+
+    bool read(JsonValue &value) {
+        if (!readValue(value, 0)) return false;
+        skipSpace();
+        return pos == text.size();
+    }
+};
+
+// Resultado de un programa del corpus
+struct BenchResult {
+    std::string name;
+    size_t bytes = 0;
+    unsigned int repeat = 1;  // compilaciones por muestra (las cortas se repiten)
+    BenchStats stats;
+};
+
+// La referencia en el formato que lee --bench-suite. Los umbrales propios de
+// cada programa que tuviera la referencia anterior se conservan.
+inline void writeBenchBaseline(std::ostream &out, const std::vector<BenchResult> &results, double calibrationMs,
+                               double thresholdPct, const JsonValue *previous) {
+    out << "{\n  \"calibration_ms\": " << calibrationMs << ",\n  \"threshold_pct\": " << thresholdPct
+        << ",\n  \"benchmarks\": [\n";
+    const JsonValue *oldBenchmarks = previous ? previous->get("benchmarks") : nullptr;
+    for (size_t i = 0; i < results.size(); ++i) {
+        const BenchResult &result = results[i];
+        out << "    {\"name\": \"" << result.name << "\", \"median_ms\": " << result.stats.medianMs
+            << ", \"p90_ms\": " << result.stats.p90Ms << ", \"p99_ms\": " << result.stats.p99Ms;
+        for (size_t b = 0; oldBenchmarks && b < oldBenchmarks->items.size(); ++b) {
+            const JsonValue &old = oldBenchmarks->items[b];
+            const JsonValue *name = old.get("name");
+            const JsonValue *threshold = old.get("threshold_pct");
+            if (name && name->string == result.name && threshold) out << ", \"threshold_pct\": " << threshold->number;
+        }
+        out << "}" << (i + 1 < results.size() ? "," : "") << "\n";
+    }
+    out << "  ]\n}\n";
+}
+
+#endif // BENCHSUITE_H_
@@ -0,0 +1,482 @@
+#ifndef CACHE_H_
+#define CACHE_H_
+
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <type_traits>
+#include <vector>
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "vm.h"
+
+// Caché de compilaciones en disco (--cache-dir). Cada entrada es un archivo cuyo
+// nombre es el hash del texto fuente, del ejecutable del compilador y de las
+// opciones que cambian el resultado, así que nunca hay que invalidar nada: un
+// cambio en cualquiera de ellos da otra clave. La entrada guarda la salida
+// (tokens, traza, INFO salvo los tiempos, IR, ensamblador o C, según las
+// opciones), los errores, el bytecode y el ejecutable de --native/--native-c. Un
+// acierto cuesta el hash y un mmap.
+
+// XXH64 (xxHash de 64 bits), de https://github.com/Cyan4973/xxHash
+class Xxh64 {
+    static const uint64_t kPrime1 = 11400714785074694791ULL;
+    static const uint64_t kPrime2 = 14029467366897019727ULL;
+    static const uint64_t kPrime3 = 1609587929392839161ULL;
+    static const uint64_t kPrime4 = 9650029242287828579ULL;
+    static const uint64_t kPrime5 = 2870177450012600261ULL;
+
+    static uint64_t rotl(uint64_t x, int r) {
+        return (x << r) | (x >> (64 - r));
+    }
+
+    static uint64_t read64(const unsigned char *p) {
+        uint64_t v;
+        std::memcpy(&v, p, sizeof(v));
+        return v;
+    }
+
+    static uint32_t read32(const unsigned char *p) {
+        uint32_t v;
+        std::memcpy(&v, p, sizeof(v));
+        return v;
+    }
+
+    static uint64_t round(uint64_t acc, uint64_t input) {
+        acc += input * kPrime2;
+        acc = rotl(acc, 31);
+        return acc * kPrime1;
+    }
+
+    static uint64_t mergeRound(uint64_t acc, uint64_t value) {
+        acc ^= round(0, value);
+        return acc * kPrime1 + kPrime4;
+    }
+
+public:
+    static uint64_t hash(const void *data, size_t length, uint64_t seed = 0) {
+        const unsigned char *p = static_cast<const unsigned char *>(data);
+        const unsigned char *end = p + length;
+        uint64_t h;
+        if (length >= 32) {
+            uint64_t v1 = seed + kPrime1 + kPrime2, v2 = seed + kPrime2, v3 = seed, v4 = seed - kPrime1;
+            for (const unsigned char *limit = end - 32; p <= limit; p += 32) {
+                v1 = round(v1, read64(p));
+                v2 = round(v2, read64(p + 8));
+                v3 = round(v3, read64(p + 16));
+                v4 = round(v4, read64(p + 24));
+            }
+            h = rotl(v1, 1) + rotl(v2, 7) + rotl(v3, 12) + rotl(v4, 18);
+            h = mergeRound(h, v1);
+            h = mergeRound(h, v2);
+            h = mergeRound(h, v3);
+            h = mergeRound(h, v4);
+        } else {
+            h = seed + kPrime5;
+        }
+        h += static_cast<uint64_t>(length);
+        for (; p + 8 <= end; p += 8) {
+            h ^= round(0, read64(p));
+            h = rotl(h, 27) * kPrime1 + kPrime4;
+        }
+        if (p + 4 <= end) {
+            h ^= static_cast<uint64_t>(read32(p)) * kPrime1;
+            h = rotl(h, 23) * kPrime2 + kPrime3;
+            p += 4;
+        }
+        for (; p < end; ++p) {
+            h ^= *p * kPrime5;
+            h = rotl(h, 11) * kPrime1;
+        }
+        h ^= h >> 33;
+        h *= kPrime2;
+        h ^= h >> 29;
+        h *= kPrime3;
+        h ^= h >> 32;
+        return h;
+    }
+};
+
+// Identidad del compilador en las claves: el hash de su propio ejecutable
+// (/proc/self/exe). Cada build, con cualquier cambio en las pasadas o en el
+// formato de las entradas, empieza con claves nuevas. Vacía si no se puede leer.
+inline const std::string &compilerIdentity() {
+    static const std::string identity = [] {
+        std::string result;
+        int fd = ::open("/proc/self/exe", O_RDONLY | O_CLOEXEC);
+        if (fd < 0) return result;
+        struct stat info;
+        if (fstat(fd, &info) == 0 && info.st_size > 0) {
+            size_t size = static_cast<size_t>(info.st_size);
+            void *data = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (data != MAP_FAILED) {
+                result = std::to_string(Xxh64::hash(data, size)) + '-' + std::to_string(size);
+                munmap(data, size);
+            }
+        }
+        close(fd);
+        return result;
+    }();
+    return identity;
+}
+
+// Serialización en binario (en el orden de bytes del host: la caché es local)
+class ByteWriter {
+    std::string data;
+
+public:
+    template <typename T>
+    void put(const T &value) {
+        static_assert(std::is_trivially_copyable<T>::value, "sólo tipos que se copian byte a byte");
+        data.append(reinterpret_cast<const char *>(&value), sizeof(T));
+    }
+
+    void putString(std::string_view s) {
+        put(static_cast<uint64_t>(s.size()));
+        data.append(s.data(), s.size());
+    }
+
+    template <typename T>
+    void putVector(const std::vector<T> &v) {
+        static_assert(std::is_trivially_copyable<T>::value, "sólo tipos que se copian byte a byte");
+        put(static_cast<uint64_t>(v.size()));
+        data.append(reinterpret_cast<const char *>(v.data()), v.size() * sizeof(T));
+    }
+
+    std::string &str() {
+        return data;
+    }
+};
+
+// Lectura de lo escrito por ByteWriter; ok() es false si los datos no alcanzan
+class ByteReader {
+    const char *p;
+    const char *end;
+    bool valid = true;
+
+    bool take(size_t n) {
+        valid = valid && static_cast<size_t>(end - p) >= n;
+        return valid;
+    }
+
+public:
+    explicit ByteReader(std::string_view data) : p(data.data()), end(data.data() + data.size()) {}
+
+    template <typename T>
+    T get() {
+        T value{};
+        if (!take(sizeof(T))) return value;
+        std::memcpy(&value, p, sizeof(T));
+        p += sizeof(T);
+        return value;
+    }
+
+    std::string_view getView() {
+        uint64_t size = get<uint64_t>();
+        if (!take(size)) return {};
+        std::string_view view(p, size);
+        p += size;
+        return view;
+    }
+
+    template <typename T>
+    void getVector(std::vector<T> &v) {
+        uint64_t size = get<uint64_t>();
+        if (size > static_cast<size_t>(end - p) / sizeof(T) || !take(size * sizeof(T))) {
+            valid = false;
+            return;
+        }
+        v.resize(size);
+        std::memcpy(v.data(), p, size * sizeof(T));
+        p += size * sizeof(T);
+    }
+
+    bool ok() const {
+        return valid && p == end;
+    }
+};
+
+inline std::string serializeBytecode(const BcModule &module) {
+    ByteWriter out;
+    out.put(static_cast<uint64_t>(module.functions.size()));
+    for (const BcFunction &fn : module.functions) {
+        out.putString(fn.name);
+        out.putVector(fn.code);
+        out.putVector(fn.constants);
+        out.put(fn.numParams);
+        out.put(fn.frameSize);
+        out.put(fn.stackNeed);
+        out.put(fn.returnsValue);
+        out.putVector(fn.valueRegs);
+        out.putVector(fn.blockStart);
+    }
+    out.put(static_cast<uint64_t>(module.strings.size()));
+    for (const std::string &s : module.strings) out.putString(s);
+    out.putVector(module.globals);
+    out.put(module.initFunction);
+    out.put(module.mainFunction);
+    return std::move(out.str());
+}
+
+inline bool deserializeBytecode(std::string_view data, BcModule &module) {
+    ByteReader in(data);
+    module = BcModule{};
+    uint64_t functions = in.get<uint64_t>();
+    if (functions > data.size()) return false;
+    module.functions.resize(functions);
+    for (BcFunction &fn : module.functions) {
+        fn.name = std::string(in.getView());
+        in.getVector(fn.code);
+        in.getVector(fn.constants);
+        fn.numParams = in.get<uint32_t>();
+        fn.frameSize = in.get<uint32_t>();
+        fn.stackNeed = in.get<uint32_t>();
+        fn.returnsValue = in.get<bool>();
+        in.getVector(fn.valueRegs);
+        in.getVector(fn.blockStart);
+    }
+    uint64_t strings = in.get<uint64_t>();
+    if (strings > data.size()) return false;
+    module.strings.reserve(strings);
+    for (uint64_t i = 0; i < strings; ++i) module.strings.emplace_back(in.getView());
+    in.getVector(module.globals);
+    module.initFunction = in.get<int>();
+    module.mainFunction = in.get<int>();
+    return in.ok();
+}
+
+// Lo que se guarda de una compilación
+struct CacheRecord {
+    bool ok = false;
+    std::string out, err;
+    std::string bytecode;    // serializeBytecode, si se pidió --run
+    std::string executable;  // el binario de --native/--native-c
+};
+
+// Una entrada leída de la caché: vistas sobre el archivo proyectado en memoria
+class CacheEntry {
+    void *mapping = MAP_FAILED;
+    size_t mappedSize = 0;
+
+public:
+    bool ok = false;
+    std::string_view out, err, bytecode, executable;
+
+    CacheEntry() = default;
+    CacheEntry(const CacheEntry &) = delete;
+    CacheEntry &operator=(const CacheEntry &) = delete;
+    ~CacheEntry() {
+        if (mapping != MAP_FAILED) munmap(mapping, mappedSize);
+    }
+
+    bool map(const std::string &path) {
+        int fd = open(path.c_str(), O_RDONLY);
+        if (fd < 0) return false;
+        struct stat info;
+        if (fstat(fd, &info) != 0 || info.st_size <= 0) {
+            close(fd);
+            return false;
+        }
+        mappedSize = static_cast<size_t>(info.st_size);
+        mapping = mmap(nullptr, mappedSize, PROT_READ, MAP_PRIVATE, fd, 0);
+        close(fd);
+        if (mapping == MAP_FAILED) return false;
+
+        ByteReader in(std::string_view(static_cast<const char *>(mapping), mappedSize));
+        if (in.get<uint32_t>() != kMagic) return false;
+        ok = in.get<uint32_t>() != 0;
+        out = in.getView();
+        err = in.getView();
+        bytecode = in.getView();
+        executable = in.getView();
+        return in.ok();
+    }
+
+    static constexpr uint32_t kMagic = 0x31434d42;  // "BMC1"
+};
+
+// Totales de aciertos y fallos, acumulados entre ejecuciones en el archivo "stats"
+struct CacheStats {
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+    uint64_t entries = 0;
+    uint64_t bytes = 0;
+};
+
+class CompileCache {
+    std::string dir;
+    uint64_t maxBytes;
+    std::atomic<uint64_t> hits{0}, misses{0};
+    std::atomic<uint64_t> tempCounter{0};
+
+    std::string entryPath(const std::string &key) const {
+        return dir + "/" + key;
+    }
+
+    static bool isEntryName(const char *name) {
+        size_t length = std::strlen(name);
+        return length == 32 && std::all_of(name, name + length, [](char c) { return std::isxdigit(static_cast<unsigned char>(c)); });
+    }
+
+    // Escribe a un archivo temporal del mismo directorio y lo renombra: quien lee
+    // ve la entrada completa o ninguna, aunque haya otros procesos escribiendo
+    bool writeAtomically(const std::string &path, const std::string &data) {
+        std::string temp = dir + "/tmp." + std::to_string(getpid()) + "." +
+                           std::to_string(std::hash<std::thread::id>()(std::this_thread::get_id())) + "." +
+                           std::to_string(tempCounter++);
+        {
+            std::ofstream file(temp, std::ios::binary);
+            file.write(data.data(), static_cast<std::streamsize>(data.size()));
+            if (!file) {
+                file.close();
+                std::remove(temp.c_str());
+                return false;
+            }
+        }
+        if (std::rename(temp.c_str(), path.c_str()) != 0) {
+            std::remove(temp.c_str());
+            return false;
+        }
+        return true;
+    }
+
+    void readCounts(CacheStats &stats) const {
+        std::ifstream file(dir + "/stats");
+        file >> stats.hits >> stats.misses;
+    }
+
+    struct EntryFile {
+        std::string path;
+        int64_t lastUse;
+        uint64_t size;
+    };
+
+    std::vector<EntryFile> listEntries() const {
+        std::vector<EntryFile> entries;
+        DIR *directory = opendir(dir.c_str());
+        if (!directory) return entries;
+        while (dirent *item = readdir(directory)) {
+            if (!isEntryName(item->d_name)) continue;
+            std::string path = entryPath(item->d_name);
+            struct stat info;
+            if (stat(path.c_str(), &info) != 0) continue;
+            int64_t lastUse = static_cast<int64_t>(info.st_mtim.tv_sec) * 1000000000 + info.st_mtim.tv_nsec;
+            entries.push_back({path, lastUse, static_cast<uint64_t>(info.st_size)});
+        }
+        closedir(directory);
+        return entries;
+    }
+
+    // Borra las entradas usadas hace más tiempo hasta que la caché entre en maxBytes
+    void evict() {
+        std::vector<EntryFile> entries = listEntries();
+        uint64_t total = 0;
+        for (const EntryFile &entry : entries) total += entry.size;
+        if (total <= maxBytes) return;
+        std::sort(entries.begin(), entries.end(),
+                  [](const EntryFile &a, const EntryFile &b) { return a.lastUse < b.lastUse; });
+        for (const EntryFile &entry : entries) {
+            if (total <= maxBytes) break;
+            if (std::remove(entry.path.c_str()) == 0) total -= entry.size;
+        }
+    }
+
+public:
+    CompileCache(std::string directory, uint64_t maxBytes) : dir(std::move(directory)), maxBytes(maxBytes) {}
+
+    // Crea el directorio si hace falta; false si no se puede usar (o si no hay
+    // con qué identificar al compilador en las claves)
+    bool open() {
+        if (compilerIdentity().empty()) return false;
+        mkdir(dir.c_str(), 0755);
+        struct stat info;
+        return stat(dir.c_str(), &info) == 0 && S_ISDIR(info.st_mode) && access(dir.c_str(), W_OK) == 0;
+    }
+
+    // Clave de 128 bits (dos XXH64 con semillas distintas) en hexadecimal
+    static std::string key(std::string_view source, const std::string &options) {
+        std::string context = compilerIdentity() + '\0' + options;
+        uint64_t seed = Xxh64::hash(context.data(), context.size());
+        uint64_t parts[2] = {Xxh64::hash(source.data(), source.size(), seed),
+                             Xxh64::hash(source.data(), source.size(), ~seed)};
+        static const char kHex[] = "0123456789abcdef";
+        std::string hex;
+        for (uint64_t part : parts) {
+            for (int shift = 60; shift >= 0; shift -= 4) hex += kHex[(part >> shift) & 0xF];
+        }
+        return hex;
+    }
+
+    // Proyecta la entrada de la clave; la marca como recién usada para el LRU
+    bool lookup(const std::string &key, CacheEntry &entry) {
+        std::string path = entryPath(key);
+        if (!entry.map(path)) {
+            misses++;
+            return false;
+        }
+        utimensat(AT_FDCWD, path.c_str(), nullptr, 0);
+        hits++;
+        return true;
+    }
+
+    void store(const std::string &key, const CacheRecord &record) {
+        ByteWriter out;
+        out.put(CacheEntry::kMagic);
+        out.put(static_cast<uint32_t>(record.ok));
+        out.putString(record.out);
+        out.putString(record.err);
+        out.putString(record.bytecode);
+        out.putString(record.executable);
+        if (writeAtomically(entryPath(key), out.str())) evict();
+    }
+
+    // Suma los aciertos y fallos de esta ejecución a los guardados en el directorio.
+    // La lectura y la escritura van bajo un flock de "stats.lock": dos procesos que
+    // terminan a la vez no pierden sus cuentas.
+    void saveStats() {
+        if (hits == 0 && misses == 0) return;
+        int lock = ::open((dir + "/stats.lock").c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+        if (lock < 0) return;
+        while (flock(lock, LOCK_EX) != 0 && errno == EINTR) {}
+        CacheStats saved;
+        readCounts(saved);
+        std::string text = std::to_string(saved.hits + hits) + " " + std::to_string(saved.misses + misses) + "\n";
+        writeAtomically(dir + "/stats", text);
+        flock(lock, LOCK_UN);
+        close(lock);
+    }
+
+    CacheStats loadStats() const {
+        CacheStats stats;
+        readCounts(stats);
+        for (const EntryFile &entry : listEntries()) {
+            stats.entries++;
+            stats.bytes += entry.size;
+        }
+        return stats;
+    }
+
+    uint64_t sessionHits() const {
+        return hits;
+    }
+
+    uint64_t sessionMisses() const {
+        return misses;
+    }
+};
+
+#endif // CACHE_H_
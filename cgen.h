@@ -0,0 +1,473 @@
+#ifndef CGEN_H_
+#define CGEN_H_
+
+#include <algorithm>
+#include <cstdint>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "ast.h"
+
+// Generador de C a partir del AST anotado por SemanticAnalyzer.
+//
+// El resultado es una sola unidad de traducción: el runtime de native_runtime.h
+// seguido del programa, de modo que cc puede integrar las funciones del runtime.
+// Las sentencias de control se traducen a las de C; cada subexpresión se guarda
+// en un temporal para conservar el orden de evaluación de izquierda a derecha
+// (C no lo garantiza) y con él el orden de los errores de ejecución. cc -O2
+// elimina los temporales.
+//
+// Convenciones: int, bool y char son int64_t; string es BmStr * y los arreglos
+// son BmArray * con los elementos en orden de filas, como en la IR.
+class CGenerator {
+    const Program &program;
+    std::ostream &out;
+
+    // Estado de la función actual
+    std::ostringstream body;
+    int indent = 1;
+    int tempCounter = 0;
+    bool pure = false;  // la sentencia actual no tiene efectos: las variables se leen directamente
+
+    std::vector<std::string> literals;
+    std::unordered_map<std::string, size_t> literalIndex;
+
+    static const char *cType(const Type &type) {
+        if (type.isArray()) return "BmArray *";
+        return type.base == TokenKind::KwString ? "BmStr *" : "int64_t ";
+    }
+
+    std::string variableName(int symbol) const {
+        const Symbol &s = program.symbols[symbol];
+        if (s.function < 0) return "g_" + s.name;
+        return "l_" + s.name + "_" + std::to_string(symbol);
+    }
+
+    static std::string functionName(const std::string &name) {
+        return "bm_fn_" + name;
+    }
+
+    static std::string escapeString(const std::string &text) {
+        std::string result;
+        for (unsigned char c : text) {
+            if (c == '"' || c == '\\') {
+                result += '\\';
+                result += static_cast<char>(c);
+            } else if (c >= 32 && c < 127 && c != '?') {
+                result += static_cast<char>(c);
+            } else {
+                const char digits[] = "01234567";
+                result += '\\';
+                result += digits[(c >> 6) & 7];
+                result += digits[(c >> 3) & 7];
+                result += digits[c & 7];
+            }
+        }
+        return result;
+    }
+
+    std::string literal(const std::string &text) {
+        auto found = literalIndex.find(text);
+        size_t id = found != literalIndex.end() ? found->second : literals.size();
+        if (found == literalIndex.end()) {
+            literals.push_back(text);
+            literalIndex.emplace(text, id);
+        }
+        return "bm_lit[" + std::to_string(id) + "]";
+    }
+
+    std::string defaultValue(const Type &type) {
+        return type.isScalar(TokenKind::KwString) ? literal("") : "0";
+    }
+
+    std::ostream &line() {
+        for (int i = 0; i < indent; ++i) body << "    ";
+        return body;
+    }
+
+    std::string temp(const Type &type, const std::string &value) {
+        std::string name = "t" + std::to_string(tempCounter++);
+        line() << cType(type) << name << " = " << value << ";\n";
+        return name;
+    }
+
+    // Expresiones: emite las sentencias necesarias y devuelve un operando de C
+    std::string expr(const Expr &e) {
+        switch (e.kind) {
+            case ExprKind::IntLit:
+            case ExprKind::BoolLit:
+            case ExprKind::CharLit:
+                if (e.intValue == INT64_MIN) return "INT64_MIN";
+                return std::to_string(e.intValue);
+            case ExprKind::StringLit:
+                return literal(e.name);
+            case ExprKind::Var:
+                if (pure) return variableName(e.symbol);
+                return temp(e.type, variableName(e.symbol));
+            case ExprKind::Assign:
+                return assign(e);
+            case ExprKind::Postfix:
+                return postfix(e);
+            case ExprKind::Unary: {
+                std::string operand = expr(*e.args[0]);
+                if (e.op == TokenKind::LogicalNot) return temp(e.type, "!" + operand);
+                return temp(e.type, "bm_neg(" + operand + ")");
+            }
+            case ExprKind::Binary:
+                return binary(e);
+            case ExprKind::Call: {
+                std::vector<std::string> args;
+                for (const auto &arg : e.args) args.push_back(expr(*arg));
+                std::string call = functionName(program.functions[e.symbol].name) + "(";
+                for (size_t i = 0; i < args.size(); ++i) call += (i ? ", " : "") + args[i];
+                call += ")";
+                if (e.type.base == TokenKind::KwVoid) {
+                    line() << call << ";\n";
+                    return "0";
+                }
+                return temp(e.type, call);
+            }
+            case ExprKind::Index: {
+                auto [array, index] = element(e);
+                return temp(e.type, load(e.type, array, index));
+            }
+        }
+        return "0";
+    }
+
+    // Elemento de arreglo: (arreglo, índice lineal) con las mismas verificaciones que la IR
+    std::pair<std::string, std::string> element(const Expr &e) {
+        std::vector<const Expr *> indices;
+        const Expr *root = &e;
+        while (root->kind == ExprKind::Index) {
+            indices.push_back(root->args[1].get());
+            root = root->args[0].get();
+        }
+        std::reverse(indices.begin(), indices.end());
+        std::string array = expr(*root);
+        Type intType;
+        intType.base = TokenKind::KwInteger;
+
+        std::string linear = expr(*indices[0]);
+        for (size_t k = 1; k < indices.size(); ++k) {
+            std::string index = expr(*indices[k]);
+            std::string dim = std::to_string(root->type.dims[k]);
+            line() << "bm_check_index(" << index << ", " << dim << ");\n";
+            linear = temp(intType, "bm_add(bm_mul(" + linear + ", " + dim + "), " + index + ")");
+        }
+        line() << "bm_check_index(" << linear << ", " << array << "->length);\n";
+        return {array, linear};
+    }
+
+    // Los elementos son de 8 bytes: las cadenas se guardan como enteros
+    static std::string load(const Type &type, const std::string &array, const std::string &index) {
+        std::string value = array + "->data[" + index + "]";
+        return type.isScalar(TokenKind::KwString) ? "(BmStr *)(intptr_t)" + value : value;
+    }
+
+    static std::string stored(const Type &type, const std::string &value) {
+        return type.isScalar(TokenKind::KwString) ? "(int64_t)(intptr_t)" + value : value;
+    }
+
+    std::string assign(const Expr &e) {
+        const Expr &target = *e.args[0];
+        if (target.kind == ExprKind::Index) {
+            auto [array, index] = element(target);
+            std::string value = expr(*e.args[1]);
+            line() << array << "->data[" << index << "] = " << stored(target.type, value) << ";\n";
+            return value;
+        }
+        std::string value = expr(*e.args[1]);
+        line() << variableName(target.symbol) << " = " << value << ";\n";
+        return value;
+    }
+
+    std::string postfix(const Expr &e) {
+        const Expr &target = *e.args[0];
+        const char *op = e.op == TokenKind::PostfixIncrement ? "bm_add" : "bm_sub";
+        if (target.kind == ExprKind::Index) {
+            auto [array, index] = element(target);
+            std::string old = temp(e.type, array + "->data[" + index + "]");
+            line() << array << "->data[" << index << "] = " << op << "(" << old << ", 1);\n";
+            return old;
+        }
+        std::string name = variableName(target.symbol);
+        std::string old = temp(e.type, name);
+        line() << name << " = " << op << "(" << old << ", 1);\n";
+        return old;
+    }
+
+    static std::string toStr(const std::string &value, const Type &type) {
+        if (type.isScalar(TokenKind::KwString)) return value;
+        if (type.isScalar(TokenKind::KwBoolean)) return "bm_bool_to_str(" + value + ")";
+        if (type.isScalar(TokenKind::KwChar)) return "bm_char_to_str(" + value + ")";
+        return "bm_int_to_str(" + value + ")";
+    }
+
+    std::string binary(const Expr &e) {
+        if (e.op == TokenKind::LogicalAnd || e.op == TokenKind::LogicalOr) {
+            // Cortocircuito: el operando derecho se evalúa dentro del if
+            std::string result = temp(e.type, expr(*e.args[0]));
+            line() << "if (" << (e.op == TokenKind::LogicalAnd ? "" : "!") << result << ") {\n";
+            indent++;
+            std::string rhs = expr(*e.args[1]);
+            line() << result << " = " << rhs << ";\n";
+            indent--;
+            line() << "}\n";
+            return result;
+        }
+        const Expr &lhsExpr = *e.args[0];
+        const Expr &rhsExpr = *e.args[1];
+        std::string lhs = expr(lhsExpr);
+        std::string rhs = expr(rhsExpr);
+        bool strings = lhsExpr.type.isScalar(TokenKind::KwString);
+        std::string value;
+        switch (e.op) {
+            case TokenKind::Addition:
+                if (e.type.isScalar(TokenKind::KwString)) {
+                    lhs = toStr(lhs, lhsExpr.type);
+                    rhs = toStr(rhs, rhsExpr.type);
+                    value = "bm_concat(" + lhs + ", " + rhs + ")";
+                } else {
+                    value = "bm_add(" + lhs + ", " + rhs + ")";
+                }
+                break;
+            case TokenKind::Subtraction: value = "bm_sub(" + lhs + ", " + rhs + ")"; break;
+            case TokenKind::Multiplication: value = "bm_mul(" + lhs + ", " + rhs + ")"; break;
+            case TokenKind::Division: value = "bm_div(" + lhs + ", " + rhs + ")"; break;
+            case TokenKind::Modulus: value = "bm_mod(" + lhs + ", " + rhs + ")"; break;
+            case TokenKind::Exponentiation: value = "bm_pow(" + lhs + ", " + rhs + ")"; break;
+            case TokenKind::LessThan: value = lhs + " < " + rhs; break;
+            case TokenKind::LessThanOrEqual: value = lhs + " <= " + rhs; break;
+            case TokenKind::GreaterThan: value = lhs + " > " + rhs; break;
+            case TokenKind::GreaterThanOrEqual: value = lhs + " >= " + rhs; break;
+            case TokenKind::isEqual:
+                value = strings ? "bm_str_eq(" + lhs + ", " + rhs + ")" : lhs + " == " + rhs;
+                break;
+            case TokenKind::NotEqual:
+                value = strings ? "!bm_str_eq(" + lhs + ", " + rhs + ")" : lhs + " != " + rhs;
+                break;
+            default:
+                return lhs;
+        }
+        return temp(e.type, value);
+    }
+
+    // Sentencias
+    std::string condition(const Expr &e) {
+        pure = !hasSideEffects(e);
+        std::string value = expr(e);
+        pure = false;
+        return value;
+    }
+
+    void exprStmt(const Expr &e) {
+        pure = !hasSideEffects(e);
+        expr(e);
+        pure = false;
+    }
+
+    void block(const std::vector<StmtPtr> &stmts) {
+        for (const auto &s : stmts) if (s) stmt(*s);
+    }
+
+    void nested(const std::vector<StmtPtr> &stmts) {
+        indent++;
+        block(stmts);
+        indent--;
+    }
+
+    void varDecl(const Stmt &s) {
+        const Symbol &symbol = program.symbols[s.symbol];
+        std::string value;
+        if (symbol.type.isArray()) {
+            int64_t length = 1;
+            for (int64_t d : symbol.type.dims) length *= d;
+            value = "bm_new_array(" + std::to_string(length) + ", " +
+                    (symbol.type.base == TokenKind::KwString ? "1" : "0") + ")";
+        } else if (s.expr) {
+            value = condition(*s.expr);
+        } else {
+            value = defaultValue(symbol.type);
+        }
+        line() << variableName(s.symbol) << " = " << value << ";\n";
+    }
+
+    void stmt(const Stmt &s) {
+        switch (s.kind) {
+            case StmtKind::VarDecl:
+                varDecl(s);
+                break;
+            case StmtKind::Expr:
+                if (s.expr) exprStmt(*s.expr);
+                break;
+            case StmtKind::Print: {
+                // Las concatenaciones se escriben por partes, como en lowering.h; con
+                // varias partes cada una queda en un temporal antes de escribir nada
+                std::vector<const Expr *> parts;
+                std::vector<std::string> values;
+                for (const auto &e : s.exprs) {
+                    parts.clear();
+                    values.clear();
+                    concatParts(*e, parts);
+                    for (const Expr *part : parts) {
+                        std::string value = condition(*part);
+                        if (parts.size() > 1 && !part->isLiteral()) value = temp(part->type, value);
+                        values.push_back(value);
+                    }
+                    for (size_t i = 0; i < parts.size(); ++i) {
+                        const Type &type = parts[i]->type;
+                        if (type.isScalar(TokenKind::KwString)) line() << "bm_print_str(" << values[i] << ");\n";
+                        else if (type.isScalar(TokenKind::KwBoolean)) line() << "bm_print_bool(" << values[i] << ");\n";
+                        else if (type.isScalar(TokenKind::KwChar)) line() << "bm_print_char(" << values[i] << ");\n";
+                        else line() << "bm_print_int(" << values[i] << ");\n";
+                    }
+                }
+                line() << "bm_println();\n";
+                break;
+            }
+            case StmtKind::Return:
+                if (s.expr) {
+                    std::string value = condition(*s.expr);
+                    line() << "return " << value << ";\n";
+                } else {
+                    line() << "return;\n";
+                }
+                break;
+            case StmtKind::Block:
+                line() << "{\n";
+                nested(s.body);
+                line() << "}\n";
+                break;
+            case StmtKind::If: {
+                std::string cond = condition(*s.expr);
+                line() << "if (" << cond << ") {\n";
+                nested(s.body);
+                if (!s.elseBody.empty()) {
+                    line() << "} else {\n";
+                    nested(s.elseBody);
+                }
+                line() << "}\n";
+                break;
+            }
+            case StmtKind::While:
+            case StmtKind::For:
+                // La condición puede necesitar sentencias: se evalúa dentro del bucle
+                line() << "{\n";
+                indent++;
+                if (s.init) stmt(*s.init);
+                line() << "for (;;) {\n";
+                indent++;
+                if (s.expr) {
+                    std::string cond = condition(*s.expr);
+                    line() << "if (!" << cond << ") break;\n";
+                }
+                block(s.body);
+                if (s.step) exprStmt(*s.step);
+                indent--;
+                line() << "}\n";
+                indent--;
+                line() << "}\n";
+                break;
+        }
+    }
+
+    // Firma de C de una función de B-minor
+    std::string signature(const Function &fn) const {
+        std::string text = fn.returnType.base == TokenKind::KwVoid ? "void " : cType(returnType(fn));
+        text += functionName(fn.name) + "(";
+        for (size_t p = 0; p < fn.params.size(); ++p) {
+            if (p) text += ", ";
+            text += cType(program.symbols[fn.params[p].symbol].type) + variableName(fn.params[p].symbol);
+        }
+        if (fn.params.empty()) text += "void";
+        return text + ")";
+    }
+
+    static Type returnType(const Function &fn) {
+        Type t;
+        t.base = fn.returnType.base;
+        return t;
+    }
+
+    // Declaraciones de las locales al principio del cuerpo: cada VarDecl asigna su
+    // valor inicial al ejecutarse, como en la IR
+    std::string function(size_t index) {
+        const Function &fn = program.functions[index];
+        body.str("");
+        indent = 1;
+        tempCounter = 0;
+        for (size_t i = 0; i < program.symbols.size(); ++i) {
+            const Symbol &s = program.symbols[i];
+            if (s.function != static_cast<int>(index)) continue;
+            bool isParam = false;
+            for (const auto &param : fn.params) isParam = isParam || param.symbol == static_cast<int>(i);
+            if (!isParam) line() << cType(s.type) << variableName(static_cast<int>(i)) << " = 0;\n";
+        }
+        block(fn.body);
+        if (fn.returnType.base != TokenKind::KwVoid) {
+            line() << "return " << defaultValue(returnType(fn)) << ";\n";
+        }
+        return "\n/* " + fn.name + " */\n" + signature(fn) + " {\n" + body.str() + "}\n";
+    }
+
+public:
+    CGenerator(const Program &program, std::ostream &out) : program(program), out(out) {}
+
+    // Escribe el programa; el runtime debe precederlo en la misma unidad de traducción
+    void run() {
+        // Primero el código: así se conocen todos los literales
+        std::string functions;
+        int mainFunction = -1;
+        for (size_t i = 0; i < program.functions.size(); ++i) {
+            functions += function(i);
+            if (program.functions[i].name == "main") mainFunction = static_cast<int>(i);
+        }
+        body.str("");
+        indent = 1;
+        tempCounter = 0;
+        for (const auto &g : program.globals) if (g) varDecl(*g);
+        std::string globalsBody = body.str();
+
+        out << "\n/* Generado por el compilador de B-minor */\n";
+        out << "static inline int64_t bm_add(int64_t a, int64_t b) { return (int64_t)((uint64_t)a + (uint64_t)b); }\n";
+        out << "static inline int64_t bm_sub(int64_t a, int64_t b) { return (int64_t)((uint64_t)a - (uint64_t)b); }\n";
+        out << "static inline int64_t bm_mul(int64_t a, int64_t b) { return (int64_t)((uint64_t)a * (uint64_t)b); }\n";
+        out << "static inline int64_t bm_neg(int64_t a) { return (int64_t)(0 - (uint64_t)a); }\n";
+        out << "static inline int64_t bm_div(int64_t a, int64_t b) {\n"
+               "    if (b == 0) bm_div_zero();\n"
+               "    return b == -1 ? bm_neg(a) : a / b;\n"
+               "}\n";
+        out << "static inline int64_t bm_mod(int64_t a, int64_t b) {\n"
+               "    if (b == 0) bm_div_zero();\n"
+               "    return b == -1 ? 0 : a % b;\n"
+               "}\n";
+        out << "static inline void bm_check_index(int64_t index, int64_t length) {\n"
+               "    if ((uint64_t)index >= (uint64_t)length) bm_bounds_error(index);\n"
+               "}\n";
+
+        // Globales y prototipos: las funciones pueden llamarse antes de su declaración
+        for (size_t i = 0; i < program.symbols.size(); ++i) {
+            const Symbol &s = program.symbols[i];
+            if (s.function < 0) out << "static " << cType(s.type) << variableName(static_cast<int>(i)) << ";\n";
+        }
+        for (const auto &fn : program.functions) out << "static " << signature(fn) << ";\n";
+        out << "static BmStr *bm_lit[" << std::max<size_t>(literals.size(), 1) << "];\n";
+        out << functions;
+
+        // Literales y luego los inicializadores de las globales en orden de declaración
+        out << "\nvoid bm_init_globals(void) {\n";
+        for (size_t i = 0; i < literals.size(); ++i) {
+            out << "    bm_lit[" << i << "] = bm_new_str(\"" << escapeString(literals[i]) << "\", " << literals[i].size() << ");\n";
+        }
+        out << globalsBody << "}\n";
+        out << "\nvoid bm_main(void) {\n";
+        if (mainFunction >= 0) out << "    " << functionName("main") << "();\n";
+        out << "}\n";
+    }
+};
+
+#endif // CGEN_H_
@@ -0,0 +1,166 @@
+#ifndef DCE_H_
+#define DCE_H_
+
+#include <vector>
+
+#include "ast.h"
+
+// Estadísticas de la eliminación de código muerto
+struct DceStats {
+    unsigned int removedFunctions = 0;  // funciones inalcanzables desde main
+    unsigned int removedGlobals = 0;    // globales sin usos y sin efectos al inicializarse
+    unsigned int removedStmts = 0;      // sentencias que siguen a un return
+};
+
+// Eliminación de código muerto sobre el programa completo. Requiere el AST anotado
+// por el análisis semántico: el grafo de llamadas sale de Expr::symbol de cada Call
+// y los usos de globales de Expr::symbol de cada Var. Parte de main y de los
+// inicializadores globales con efectos secundarios (se ejecutan siempre) y conserva
+// sólo lo alcanzable. Sin main no hay punto de entrada y todas las funciones se
+// conservan. Los índices de símbolos quedan obsoletos: hay que repetir el análisis
+// semántico si se eliminó algo.
+class DeadCodeEliminator {
+    DceStats stats;
+    const Program *program = nullptr;
+    std::vector<char> reachedFunctions;
+    std::vector<char> usedGlobals;
+    std::vector<int> globalOfSymbol;  // símbolo -> posición en Program::globals (-1 si es local)
+    std::vector<const Function *> pendingFunctions;
+    std::vector<const Stmt *> pendingGlobals;
+
+    // Devuelve false si la sentencia nunca termina normalmente
+    static bool fallsThrough(const Stmt &s) {
+        switch (s.kind) {
+            case StmtKind::Return:
+                return false;
+            case StmtKind::Block:
+                for (const auto &b : s.body) if (b && !fallsThrough(*b)) return false;
+                return true;
+            case StmtKind::If: {
+                bool thenFalls = true, elseFalls = true;
+                for (const auto &b : s.body) if (b && !fallsThrough(*b)) thenFalls = false;
+                for (const auto &b : s.elseBody) if (b && !fallsThrough(*b)) elseFalls = false;
+                return thenFalls || elseFalls;
+            }
+            default:
+                return true;
+        }
+    }
+
+    // Quita las sentencias que siguen a una que no termina normalmente
+    void pruneStmts(std::vector<StmtPtr> &stmts) {
+        for (size_t i = 0; i < stmts.size(); ++i) {
+            if (!stmts[i]) continue;
+            pruneStmt(*stmts[i]);
+            if (!fallsThrough(*stmts[i])) {
+                stats.removedStmts += static_cast<unsigned int>(stmts.size() - i - 1);
+                stmts.resize(i + 1);
+                return;
+            }
+        }
+    }
+
+    void pruneStmt(Stmt &s) {
+        pruneStmts(s.body);
+        pruneStmts(s.elseBody);
+    }
+
+    void markFunction(int index) {
+        if (index < 0 || reachedFunctions[index]) return;
+        reachedFunctions[index] = 1;
+        pendingFunctions.push_back(&program->functions[index]);
+    }
+
+    void markGlobal(int position) {
+        if (position < 0 || usedGlobals[position]) return;
+        usedGlobals[position] = 1;
+        pendingGlobals.push_back(program->globals[position].get());
+    }
+
+    void scanExpr(const Expr &e) {
+        if (e.kind == ExprKind::Call) markFunction(e.symbol);
+        else if (e.kind == ExprKind::Var && e.symbol >= 0) markGlobal(globalOfSymbol[e.symbol]);
+        for (const auto &arg : e.args) if (arg) scanExpr(*arg);
+    }
+
+    void scanStmt(const Stmt &s) {
+        if (s.expr) scanExpr(*s.expr);
+        if (s.step) scanExpr(*s.step);
+        if (s.init) scanStmt(*s.init);
+        for (const auto &e : s.exprs) if (e) scanExpr(*e);
+        for (const auto &b : s.body) if (b) scanStmt(*b);
+        for (const auto &b : s.elseBody) if (b) scanStmt(*b);
+    }
+
+    // Recorre lo alcanzable hasta que no aparecen funciones ni globales nuevas
+    void propagate() {
+        while (!pendingFunctions.empty() || !pendingGlobals.empty()) {
+            if (!pendingFunctions.empty()) {
+                const Function *fn = pendingFunctions.back();
+                pendingFunctions.pop_back();
+                for (const auto &s : fn->body) if (s) scanStmt(*s);
+            } else {
+                const Stmt *g = pendingGlobals.back();
+                pendingGlobals.pop_back();
+                if (g) scanStmt(*g);
+            }
+        }
+    }
+
+public:
+    DceStats run(Program &target) {
+        stats = DceStats{};
+        program = &target;
+
+        for (auto &fn : target.functions) pruneStmts(fn.body);
+
+        globalOfSymbol.assign(target.symbols.size(), -1);
+        for (size_t i = 0; i < target.globals.size(); ++i) {
+            const StmtPtr &g = target.globals[i];
+            if (g && g->symbol >= 0) globalOfSymbol[g->symbol] = static_cast<int>(i);
+        }
+        reachedFunctions.assign(target.functions.size(), 0);
+        usedGlobals.assign(target.globals.size(), 0);
+
+        bool hasMain = false;
+        for (size_t i = 0; i < target.functions.size(); ++i) {
+            if (target.functions[i].name == "main") {
+                markFunction(static_cast<int>(i));
+                hasMain = true;
+            }
+        }
+        if (!hasMain) {
+            for (size_t i = 0; i < target.functions.size(); ++i) markFunction(static_cast<int>(i));
+        }
+        for (size_t i = 0; i < target.globals.size(); ++i) {
+            const StmtPtr &g = target.globals[i];
+            if (g && g->expr && hasSideEffects(*g->expr)) markGlobal(static_cast<int>(i));
+        }
+        propagate();
+
+        std::vector<Function> functions;
+        for (size_t i = 0; i < target.functions.size(); ++i) {
+            if (reachedFunctions[i]) functions.push_back(std::move(target.functions[i]));
+            else stats.removedFunctions++;
+        }
+        target.functions = std::move(functions);
+
+        std::vector<StmtPtr> globals;
+        for (size_t i = 0; i < target.globals.size(); ++i) {
+            if (usedGlobals[i]) globals.push_back(std::move(target.globals[i]));
+            else stats.removedGlobals++;
+        }
+        target.globals = std::move(globals);
+
+        pendingFunctions.clear();
+        pendingGlobals.clear();
+        program = nullptr;
+        return stats;
+    }
+
+    bool changed() const {
+        return stats.removedFunctions > 0 || stats.removedGlobals > 0 || stats.removedStmts > 0;
+    }
+};
+
+#endif // DCE_H_
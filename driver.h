@@ -0,0 +1,114 @@
+#ifndef DRIVER_H_
+#define DRIVER_H_
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <glob.h>
+
+// Piezas del driver de línea de comandos: expansión de @archivos y patrones, y el
+// grupo de hilos que compila varios archivos a la vez.
+
+// Reemplaza cada "@archivo" por los argumentos escritos en él (separados por
+// espacios o saltos de línea; pueden incluir otros @archivos). Devuelve false si
+// un archivo de respuesta no se puede leer o se incluye a sí mismo sin fin.
+inline bool expandResponseFiles(const std::vector<std::string> &args, std::vector<std::string> &result,
+                                int depth = 0) {
+    static const int kMaxDepth = 16;
+    for (const std::string &arg : args) {
+        if (arg.size() < 2 || arg[0] != '@') {
+            result.push_back(arg);
+            continue;
+        }
+        std::ifstream file(arg.substr(1));
+        if (!file.is_open() || depth == kMaxDepth) {
+            std::cerr << "No se pudo leer el archivo de respuesta '" << arg.substr(1) << "'." << std::endl;
+            return false;
+        }
+        std::vector<std::string> nested;
+        for (std::string word; file >> word;) nested.push_back(word);
+        if (!expandResponseFiles(nested, result, depth + 1)) return false;
+    }
+    return true;
+}
+
+// Ruta relativa al directorio dado (vacío: el directorio actual del proceso)
+inline std::string resolvePath(const std::string &directory, const std::string &path) {
+    if (directory.empty() || path.empty() || path[0] == '/') return path;
+    return directory + '/' + path;
+}
+
+// Agrega los archivos que coinciden con el patrón (*, ? o [...]) en orden
+// alfabético. Un nombre sin comodines, o un patrón sin coincidencias, se agrega
+// tal cual para que la lectura informe el error. Con directory, un patrón
+// relativo se busca en ese directorio y los nombres quedan relativos a él.
+inline void expandGlob(const std::string &pattern, std::vector<std::string> &result,
+                       const std::string &directory = "") {
+    if (pattern.find_first_of("*?[") == std::string::npos) {
+        result.push_back(pattern);
+        return;
+    }
+    const std::string resolved = resolvePath(directory, pattern);
+    const size_t prefix = resolved.size() - pattern.size();
+    glob_t matches;
+    if (glob(resolved.c_str(), 0, nullptr, &matches) == 0) {
+        for (size_t i = 0; i < matches.gl_pathc; ++i) result.push_back(matches.gl_pathv[i] + prefix);
+    } else {
+        result.push_back(pattern);
+    }
+    globfree(&matches);
+}
+
+// Grupo de hilos de tamaño fijo (por defecto, uno por núcleo). run() reparte las
+// tareas 0..count-1 entre los hilos, que toman siempre el siguiente índice libre,
+// y llama a done(i) desde el hilo que llamó, en orden de índice, apenas termina
+// la tarea i y todas las anteriores: la salida queda en el orden de las entradas.
+class ThreadPool {
+    unsigned int size;
+
+public:
+    explicit ThreadPool(unsigned int threads = 0) {
+        size = threads ? threads : std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    unsigned int threads() const {
+        return size;
+    }
+
+    template <typename Task, typename Done>
+    void run(size_t count, Task task, Done done) {
+        std::atomic<size_t> next{0};
+        std::mutex mutex;
+        std::condition_variable finishedOne;
+        std::vector<char> finished(count, 0);
+        auto worker = [&] {
+            for (size_t i; (i = next++) < count;) {
+                task(i);
+                {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    finished[i] = 1;
+                }
+                finishedOne.notify_all();
+            }
+        };
+        std::vector<std::thread> workers;
+        for (size_t t = 0; t < size && t < count; ++t) workers.emplace_back(worker);
+        for (size_t i = 0; i < count; ++i) {
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                finishedOne.wait(lock, [&] { return finished[i] != 0; });
+            }
+            done(i);
+        }
+        for (auto &thread : workers) thread.join();
+    }
+};
+
+#endif // DRIVER_H_
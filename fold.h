@@ -0,0 +1,531 @@
+#ifndef FOLD_H_
+#define FOLD_H_
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "ast.h"
+
+// Potencia entera: false si el resultado desborda int64.
+// Exponente negativo: 1 para base 1, ±1 para base -1 y 0 en otro caso.
+inline bool checkedPow(int64_t base, int64_t exp, int64_t &out) {
+    if (exp < 0) {
+        if (base == 1) out = 1;
+        else if (base == -1) out = (exp & 1) ? -1 : 1;
+        else out = 0;
+        return true;
+    }
+    int64_t result = 1;
+    while (exp > 0) {
+        if ((exp & 1) && __builtin_mul_overflow(result, base, &result)) return false;
+        exp >>= 1;
+        if (exp > 0 && __builtin_mul_overflow(base, base, &base)) return false;
+    }
+    out = result;
+    return true;
+}
+
+// Estadísticas del plegado de constantes
+struct FoldStats {
+    unsigned int foldedExprs = 0;       // subexpresiones reemplazadas por un literal
+    unsigned int propagatedVars = 0;    // usos de variables reemplazados por su constante
+    unsigned int prunedBranches = 0;    // if con condición constante
+    unsigned int removedLoops = 0;      // while/for cuya condición es false desde el inicio
+};
+
+// Plegado de constantes y propagación condicional sobre el AST.
+// Cada variable tiene un valor en el retículo Desconocido < Constante < Sobredefinido;
+// las ramas que no llegan al punto de unión (terminan en return) no participan en
+// la unión y las variables modificadas dentro de un bucle quedan sobredefinidas.
+// Las operaciones enteras que desbordan, dividen por cero o dependen de efectos
+// secundarios nunca se pliegan: se dejan para tiempo de ejecución.
+class ConstantFolder {
+    struct Value {
+        enum State : char { Unknown, Const, Overdefined };
+        State state = Unknown;
+        ExprKind kind = ExprKind::IntLit;   // tipo del literal si es constante
+        int64_t intValue = 0;
+        std::string text;
+
+        bool operator==(const Value &other) const {
+            return state == other.state && kind == other.kind && intValue == other.intValue && text == other.text;
+        }
+    };
+
+    using Env = std::vector<Value>;
+
+    FoldStats stats;
+    std::vector<std::unordered_map<std::string, int>> scopes;
+    Env env;
+    std::unordered_set<std::string> modifiedGlobals;
+
+    static Value overdefined() {
+        Value v;
+        v.state = Value::Overdefined;
+        return v;
+    }
+
+    static Value constant(ExprKind kind, int64_t intValue, std::string text = "") {
+        Value v;
+        v.state = Value::Const;
+        v.kind = kind;
+        v.intValue = intValue;
+        v.text = std::move(text);
+        return v;
+    }
+
+    static Value valueOf(const Expr &e) {
+        if (!e.isLiteral()) return overdefined();
+        return constant(e.kind, e.intValue, e.kind == ExprKind::StringLit ? e.name : "");
+    }
+
+    static std::string toText(const Value &v) {
+        switch (v.kind) {
+            case ExprKind::StringLit: return v.text;
+            case ExprKind::BoolLit: return v.intValue ? "true" : "false";
+            case ExprKind::CharLit: return std::string(1, static_cast<char>(v.intValue));
+            default: return std::to_string(v.intValue);
+        }
+    }
+
+    // Unión de dos estados en un punto de confluencia
+    static Value meet(const Value &a, const Value &b) {
+        if (a.state == Value::Unknown) return b;
+        if (b.state == Value::Unknown) return a;
+        if (a == b) return a;
+        return overdefined();
+    }
+
+    void meetInto(Env &target, const Env &other) {
+        for (size_t i = 0; i < target.size() && i < other.size(); ++i) {
+            target[i] = meet(target[i], other[i]);
+        }
+    }
+
+    // Manejo de ámbitos
+    int declare(const std::string &name, Value value) {
+        int id = static_cast<int>(env.size());
+        env.push_back(std::move(value));
+        scopes.back()[name] = id;
+        return id;
+    }
+
+    int lookup(const std::string &name) const {
+        for (auto it = scopes.rbegin(); it != scopes.rend(); ++it) {
+            auto found = it->find(name);
+            if (found != it->end()) return found->second;
+        }
+        return -1;
+    }
+
+    // Nombres de variables escalares asignadas o incrementadas dentro de una expresión
+    static void collectAssigned(const Expr &e, std::unordered_set<std::string> &out) {
+        if ((e.kind == ExprKind::Assign || e.kind == ExprKind::Postfix) && e.args[0]->kind == ExprKind::Var) {
+            out.insert(e.args[0]->name);
+        }
+        for (const auto &arg : e.args) {
+            if (arg) collectAssigned(*arg, out);
+        }
+    }
+
+    static void collectAssigned(const Stmt &s, std::unordered_set<std::string> &out) {
+        if (s.expr) collectAssigned(*s.expr, out);
+        if (s.step) collectAssigned(*s.step, out);
+        if (s.init) collectAssigned(*s.init, out);
+        for (const auto &e : s.exprs) if (e) collectAssigned(*e, out);
+        for (const auto &b : s.body) if (b) collectAssigned(*b, out);
+        for (const auto &b : s.elseBody) if (b) collectAssigned(*b, out);
+    }
+
+    // ¿Hay alguna llamada en la expresión o sentencia? (puede escribir globales)
+    static bool containsCall(const Expr &e) {
+        if (e.kind == ExprKind::Call) return true;
+        for (const auto &arg : e.args) {
+            if (arg && containsCall(*arg)) return true;
+        }
+        return false;
+    }
+
+    static bool containsCall(const Stmt &s) {
+        if (s.expr && containsCall(*s.expr)) return true;
+        if (s.step && containsCall(*s.step)) return true;
+        if (s.init && containsCall(*s.init)) return true;
+        for (const auto &e : s.exprs) if (e && containsCall(*e)) return true;
+        for (const auto &b : s.body) if (b && containsCall(*b)) return true;
+        for (const auto &b : s.elseBody) if (b && containsCall(*b)) return true;
+        return false;
+    }
+
+    void invalidate(const std::unordered_set<std::string> &names) {
+        for (const auto &name : names) {
+            int id = lookup(name);
+            if (id >= 0) env[id] = overdefined();
+        }
+    }
+
+    // Una llamada puede escribir cualquier global modificada en alguna función
+    // (aunque un local del mismo nombre la oculte en este ámbito)
+    void invalidateModifiedGlobals() {
+        for (const auto &name : modifiedGlobals) {
+            auto found = scopes.front().find(name);
+            if (found != scopes.front().end()) env[found->second] = overdefined();
+        }
+    }
+
+    // Reemplazar una expresión sin efectos secundarios por su valor constante
+    void replaceWithLiteral(ExprPtr &e, const Value &v) {
+        if (v.state != Value::Const || e->isLiteral() || hasSideEffects(*e)) return;
+        if (e->kind == ExprKind::Var) stats.propagatedVars++;
+        else stats.foldedExprs++;
+        ExprPtr lit = makeExpr(v.kind, e->location);
+        lit->type = literalType(v.kind);
+        lit->intValue = v.intValue;
+        lit->name = v.text;
+        e = std::move(lit);
+    }
+
+    Value foldUnary(TokenKind op, const Value &v) {
+        if (v.state != Value::Const) return overdefined();
+        if (op == TokenKind::LogicalNot && v.kind == ExprKind::BoolLit) {
+            return constant(ExprKind::BoolLit, !v.intValue);
+        }
+        if (op == TokenKind::Subtraction && v.kind == ExprKind::IntLit && v.intValue != INT64_MIN) {
+            return constant(ExprKind::IntLit, -v.intValue);
+        }
+        return overdefined();
+    }
+
+    Value foldBinary(TokenKind op, const Value &a, const Value &b) {
+        if (a.state != Value::Const || b.state != Value::Const) return overdefined();
+
+        // Concatenación de cadenas
+        if (op == TokenKind::Addition && (a.kind == ExprKind::StringLit || b.kind == ExprKind::StringLit)) {
+            return constant(ExprKind::StringLit, 0, toText(a) + toText(b));
+        }
+
+        if (a.kind == ExprKind::IntLit && b.kind == ExprKind::IntLit) {
+            int64_t x = a.intValue, y = b.intValue, r = 0;
+            switch (op) {
+                case TokenKind::Addition:
+                    if (__builtin_add_overflow(x, y, &r)) return overdefined();
+                    return constant(ExprKind::IntLit, r);
+                case TokenKind::Subtraction:
+                    if (__builtin_sub_overflow(x, y, &r)) return overdefined();
+                    return constant(ExprKind::IntLit, r);
+                case TokenKind::Multiplication:
+                    if (__builtin_mul_overflow(x, y, &r)) return overdefined();
+                    return constant(ExprKind::IntLit, r);
+                case TokenKind::Division:
+                    if (y == 0 || (x == INT64_MIN && y == -1)) return overdefined();
+                    return constant(ExprKind::IntLit, x / y);
+                case TokenKind::Modulus:
+                    if (y == 0 || (x == INT64_MIN && y == -1)) return overdefined();
+                    return constant(ExprKind::IntLit, x % y);
+                case TokenKind::Exponentiation:
+                    if (!checkedPow(x, y, r)) return overdefined();
+                    return constant(ExprKind::IntLit, r);
+                default:
+                    break;
+            }
+        }
+
+        if (a.kind == b.kind && a.kind != ExprKind::StringLit) {
+            int64_t x = a.intValue, y = b.intValue;
+            switch (op) {
+                case TokenKind::LessThan: return constant(ExprKind::BoolLit, x < y);
+                case TokenKind::LessThanOrEqual: return constant(ExprKind::BoolLit, x <= y);
+                case TokenKind::GreaterThan: return constant(ExprKind::BoolLit, x > y);
+                case TokenKind::GreaterThanOrEqual: return constant(ExprKind::BoolLit, x >= y);
+                default: break;
+            }
+        }
+
+        if (a.kind == b.kind) {
+            bool equal = a.intValue == b.intValue && a.text == b.text;
+            if (op == TokenKind::isEqual) return constant(ExprKind::BoolLit, equal);
+            if (op == TokenKind::NotEqual) return constant(ExprKind::BoolLit, !equal);
+        }
+
+        if (a.kind == ExprKind::BoolLit && b.kind == ExprKind::BoolLit) {
+            if (op == TokenKind::LogicalAnd) return constant(ExprKind::BoolLit, a.intValue && b.intValue);
+            if (op == TokenKind::LogicalOr) return constant(ExprKind::BoolLit, a.intValue || b.intValue);
+        }
+        return overdefined();
+    }
+
+    // Pliega la expresión en su lugar y devuelve su valor en el retículo
+    Value foldExpr(ExprPtr &e) {
+        if (!e) return overdefined();
+        Value result = overdefined();
+        switch (e->kind) {
+            case ExprKind::IntLit:
+            case ExprKind::BoolLit:
+            case ExprKind::CharLit:
+            case ExprKind::StringLit:
+                return valueOf(*e);
+
+            case ExprKind::Var: {
+                int id = lookup(e->name);
+                if (id >= 0 && env[id].state == Value::Const) result = env[id];
+                break;
+            }
+
+            case ExprKind::Assign: {
+                ExprPtr &target = e->args[0];
+                if (target->kind == ExprKind::Index) {
+                    foldExpr(target->args[0]);
+                    foldExpr(target->args[1]);
+                }
+                Value value = foldExpr(e->args[1]);
+                if (target->kind == ExprKind::Var) {
+                    int id = lookup(target->name);
+                    if (id >= 0) env[id] = value.state == Value::Const ? value : overdefined();
+                }
+                return value;
+            }
+
+            case ExprKind::Postfix: {
+                ExprPtr &target = e->args[0];
+                if (target->kind == ExprKind::Index) {
+                    foldExpr(target->args[0]);
+                    foldExpr(target->args[1]);
+                    return overdefined();
+                }
+                int id = lookup(target->name);
+                if (id < 0) return overdefined();
+                Value old = env[id];
+                int64_t next = 0;
+                int64_t delta = e->op == TokenKind::PostfixIncrement ? 1 : -1;
+                if (old.state == Value::Const && old.kind == ExprKind::IntLit &&
+                    !__builtin_add_overflow(old.intValue, delta, &next)) {
+                    env[id] = constant(ExprKind::IntLit, next);
+                } else {
+                    env[id] = overdefined();
+                }
+                return overdefined();
+            }
+
+            case ExprKind::Call:
+                for (auto &arg : e->args) foldExpr(arg);
+                invalidateModifiedGlobals();
+                return overdefined();
+
+            case ExprKind::Index:
+                for (auto &arg : e->args) foldExpr(arg);
+                return overdefined();
+
+            case ExprKind::Unary:
+                result = foldUnary(e->op, foldExpr(e->args[0]));
+                break;
+
+            case ExprKind::Binary:
+                if (e->op == TokenKind::LogicalAnd || e->op == TokenKind::LogicalOr) {
+                    return foldShortCircuit(e);
+                }
+                {
+                    Value lhs = foldExpr(e->args[0]);
+                    Value rhs = foldExpr(e->args[1]);
+                    result = foldBinary(e->op, lhs, rhs);
+                }
+                break;
+        }
+        replaceWithLiteral(e, result);
+        return result;
+    }
+
+    // && y ||: el lado derecho sólo se evalúa condicionalmente
+    Value foldShortCircuit(ExprPtr &e) {
+        bool isAnd = e->op == TokenKind::LogicalAnd;
+        Value lhs = foldExpr(e->args[0]);
+        if (lhs.state == Value::Const && lhs.kind == ExprKind::BoolLit) {
+            if (static_cast<bool>(lhs.intValue) != isAnd) {
+                // false && x  ->  false,  true || x  ->  true
+                replaceWithLiteral(e, lhs);
+                return lhs;
+            }
+            // true && x  ->  x,  false || x  ->  x
+            Value rhs = foldExpr(e->args[1]);
+            ExprPtr rhsExpr = std::move(e->args[1]);
+            e = std::move(rhsExpr);
+            stats.foldedExprs++;
+            return rhs;
+        }
+        Env before = env;
+        Value rhs = foldExpr(e->args[1]);
+        meetInto(env, before);
+        Value result = foldBinary(e->op, lhs, rhs);
+        replaceWithLiteral(e, result);
+        return result;
+    }
+
+    // Condición reducida a un literal (sin efectos secundarios pendientes)
+    static bool isConstBool(const ExprPtr &e, bool expected) {
+        return e && e->kind == ExprKind::BoolLit && static_cast<bool>(e->intValue) == expected;
+    }
+
+    // Convierte la sentencia en un bloque con el cuerpo indicado
+    static void replaceWithBlock(StmtPtr &s, std::vector<StmtPtr> body) {
+        StmtPtr block = makeStmt(StmtKind::Block, s->location);
+        block->body = std::move(body);
+        s = std::move(block);
+    }
+
+    // Devuelve false si la lista nunca alcanza su final (termina en return)
+    bool foldStmts(std::vector<StmtPtr> &stmts) {
+        bool fallsThrough = true;
+        for (auto &s : stmts) {
+            if (s && !foldStmt(s)) fallsThrough = false;
+        }
+        return fallsThrough;
+    }
+
+    bool foldScoped(std::vector<StmtPtr> &stmts) {
+        scopes.emplace_back();
+        bool fallsThrough = foldStmts(stmts);
+        scopes.pop_back();
+        return fallsThrough;
+    }
+
+    bool foldStmt(StmtPtr &s) {
+        switch (s->kind) {
+            case StmtKind::VarDecl: {
+                for (auto &dim : s->declType.dims) foldExpr(dim);
+                Value value = foldExpr(s->expr);
+                if (s->declType.isArray() || !s->expr || value.state != Value::Const) value = overdefined();
+                declare(s->name, value);
+                return true;
+            }
+            case StmtKind::Expr:
+                foldExpr(s->expr);
+                return true;
+            case StmtKind::Print:
+                for (auto &e : s->exprs) foldExpr(e);
+                return true;
+            case StmtKind::Return:
+                foldExpr(s->expr);
+                return false;
+            case StmtKind::Block:
+                return foldScoped(s->body);
+            case StmtKind::If:
+                return foldIf(s);
+            case StmtKind::While:
+                return foldWhile(s);
+            case StmtKind::For:
+                return foldFor(s);
+        }
+        return true;
+    }
+
+    bool foldIf(StmtPtr &s) {
+        Value cond = foldExpr(s->expr);
+        if (s->expr && s->expr->kind == ExprKind::BoolLit) {
+            stats.prunedBranches++;
+            replaceWithBlock(s, std::move(cond.intValue ? s->body : s->elseBody));
+            return foldScoped(s->body);
+        }
+        Env before = env;
+        bool thenFalls = foldScoped(s->body);
+        Env afterThen = std::move(env);
+        env = std::move(before);
+        bool elseFalls = foldScoped(s->elseBody);
+
+        if (thenFalls && elseFalls) {
+            meetInto(env, afterThen);
+        } else if (thenFalls) {
+            env = std::move(afterThen);
+        }
+        return thenFalls || elseFalls;
+    }
+
+    // Antes de la condición se invalida todo lo que una vuelta del bucle puede
+    // cambiar, incluidas las globales que escriben las funciones llamadas en él
+    bool foldWhile(StmtPtr &s) {
+        std::unordered_set<std::string> assigned;
+        collectAssigned(*s, assigned);
+        bool calls = containsCall(*s);
+        invalidate(assigned);
+        if (calls) invalidateModifiedGlobals();
+        foldExpr(s->expr);
+        if (isConstBool(s->expr, false)) {
+            stats.removedLoops++;
+            replaceWithBlock(s, {});
+            return true;
+        }
+        Env before = env;
+        foldScoped(s->body);
+        env = std::move(before);
+        if (calls) invalidateModifiedGlobals();
+        return true;
+    }
+
+    bool foldFor(StmtPtr &s) {
+        scopes.emplace_back();
+        if (s->init) foldStmt(s->init);
+        std::unordered_set<std::string> assigned;
+        if (s->expr) collectAssigned(*s->expr, assigned);
+        if (s->step) collectAssigned(*s->step, assigned);
+        for (const auto &b : s->body) if (b) collectAssigned(*b, assigned);
+        bool calls = (s->expr && containsCall(*s->expr)) || (s->step && containsCall(*s->step));
+        for (const auto &b : s->body) if (b && containsCall(*b)) calls = true;
+        invalidate(assigned);
+        if (calls) invalidateModifiedGlobals();
+        foldExpr(s->expr);
+        if (isConstBool(s->expr, false)) {
+            stats.removedLoops++;
+            std::vector<StmtPtr> init;
+            if (s->init) init.push_back(std::move(s->init));
+            scopes.pop_back();
+            replaceWithBlock(s, std::move(init));
+            return true;
+        }
+        Env before = env;
+        foldScoped(s->body);
+        foldExpr(s->step);
+        env = std::move(before);
+        if (calls) invalidateModifiedGlobals();
+        scopes.pop_back();
+        return true;
+    }
+
+public:
+    FoldStats run(Program &program) {
+        stats = FoldStats{};
+        scopes.assign(1, {});
+        env.clear();
+
+        // Globales modificadas en alguna función: no se propagan dentro de funciones
+        modifiedGlobals.clear();
+        for (const auto &fn : program.functions) {
+            for (const auto &s : fn.body) if (s) collectAssigned(*s, modifiedGlobals);
+        }
+
+        // Los inicializadores globales se evalúan en orden antes de cualquier función.
+        // Desde el primero que llama a una función, las globales siguientes pueden
+        // leerse antes de inicializarse: dentro de las funciones no se propagan.
+        size_t settledGlobals = SIZE_MAX;
+        for (auto &g : program.globals) {
+            if (!g) continue;
+            if (settledGlobals == SIZE_MAX && g->expr && hasSideEffects(*g->expr)) settledGlobals = env.size();
+            foldStmt(g);
+        }
+        invalidateModifiedGlobals();
+        Env globals = env;
+        for (size_t i = settledGlobals; i < globals.size(); ++i) globals[i] = overdefined();
+
+        for (auto &fn : program.functions) {
+            env = globals;
+            scopes.resize(1);
+            scopes.emplace_back();
+            for (const auto &param : fn.params) declare(param.name, overdefined());
+            foldScoped(fn.body);
+        }
+        scopes.clear();
+        env.clear();
+        return stats;
+    }
+};
+
+#endif // FOLD_H_
@@ -0,0 +1,403 @@
+// Harness de fuzzing de rendimiento del lexer y el parser. Además de las caídas,
+// busca entradas cuyo tiempo o memoria crecen más que linealmente con su tamaño:
+// cada entrada se repite hasta kScaleBaseBytes y después kScaleFactor veces más,
+// y si el costo crece mucho más que el tamaño la entrada se marca como lenta.
+//
+// Con libFuzzer (la entrada lenta aborta, así libFuzzer la guarda y con
+// -minimize_crash=1 la reduce):
+//   clang++ -std=c++17 -O1 -g -fsanitize=fuzzer,address -DBM_LIBFUZZER fuzz.cpp -o bm_fuzz
+//   ./bm_fuzz -max_len=4096 corpus/
+// Sin dependencias, con su propio bucle de mutaciones guiado por la lentitud:
+//   g++ -std=c++17 -O2 fuzz.cpp -o bm_fuzz
+//   ./bm_fuzz -runs=5000 -seed=1 [semillas...]
+// En el modo propio cada entrada corre en un proceso hijo (una caída o un tiempo
+// agotado no detienen la búsqueda) y lo encontrado se reduce antes de guardarse:
+// las entradas lentas en bench_regressions/, que --bench-suite mide junto con su
+// corpus, y las caídas en fuzz_crashes/. Se guarda la entrada ya repetida al
+// tamaño grande, así el compilador la reproduce directamente.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <new>
+#include <random>
+#include <string>
+#include <vector>
+#include <malloc.h>
+#include <signal.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "lexer.h"
+#include "parser.h"
+#include "benchsuite.h"
+
+// Tamaños de la prueba de escala: lineal, el costo grande es unas kScaleFactor
+// veces el chico; se marca por encima de kMaxGrowth veces eso
+static const size_t kScaleBaseBytes = 4096;
+static const size_t kScaleFactor = 8;
+static const double kMaxGrowth = 3.0;
+// Por debajo de esto la medida grande es ruido y no se marca
+static const double kMinLargeMs = 2.0;
+static const uint64_t kMinLargeBytes = 1 << 20;
+
+static const char *const kCrashesDir = "fuzz_crashes";
+
+// Memoria viva del hilo según los operator new/delete de abajo, y su pico
+struct LiveMemory {
+    uint64_t allocations = 0;
+    uint64_t live = 0;
+    uint64_t peak = 0;
+};
+
+static LiveMemory &liveMemory() {
+    thread_local LiveMemory memory;
+    return memory;
+}
+
+// Como en main.cpp, pero con el tamaño real de cada bloque para seguir la memoria
+// viva. malloc_usable_size es de glibc (y de los sanitizadores de clang).
+void *operator new(std::size_t size) {
+    void *p = std::malloc(size ? size : 1);
+    if (!p) throw std::bad_alloc();
+    LiveMemory &memory = liveMemory();
+    memory.allocations++;
+    memory.live += malloc_usable_size(p);
+    memory.peak = std::max(memory.peak, memory.live);
+    return p;
+}
+
+__attribute__((noinline)) void operator delete(void *p) noexcept {
+    if (p) liveMemory().live -= malloc_usable_size(p);
+    std::free(p);
+}
+
+__attribute__((noinline)) void operator delete(void *p, std::size_t) noexcept {
+    operator delete(p);
+}
+
+// Lo que cuesta analizar un texto
+struct FrontEndCost {
+    double ms = 0;
+    uint64_t allocations = 0;
+    uint64_t peakBytes = 0;  // pico de memoria viva por encima de la del comienzo
+};
+
+// Lexer y parser sobre el texto, sin traza y con los mensajes descartados
+static FrontEndCost runFrontEnd(const std::string &text) {
+    std::ostream discard(nullptr);
+    CompilerStreams &streams = compilerStreams();
+    CompilerStreams saved = streams;
+    streams = CompilerStreams{&discard, &discard};
+    SourceFile source{"<fuzz>", text};
+    LiveMemory &memory = liveMemory();
+    const uint64_t startAllocations = memory.allocations;
+    const uint64_t startLive = memory.live;
+    memory.peak = memory.live;
+    FrontEndCost cost;
+    auto start = std::chrono::steady_clock::now();
+    {
+        Lexer lexer(source);
+        Parser parser(lexer, false);
+        parser.parse();
+    }
+    cost.ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    cost.allocations = memory.allocations - startAllocations;
+    cost.peakBytes = memory.peak - startLive;
+    streams = saved;
+    return cost;
+}
+
+// El mejor de tres: el ruido sólo hace más lenta una corrida
+static FrontEndCost bestFrontEnd(const std::string &text) {
+    FrontEndCost best = runFrontEnd(text);
+    for (int run = 0; run < 2; ++run) {
+        FrontEndCost cost = runFrontEnd(text);
+        best.ms = std::min(best.ms, cost.ms);
+    }
+    return best;
+}
+
+static std::string repeatTo(const std::string &unit, size_t bytes) {
+    std::string text;
+    if (unit.empty()) return text;
+    while (text.size() < bytes) text += unit;
+    return text;
+}
+
+// La entrada repetida a los dos tamaños y su costo en cada uno
+struct ScalingResult {
+    double smallMs = 0;
+    double largeMs = 0;
+    uint64_t smallPeak = 0;
+    uint64_t largePeak = 0;
+
+    double timeGrowth() const {
+        return largeMs / std::max(smallMs, 1e-3);
+    }
+
+    double memoryGrowth() const {
+        return static_cast<double>(largePeak) / static_cast<double>(std::max<uint64_t>(smallPeak, 1));
+    }
+
+    bool superlinearTime() const {
+        return largeMs >= kMinLargeMs && timeGrowth() > kMaxGrowth * kScaleFactor;
+    }
+
+    bool superlinearMemory() const {
+        return largePeak >= kMinLargeBytes && memoryGrowth() > kMaxGrowth * kScaleFactor;
+    }
+
+    bool superlinear() const {
+        return superlinearTime() || superlinearMemory();
+    }
+};
+
+static ScalingResult measureScaling(const std::string &unit) {
+    ScalingResult result;
+    if (unit.empty()) return result;
+    std::string small = repeatTo(unit, kScaleBaseBytes);
+    std::string large;
+    for (size_t i = 0; i < kScaleFactor; ++i) large += small;
+    FrontEndCost smallCost = bestFrontEnd(small);
+    FrontEndCost largeCost = bestFrontEnd(large);
+    result.smallMs = smallCost.ms;
+    result.largeMs = largeCost.ms;
+    result.smallPeak = smallCost.peakBytes;
+    result.largePeak = largeCost.peakBytes;
+    return result;
+}
+
+static void printScaling(const ScalingResult &scaling) {
+    std::cerr << "INFO FUZZ - tiempo " << scaling.smallMs << " ms -> " << scaling.largeMs << " ms (x"
+              << scaling.timeGrowth() << "), memoria " << scaling.smallPeak << " -> " << scaling.largePeak
+              << " bytes (x" << scaling.memoryGrowth() << ") al crecer x" << kScaleFactor << "\n";
+}
+
+// Guarda la entrada repetida al tamaño grande en dir/prefijo-<hash>.txt
+static std::string saveScaled(const char *dir, const char *prefix, const std::string &unit) {
+    mkdir(dir, 0755);
+    char name[32];
+    std::snprintf(name, sizeof(name), "%016llx",
+                  static_cast<unsigned long long>(Xxh64::hash(unit.data(), unit.size(), 0)));
+    std::string path = std::string(dir) + "/" + prefix + name + ".txt";
+    std::ofstream file(path, std::ios::binary);
+    file << repeatTo(unit, kScaleBaseBytes * kScaleFactor);
+    if (!file) std::cerr << "No se pudo escribir '" << path << "'." << std::endl;
+    return path;
+}
+
+// Punto de entrada de libFuzzer (y de cualquier driver compatible)
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size) {
+    std::string unit(reinterpret_cast<const char *>(data), size);
+    ScalingResult scaling = measureScaling(unit);
+    // Se confirma con otra medida antes de marcarla: una sola puede ser ruido
+    if (scaling.superlinear() && measureScaling(unit).superlinear()) {
+        printScaling(scaling);
+        std::cerr << "ERROR FUZZ - entrada de costo superlineal, guardada en '"
+                  << saveScaled(kBenchRegressionsDir, "slow-", unit) << "'" << std::endl;
+        std::abort();
+    }
+    return 0;
+}
+
+#ifndef BM_LIBFUZZER
+
+// Resultado de una entrada corrida en un proceso hijo
+enum class Outcome { Ok, Superlinear, Crash, Timeout };
+
+struct Evaluation {
+    Outcome outcome = Outcome::Ok;
+    ScalingResult scaling;
+};
+
+// Segundos que puede tardar un hijo antes de contarse como tiempo agotado
+static const unsigned int kTimeoutSeconds = 10;
+
+static Evaluation evaluateIsolated(const std::string &unit) {
+    Evaluation evaluation;
+    int fds[2];
+    if (pipe(fds) != 0) {
+        evaluation.scaling = measureScaling(unit);
+        if (evaluation.scaling.superlinear()) evaluation.outcome = Outcome::Superlinear;
+        return evaluation;
+    }
+    pid_t child = fork();
+    if (child == 0) {
+        close(fds[0]);
+        alarm(kTimeoutSeconds);
+        ScalingResult scaling = measureScaling(unit);
+        if (scaling.superlinear()) scaling = measureScaling(unit);
+        ssize_t written = write(fds[1], &scaling, sizeof(scaling));
+        _exit(written == static_cast<ssize_t>(sizeof(scaling)) ? 0 : 1);
+    }
+    close(fds[1]);
+    ScalingResult scaling;
+    bool received = read(fds[0], &scaling, sizeof(scaling)) == static_cast<ssize_t>(sizeof(scaling));
+    close(fds[0]);
+    int status = 0;
+    waitpid(child, &status, 0);
+    if (WIFSIGNALED(status)) {
+        evaluation.outcome = WTERMSIG(status) == SIGALRM ? Outcome::Timeout : Outcome::Crash;
+    } else if (received) {
+        evaluation.scaling = scaling;
+        if (scaling.superlinear()) evaluation.outcome = Outcome::Superlinear;
+    } else {
+        evaluation.outcome = Outcome::Crash;
+    }
+    return evaluation;
+}
+
+// Quita trozos cada vez más chicos mientras el resultado siga siendo el mismo
+static std::string minimize(std::string unit, Outcome outcome) {
+    static const unsigned int kMaxSteps = 300;
+    unsigned int steps = 0;
+    for (size_t chunk = std::max<size_t>(unit.size() / 2, 1); steps < kMaxSteps; chunk = std::max<size_t>(chunk / 2, 1)) {
+        for (size_t pos = 0; pos < unit.size() && steps < kMaxSteps;) {
+            std::string candidate = unit.substr(0, pos) + unit.substr(std::min(pos + chunk, unit.size()));
+            steps++;
+            if (!candidate.empty() && evaluateIsolated(candidate).outcome == outcome) unit = candidate;
+            else pos += chunk;
+        }
+        if (chunk == 1) break;
+    }
+    return unit;
+}
+
+// Mutaciones sobre el texto: bytes sueltos, piezas de la gramática, y trozos
+// borrados, duplicados o traídos de otra entrada del corpus
+class Mutator {
+    std::mt19937 random;
+    size_t maxLength;
+
+    size_t pick(size_t n) {
+        return n ? static_cast<size_t>(random() % n) : 0;
+    }
+
+public:
+    Mutator(uint32_t seed, size_t maxLength) : random(seed), maxLength(maxLength) {}
+
+    std::string mutate(const std::string &input, const std::string &other) {
+        static const char *const kPieces[] = {
+            "function ", "int ", "bool ", "char ", "string ", "void ", "array ", "if (", "else ", "for (",
+            "while (", "return ", "print(", "(", ")", "{", "}", "[", "]", ";", ",", " = ", " == ", " != ",
+            " + ", " - ", " * ", " / ", " % ", " ^ ", "++", "--", "!", " && ", " || ", " < ", " <= ", " > ",
+            "/*", "*/", "//", "\n", "\"", "'", "'\\n'", "$", "x", "f(x)", "a[1]", "1", "123456789012345678901", " "};
+        std::string text = input;
+        for (size_t count = 1 + pick(4); count > 0; --count) {
+            size_t pos = pick(text.size() + 1);
+            size_t length = 1 + pick(std::min<size_t>(text.size() - std::min(pos, text.size()) + 1, 64));
+            switch (pick(6)) {
+                case 0:
+                    if (!text.empty()) text[pick(text.size())] = static_cast<char>(pick(128));
+                    break;
+                case 1:
+                    text.insert(pos, kPieces[pick(sizeof(kPieces) / sizeof(kPieces[0]))]);
+                    break;
+                case 2:
+                    text.erase(pos, length);
+                    break;
+                case 3:
+                    text.insert(pos, text.substr(pos, length));
+                    break;
+                case 4:
+                    text.replace(pos, length, kPieces[pick(sizeof(kPieces) / sizeof(kPieces[0]))]);
+                    break;
+                default: {
+                    size_t from = pick(other.size());
+                    text.insert(pos, other.substr(from, 1 + pick(256)));
+                }
+            }
+        }
+        if (text.size() > maxLength) text.resize(maxLength);
+        return text;
+    }
+};
+
+static bool readFile(const std::string &path, std::string &text) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open()) return false;
+    text.assign((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    return true;
+}
+
+// Bucle propio: opciones al estilo de libFuzzer (-runs=, -seed=, -max_len=) y
+// archivos semilla; sin semillas usa los ejemplos del repositorio
+int main(int argc, char *argv[]) {
+    static const size_t kMaxCorpus = 64;
+    static const unsigned int kMaxFindings = 20;
+    unsigned long runs = 2000;
+    uint32_t seed = 1;
+    size_t maxLength = 4096;
+    std::vector<std::string> seedFiles;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg.compare(0, 6, "-runs=") == 0) runs = std::strtoul(arg.c_str() + 6, nullptr, 10);
+        else if (arg.compare(0, 6, "-seed=") == 0) seed = static_cast<uint32_t>(std::strtoul(arg.c_str() + 6, nullptr, 10));
+        else if (arg.compare(0, 9, "-max_len=") == 0) maxLength = std::max<size_t>(1, std::strtoul(arg.c_str() + 9, nullptr, 10));
+        else seedFiles.push_back(arg);
+    }
+    if (seedFiles.empty()) {
+        seedFiles = {"PRUEBA_COMPLETA.txt", "ARCHIVO_PRUEBA1_PARSERNUEVO.txt", "PRUEBA_CON_FALLO.txt", "BENCH_LOOPS.txt"};
+    }
+
+    // Corpus guiado por la lentitud: cada entrada con su crecimiento de tiempo; una
+    // mutación que crece más que la menos lenta la reemplaza
+    struct Entry {
+        std::string text;
+        double growth;
+    };
+    std::vector<Entry> corpus;
+    for (const std::string &path : seedFiles) {
+        std::string text;
+        if (!readFile(path, text)) {
+            std::cerr << "No se pudo abrir el archivo '" << path << "'." << std::endl;
+            return 1;
+        }
+        if (text.size() > maxLength) text.resize(maxLength);
+        corpus.push_back({text, evaluateIsolated(text).scaling.timeGrowth()});
+    }
+
+    Mutator mutator(seed, maxLength);
+    std::mt19937 random(seed);
+    unsigned int findings = 0;
+    unsigned long run = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (; run < runs && findings < kMaxFindings; ++run) {
+        const Entry &parent = corpus[random() % corpus.size()];
+        const Entry &other = corpus[random() % corpus.size()];
+        std::string unit = mutator.mutate(parent.text, other.text);
+        if (unit.empty()) continue;
+        Evaluation evaluation = evaluateIsolated(unit);
+        if (evaluation.outcome != Outcome::Ok) {
+            findings++;
+            std::string reduced = minimize(unit, evaluation.outcome);
+            bool crashed = evaluation.outcome == Outcome::Crash;
+            std::string path = saveScaled(crashed ? kCrashesDir : kBenchRegressionsDir, crashed ? "crash-" : "slow-", reduced);
+            const char *what = crashed ? "caída" : evaluation.outcome == Outcome::Timeout ? "tiempo agotado" : "costo superlineal";
+            if (evaluation.outcome == Outcome::Superlinear) printScaling(evaluation.scaling);
+            std::cerr << "ERROR FUZZ - " << what << " con una entrada de " << reduced.size() << " bytes (de "
+                      << unit.size() << "), guardada repetida en '" << path << "'" << std::endl;
+            continue;
+        }
+        auto lowest = std::min_element(corpus.begin(), corpus.end(),
+                                       [](const Entry &a, const Entry &b) { return a.growth < b.growth; });
+        double growth = evaluation.scaling.timeGrowth();
+        if (corpus.size() < kMaxCorpus) corpus.push_back({unit, growth});
+        else if (growth > lowest->growth) *lowest = {unit, growth};
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    double worst = 0;
+    for (const Entry &entry : corpus) worst = std::max(worst, entry.growth);
+    std::cout << "INFO FUZZ - " << run << " mutaciones en " << seconds << " s, " << findings
+              << " hallazgos; mayor crecimiento de tiempo en el corpus x" << worst << " (lineal: x" << kScaleFactor
+              << ")\n";
+    return findings ? 1 : 0;
+}
+
+#endif // BM_LIBFUZZER
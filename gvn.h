@@ -0,0 +1,229 @@
+#ifndef GVN_H_
+#define GVN_H_
+
+#include <algorithm>
+#include <cstdint>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "ir.h"
+
+// Estadísticas de la numeración de valores
+struct GvnStats {
+    unsigned int redundantValues = 0;   // cálculos reemplazados por uno que los domina
+    unsigned int redundantLoads = 0;    // lecturas de globales o arreglos reutilizadas
+    unsigned int redundantChecks = 0;   // verificaciones de límites repetidas
+};
+
+// Numeración global de valores y eliminación de subexpresiones comunes.
+// Recorre el árbol de dominadores con una tabla de expresiones con ámbito: una
+// instrucción pura cuyo cálculo (operación, tipo, operandos, inmediato) ya
+// existe en un bloque dominante se reemplaza por ese valor. Las lecturas de
+// memoria llevan además la versión de la memoria que leen: StoreGlobal cambia
+// la versión de su global, Store la de los arreglos y Call la de todo. Un bloque
+// con un único predecesor hereda la memoria de él; en los puntos de unión (y en
+// los encabezados de bucle) la memoria empieza en una versión nueva.
+class GlobalValueNumbering {
+    struct Key {
+        IrOp op;
+        IrType type;
+        uint32_t a, b;
+        int64_t imm;
+        uint32_t memory;
+
+        bool operator==(const Key &other) const {
+            return op == other.op && type == other.type && a == other.a && b == other.b &&
+                   imm == other.imm && memory == other.memory;
+        }
+    };
+
+    struct KeyHash {
+        size_t operator()(const Key &k) const {
+            uint64_t h = static_cast<uint64_t>(k.op) | (static_cast<uint64_t>(k.type) << 8) |
+                         (static_cast<uint64_t>(k.memory) << 32);
+            h ^= (static_cast<uint64_t>(k.a) << 32 | k.b) * 0x9E3779B97F4A7C15ull;
+            h ^= static_cast<uint64_t>(k.imm) * 0xC2B2AE3D27D4EB4Full;
+            return static_cast<size_t>(h ^ (h >> 29));
+        }
+    };
+
+    // Estado de la memoria en un punto del recorrido
+    struct MemoryState {
+        uint32_t barrier = 0;   // versión mínima de cualquier global
+        uint32_t arrays = 0;    // versión de los arreglos
+    };
+
+    GvnStats stats;
+    IrEdit edit;
+    std::unordered_map<Key, uint32_t, KeyHash> table;
+    std::vector<std::pair<Key, uint32_t>> undo;               // (clave, valor anterior o kNoValue)
+    std::vector<uint32_t> globalVersion;                      // última escritura de cada global
+    std::vector<std::pair<uint32_t, uint32_t>> globalUndo;    // (global, versión anterior)
+    MemoryState memory;
+    uint32_t nextVersion = 0;
+
+    static bool isCommutative(IrOp op) {
+        return op == IrOp::Add || op == IrOp::Mul || op == IrOp::Eq || op == IrOp::Ne ||
+               op == IrOp::StrEq || op == IrOp::StrNe;
+    }
+
+    // Operaciones que pueden reutilizarse si el mismo cálculo ya se hizo antes.
+    // Div y Mod sólo abortan con divisor cero: si el anterior no abortó, éste tampoco.
+    static bool isNumberable(IrOp op) {
+        switch (op) {
+            case IrOp::Const: case IrOp::ConstStr:
+            case IrOp::Add: case IrOp::Sub: case IrOp::Mul: case IrOp::Div: case IrOp::Mod: case IrOp::Pow:
+            case IrOp::Neg: case IrOp::Not:
+            case IrOp::Eq: case IrOp::Ne: case IrOp::Lt: case IrOp::Le: case IrOp::Gt: case IrOp::Ge:
+            case IrOp::StrEq: case IrOp::StrNe: case IrOp::Concat: case IrOp::ToStr:
+            case IrOp::ArrayLen: case IrOp::BoundsCheck:
+            case IrOp::LoadGlobal: case IrOp::Load:
+                return true;
+            default:
+                return false;
+        }
+    }
+
+    uint32_t newVersion() {
+        return ++nextVersion;
+    }
+
+    uint32_t versionOfGlobal(int64_t global) const {
+        uint32_t version = globalVersion[static_cast<size_t>(global)];
+        return version > memory.barrier ? version : memory.barrier;
+    }
+
+    void setGlobalVersion(int64_t global, uint32_t version) {
+        globalUndo.push_back({static_cast<uint32_t>(global), globalVersion[static_cast<size_t>(global)]});
+        globalVersion[static_cast<size_t>(global)] = version;
+    }
+
+    void insert(const Key &key, uint32_t value) {
+        auto found = table.find(key);
+        undo.push_back({key, found == table.end() ? kNoValue : found->second});
+        table[key] = value;
+    }
+
+    Key keyOf(const IrInst &inst) {
+        Key key{inst.op, inst.type, kNoValue, kNoValue, inst.imm, 0};
+        const IrOpInfo &info = irOpInfo(inst.op);
+        if ((info.valueOperands & 1) && inst.a != kNoValue) key.a = edit.resolve(inst.a);
+        if ((info.valueOperands & 2) && inst.b != kNoValue) key.b = edit.resolve(inst.b);
+        if (isCommutative(inst.op) && key.b < key.a) std::swap(key.a, key.b);
+        if (inst.op == IrOp::LoadGlobal) key.memory = versionOfGlobal(inst.imm);
+        if (inst.op == IrOp::Load) key.memory = memory.arrays;
+        return key;
+    }
+
+    void visitBlock(uint32_t block) {
+        for (uint32_t id : edit.lists[block]) {
+            IrInst &inst = edit.pool[id];
+            switch (inst.op) {
+                case IrOp::StoreGlobal: {
+                    // La lectura siguiente de la global devuelve el valor escrito
+                    uint32_t version = newVersion();
+                    setGlobalVersion(inst.imm, version);
+                    uint32_t value = edit.resolve(inst.a);
+                    insert(Key{IrOp::LoadGlobal, edit.pool[value].type, kNoValue, kNoValue, inst.imm, version}, value);
+                    continue;
+                }
+                case IrOp::Store: {
+                    memory.arrays = newVersion();
+                    uint32_t value = edit.resolve(inst.c);
+                    Key key{IrOp::Load, edit.pool[value].type, edit.resolve(inst.a), edit.resolve(inst.b), 0, memory.arrays};
+                    insert(key, value);
+                    continue;
+                }
+                case IrOp::Call:
+                    memory.barrier = newVersion();
+                    memory.arrays = newVersion();
+                    continue;
+                default:
+                    break;
+            }
+            if (!isNumberable(inst.op)) continue;
+
+            Key key = keyOf(inst);
+            auto found = table.find(key);
+            if (found == table.end()) {
+                insert(key, id);
+                continue;
+            }
+            if (inst.op == IrOp::BoundsCheck) {
+                inst.op = IrOp::Nop;
+                stats.redundantChecks++;
+            } else {
+                edit.replace(id, found->second);
+                if (inst.op == IrOp::Load || inst.op == IrOp::LoadGlobal) stats.redundantLoads++;
+                else stats.redundantValues++;
+            }
+        }
+    }
+
+    void runFunction(IrFunction &fn) {
+        if (fn.blocks.empty()) return;
+        edit = IrEdit(fn);
+        table.clear();
+        undo.clear();
+        globalUndo.clear();
+        std::fill(globalVersion.begin(), globalVersion.end(), 0);
+        nextVersion = 0;
+        memory = MemoryState{};
+
+        // Recorrido en profundidad del árbol de dominadores; al volver de un
+        // bloque se deshacen sus entradas de la tabla y sus escrituras a globales
+        struct Frame {
+            uint32_t block, next;
+            size_t undoMark, globalUndoMark;
+            MemoryState exitMemory;
+        };
+        std::vector<Frame> stack;
+        auto enter = [&](uint32_t block) {
+            Frame frame{block, 0, undo.size(), globalUndo.size(), MemoryState{}};
+            const IrBlock &info = fn.blocks[block];
+            if (block != 0 && info.predCount != 1) {
+                memory.barrier = newVersion();
+                memory.arrays = newVersion();
+            }
+            visitBlock(block);
+            frame.exitMemory = memory;
+            stack.push_back(frame);
+        };
+        enter(0);
+        while (!stack.empty()) {
+            Frame &top = stack.back();
+            const IrBlock &info = fn.blocks[top.block];
+            if (top.next < info.domChildCount) {
+                uint32_t child = fn.domChildren[info.domChildBegin + top.next++];
+                memory = top.exitMemory;
+                enter(child);
+                continue;
+            }
+            while (undo.size() > top.undoMark) {
+                auto &[key, previous] = undo.back();
+                if (previous == kNoValue) table.erase(key);
+                else table[key] = previous;
+                undo.pop_back();
+            }
+            while (globalUndo.size() > top.globalUndoMark) {
+                globalVersion[globalUndo.back().first] = globalUndo.back().second;
+                globalUndo.pop_back();
+            }
+            stack.pop_back();
+        }
+        edit.commit(fn);
+    }
+
+public:
+    GvnStats run(IrModule &module) {
+        stats = GvnStats{};
+        globalVersion.assign(module.globals.size(), 0);
+        for (auto &fn : module.functions) runFunction(fn);
+        edit = IrEdit();
+        table.clear();
+        return stats;
+    }
+};
+
+#endif // GVN_H_
@@ -68,7 +68,7 @@ struct SourceLocation {
 // Estructura del token
 struct Token {
     SourceLocation location;
-    TokenKind kind;
+    TokenKind kind = TokenKind::Unknown;
     std::optional<std::string> value = std::nullopt;
 
     // token vacio
@@ -139,5 +139,26 @@ struct SourceFile {
     std::string buffer;
 };
 
+// Destino de los mensajes del compilador (tokens, traza, INFO y errores) en el
+// hilo actual. Por defecto la consola; el driver los junta en memoria por archivo
+// para imprimirlos en orden aunque los archivos se compilen en paralelo.
+struct CompilerStreams {
+    std::ostream *out = &std::cout;
+    std::ostream *err = &std::cerr;
+};
+
+inline CompilerStreams &compilerStreams() {
+    thread_local CompilerStreams streams;
+    return streams;
+}
+
+inline std::ostream &compilerOut() {
+    return *compilerStreams().out;
+}
+
+inline std::ostream &compilerErr() {
+    return *compilerStreams().err;
+}
+
 
 #endif // HELPER_H_
\ No newline at end of file
@@ -0,0 +1,380 @@
+#ifndef INLINE_H_
+#define INLINE_H_
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+#include "ir.h"
+
+// Estadísticas de la integración de funciones
+struct InlineStats {
+    unsigned int inlinedCalls = 0;      // llamadas reemplazadas por el cuerpo de la función
+    unsigned int tailCalls = 0;         // return f(...) convertidos en un salto al inicio
+    unsigned int accumulatedCalls = 0;  // return x + f(...) / x * f(...) con acumulador
+};
+
+// Integración de funciones y eliminación de recursión en cola sobre la IR.
+//  - Recursión en cola: en una función f, "return f(args)" pasa a ser un salto a
+//    un encabezado nuevo donde cada parámetro es un phi, así la recursión se
+//    convierte en un bucle y usa pila constante. "return x + f(args)" y
+//    "return x * f(args)" (asociativas y conmutativas módulo 2^64) se tratan
+//    igual con un acumulador que se combina con el valor de los demás return.
+//  - Integración: las llamadas a funciones pequeñas que no participan en un
+//    ciclo del grafo de llamadas se reemplazan por una copia de su cuerpo. El
+//    costo es el número de instrucciones de la función llamada; las funciones se
+//    procesan de abajo hacia arriba para integrar cuerpos ya optimizados.
+class Inliner {
+    static const uint32_t kMaxCalleeCost = 40;      // instrucciones de la función integrada
+    static const uint32_t kMaxCallerSize = 4000;    // tamaño máximo al que crece la función
+
+    InlineStats stats;
+    IrModule *module = nullptr;
+    std::vector<uint32_t> cost;
+    std::vector<char> recursive;
+
+    static void replacePred(IrEdit &edit, uint32_t block, uint32_t from, uint32_t to) {
+        std::vector<uint32_t> succ;
+        edit.successors(block, succ);
+        std::sort(succ.begin(), succ.end());
+        succ.erase(std::unique(succ.begin(), succ.end()), succ.end());
+        for (uint32_t s : succ) {
+            for (uint32_t &p : edit.preds[s]) if (p == from) p = to;
+        }
+    }
+
+    // Recursión en cola
+
+    struct TailSite {
+        uint32_t block;
+        uint32_t call;
+        uint32_t combine;   // suma o producto con la llamada (kNoValue si se devuelve tal cual)
+        uint32_t other;     // operando que se acumula
+    };
+
+    static bool isMovable(const IrInst &inst) {
+        const IrOpInfo &info = irOpInfo(inst.op);
+        return inst.op != IrOp::Phi && !info.sideEffects && !info.readsMemory;
+    }
+
+    // ¿Alguna instrucción entre call y end (sin contar except) usa el resultado de la llamada?
+    static bool usedBetween(const IrFunction &fn, uint32_t call, uint32_t end, uint32_t except) {
+        bool used = false;
+        for (uint32_t i = call + 1; i < end; ++i) {
+            if (i == except) continue;
+            fn.forEachOperand(fn.insts[i], [&](uint32_t v) { if (v == call) used = true; });
+        }
+        return used;
+    }
+
+    void eliminateTailCalls(uint32_t index) {
+        IrFunction &fn = module->functions[index];
+        std::vector<TailSite> sites;
+        IrOp accumulate = IrOp::Nop;
+        for (uint32_t b = 0; b < fn.blocks.size(); ++b) {
+            const IrBlock &block = fn.blocks[b];
+            const IrInst &ret = fn.insts[block.end - 1];
+            if (ret.op != IrOp::Return) continue;
+            // Entre la llamada y el return sólo puede haber cálculos puros que no leen memoria
+            uint32_t callId = block.end - 1;
+            while (callId > block.begin && isMovable(fn.insts[callId - 1])) --callId;
+            if (callId == block.begin) continue;
+            --callId;
+            const IrInst &call = fn.insts[callId];
+            if (call.op != IrOp::Call || call.imm != index) continue;
+            if (ret.a == callId || (ret.a == kNoValue && fn.returnType == IrType::Void)) {
+                if (!usedBetween(fn, callId, block.end - 1, kNoValue)) sites.push_back({b, callId, kNoValue, kNoValue});
+                continue;
+            }
+            if (fn.returnType != IrType::Int || ret.a == kNoValue || ret.a < callId) continue;
+            const IrInst &combine = fn.insts[ret.a];
+            if (combine.op != IrOp::Add && combine.op != IrOp::Mul) continue;
+            uint32_t other = combine.a == callId ? combine.b : combine.b == callId ? combine.a : kNoValue;
+            if (other == kNoValue || other == callId || usedBetween(fn, callId, block.end - 1, ret.a)) continue;
+            if (accumulate != IrOp::Nop && accumulate != combine.op) continue;
+            accumulate = combine.op;
+            sites.push_back({b, callId, ret.a, other});
+        }
+        if (sites.empty() || fn.blocks[0].predCount != 0) return;
+
+        IrEdit edit(fn);
+        const uint32_t numOriginal = static_cast<uint32_t>(edit.pool.size());
+
+        // El bloque 0 conserva los parámetros; el resto pasa al nuevo encabezado
+        uint32_t header = edit.newBlock();
+        std::vector<uint32_t> params(fn.paramTypes.size(), kNoValue);
+        std::vector<uint32_t> rest;
+        for (uint32_t id : edit.lists[0]) {
+            if (edit.pool[id].op == IrOp::Param) params[static_cast<size_t>(edit.pool[id].imm)] = id;
+            else rest.push_back(id);
+        }
+        edit.lists[header] = std::move(rest);
+        edit.lists[0].clear();
+        for (uint32_t id : params) if (id != kNoValue) edit.lists[0].push_back(id);
+        replacePred(edit, header, 0, header);
+        edit.append(0, makeIrInst(IrOp::Jump, IrType::Void, header));
+        edit.addEdge(0, header);
+
+        std::vector<uint32_t> phis(params.size(), kNoValue);
+        for (size_t k = 0; k < params.size(); ++k) {
+            if (params[k] != kNoValue) phis[k] = edit.addPhi(header, fn.paramTypes[k]);
+        }
+        // Los usos de los parámetros pasan a los phis (incluidos los argumentos de las llamadas en cola)
+        for (uint32_t id = 0; id < numOriginal; ++id) {
+            edit.forEachOperand(edit.pool[id], [&](uint32_t &v) {
+                if (v != kNoValue && edit.pool[v].op == IrOp::Param) v = phis[static_cast<size_t>(edit.pool[v].imm)];
+            });
+        }
+
+        uint32_t accumulator = kNoValue;
+        std::vector<uint32_t> accValues;
+        if (accumulate != IrOp::Nop) {
+            int64_t identity = accumulate == IrOp::Add ? 0 : 1;
+            uint32_t start = edit.insertBeforeTerminator(0, makeIrConst(identity));
+            accumulator = edit.addPhi(header, IrType::Int);
+            accValues.push_back(start);
+        }
+
+        std::vector<std::vector<uint32_t>> phiValues(params.size());
+        for (size_t k = 0; k < params.size(); ++k) phiValues[k].push_back(params[k]);
+        std::vector<char> isSite(edit.lists.size(), 0);
+        for (const TailSite &site : sites) {
+            const IrInst call = edit.pool[site.call];
+            uint32_t block = site.block == 0 ? header : site.block;
+            auto &list = edit.lists[block];
+            list.erase(std::remove_if(list.begin(), list.end(), [&](uint32_t id) {
+                return id == site.call || id == site.combine || irOpInfo(edit.pool[id].op).isTerminator;
+            }), list.end());
+            for (size_t k = 0; k < params.size(); ++k) phiValues[k].push_back(edit.operands[call.a + k]);
+            if (accumulator != kNoValue) {
+                uint32_t other = site.other;
+                if (other != kNoValue && edit.pool[other].op == IrOp::Param) other = phis[static_cast<size_t>(edit.pool[other].imm)];
+                accValues.push_back(other == kNoValue ? accumulator
+                    : edit.append(block, makeIrInst(accumulate, IrType::Int, accumulator, other)));
+                if (site.other != kNoValue) stats.accumulatedCalls++;
+                else stats.tailCalls++;
+            } else {
+                stats.tailCalls++;
+            }
+            edit.append(block, makeIrInst(IrOp::Jump, IrType::Void, header));
+            edit.addEdge(block, header);
+            isSite[block] = 1;
+        }
+        for (size_t k = 0; k < params.size(); ++k) {
+            if (phis[k] != kNoValue) edit.setOperands(phis[k], phiValues[k]);
+        }
+
+        // Los demás return combinan su valor con el acumulador
+        if (accumulator != kNoValue) {
+            edit.setOperands(accumulator, accValues);
+            for (uint32_t b = 0; b < edit.lists.size(); ++b) {
+                if (isSite[b] || edit.lists[b].empty()) continue;
+                uint32_t retId = edit.lists[b].back();
+                IrInst &ret = edit.pool[retId];
+                if (ret.op != IrOp::Return || ret.a == kNoValue) continue;
+                uint32_t value = ret.a;
+                uint32_t combined = edit.insertBeforeTerminator(b, makeIrInst(accumulate, IrType::Int, accumulator, value));
+                edit.pool[retId].a = combined;
+            }
+        }
+        edit.commit(fn);
+    }
+
+    // Integración
+
+    static uint32_t costOf(const IrFunction &fn) {
+        uint32_t total = 0;
+        for (const IrInst &inst : fn.insts) {
+            if (inst.op != IrOp::Param && inst.op != IrOp::Nop) total++;
+        }
+        return total;
+    }
+
+    // Funciones que pueden llegar a llamarse a sí mismas
+    void findRecursive() {
+        const size_t n = module->functions.size();
+        std::vector<std::vector<uint32_t>> callees(n);
+        for (size_t i = 0; i < n; ++i) {
+            for (const IrInst &inst : module->functions[i].insts) {
+                if (inst.op == IrOp::Call) callees[i].push_back(static_cast<uint32_t>(inst.imm));
+            }
+        }
+        recursive.assign(n, 0);
+        std::vector<char> seen;
+        std::vector<uint32_t> work;
+        for (size_t i = 0; i < n; ++i) {
+            seen.assign(n, 0);
+            work = callees[i];
+            while (!work.empty() && !recursive[i]) {
+                uint32_t f = work.back();
+                work.pop_back();
+                if (f == i) recursive[i] = 1;
+                if (seen[f]) continue;
+                seen[f] = 1;
+                work.insert(work.end(), callees[f].begin(), callees[f].end());
+            }
+        }
+    }
+
+    bool canInline(uint32_t caller, uint32_t callee) const {
+        const IrFunction &fn = module->functions[callee];
+        if (callee == caller || recursive[callee] || fn.blocks.empty() || fn.blocks[0].predCount != 0) return false;
+        if (cost[callee] > kMaxCalleeCost) return false;
+        for (uint32_t b = 0; b < fn.blocks.size(); ++b) {
+            if (fn.terminator(b).op == IrOp::Return) return true;
+        }
+        return false;
+    }
+
+    // Reemplaza la llamada (en la posición pos del bloque) por una copia de la función.
+    // Devuelve el bloque de continuación con las instrucciones que seguían a la llamada.
+    uint32_t inlineCall(IrEdit &edit, uint32_t block, size_t pos) {
+        uint32_t callId = edit.lists[block][pos];
+        const IrInst call = edit.pool[callId];
+        const IrFunction &callee = module->functions[static_cast<size_t>(call.imm)];
+        std::vector<uint32_t> args(edit.operands.begin() + call.a, edit.operands.begin() + call.a + call.b);
+
+        uint32_t cont = edit.newBlock();
+        {
+            auto &list = edit.lists[block];
+            edit.lists[cont].assign(list.begin() + pos + 1, list.end());
+            list.resize(pos);
+        }
+        replacePred(edit, cont, block, cont);
+
+        std::vector<uint32_t> blockMap(callee.blocks.size());
+        for (uint32_t b = 0; b < callee.blocks.size(); ++b) blockMap[b] = edit.newBlock();
+        std::vector<uint32_t> valueMap(callee.insts.size(), kNoValue);
+        std::vector<std::pair<uint32_t, uint32_t>> copies;      // (id nuevo, instrucción original)
+        std::vector<std::pair<uint32_t, uint32_t>> returns;     // (bloque nuevo, valor original)
+
+        for (uint32_t b = 0; b < callee.blocks.size(); ++b) {
+            uint32_t target = blockMap[b];
+            for (uint32_t i = callee.blocks[b].begin; i < callee.blocks[b].end; ++i) {
+                const IrInst &inst = callee.insts[i];
+                if (inst.op == IrOp::Param) {
+                    valueMap[i] = args[static_cast<size_t>(inst.imm)];
+                } else if (inst.op == IrOp::Return) {
+                    returns.push_back({target, inst.a});
+                    edit.append(target, makeIrInst(IrOp::Jump, IrType::Void, cont));
+                    edit.addEdge(target, cont);
+                } else {
+                    valueMap[i] = edit.append(target, inst);
+                    copies.push_back({valueMap[i], i});
+                }
+            }
+            const uint32_t *preds = callee.predsOf(b);
+            for (uint32_t k = 0; k < callee.blocks[b].predCount; ++k) edit.addEdge(blockMap[preds[k]], target);
+        }
+
+        auto mapValue = [&](uint32_t v) { return v == kNoValue ? kNoValue : valueMap[v]; };
+        for (const auto &[id, original] : copies) {
+            const IrInst &inst = callee.insts[original];
+            const IrOpInfo &info = irOpInfo(inst.op);
+            if (info.usesPool) {
+                std::vector<uint32_t> values;
+                for (uint32_t k = 0; k < inst.b; ++k) values.push_back(mapValue(callee.operands[inst.a + k]));
+                edit.setOperands(id, values);
+                continue;
+            }
+            IrInst &copy = edit.pool[id];
+            if (info.valueOperands & 1) copy.a = mapValue(inst.a);
+            if (info.valueOperands & 2) copy.b = mapValue(inst.b);
+            if (info.valueOperands & 4) copy.c = mapValue(inst.c);
+            if (inst.op == IrOp::Jump) copy.a = blockMap[inst.a];
+            if (inst.op == IrOp::Branch) {
+                copy.b = blockMap[inst.b];
+                copy.c = blockMap[inst.c];
+            }
+        }
+
+        edit.append(block, makeIrInst(IrOp::Jump, IrType::Void, blockMap[0]));
+        edit.addEdge(block, blockMap[0]);
+
+        if (call.type != IrType::Void) {
+            uint32_t result;
+            if (returns.size() == 1) {
+                result = mapValue(returns[0].second);
+            } else {
+                result = edit.addPhi(cont, call.type);
+                std::vector<uint32_t> values;
+                for (uint32_t p : edit.preds[cont]) {
+                    for (const auto &[from, value] : returns) {
+                        if (from == p) values.push_back(mapValue(value));
+                    }
+                }
+                edit.setOperands(result, values);
+            }
+            edit.replace(callId, result);
+        }
+        stats.inlinedCalls++;
+        return cont;
+    }
+
+    void inlineInto(uint32_t caller) {
+        IrFunction &fn = module->functions[caller];
+        if (fn.blocks.empty()) return;
+        IrEdit edit(fn);
+        bool changed = false;
+        std::vector<uint32_t> work;
+        for (uint32_t b = static_cast<uint32_t>(edit.lists.size()); b-- > 0;) work.push_back(b);
+        while (!work.empty() && edit.pool.size() < kMaxCallerSize) {
+            uint32_t block = work.back();
+            work.pop_back();
+            const auto &list = edit.lists[block];
+            for (size_t pos = 0; pos < list.size(); ++pos) {
+                const IrInst &inst = edit.pool[list[pos]];
+                if (inst.op != IrOp::Call || !canInline(caller, static_cast<uint32_t>(inst.imm))) continue;
+                work.push_back(inlineCall(edit, block, pos));
+                changed = true;
+                break;
+            }
+        }
+        if (!changed) return;
+        edit.commit(fn);
+        cost[caller] = costOf(fn);
+    }
+
+    // Post-orden del grafo de llamadas: las funciones llamadas antes que quien las llama
+    void postorder(uint32_t f, std::vector<char> &seen, std::vector<uint32_t> &order) const {
+        std::vector<std::pair<uint32_t, uint32_t>> stack{{f, 0}};
+        seen[f] = 1;
+        while (!stack.empty()) {
+            auto &[fnIndex, next] = stack.back();
+            const IrFunction &fn = module->functions[fnIndex];
+            bool pushed = false;
+            while (next < fn.insts.size()) {
+                const IrInst &inst = fn.insts[next++];
+                if (inst.op != IrOp::Call || seen[static_cast<size_t>(inst.imm)]) continue;
+                seen[static_cast<size_t>(inst.imm)] = 1;
+                stack.push_back({static_cast<uint32_t>(inst.imm), 0});
+                pushed = true;
+                break;
+            }
+            if (!pushed) {
+                order.push_back(stack.back().first);
+                stack.pop_back();
+            }
+        }
+    }
+
+public:
+    InlineStats run(IrModule &target) {
+        stats = InlineStats{};
+        module = &target;
+        const uint32_t n = static_cast<uint32_t>(target.functions.size());
+        for (uint32_t i = 0; i < n; ++i) eliminateTailCalls(i);
+
+        findRecursive();
+        cost.resize(n);
+        for (uint32_t i = 0; i < n; ++i) cost[i] = costOf(target.functions[i]);
+        std::vector<char> seen(n, 0);
+        std::vector<uint32_t> order;
+        for (uint32_t i = 0; i < n; ++i) if (!seen[i]) postorder(i, seen, order);
+        for (uint32_t f : order) inlineInto(f);
+        module = nullptr;
+        return stats;
+    }
+};
+
+#endif // INLINE_H_
@@ -0,0 +1,286 @@
+#ifndef INTERPRETER_H_
+#define INTERPRETER_H_
+
+#include <algorithm>
+#include <cstdint>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "ast.h"
+#include "runtime.h"
+
+// Intérprete directo sobre el AST anotado. Es deliberadamente simple (entornos
+// por nombre, valores con std::string): sirve como referencia de semántica y
+// como línea base para medir la máquina virtual.
+class TreeWalker {
+    struct Value {
+        int64_t i = 0;
+        std::string s;
+        std::shared_ptr<std::vector<Value>> array;
+    };
+
+    using Scope = std::unordered_map<std::string, Value>;
+
+    const Program &program;
+    OutputBuffer &out;
+    Scope globals;
+    std::vector<std::vector<Scope>> callStack;  // por llamada: pila de ámbitos
+    bool returning = false;
+    Value returnValue;
+
+    static const size_t kMaxDepth = 4000;  // la recursión usa la pila nativa
+
+    Value *lookup(const std::string &name) {
+        auto &scopes = callStack.back();
+        for (auto it = scopes.rbegin(); it != scopes.rend(); ++it) {
+            auto found = it->find(name);
+            if (found != it->end()) return &found->second;
+        }
+        auto found = globals.find(name);
+        return found != globals.end() ? &found->second : nullptr;
+    }
+
+    static std::string toString(const Value &v, const Type &type) {
+        if (type.isScalar(TokenKind::KwString)) return v.s;
+        if (type.isScalar(TokenKind::KwBoolean)) return v.i ? "true" : "false";
+        if (type.isScalar(TokenKind::KwChar)) return std::string(1, static_cast<char>(v.i));
+        if (type.isArray()) return "<array>";
+        return std::to_string(v.i);
+    }
+
+    Value defaultValue(const Type &type) {
+        Value v;
+        if (type.isArray()) {
+            int64_t length = 1;
+            for (int64_t d : type.dims) length *= d;
+            Type element;
+            element.base = type.base;
+            v.array = std::make_shared<std::vector<Value>>(static_cast<size_t>(length), defaultValue(element));
+        }
+        return v;
+    }
+
+    // Elemento de arreglo con la misma verificación de límites que la IR
+    Value &element(const Expr &e) {
+        std::vector<const Expr *> indices;
+        const Expr *root = &e;
+        while (root->kind == ExprKind::Index) {
+            indices.push_back(root->args[1].get());
+            root = root->args[0].get();
+        }
+        std::reverse(indices.begin(), indices.end());
+        Value array = eval(*root);
+        int64_t linear = eval(*indices[0]).i;
+        for (size_t k = 1; k < indices.size(); ++k) {
+            int64_t index = eval(*indices[k]).i;
+            int64_t dim = root->type.dims[k];
+            if (index < 0 || index >= dim) throw RuntimeError("array index " + std::to_string(index) + " out of bounds");
+            linear = wrapAdd(wrapMul(linear, dim), index);
+        }
+        if (linear < 0 || linear >= static_cast<int64_t>(array.array->size())) {
+            throw RuntimeError("array index " + std::to_string(linear) + " out of bounds");
+        }
+        return (*array.array)[static_cast<size_t>(linear)];
+    }
+
+    Value evalBinary(const Expr &e) {
+        Value result;
+        if (e.op == TokenKind::LogicalAnd) {
+            result.i = eval(*e.args[0]).i && eval(*e.args[1]).i;
+            return result;
+        }
+        if (e.op == TokenKind::LogicalOr) {
+            result.i = eval(*e.args[0]).i || eval(*e.args[1]).i;
+            return result;
+        }
+        Value lhs = eval(*e.args[0]);
+        Value rhs = eval(*e.args[1]);
+        const Type &lt = e.args[0]->type;
+        const Type &rt = e.args[1]->type;
+        if (e.op == TokenKind::Addition && e.type.isScalar(TokenKind::KwString)) {
+            result.s = toString(lhs, lt) + toString(rhs, rt);
+            return result;
+        }
+        if (lt.isScalar(TokenKind::KwString)) {
+            bool equal = lhs.s == rhs.s;
+            result.i = e.op == TokenKind::isEqual ? equal : !equal;
+            return result;
+        }
+        switch (e.op) {
+            case TokenKind::Addition: result.i = wrapAdd(lhs.i, rhs.i); break;
+            case TokenKind::Subtraction: result.i = wrapSub(lhs.i, rhs.i); break;
+            case TokenKind::Multiplication: result.i = wrapMul(lhs.i, rhs.i); break;
+            case TokenKind::Division: result.i = checkedDiv(lhs.i, rhs.i); break;
+            case TokenKind::Modulus: result.i = checkedMod(lhs.i, rhs.i); break;
+            case TokenKind::Exponentiation: result.i = wrapPow(lhs.i, rhs.i); break;
+            case TokenKind::LessThan: result.i = lhs.i < rhs.i; break;
+            case TokenKind::LessThanOrEqual: result.i = lhs.i <= rhs.i; break;
+            case TokenKind::GreaterThan: result.i = lhs.i > rhs.i; break;
+            case TokenKind::GreaterThanOrEqual: result.i = lhs.i >= rhs.i; break;
+            case TokenKind::isEqual: result.i = lhs.i == rhs.i; break;
+            case TokenKind::NotEqual: result.i = lhs.i != rhs.i; break;
+            default: break;
+        }
+        return result;
+    }
+
+    Value call(const Expr &e) {
+        const Function &fn = program.functions[e.symbol];
+        std::vector<Value> args;
+        for (const auto &arg : e.args) args.push_back(eval(*arg));
+        if (callStack.size() >= kMaxDepth) throw RuntimeError("stack overflow");
+        callStack.emplace_back(1);
+        for (size_t p = 0; p < fn.params.size(); ++p) callStack.back().back()[fn.params[p].name] = args[p];
+        returnValue = Value();
+        execBlock(fn.body);
+        returning = false;
+        callStack.pop_back();
+        return std::move(returnValue);
+    }
+
+    Value eval(const Expr &e) {
+        Value result;
+        switch (e.kind) {
+            case ExprKind::IntLit:
+            case ExprKind::BoolLit:
+            case ExprKind::CharLit:
+                result.i = e.intValue;
+                return result;
+            case ExprKind::StringLit:
+                result.s = e.name;
+                return result;
+            case ExprKind::Var:
+                return *lookup(e.name);
+            case ExprKind::Assign: {
+                Value value;
+                if (e.args[0]->kind == ExprKind::Index) {
+                    Value &target = element(*e.args[0]);
+                    value = eval(*e.args[1]);
+                    target = value;
+                } else {
+                    value = eval(*e.args[1]);
+                    *lookup(e.args[0]->name) = value;
+                }
+                return value;
+            }
+            case ExprKind::Binary:
+                return evalBinary(e);
+            case ExprKind::Unary:
+                result = eval(*e.args[0]);
+                result.i = e.op == TokenKind::LogicalNot ? !result.i : wrapSub(0, result.i);
+                return result;
+            case ExprKind::Postfix: {
+                Value &target = e.args[0]->kind == ExprKind::Index ? element(*e.args[0]) : *lookup(e.args[0]->name);
+                result = target;
+                target.i = e.op == TokenKind::PostfixIncrement ? wrapAdd(target.i, 1) : wrapSub(target.i, 1);
+                return result;
+            }
+            case ExprKind::Call:
+                return call(e);
+            case ExprKind::Index:
+                return element(e);
+        }
+        return result;
+    }
+
+    void execBlock(const std::vector<StmtPtr> &stmts) {
+        for (const auto &s : stmts) {
+            if (returning) return;
+            if (s) exec(*s);
+        }
+    }
+
+    void execScoped(const std::vector<StmtPtr> &stmts) {
+        callStack.back().emplace_back();
+        execBlock(stmts);
+        callStack.back().pop_back();
+    }
+
+    void exec(const Stmt &s) {
+        switch (s.kind) {
+            case StmtKind::VarDecl: {
+                const Type &type = program.symbols[s.symbol].type;
+                Value value = s.expr ? eval(*s.expr) : defaultValue(type);
+                callStack.back().back()[s.name] = value;
+                break;
+            }
+            case StmtKind::Expr:
+                if (s.expr) eval(*s.expr);
+                break;
+            case StmtKind::Print: {
+                // Las concatenaciones se escriben por partes, como en lowering.h
+                std::vector<const Expr *> parts;
+                std::vector<Value> values;
+                for (const auto &e : s.exprs) {
+                    parts.clear();
+                    values.clear();
+                    concatParts(*e, parts);
+                    for (const Expr *part : parts) values.push_back(eval(*part));
+                    for (size_t i = 0; i < parts.size(); ++i) {
+                        std::string text = toString(values[i], parts[i]->type);
+                        out.write(text.data(), text.size());
+                    }
+                }
+                out.newline();
+                break;
+            }
+            case StmtKind::Return:
+                returnValue = s.expr ? eval(*s.expr) : Value();
+                returning = true;
+                break;
+            case StmtKind::Block:
+                execScoped(s.body);
+                break;
+            case StmtKind::If:
+                if (eval(*s.expr).i) execScoped(s.body);
+                else execScoped(s.elseBody);
+                break;
+            case StmtKind::While:
+                while (!returning && eval(*s.expr).i) execScoped(s.body);
+                break;
+            case StmtKind::For:
+                callStack.back().emplace_back();
+                if (s.init) exec(*s.init);
+                while (!returning && (!s.expr || eval(*s.expr).i)) {
+                    execScoped(s.body);
+                    if (returning) break;
+                    if (s.step) eval(*s.step);
+                }
+                callStack.back().pop_back();
+                break;
+        }
+    }
+
+public:
+    TreeWalker(const Program &program, OutputBuffer &out) : program(program), out(out) {}
+
+    // Inicializa las globales y ejecuta main; false si hubo un error de ejecución
+    bool run() {
+        callStack.assign(1, std::vector<Scope>(1));
+        try {
+            for (const auto &g : program.globals) {
+                if (!g) continue;
+                const Type &type = program.symbols[g->symbol].type;
+                globals[g->name] = g->expr ? eval(*g->expr) : defaultValue(type);
+            }
+            for (const auto &fn : program.functions) {
+                if (fn.name != "main") continue;
+                callStack.emplace_back(1);
+                execBlock(fn.body);
+                returning = false;
+                callStack.pop_back();
+            }
+        } catch (const RuntimeError &error) {
+            out.flush();
+            compilerErr() << "Runtime Error: " << error.what() << std::endl;
+            return false;
+        }
+        out.flush();
+        return true;
+    }
+};
+
+#endif // INTERPRETER_H_
@@ -0,0 +1,643 @@
+#ifndef IR_H_
+#define IR_H_
+
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Representación intermedia de tres direcciones en forma SSA.
+//
+// Cada función guarda todas sus instrucciones en un único arreglo contiguo:
+// los bloques básicos son rangos [begin, end) de ese arreglo (phis primero,
+// terminador al final) y el número de valor de una instrucción es su índice.
+// Los operandos variables (phi, call) y las listas de predecesores viven en
+// arreglos planos compartidos, así que no hay nodos en el heap por instrucción.
+// Para modificar una función se usa IrEdit, que al confirmar vuelve a
+// compactar todo en tiempo lineal y recalcula el árbol de dominadores.
+
+const uint32_t kNoValue = UINT32_MAX;
+const uint32_t kNoBlock = UINT32_MAX;
+
+enum class IrType : uint8_t { Void, Int, Bool, Char, Str, Array };
+
+enum class IrOp : uint8_t {
+    Nop,
+    Const,          // imm
+    ConstStr,       // imm = índice en IrModule::strings
+    Param,          // imm = índice del parámetro
+    Phi,            // operandos [a, a+b) alineados con los predecesores del bloque
+    Add, Sub, Mul, Div, Mod, Pow,
+    Neg, Not,
+    Eq, Ne, Lt, Le, Gt, Ge,
+    StrEq, StrNe,
+    Concat,         // a + b, ambos cadenas
+    ToStr,          // a convertido a cadena; imm = IrType de a
+    LoadGlobal,     // imm = índice de la global
+    StoreGlobal,    // a = valor, imm = índice de la global
+    NewArray,       // a = longitud, imm = IrType del elemento
+    ArrayLen,       // a = arreglo
+    BoundsCheck,    // a = índice, b = longitud; aborta si está fuera de rango
+    Load,           // a = arreglo, b = índice
+    Store,          // a = arreglo, b = índice, c = valor
+    Call,           // imm = función, argumentos [a, a+b)
+    Print,          // a = valor, imm = IrType de a
+    PrintLn,
+    Jump,           // a = bloque destino
+    Branch,         // a = condición, b = bloque si true, c = bloque si false
+    Return          // a = valor o kNoValue
+};
+
+// Propiedades de cada operación
+struct IrOpInfo {
+    const char *name;
+    uint8_t valueOperands;  // bits 0..2: a, b, c son valores
+    bool usesPool;          // operandos en IrFunction::operands
+    bool sideEffects;       // no puede eliminarse aunque no tenga usos
+    bool readsMemory;       // depende de globales o arreglos
+    bool isTerminator;
+};
+
+inline const IrOpInfo &irOpInfo(IrOp op) {
+    static const IrOpInfo table[] = {
+        {"nop", 0, false, false, false, false},
+        {"const", 0, false, false, false, false},
+        {"conststr", 0, false, false, false, false},
+        {"param", 0, false, false, false, false},
+        {"phi", 0, true, false, false, false},
+        {"add", 3, false, false, false, false},
+        {"sub", 3, false, false, false, false},
+        {"mul", 3, false, false, false, false},
+        {"div", 3, false, true, false, false},
+        {"mod", 3, false, true, false, false},
+        {"pow", 3, false, false, false, false},
+        {"neg", 1, false, false, false, false},
+        {"not", 1, false, false, false, false},
+        {"eq", 3, false, false, false, false},
+        {"ne", 3, false, false, false, false},
+        {"lt", 3, false, false, false, false},
+        {"le", 3, false, false, false, false},
+        {"gt", 3, false, false, false, false},
+        {"ge", 3, false, false, false, false},
+        {"streq", 3, false, false, false, false},
+        {"strne", 3, false, false, false, false},
+        {"concat", 3, false, false, false, false},
+        {"tostr", 1, false, false, false, false},
+        {"loadglobal", 0, false, false, true, false},
+        {"storeglobal", 1, false, true, false, false},
+        {"newarray", 1, false, true, false, false},
+        {"arraylen", 1, false, false, false, false},
+        {"boundscheck", 3, false, true, false, false},
+        {"load", 3, false, false, true, false},
+        {"store", 7, false, true, false, false},
+        {"call", 0, true, true, true, false},
+        {"print", 1, false, true, false, false},
+        {"println", 0, false, true, false, false},
+        {"jump", 0, false, true, false, true},
+        {"branch", 1, false, true, false, true},
+        {"ret", 1, false, true, false, true},
+    };
+    return table[static_cast<int>(op)];
+}
+
+inline const char *irTypeName(IrType type) {
+    switch (type) {
+        case IrType::Int: return "int";
+        case IrType::Bool: return "bool";
+        case IrType::Char: return "char";
+        case IrType::Str: return "string";
+        case IrType::Array: return "array";
+        default: return "void";
+    }
+}
+
+// Instrucción: 24 bytes, sin punteros
+struct IrInst {
+    IrOp op = IrOp::Nop;
+    IrType type = IrType::Void;
+    uint32_t a = kNoValue;
+    uint32_t b = kNoValue;
+    uint32_t c = kNoValue;
+    int64_t imm = 0;
+};
+
+// Instrucción nueva, para las pasadas que agregan código a la IR
+inline IrInst makeIrInst(IrOp op, IrType type, uint32_t a = kNoValue, uint32_t b = kNoValue, uint32_t c = kNoValue,
+                         int64_t imm = 0) {
+    IrInst inst;
+    inst.op = op;
+    inst.type = type;
+    inst.a = a;
+    inst.b = b;
+    inst.c = c;
+    inst.imm = imm;
+    return inst;
+}
+
+inline IrInst makeIrConst(int64_t value) {
+    return makeIrInst(IrOp::Const, IrType::Int, kNoValue, kNoValue, kNoValue, value);
+}
+
+struct IrBlock {
+    uint32_t begin = 0, end = 0;            // instrucciones [begin, end)
+    uint32_t predBegin = 0, predCount = 0;  // predecesores en IrFunction::preds
+    uint32_t idom = kNoBlock;               // dominador inmediato (kNoBlock en la entrada)
+    uint32_t domChildBegin = 0, domChildCount = 0;
+    uint32_t domPre = 0, domPost = 0;       // numeración del árbol para consultas O(1)
+};
+
+// Bucle contado que el backend nativo puede ejecutar de a varios elementos antes
+// de la versión escalar (lo marca LoopVectorizer, en vectorize.h)
+struct IrVectorLoop {
+    uint32_t preheader = kNoBlock, header = kNoBlock, body = kNoBlock;
+    uint32_t counter = kNoValue;            // phi de paso 1 con counter < bound
+    uint32_t bound = kNoValue;
+    std::vector<uint32_t> reductions;       // phis acumuladores: phi + valor del cuerpo
+    std::vector<uint32_t> inductions;       // phis lineales: phi + paso invariante
+};
+
+struct IrFunction {
+    std::string name;
+    IrType returnType = IrType::Void;
+    std::vector<IrType> paramTypes;
+    std::vector<IrInst> insts;
+    std::vector<uint32_t> operands;
+    std::vector<IrBlock> blocks;            // en orden inverso de post-orden; 0 es la entrada
+    std::vector<uint32_t> preds;
+    std::vector<uint32_t> domChildren;
+    std::vector<IrVectorLoop> vectorLoops;
+
+    const IrInst &terminator(uint32_t block) const {
+        return insts[blocks[block].end - 1];
+    }
+
+    // Sucesores del bloque según su terminador (hasta dos)
+    uint32_t successors(uint32_t block, uint32_t out[2]) const {
+        const IrInst &t = terminator(block);
+        if (t.op == IrOp::Jump) {
+            out[0] = t.a;
+            return 1;
+        }
+        if (t.op == IrOp::Branch) {
+            out[0] = t.b;
+            out[1] = t.c;
+            return 2;
+        }
+        return 0;
+    }
+
+    const uint32_t *predsOf(uint32_t block) const {
+        return preds.data() + blocks[block].predBegin;
+    }
+
+    bool dominates(uint32_t a, uint32_t b) const {
+        return blocks[a].domPre <= blocks[b].domPre && blocks[b].domPost <= blocks[a].domPost;
+    }
+
+    // Bloque que contiene una instrucción (búsqueda binaria sobre los rangos)
+    uint32_t blockOf(uint32_t value) const {
+        uint32_t lo = 0, hi = static_cast<uint32_t>(blocks.size());
+        while (hi - lo > 1) {
+            uint32_t mid = (lo + hi) / 2;
+            if (blocks[mid].begin <= value) lo = mid; else hi = mid;
+        }
+        return lo;
+    }
+
+    // Llama a fn(uint32_t &operand) para cada operando que es un valor
+    template <typename F>
+    void forEachOperand(IrInst &inst, F fn) {
+        const IrOpInfo &info = irOpInfo(inst.op);
+        if (info.usesPool) {
+            for (uint32_t i = 0; i < inst.b; ++i) fn(operands[inst.a + i]);
+            return;
+        }
+        if ((info.valueOperands & 1) && inst.a != kNoValue) fn(inst.a);
+        if ((info.valueOperands & 2) && inst.b != kNoValue) fn(inst.b);
+        if ((info.valueOperands & 4) && inst.c != kNoValue) fn(inst.c);
+    }
+
+    template <typename F>
+    void forEachOperand(const IrInst &inst, F fn) const {
+        const IrOpInfo &info = irOpInfo(inst.op);
+        if (info.usesPool) {
+            for (uint32_t i = 0; i < inst.b; ++i) fn(operands[inst.a + i]);
+            return;
+        }
+        if ((info.valueOperands & 1) && inst.a != kNoValue) fn(inst.a);
+        if ((info.valueOperands & 2) && inst.b != kNoValue) fn(inst.b);
+        if ((info.valueOperands & 4) && inst.c != kNoValue) fn(inst.c);
+    }
+};
+
+struct IrGlobal {
+    std::string name;
+    IrType type = IrType::Int;
+};
+
+struct IrModule {
+    std::vector<IrFunction> functions;  // mismos índices que Program::functions, más $init al final
+    std::vector<IrGlobal> globals;
+    std::vector<std::string> strings;
+    int initFunction = -1;              // inicializa las globales
+    int mainFunction = -1;
+
+    uint32_t internString(const std::string &text) {
+        auto found = stringIndex.find(text);
+        if (found != stringIndex.end()) return found->second;
+        uint32_t id = static_cast<uint32_t>(strings.size());
+        strings.push_back(text);
+        stringIndex.emplace(text, id);
+        return id;
+    }
+
+    int findFunction(const std::string &name) const {
+        for (size_t i = 0; i < functions.size(); ++i) {
+            if (functions[i].name == name) return static_cast<int>(i);
+        }
+        return -1;
+    }
+
+private:
+    std::unordered_map<std::string, uint32_t> stringIndex;
+};
+
+// Forma editable de una función: un pool de instrucciones y una lista de ids por
+// bloque. Los valores eliminados se marcan con Nop o se redirigen con replace().
+class IrEdit {
+public:
+    std::vector<IrInst> pool;
+    std::vector<uint32_t> operands;
+    std::vector<std::vector<uint32_t>> lists;   // ids por bloque (phis al inicio)
+    std::vector<std::vector<uint32_t>> preds;   // predecesores por bloque
+    std::vector<uint32_t> replacement;          // id -> id que lo reemplaza
+
+    IrEdit() = default;
+
+    // Abre una función compacta para edición
+    explicit IrEdit(const IrFunction &fn) {
+        pool = fn.insts;
+        operands = fn.operands;
+        replacement.resize(pool.size());
+        for (uint32_t i = 0; i < pool.size(); ++i) replacement[i] = i;
+        lists.resize(fn.blocks.size());
+        preds.resize(fn.blocks.size());
+        for (uint32_t b = 0; b < fn.blocks.size(); ++b) {
+            for (uint32_t i = fn.blocks[b].begin; i < fn.blocks[b].end; ++i) lists[b].push_back(i);
+            preds[b].assign(fn.predsOf(b), fn.predsOf(b) + fn.blocks[b].predCount);
+        }
+    }
+
+    uint32_t newBlock() {
+        lists.emplace_back();
+        preds.emplace_back();
+        return static_cast<uint32_t>(lists.size() - 1);
+    }
+
+    uint32_t add(const IrInst &inst) {
+        pool.push_back(inst);
+        replacement.push_back(static_cast<uint32_t>(pool.size() - 1));
+        return static_cast<uint32_t>(pool.size() - 1);
+    }
+
+    uint32_t append(uint32_t block, const IrInst &inst) {
+        uint32_t id = add(inst);
+        lists[block].push_back(id);
+        return id;
+    }
+
+    // Inserta antes del terminador del bloque
+    uint32_t insertBeforeTerminator(uint32_t block, const IrInst &inst) {
+        uint32_t id = add(inst);
+        auto &list = lists[block];
+        auto pos = list.end();
+        if (!list.empty() && irOpInfo(pool[list.back()].op).isTerminator) --pos;
+        list.insert(pos, id);
+        return id;
+    }
+
+    uint32_t addPhi(uint32_t block, IrType type) {
+        IrInst phi;
+        phi.op = IrOp::Phi;
+        phi.type = type;
+        phi.a = static_cast<uint32_t>(operands.size());
+        phi.b = 0;
+        uint32_t id = add(phi);
+        lists[block].insert(lists[block].begin(), id);
+        return id;
+    }
+
+    // Guarda una lista de operandos en el pool y la asigna a la instrucción (phi o call)
+    void setOperands(uint32_t id, const std::vector<uint32_t> &values) {
+        pool[id].a = static_cast<uint32_t>(operands.size());
+        pool[id].b = static_cast<uint32_t>(values.size());
+        operands.insert(operands.end(), values.begin(), values.end());
+    }
+
+    // Llama a fn(uint32_t &operand) para cada operando que es un valor
+    template <typename F>
+    void forEachOperand(IrInst &inst, F fn) {
+        const IrOpInfo &info = irOpInfo(inst.op);
+        if (info.usesPool) {
+            for (uint32_t i = 0; i < inst.b; ++i) fn(operands[inst.a + i]);
+            return;
+        }
+        if ((info.valueOperands & 1) && inst.a != kNoValue) fn(inst.a);
+        if ((info.valueOperands & 2) && inst.b != kNoValue) fn(inst.b);
+        if ((info.valueOperands & 4) && inst.c != kNoValue) fn(inst.c);
+    }
+
+    void addEdge(uint32_t from, uint32_t to) {
+        preds[to].push_back(from);
+    }
+
+    uint32_t resolve(uint32_t id) {
+        while (replacement[id] != id) {
+            replacement[id] = replacement[replacement[id]];
+            id = replacement[id];
+        }
+        return id;
+    }
+
+    void replace(uint32_t id, uint32_t with) {
+        replacement[resolve(id)] = resolve(with);
+    }
+
+    void successors(uint32_t block, std::vector<uint32_t> &out) const {
+        out.clear();
+        if (lists[block].empty()) return;
+        const IrInst &t = pool[lists[block].back()];
+        if (t.op == IrOp::Jump) out.push_back(t.a);
+        if (t.op == IrOp::Branch) {
+            out.push_back(t.b);
+            out.push_back(t.c);
+        }
+    }
+
+    bool isTerminated(uint32_t block) const {
+        return !lists[block].empty() && irOpInfo(pool[lists[block].back()].op).isTerminator;
+    }
+
+    // Compacta la función: elimina bloques inalcanzables, Nops y phis triviales,
+    // ordena los bloques en post-orden inverso, renumera los valores y calcula
+    // predecesores y dominadores.
+    void commit(IrFunction &fn) {
+        const uint32_t numBlocks = static_cast<uint32_t>(lists.size());
+
+        // Post-orden inverso desde la entrada (DFS iterativo)
+        std::vector<uint32_t> postorder;
+        std::vector<uint8_t> state(numBlocks, 0);
+        std::vector<std::pair<uint32_t, uint32_t>> stack{{0, 0}};
+        std::vector<uint32_t> succ;
+        state[0] = 1;
+        while (!stack.empty()) {
+            auto &[block, next] = stack.back();
+            successors(block, succ);
+            if (next < succ.size()) {
+                uint32_t s = succ[next++];
+                if (!state[s]) {
+                    state[s] = 1;
+                    stack.push_back({s, 0});
+                }
+            } else {
+                postorder.push_back(block);
+                stack.pop_back();
+            }
+        }
+        std::vector<uint32_t> order(postorder.rbegin(), postorder.rend());
+        std::vector<uint32_t> newBlock(numBlocks, kNoBlock);
+        for (uint32_t i = 0; i < order.size(); ++i) newBlock[order[i]] = i;
+
+        // Nuevos predecesores en orden determinista
+        std::vector<std::vector<uint32_t>> newPreds(order.size());
+        for (uint32_t i = 0; i < order.size(); ++i) {
+            successors(order[i], succ);
+            for (uint32_t s : succ) newPreds[newBlock[s]].push_back(i);
+        }
+
+        // Realinear operandos de phis con los nuevos predecesores
+        for (uint32_t i = 0; i < order.size(); ++i) {
+            uint32_t old = order[i];
+            for (uint32_t id : lists[old]) {
+                if (pool[id].op != IrOp::Phi) continue;
+                std::vector<uint32_t> aligned;
+                aligned.reserve(newPreds[i].size());
+                for (uint32_t p : newPreds[i]) {
+                    uint32_t value = kNoValue;
+                    for (uint32_t k = 0; k < preds[old].size() && k < pool[id].b; ++k) {
+                        if (newBlock[preds[old][k]] == p) {
+                            value = operands[pool[id].a + k];
+                            break;
+                        }
+                    }
+                    aligned.push_back(value);
+                }
+                setOperands(id, aligned);
+            }
+        }
+
+        // Eliminar phis triviales hasta un punto fijo
+        bool changed = true;
+        while (changed) {
+            changed = false;
+            for (uint32_t old : order) {
+                for (uint32_t id : lists[old]) {
+                    if (pool[id].op != IrOp::Phi || resolve(id) != id) continue;
+                    uint32_t same = kNoValue;
+                    bool trivial = true;
+                    for (uint32_t k = 0; k < pool[id].b; ++k) {
+                        uint32_t v = operands[pool[id].a + k];
+                        if (v == kNoValue) continue;
+                        v = resolve(v);
+                        if (v == id || v == same) continue;
+                        if (same != kNoValue) {
+                            trivial = false;
+                            break;
+                        }
+                        same = v;
+                    }
+                    if (trivial && same != kNoValue) {
+                        replace(id, same);
+                        changed = true;
+                    }
+                }
+            }
+        }
+
+        // Numeración densa de valores
+        std::vector<uint32_t> newId(pool.size(), kNoValue);
+        uint32_t count = 0;
+        for (uint32_t old : order) {
+            for (uint32_t id : lists[old]) {
+                if (pool[id].op == IrOp::Nop || resolve(id) != id) continue;
+                newId[id] = count++;
+            }
+        }
+
+        auto mapValue = [&](uint32_t v) -> uint32_t {
+            if (v == kNoValue) return kNoValue;
+            return newId[resolve(v)];
+        };
+
+        fn.insts.clear();
+        fn.insts.reserve(count);
+        fn.operands.clear();
+        fn.blocks.assign(order.size(), IrBlock{});
+        fn.preds.clear();
+        for (uint32_t i = 0; i < order.size(); ++i) {
+            IrBlock &block = fn.blocks[i];
+            block.begin = static_cast<uint32_t>(fn.insts.size());
+            block.predBegin = static_cast<uint32_t>(fn.preds.size());
+            block.predCount = static_cast<uint32_t>(newPreds[i].size());
+            fn.preds.insert(fn.preds.end(), newPreds[i].begin(), newPreds[i].end());
+            for (uint32_t id : lists[order[i]]) {
+                if (newId[id] == kNoValue) continue;
+                IrInst inst = pool[id];
+                const IrOpInfo &info = irOpInfo(inst.op);
+                if (info.usesPool) {
+                    uint32_t begin = static_cast<uint32_t>(fn.operands.size());
+                    for (uint32_t k = 0; k < inst.b; ++k) fn.operands.push_back(mapValue(operands[inst.a + k]));
+                    inst.a = begin;
+                } else {
+                    if (info.valueOperands & 1) inst.a = mapValue(inst.a);
+                    if (info.valueOperands & 2) inst.b = mapValue(inst.b);
+                    if (info.valueOperands & 4) inst.c = mapValue(inst.c);
+                }
+                if (inst.op == IrOp::Jump) inst.a = newBlock[inst.a];
+                if (inst.op == IrOp::Branch) {
+                    inst.b = newBlock[inst.b];
+                    inst.c = newBlock[inst.c];
+                }
+                fn.insts.push_back(inst);
+            }
+            block.end = static_cast<uint32_t>(fn.insts.size());
+        }
+        computeDominators(fn);
+        fn.vectorLoops.clear();
+
+        // La función compacta pasa a ser la nueva base de edición
+        *this = IrEdit(fn);
+    }
+
+    // Dominadores de Cooper, Harvey y Kennedy sobre bloques ya numerados en RPO
+    static void computeDominators(IrFunction &fn) {
+        const uint32_t n = static_cast<uint32_t>(fn.blocks.size());
+        if (n == 0) return;
+        std::vector<uint32_t> idom(n, kNoBlock);
+        idom[0] = 0;
+        bool changed = true;
+        while (changed) {
+            changed = false;
+            for (uint32_t b = 1; b < n; ++b) {
+                uint32_t newIdom = kNoBlock;
+                const uint32_t *p = fn.predsOf(b);
+                for (uint32_t k = 0; k < fn.blocks[b].predCount; ++k) {
+                    uint32_t pred = p[k];
+                    if (idom[pred] == kNoBlock) continue;
+                    if (newIdom == kNoBlock) {
+                        newIdom = pred;
+                        continue;
+                    }
+                    uint32_t x = pred, y = newIdom;
+                    while (x != y) {
+                        while (x > y) x = idom[x];
+                        while (y > x) y = idom[y];
+                    }
+                    newIdom = x;
+                }
+                if (idom[b] != newIdom) {
+                    idom[b] = newIdom;
+                    changed = true;
+                }
+            }
+        }
+
+        // Hijos en formato CSR y numeración pre/post del árbol
+        std::vector<uint32_t> childCount(n, 0);
+        for (uint32_t b = 1; b < n; ++b) childCount[idom[b]]++;
+        fn.domChildren.assign(n > 0 ? n - 1 : 0, 0);
+        uint32_t offset = 0;
+        for (uint32_t b = 0; b < n; ++b) {
+            fn.blocks[b].idom = b == 0 ? kNoBlock : idom[b];
+            fn.blocks[b].domChildBegin = offset;
+            fn.blocks[b].domChildCount = 0;
+            offset += childCount[b];
+        }
+        for (uint32_t b = 1; b < n; ++b) {
+            IrBlock &parent = fn.blocks[idom[b]];
+            fn.domChildren[parent.domChildBegin + parent.domChildCount++] = b;
+        }
+        uint32_t counter = 0;
+        std::vector<std::pair<uint32_t, uint32_t>> stack{{0, 0}};
+        fn.blocks[0].domPre = counter++;
+        while (!stack.empty()) {
+            auto &[b, next] = stack.back();
+            if (next < fn.blocks[b].domChildCount) {
+                uint32_t child = fn.domChildren[fn.blocks[b].domChildBegin + next++];
+                fn.blocks[child].domPre = counter++;
+                stack.push_back({child, 0});
+            } else {
+                fn.blocks[b].domPost = counter++;
+                stack.pop_back();
+            }
+        }
+    }
+};
+
+// Volcado textual de la IR (para --emit-ir y depuración)
+inline void printIrFunction(const IrModule &module, const IrFunction &fn, std::ostream &out) {
+    out << "function " << fn.name << "(";
+    for (size_t i = 0; i < fn.paramTypes.size(); ++i) {
+        out << (i ? ", " : "") << irTypeName(fn.paramTypes[i]);
+    }
+    out << ") : " << irTypeName(fn.returnType) << "\n";
+    for (uint32_t b = 0; b < fn.blocks.size(); ++b) {
+        const IrBlock &block = fn.blocks[b];
+        out << "  b" << b << ":";
+        if (block.predCount) {
+            out << "  ; preds";
+            for (uint32_t k = 0; k < block.predCount; ++k) out << " b" << fn.predsOf(b)[k];
+        }
+        if (block.idom != kNoBlock) out << "  idom b" << block.idom;
+        for (const IrVectorLoop &loop : fn.vectorLoops) {
+            if (loop.header == b) out << "  vectorizable %" << loop.counter << " < %" << loop.bound;
+        }
+        out << "\n";
+        for (uint32_t i = block.begin; i < block.end; ++i) {
+            const IrInst &inst = fn.insts[i];
+            out << "    ";
+            if (inst.type != IrType::Void) out << "%" << i << ":" << irTypeName(inst.type) << " = ";
+            out << irOpInfo(inst.op).name;
+            switch (inst.op) {
+                case IrOp::Const: out << " " << inst.imm; break;
+                case IrOp::ConstStr: out << " \"" << module.strings[inst.imm] << "\""; break;
+                case IrOp::Param: out << " " << inst.imm; break;
+                case IrOp::LoadGlobal:
+                case IrOp::StoreGlobal: out << " @" << module.globals[inst.imm].name; break;
+                case IrOp::Call: out << " " << module.functions[inst.imm].name; break;
+                case IrOp::Jump: out << " b" << inst.a; break;
+                case IrOp::Branch: out << " %" << inst.a << ", b" << inst.b << ", b" << inst.c; break;
+                default: break;
+            }
+            if (inst.op != IrOp::Jump && inst.op != IrOp::Branch) {
+                bool first = true;
+                fn.forEachOperand(inst, [&](uint32_t v) {
+                    out << (first ? " " : ", ");
+                    if (v == kNoValue) out << "undef"; else out << "%" << v;
+                    first = false;
+                });
+            }
+            out << "\n";
+        }
+    }
+}
+
+inline void printIr(const IrModule &module, std::ostream &out) {
+    for (const auto &global : module.globals) {
+        out << "global @" << global.name << " : " << irTypeName(global.type) << "\n";
+    }
+    for (const auto &fn : module.functions) printIrFunction(module, fn, out);
+}
+
+#endif // IR_H_
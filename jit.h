@@ -0,0 +1,648 @@
+#ifndef JIT_H_
+#define JIT_H_
+
+// Compilación en tiempo de ejecución a x86-64 (ABI System V).
+//
+// Las funciones empiezan en la VM; al agotar su contador de llamadas, o el de
+// vueltas de un bucle, se traducen desde la IR con el mismo X86FunctionCompiler
+// del backend nativo, pero codificando bytes de máquina (X86Encoder) en páginas
+// obtenidas con mmap que pasan de escritura a ejecución (PROT_EXEC) al instalar
+// cada función. El código nativo comparte con la VM la arena, las cadenas, las
+// globales y la salida:
+//  - las llamadas entre funciones pasan por una tabla de entradas; mientras una
+//    función no está compilada su entrada es un tramo que vuelve al intérprete;
+//  - los bucles calientes entran a mitad de la función (OSR) cargando los valores
+//    vivos desde los registros de la VM;
+//  - los errores de ejecución vuelven con longjmp al último paso de la VM al
+//    código nativo, que los relanza como RuntimeError.
+
+#if defined(__x86_64__) && defined(__unix__)
+#define BM_JIT_AVAILABLE 1
+
+#include <csetjmp>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <unistd.h>
+
+#include "ir.h"
+#include "runtime.h"
+#include "vm.h"
+#include "x86.h"
+
+// Direcciones que el código generado usa como inmediatos de 64 bits
+struct JitAddresses {
+    const void *helpers[static_cast<int>(X86Helper::Count)] = {};
+    const void *const *entries = nullptr;    // entrada de cada función
+    const BmString *const *strings = nullptr;
+    int64_t *globals = nullptr;
+    const uintptr_t *stackLimit = nullptr;
+};
+
+// Ensamblador binario con la misma interfaz que X86TextAssembler
+class X86Encoder {
+    const JitAddresses &addresses;
+    std::vector<uint8_t> code;
+    std::vector<int64_t> labels;                      // posición de cada etiqueta o -1
+    std::vector<std::pair<size_t, uint32_t>> fixups;  // (desplazamiento rel32, etiqueta)
+
+    void byte(uint32_t value) {
+        code.push_back(static_cast<uint8_t>(value));
+    }
+
+    void int32(int64_t value) {
+        uint32_t v = static_cast<uint32_t>(value);
+        for (int i = 0; i < 4; ++i) byte(v >> (8 * i));
+    }
+
+    void int64(uint64_t value) {
+        for (int i = 0; i < 8; ++i) byte(static_cast<uint32_t>(value >> (8 * i)));
+    }
+
+    static bool fitsInt8(int64_t value) {
+        return value >= -128 && value <= 127;
+    }
+
+    // Prefijo REX; wide selecciona operandos de 64 bits
+    void rex(bool wide, int reg, const X86Operand &rm) {
+        uint32_t value = 0x40 | (wide ? 8 : 0) | ((reg >> 3) & 1) << 2 | (rm.reg >> 3 & 1);
+        if (rm.isMem() && rm.index >= 0) value |= (rm.index >> 3 & 1) << 1;
+        if (value != 0x40) byte(value);
+    }
+
+    void modrm(int reg, const X86Operand &rm) {
+        uint32_t r = static_cast<uint32_t>(reg & 7) << 3;
+        if (rm.isReg()) {
+            byte(0xC0 | r | (rm.reg & 7));
+            return;
+        }
+        int64_t disp = rm.value;
+        uint32_t mod = disp == 0 && (rm.reg & 7) != RBP ? 0 : fitsInt8(disp) ? 1 : 2;
+        if (rm.index >= 0 || (rm.reg & 7) == RSP) {
+            byte(mod << 6 | r | 4);
+            uint32_t index = rm.index >= 0 ? static_cast<uint32_t>(rm.index & 7) : 4;
+            byte((rm.index >= 0 ? 3u : 0u) << 6 | index << 3 | (rm.reg & 7));
+        } else {
+            byte(mod << 6 | r | (rm.reg & 7));
+        }
+        if (mod == 1) byte(static_cast<uint32_t>(disp));
+        else if (mod == 2) int32(disp);
+    }
+
+    // Instrucción de 64 bits con ModRM: opcode reg, r/m
+    void instruction(uint32_t opcode, int reg, const X86Operand &rm) {
+        rex(true, reg, rm);
+        if (opcode > 0xFF) byte(opcode >> 8);
+        byte(opcode & 0xFF);
+        modrm(reg, rm);
+    }
+
+    // SSE: prefijo obligatorio, REX si hace falta, 0F y el opcode
+    void sse(uint32_t prefix, uint32_t opcode, int reg, const X86Operand &rm, bool wide = false) {
+        byte(prefix);
+        rex(wide, reg, rm);
+        byte(0x0F);
+        byte(opcode);
+        modrm(reg, rm);
+    }
+
+    // VEX de tres bytes: map 1 = 0F, 2 = 0F38, 3 = 0F3A; pp 1 = 66, 2 = F3; l para 256 bits
+    void vex(uint32_t map, uint32_t pp, bool w, bool l, int vvvv, uint32_t opcode, int reg, const X86Operand &rm) {
+        uint32_t index = rm.isMem() && rm.index >= 0 ? static_cast<uint32_t>(rm.index >> 3 & 1) : 0;
+        uint32_t rxb = static_cast<uint32_t>(reg >> 3 & 1) << 2 | index << 1 | static_cast<uint32_t>(rm.reg >> 3 & 1);
+        byte(0xC4);
+        byte((~rxb & 7) << 5 | map);
+        byte((w ? 0x80 : 0) | (~static_cast<uint32_t>(vvvv) & 15) << 3 | (l ? 4 : 0) | pp);
+        byte(opcode);
+        modrm(reg, rm);
+    }
+
+    static uint32_t vecOpcode(X86VecOp op) {
+        static const uint32_t opcodes[] = {0xD4, 0xFB, 0xF4, 0xEF};
+        return opcodes[static_cast<int>(op)];
+    }
+
+    void movAbsolute(int reg, const void *address) {
+        byte(0x48 | (reg >> 3 & 1));
+        byte(0xB8 + (reg & 7));
+        int64(static_cast<uint64_t>(reinterpret_cast<uintptr_t>(address)));
+    }
+
+    void branch(uint32_t label) {
+        if (label >= labels.size()) labels.resize(label + 1, -1);
+        fixups.push_back({code.size(), label});
+        int32(0);
+    }
+
+public:
+    static constexpr bool kChecksStack = true;
+
+    explicit X86Encoder(const JitAddresses &addresses) : addresses(addresses) {}
+
+    const std::vector<uint8_t> &bytes() const { return code; }
+    size_t labelOffset(uint32_t label) const { return static_cast<size_t>(labels[label]); }
+
+    // Resuelve los saltos pendientes de la función
+    void finish() {
+        for (const auto &fixup : fixups) {
+            int64_t rel = labels[fixup.second] - static_cast<int64_t>(fixup.first + 4);
+            uint32_t v = static_cast<uint32_t>(rel);
+            std::memcpy(&code[fixup.first], &v, 4);
+        }
+        fixups.clear();
+    }
+
+    void beginFunction(uint32_t) {
+        labels.clear();
+        fixups.clear();
+    }
+
+    void bind(uint32_t label) {
+        if (label >= labels.size()) labels.resize(label + 1, -1);
+        labels[label] = static_cast<int64_t>(code.size());
+    }
+
+    void mov(const X86Operand &dst, const X86Operand &src) {
+        if (src.isImm()) {
+            if (!src.fitsImm32()) {
+                byte(0x48 | (dst.reg >> 3 & 1));
+                byte(0xB8 + (dst.reg & 7));
+                int64(static_cast<uint64_t>(src.value));
+                return;
+            }
+            instruction(0xC7, 0, dst);
+            int32(src.value);
+        } else if (src.isReg()) {
+            instruction(0x89, src.reg, dst);
+        } else {
+            instruction(0x8B, dst.reg, src);
+        }
+    }
+
+    void alu(X86Alu op, const X86Operand &dst, const X86Operand &src) {
+        static const uint32_t toRm[] = {0x01, 0x29, 0x39, 0x31};
+        static const uint32_t extension[] = {0, 5, 7, 6};
+        int k = static_cast<int>(op);
+        if (src.isImm()) {
+            instruction(fitsInt8(src.value) ? 0x83 : 0x81, static_cast<int>(extension[k]), dst);
+            if (fitsInt8(src.value)) byte(static_cast<uint32_t>(src.value));
+            else int32(src.value);
+        } else if (src.isReg()) {
+            instruction(toRm[k], src.reg, dst);
+        } else {
+            instruction(toRm[k] + 2, dst.reg, src);
+        }
+    }
+
+    void imul(int dst, const X86Operand &src) { instruction(0x0FAF, dst, src); }
+    void neg(int reg) { instruction(0xF7, 3, X86Operand::r(reg)); }
+    void cqo() { byte(0x48); byte(0x99); }
+    void idiv(int reg) { instruction(0xF7, 7, X86Operand::r(reg)); }
+    void test(int a, int b) { instruction(0x85, b, X86Operand::r(a)); }
+
+    void setcc(X86Cond cond) {
+        byte(0x0F); byte(0x90 | static_cast<uint32_t>(cond)); byte(0xC0);  // setcc %al
+        byte(0x0F); byte(0xB6); byte(0xC0);                                 // movzbl %al, %eax
+    }
+
+    void lea(int dst, const X86Operand &mem) { instruction(0x8D, dst, mem); }
+
+    void push(const X86Operand &op) {
+        if (op.isImm()) {
+            byte(0x68);
+            int32(op.value);
+        } else if (op.isReg()) {
+            if (op.reg >= 8) byte(0x41);
+            byte(0x50 + (op.reg & 7));
+        } else {
+            rex(false, 0, op);
+            byte(0xFF);
+            modrm(6, op);
+        }
+    }
+
+    void pop(int reg) {
+        if (reg >= 8) byte(0x41);
+        byte(0x58 + (reg & 7));
+    }
+
+    void jmp(uint32_t label) { byte(0xE9); branch(label); }
+    void jcc(X86Cond cond, uint32_t label) { byte(0x0F); byte(0x80 | static_cast<uint32_t>(cond)); branch(label); }
+    void ret() { byte(0xC3); }
+
+    // Las llamadas van por %rax: el código y el runtime pueden estar a más de 2 GB
+    void callHelper(X86Helper helper) {
+        movAbsolute(RAX, addresses.helpers[static_cast<int>(helper)]);
+        byte(0xFF); byte(0xD0);  // call *%rax
+    }
+
+    void callFunction(uint32_t index) {
+        movAbsolute(RAX, &addresses.entries[index]);
+        byte(0xFF); byte(0x10);  // call *(%rax)
+    }
+
+    void loadGlobal(int reg, uint32_t index) {
+        movAbsolute(RCX, &addresses.globals[index]);
+        mov(X86Operand::r(reg), X86Operand::mem(RCX, 0));
+    }
+
+    void storeGlobal(uint32_t index, int reg) {
+        movAbsolute(RCX, &addresses.globals[index]);
+        mov(X86Operand::mem(RCX, 0), X86Operand::r(reg));
+    }
+
+    void loadString(int reg, uint32_t index) {
+        movAbsolute(reg, addresses.strings[index]);
+    }
+
+    void vecLoad(int dst, const X86Operand &mem, bool wide) {
+        if (wide) vex(1, 2, false, true, 0, 0x6F, dst, mem);
+        else sse(0xF3, 0x6F, dst, mem);
+    }
+
+    void vecStore(const X86Operand &mem, int src, bool wide) {
+        if (wide) vex(1, 2, false, true, 0, 0x7F, src, mem);
+        else sse(0xF3, 0x7F, src, mem);
+    }
+
+    void vecMove(int dst, int src, bool wide) {
+        if (wide) vex(1, 1, false, true, 0, 0x6F, dst, X86Operand::r(src));
+        else sse(0x66, 0x6F, dst, X86Operand::r(src));
+    }
+
+    void vecAlu(X86VecOp op, int dst, int a, int b, bool wide) {
+        if (wide) vex(1, 1, false, true, a, vecOpcode(op), dst, X86Operand::r(b));
+        else sse(0x66, vecOpcode(op), dst, X86Operand::r(b));
+    }
+
+    void vecShift(X86VecOp op, int dst, int a, uint8_t bits, bool wide) {
+        int extension = op == X86VecOp::ShiftLeft ? 6 : 2;
+        if (wide) vex(1, 1, false, true, dst, 0x73, extension, X86Operand::r(a));
+        else sse(0x66, 0x73, extension, X86Operand::r(dst));
+        byte(bits);
+    }
+
+    void vecBroadcast(int dst, int reg, bool wide) {
+        if (wide) {
+            vex(1, 1, true, false, 0, 0x6E, dst, X86Operand::r(reg));     // vmovq
+            vex(2, 1, false, true, 0, 0x59, dst, X86Operand::r(dst));     // vpbroadcastq
+        } else {
+            sse(0x66, 0x6E, dst, X86Operand::r(reg), true);               // movq
+            sse(0x66, 0x6C, dst, X86Operand::r(dst));                     // punpcklqdq
+        }
+    }
+
+    void vecExtract(int reg, int src, bool wide) {
+        if (wide) vex(1, 1, true, false, 0, 0x7E, src, X86Operand::r(reg));
+        else sse(0x66, 0x7E, src, X86Operand::r(reg), true);
+    }
+
+    void vecSum(int reg, int src, int scratch, bool wide) {
+        if (wide) {
+            vex(3, 1, false, true, 0, 0x39, src, X86Operand::r(scratch));     // vextracti128 $1
+            byte(1);
+            vex(1, 1, false, false, scratch, 0xD4, scratch, X86Operand::r(src));
+            vex(1, 1, false, false, 0, 0x70, src, X86Operand::r(scratch));     // vpshufd $0x4e
+            byte(0x4E);
+            vex(1, 1, false, false, scratch, 0xD4, scratch, X86Operand::r(src));
+        } else {
+            sse(0x66, 0x70, scratch, X86Operand::r(src));                      // pshufd $0x4e
+            byte(0x4E);
+            sse(0x66, 0xD4, scratch, X86Operand::r(src));
+        }
+        vecExtract(reg, scratch, wide);
+    }
+
+    void vzeroupper() { byte(0xC5); byte(0xF8); byte(0x77); }
+
+    // En el prólogo sólo %rax está libre: los argumentos siguen en sus registros
+    void stackCheck(uint32_t overflowLabel) {
+        movAbsolute(RAX, addresses.stackLimit);
+        alu(X86Alu::Cmp, X86Operand::r(RSP), X86Operand::mem(RAX, 0));
+        jcc(X86Cond::B, overflowLabel);
+    }
+};
+
+// Páginas para el código generado: se escriben y luego se dejan de sólo lectura y ejecución
+class JitCodeRegion {
+    uint8_t *base = nullptr;
+    size_t size = 0;
+    size_t used = 0;
+
+public:
+    explicit JitCodeRegion(size_t bytes) {
+        void *p = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (p != MAP_FAILED) {
+            base = static_cast<uint8_t *>(p);
+            size = bytes;
+        }
+    }
+
+    ~JitCodeRegion() {
+        if (base) munmap(base, size);
+    }
+
+    JitCodeRegion(const JitCodeRegion &) = delete;
+    JitCodeRegion &operator=(const JitCodeRegion &) = delete;
+
+    // Copia el código y devuelve su dirección, o nullptr si no hay espacio
+    const uint8_t *install(const std::vector<uint8_t> &code) {
+        size_t start = (used + 15) & ~static_cast<size_t>(15);
+        if (!base || start + code.size() > size) return nullptr;
+        size_t page = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+        size_t first = start / page * page;
+        size_t last = (start + code.size() + page - 1) / page * page;
+        if (mprotect(base + first, last - first, PROT_READ | PROT_WRITE) != 0) return nullptr;
+        std::memcpy(base + start, code.data(), code.size());
+        if (mprotect(base + first, last - first, PROT_READ | PROT_EXEC) != 0) return nullptr;
+        used = start + code.size();
+        return base + start;
+    }
+
+    size_t bytesUsed() const {
+        return used;
+    }
+};
+
+class JitCompiler : public VmTierUp {
+    struct JitFunction {
+        bool attempted = false;
+        const void *entry = nullptr;
+        std::vector<std::pair<uint32_t, const void *>> loops;  // (pc de la cabecera, entrada OSR)
+    };
+
+    const IrModule &ir;
+    const BcModule &bytecode;
+    VirtualMachine &vm;
+    JitCodeRegion region;
+    JitAddresses addresses;
+    std::vector<const void *> entries;
+    std::vector<const BmString *> strings;
+    std::vector<JitFunction> compiled;
+    uint32_t compiledCount = 0;
+    uint32_t vectorLanes = __builtin_cpu_supports("avx2") ? 4 : 2;    // SSE2 siempre está en x86-64
+
+    // Estado del paso entre la VM y el código nativo
+    uintptr_t stackLimit = 0;
+    std::jmp_buf *errorJump = nullptr;
+    char errorMessage[256] = {};  // sin destructor: longjmp no puede saltarse uno
+    int64_t *stackTop = nullptr;
+
+    static const size_t kRegionBytes = 64 << 20;
+    static const size_t kStackMargin = 1 << 20;  // para el runtime y la VM entre funciones nativas
+
+    static JitCompiler *&active() {
+        thread_local JitCompiler *compiler = nullptr;
+        return compiler;
+    }
+
+    static int64_t fromPointer(const void *p) { return static_cast<int64_t>(reinterpret_cast<intptr_t>(p)); }
+    static const BmString *asString(int64_t v) { return reinterpret_cast<const BmString *>(static_cast<intptr_t>(v)); }
+
+    // Error de ejecución dentro del código nativo: vuelve al último paso desde la VM.
+    // Los marcos que longjmp descarta no deben tener objetos con destructor, así que
+    // el mensaje se arma en buffers de char.
+    [[noreturn]] static void fail(const char *message) {
+        JitCompiler &jit = *active();
+        std::snprintf(jit.errorMessage, sizeof jit.errorMessage, "%s", message);
+        std::longjmp(*jit.errorJump, 1);
+    }
+
+    // Funciones del runtime con la convención de llamada de C
+    static int64_t helperPow(int64_t base, int64_t exp) { return wrapPow(base, exp); }
+    static int64_t helperStrEq(int64_t a, int64_t b) { return stringsEqual(asString(a), asString(b)); }
+    static int64_t helperConcat(int64_t a, int64_t b) { return fromPointer(active()->vm.concat(asString(a), asString(b))); }
+    static int64_t helperIntToStr(int64_t v) { return fromPointer(active()->vm.toString(v, IrType::Int)); }
+    static int64_t helperBoolToStr(int64_t v) { return fromPointer(active()->vm.toString(v, IrType::Bool)); }
+    static int64_t helperCharToStr(int64_t v) { return fromPointer(active()->vm.toString(v, IrType::Char)); }
+    static void helperPrintInt(int64_t v) { active()->vm.print(v, IrType::Int); }
+    static void helperPrintBool(int64_t v) { active()->vm.print(v, IrType::Bool); }
+    static void helperPrintChar(int64_t v) { active()->vm.print(v, IrType::Char); }
+    static void helperPrintStr(int64_t v) { active()->vm.print(v, IrType::Str); }
+    static void helperPrintLn() { active()->vm.printLine(); }
+    static void helperBoundsError(int64_t index) {
+        char message[64];
+        std::snprintf(message, sizeof message, "array index %lld out of bounds", static_cast<long long>(index));
+        fail(message);
+    }
+    static void helperDivZero() { fail("division by zero"); }
+    static void helperStackOverflow() { fail("stack overflow"); }
+
+    static int64_t helperNewArray(int64_t length, int64_t strings) {
+        if (length < 0) fail("negative array size");
+        return fromPointer(active()->vm.newArray(length, strings ? IrType::Str : IrType::Int));
+    }
+
+    // Llamada a una función todavía interpretada (desde su tramo de entrada)
+    static int64_t helperEnterInterpreter(int64_t function, const int64_t *args) {
+        JitCompiler &jit = *active();
+        char message[sizeof jit.errorMessage];
+        try {
+            return jit.vm.callInterpreted(static_cast<uint32_t>(function), args, jit.stackTop);
+        } catch (const RuntimeError &error) {
+            // El salto se da fuera del catch, con la excepción ya destruida
+            std::snprintf(message, sizeof message, "%s", error.what());
+        }
+        fail(message);
+    }
+
+    template <typename F>
+    static const void *address(F function) {
+        return reinterpret_cast<const void *>(function);
+    }
+
+    static int64_t invoke(const void *entry, const int64_t *a, uint32_t count) {
+        void *p = const_cast<void *>(entry);
+        switch (count) {
+            case 0: return reinterpret_cast<int64_t (*)()>(p)();
+            case 1: return reinterpret_cast<int64_t (*)(int64_t)>(p)(a[0]);
+            case 2: return reinterpret_cast<int64_t (*)(int64_t, int64_t)>(p)(a[0], a[1]);
+            case 3: return reinterpret_cast<int64_t (*)(int64_t, int64_t, int64_t)>(p)(a[0], a[1], a[2]);
+            case 4: return reinterpret_cast<int64_t (*)(int64_t, int64_t, int64_t, int64_t)>(p)(a[0], a[1], a[2], a[3]);
+            case 5: return reinterpret_cast<int64_t (*)(int64_t, int64_t, int64_t, int64_t, int64_t)>(p)(a[0], a[1], a[2], a[3], a[4]);
+            default: return reinterpret_cast<int64_t (*)(int64_t, int64_t, int64_t, int64_t, int64_t, int64_t)>(p)(a[0], a[1], a[2], a[3], a[4], a[5]);
+        }
+    }
+
+    // Tramo de entrada de una función interpretada: copia los argumentos a la
+    // pila nativa y llama a helperEnterInterpreter(función, argumentos)
+    const void *emitInterpreterStub(uint32_t function, uint32_t numParams) {
+        static const int argumentRegs[] = {RDI, RSI, RDX, RCX, R8, R9};
+        X86Encoder as(addresses);
+        as.push(X86Operand::r(RBP));
+        as.mov(X86Operand::r(RBP), X86Operand::r(RSP));
+        int64_t bytes = (8 * static_cast<int64_t>(numParams) + 15) & ~static_cast<int64_t>(15);
+        if (bytes) as.alu(X86Alu::Sub, X86Operand::r(RSP), X86Operand::imm(bytes));
+        for (uint32_t i = 0; i < numParams; ++i) {
+            X86Operand slot = X86Operand::mem(RSP, static_cast<int32_t>(8 * i));
+            if (i < 6) {
+                as.mov(slot, X86Operand::r(argumentRegs[i]));
+            } else {
+                as.mov(X86Operand::r(RAX), X86Operand::mem(RBP, static_cast<int32_t>(16 + 8 * (i - 6))));
+                as.mov(slot, X86Operand::r(RAX));
+            }
+        }
+        as.mov(X86Operand::r(RSI), X86Operand::r(RSP));
+        as.mov(X86Operand::r(RDI), X86Operand::imm(function));
+        as.callHelper(X86Helper::EnterInterpreter);
+        as.mov(X86Operand::r(RSP), X86Operand::r(RBP));
+        as.pop(RBP);
+        as.ret();
+        return region.install(as.bytes());
+    }
+
+    // Cabeceras de bucle: bloques a los que llega una arista desde un bloque posterior
+    static std::vector<uint32_t> loopHeaders(const IrFunction &fn) {
+        std::vector<uint32_t> headers;
+        for (uint32_t b = 0; b < fn.blocks.size(); ++b) {
+            const uint32_t *preds = fn.predsOf(b);
+            for (uint32_t k = 0; k < fn.blocks[b].predCount; ++k) {
+                if (preds[k] >= b) {
+                    headers.push_back(b);
+                    break;
+                }
+            }
+        }
+        return headers;
+    }
+
+    // Compila la función una sola vez, con entradas OSR en todas sus cabeceras de bucle
+    JitFunction &ensureCompiled(uint32_t function) {
+        JitFunction &jf = compiled[function];
+        if (jf.attempted) return jf;
+        jf.attempted = true;
+
+        const IrFunction &fn = ir.functions[function];
+        const BcFunction &bc = bytecode.functions[function];
+        std::vector<uint32_t> headers = loopHeaders(fn);
+        std::vector<uint32_t> labels;
+        X86Encoder as(addresses);
+        X86FunctionCompiler<X86Encoder> compiler(as);
+        compiler.setVectorLanes(vectorLanes);
+        compiler.compile(fn, function, headers, &bc.valueRegs, &labels);
+        as.finish();
+        const uint8_t *code = region.install(as.bytes());
+        if (!code) return jf;
+
+        jf.entry = code;
+        for (size_t k = 0; k < headers.size(); ++k) {
+            jf.loops.push_back({bc.blockStart[headers[k]], code + as.labelOffset(labels[k])});
+        }
+        entries[function] = code;
+        compiledCount++;
+        return jf;
+    }
+
+    // El límite de la pila nativa se fija al entrar por primera vez al código generado
+    void setStackLimit() {
+        char marker;
+        struct rlimit limit;
+        size_t budget = 8 << 20;
+        if (getrlimit(RLIMIT_STACK, &limit) == 0 && limit.rlim_cur != RLIM_INFINITY) budget = limit.rlim_cur;
+        budget = budget > 2 * kStackMargin ? budget - kStackMargin : budget / 2;
+        stackLimit = reinterpret_cast<uintptr_t>(&marker) - budget;
+    }
+
+    template <typename Call>
+    int64_t enterNative(int64_t *top, Call call) {
+        std::jmp_buf jump;
+        std::jmp_buf *outerJump = errorJump;
+        int64_t *outerTop = stackTop;
+        if (!outerJump) setStackLimit();
+        errorJump = &jump;
+        stackTop = top;
+        if (setjmp(jump)) {
+            errorJump = outerJump;
+            stackTop = outerTop;
+            throw RuntimeError(errorMessage);
+        }
+        int64_t result = call();
+        errorJump = outerJump;
+        stackTop = outerTop;
+        return result;
+    }
+
+public:
+    JitCompiler(const IrModule &ir, const BcModule &bytecode, VirtualMachine &vm)
+        : ir(ir), bytecode(bytecode), vm(vm), region(kRegionBytes), compiled(ir.functions.size()) {
+        active() = this;
+        const void **helpers = addresses.helpers;
+        helpers[static_cast<int>(X86Helper::Pow)] = address(&helperPow);
+        helpers[static_cast<int>(X86Helper::StrEq)] = address(&helperStrEq);
+        helpers[static_cast<int>(X86Helper::Concat)] = address(&helperConcat);
+        helpers[static_cast<int>(X86Helper::IntToStr)] = address(&helperIntToStr);
+        helpers[static_cast<int>(X86Helper::BoolToStr)] = address(&helperBoolToStr);
+        helpers[static_cast<int>(X86Helper::CharToStr)] = address(&helperCharToStr);
+        helpers[static_cast<int>(X86Helper::NewArray)] = address(&helperNewArray);
+        helpers[static_cast<int>(X86Helper::PrintInt)] = address(&helperPrintInt);
+        helpers[static_cast<int>(X86Helper::PrintBool)] = address(&helperPrintBool);
+        helpers[static_cast<int>(X86Helper::PrintChar)] = address(&helperPrintChar);
+        helpers[static_cast<int>(X86Helper::PrintStr)] = address(&helperPrintStr);
+        helpers[static_cast<int>(X86Helper::PrintLn)] = address(&helperPrintLn);
+        helpers[static_cast<int>(X86Helper::BoundsError)] = address(&helperBoundsError);
+        helpers[static_cast<int>(X86Helper::DivZero)] = address(&helperDivZero);
+        helpers[static_cast<int>(X86Helper::StackOverflow)] = address(&helperStackOverflow);
+        helpers[static_cast<int>(X86Helper::EnterInterpreter)] = address(&helperEnterInterpreter);
+
+        for (uint32_t i = 0; i < bytecode.strings.size(); ++i) strings.push_back(vm.stringConstant(i));
+        entries.assign(ir.functions.size(), nullptr);
+        addresses.entries = entries.data();
+        addresses.strings = strings.data();
+        addresses.globals = vm.globalData();
+        addresses.stackLimit = &stackLimit;
+        for (uint32_t i = 0; i < ir.functions.size(); ++i) {
+            entries[i] = emitInterpreterStub(i, static_cast<uint32_t>(ir.functions[i].paramTypes.size()));
+        }
+    }
+
+    ~JitCompiler() override {
+        if (active() == this) active() = nullptr;
+    }
+
+    // La región se reserva con mmap: sin ella la VM sigue sola
+    bool available() const {
+        for (const void *entry : entries) {
+            if (!entry) return false;
+        }
+        return true;
+    }
+
+    const void *compileFunction(uint32_t function) override {
+        const JitFunction &jf = ensureCompiled(function);
+        // Desde C++ sólo se llama con argumentos en registros
+        return bytecode.functions[function].numParams <= 6 ? jf.entry : nullptr;
+    }
+
+    const void *compileLoop(uint32_t function, uint32_t pc) override {
+        const JitFunction &jf = ensureCompiled(function);
+        for (const auto &loop : jf.loops) {
+            if (loop.first == pc) return loop.second;
+        }
+        return nullptr;
+    }
+
+    int64_t callFunction(const void *entry, const int64_t *args, uint32_t count, int64_t *top) override {
+        return enterNative(top, [&] { return invoke(entry, args, count); });
+    }
+
+    int64_t enterLoop(const void *entry, int64_t *base, int64_t *top) override {
+        return enterNative(top, [&] { return reinterpret_cast<int64_t (*)(int64_t *)>(const_cast<void *>(entry))(base); });
+    }
+
+    uint32_t functionsCompiled() const {
+        return compiledCount;
+    }
+
+    size_t codeBytes() const {
+        return region.bytesUsed();
+    }
+};
+
+#endif // __x86_64__ && __unix__
+
+#endif // JIT_H_
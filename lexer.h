@@ -10,18 +10,32 @@
 #include <stdlib.h>
 
 #include "helper.h"
+#include "report.h"
+
+// Origen de los tokens que consume el parser: el Lexer con todo el texto ya
+// analizado, o PipelinedLexer (pipeline.h), que los recibe de otro hilo
+class TokenSource {
+public:
+    virtual ~TokenSource() = default;
+    virtual Token getToken() = 0;
+    virtual Token peekToken() = 0;
+};
 
 // Clase del analizador léxico (lexer)
-class Lexer {
+class Lexer : public TokenSource {
     const SourceFile *source;
     size_t idx = 0;
     int line = 1;
     int column = 0;
     unsigned int errorCount = 0;
+    bool endMarker = false;  // el análisis terminó en un '$' y no en el final del texto
     std::vector<Token> tokens;
+    size_t next = 0;         // siguiente token que entrega getToken()
 
 public:
-    explicit Lexer(const SourceFile &source) : source(&source) {
+    // Con tokenizeAll en false no analiza nada: los tokens se piden con getNextToken()
+    explicit Lexer(const SourceFile &source, bool tokenizeAll = true) : source(&source) {
+        if (!tokenizeAll) return;
         tokenize();
         //std::cout << "DEBUG LEXER - Tokens generated: " << tokens.size() << std::endl;
         // print all tokens
@@ -33,7 +47,7 @@ public:
 
     void printTokens() {
         for (const auto &token : tokens) {
-            std::cout << "Token: " << token.kindToString() << " [ " << token.value.value_or("") << " ] found at (" << token.location.line << ":" << token.location.col << ")\n";
+            compilerOut() << "Token: " << token.kindToString() << " [ " << token.value.value_or("") << " ] found at (" << token.location.line << ":" << token.location.col << ")\n";
         }
     }
 
@@ -41,10 +55,18 @@ public:
         return errorCount;
     }
 
+    size_t tokenCount() const {
+        return tokens.size();
+    }
+
+    bool reachedEndMarker() const {
+        return endMarker;
+    }
+
     char peekNextChar() const {
     // Check if we're at the end of the buffer
         if (idx >= source->buffer.size()) {
-            std::cout << "DEBUG LEXER - Reached EOF while peeking at index: " << idx << std::endl;
+            compilerOut() << "DEBUG LEXER - Reached EOF while peeking at index: " << idx << '\n';
             return EOF;  // Return EOF to indicate end of file
         }
         return source->buffer[idx];
@@ -70,10 +92,11 @@ public:
 
     // insert token in front of the vector
     void insertToken(Token token) {
-        tokens.insert(tokens.begin(), token);
+        ungetToken(std::move(token));
     }
 
     void tokenize() {
+        AllocationSite site("lexer: lista de tokens");  // crecimiento de la lista y copias
         Token token = getNextToken();
         while (token.kind != TokenKind::Eof) {
             tokens.push_back(token);
@@ -83,29 +106,44 @@ public:
         tokens.push_back(token);
     }
 
-    Token peekToken() {
-        if (tokens.empty()) {
+    Token peekToken() override {
+        if (next >= tokens.size()) {
             return Token{source->path, line, column, TokenKind::Eof};
         }
-        return tokens.front(); // Devolver el siguiente token sin eliminarlo de la lista
+        return tokens[next]; // Devolver el siguiente token sin avanzar
     }
 
     void ungetToken(Token token) {
-        tokens.insert(tokens.begin(), token); // Insertar el token al principio de la lista para "devolverlo"
-    }   
-    //get tokens in order
-    Token getToken() {
-        if (tokens.empty()) {
+        // "Devolver" el token: ocupa el lugar anterior al siguiente
+        if (next > 0) tokens[--next] = std::move(token);
+        else tokens.insert(tokens.begin(), std::move(token));
+    }
+    //get tokens in order (avanza un índice en lugar de borrar del principio).
+    // El token se mueve: el parser no vuelve atrás, y así no se copia su valor.
+    Token getToken() override {
+        if (next >= tokens.size()) {
             return Token{source->path, line, column, TokenKind::Eof};
         }
-        Token token = tokens.front();
-        tokens.erase(tokens.begin());
-        return token;
+        return std::move(tokens[next++]);
     }
     
     
     
+    // Siguiente token. Los comentarios se saltan en este bucle: con una llamada
+    // recursiva por comentario, miles de comentarios seguidos agotaban la pila.
     Token getNextToken() {
+        AllocationSite site("lexer: token");
+        Token token;
+        bool skippedComment;
+        do {
+            skippedComment = false;
+            token = scanToken(skippedComment);
+        } while (skippedComment);
+        return token;
+    }
+
+    // Un token, o un comentario saltado (skippedComment en true y el token sin usar)
+    Token scanToken(bool &skippedComment) {
     char currentChar = eatNextChar();
 
     // Check for EOF immediately
@@ -130,7 +168,8 @@ public:
             while (peekNextChar() != '\n' && peekNextChar() != EOF) {
                 eatNextChar();
             }
-            return getNextToken();  // Continuar después del comentario de línea
+            skippedComment = true;  // Continuar después del comentario de línea
+            return Token{};
         } else if (peekNextChar() == '*') {
             eatNextChar();  // Consumir el asterisco '*'
             while (true) {
@@ -144,7 +183,8 @@ public:
                     break;  // Salir del comentario de bloque correctamente cerrado
                 }
             }
-            return getNextToken();  // Continuar después del comentario de bloque
+            skippedComment = true;  // Continuar después del comentario de bloque
+            return Token{};
         }
     }
 
@@ -211,7 +251,9 @@ public:
                 return Token{tokenStartLocation, TokenKind::isEqual};
             }
             return Token{tokenStartLocation, TokenKind::Assign};
-        case '$': return Token{tokenStartLocation, TokenKind::Eof}; // Fin del programa
+        case '$': // Fin del programa
+            endMarker = true;
+            return Token{tokenStartLocation, TokenKind::Eof};
     }
 
     // Identificar cadenas
@@ -252,7 +294,7 @@ public:
         const char *c = value.c_str(); 
         long long ll = std::strtoll(c, nullptr, 10);
         if (ll > 9223372036854775807LL || ll < -9223372036854775807LL) {
-            std::cerr << "ERROR LEXICO - Numero fuera de rango" << std::endl;
+            compilerErr() << "ERROR LEXICO - Numero fuera de rango" << std::endl;
             errorCount++;
             return Token{tokenStartLocation, TokenKind::Unknown};
         }
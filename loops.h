@@ -0,0 +1,351 @@
+#ifndef LOOPS_H_
+#define LOOPS_H_
+
+#include <algorithm>
+#include <cstdint>
+#include <map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#include "ir.h"
+#include "runtime.h"
+
+// Estadísticas de las optimizaciones de bucles
+struct LoopStats {
+    unsigned int loops = 0;             // bucles naturales con pre-encabezado
+    unsigned int hoisted = 0;           // instrucciones invariantes sacadas del bucle
+    unsigned int reducedMuls = 0;       // i * k reemplazados por una suma acumulada
+    unsigned int reducedPows = 0;       // k ^ i reemplazados por un producto acumulado
+    unsigned int expandedPows = 0;      // x ^ n (n constante) convertidos en multiplicaciones
+};
+
+// Bucle natural
+struct IrLoop {
+    uint32_t header = 0;
+    uint32_t preheader = kNoBlock;
+    uint32_t latch = kNoBlock;          // único bloque con arista de retorno, o kNoBlock
+    std::vector<uint32_t> blocks;       // en orden de la función (post-orden inverso)
+    std::vector<char> contains;         // por bloque
+    bool hasCalls = false;
+    std::unordered_set<int64_t> storedGlobals;
+};
+
+// Bucles naturales de una función compacta, los internos primero. Un bucle se
+// obtiene de las aristas de retorno (predecesores dominados por el encabezado);
+// sólo se devuelven los que tienen pre-encabezado: un único predecesor externo
+// del encabezado terminado en un salto incondicional, como los deja la traducción.
+inline std::vector<IrLoop> findLoops(const IrFunction &fn) {
+    const uint32_t n = static_cast<uint32_t>(fn.blocks.size());
+    std::vector<IrLoop> loops;
+    for (uint32_t h = 0; h < n; ++h) {
+        IrLoop loop;
+        loop.header = h;
+        loop.contains.assign(n, 0);
+        std::vector<uint32_t> work;
+        const uint32_t *preds = fn.predsOf(h);
+        for (uint32_t k = 0; k < fn.blocks[h].predCount; ++k) {
+            if (fn.dominates(h, preds[k])) work.push_back(preds[k]);
+        }
+        if (work.empty()) continue;
+        if (work.size() == 1) loop.latch = work[0];
+        loop.contains[h] = 1;
+        while (!work.empty()) {
+            uint32_t b = work.back();
+            work.pop_back();
+            if (loop.contains[b]) continue;
+            loop.contains[b] = 1;
+            const uint32_t *bp = fn.predsOf(b);
+            for (uint32_t k = 0; k < fn.blocks[b].predCount; ++k) work.push_back(bp[k]);
+        }
+        uint32_t entries = 0;
+        for (uint32_t k = 0; k < fn.blocks[h].predCount; ++k) {
+            if (loop.contains[preds[k]]) continue;
+            loop.preheader = preds[k];
+            entries++;
+        }
+        if (entries != 1 || fn.terminator(loop.preheader).op != IrOp::Jump) continue;
+        for (uint32_t b = 0; b < n; ++b) {
+            if (!loop.contains[b]) continue;
+            loop.blocks.push_back(b);
+            for (uint32_t i = fn.blocks[b].begin; i < fn.blocks[b].end; ++i) {
+                const IrInst &inst = fn.insts[i];
+                if (inst.op == IrOp::Call) loop.hasCalls = true;
+                if (inst.op == IrOp::StoreGlobal) loop.storedGlobals.insert(inst.imm);
+            }
+        }
+        loops.push_back(std::move(loop));
+    }
+    // Los bucles internos tienen el encabezado después que los externos
+    std::sort(loops.begin(), loops.end(), [](const IrLoop &x, const IrLoop &y) { return x.header > y.header; });
+    return loops;
+}
+
+// Optimizaciones de bucles sobre la IR de cada función. Los bucles sin
+// pre-encabezado se dejan como están; los demás se procesan de dentro hacia fuera:
+//  - movimiento de código invariante: las operaciones puras que no pueden abortar
+//    y cuyos operandos se definen fuera del bucle pasan al pre-encabezado, y las
+//    lecturas de globales también si el bucle no las escribe ni hace llamadas;
+//  - reducción de fuerza: con una variable de inducción i = phi(inicio, i ± c),
+//    i * k pasa a ser una nueva variable j = phi(inicio * k, j + c * k) y k ^ i
+//    un producto acumulado; la aritmética es módulo 2^64 como en el runtime.
+// Además, x ^ n con n constante pequeño se expande a multiplicaciones.
+class LoopOptimizer {
+    static const int64_t kMaxExpandedExponent = 16;
+
+    struct InductionVariable {
+        uint32_t phi;
+        uint32_t init;      // valor desde el pre-encabezado
+        uint32_t next;      // phi ± c, valor desde el bloque de retorno
+        int64_t step;
+    };
+
+    LoopStats stats;
+    IrEdit edit;
+    std::vector<uint32_t> blockOf;   // instrucción -> bloque actual
+
+    void track(uint32_t id, uint32_t block) {
+        if (blockOf.size() <= id) blockOf.resize(id + 1, kNoBlock);
+        blockOf[id] = block;
+    }
+
+    uint32_t emitInPreheader(const IrLoop &loop, const IrInst &inst) {
+        uint32_t id = edit.insertBeforeTerminator(loop.preheader, inst);
+        track(id, loop.preheader);
+        return id;
+    }
+
+    // Inserta una instrucción nueva justo antes o después de otra del mismo bloque
+    uint32_t insertNear(uint32_t anchor, const IrInst &inst, bool after) {
+        uint32_t block = blockOf[anchor];
+        uint32_t id = edit.add(inst);
+        auto &list = edit.lists[block];
+        auto pos = std::find(list.begin(), list.end(), anchor);
+        list.insert(after ? pos + 1 : pos, id);
+        track(id, block);
+        return id;
+    }
+
+    bool isConst(uint32_t value) const {
+        return edit.pool[value].op == IrOp::Const;
+    }
+
+    bool definedOutside(const IrLoop &loop, uint32_t value) const {
+        uint32_t block = blockOf[value];
+        return block == kNoBlock || !loop.contains[block];
+    }
+
+    bool isHoistable(const IrLoop &loop, const IrInst &inst) {
+        switch (inst.op) {
+            case IrOp::Const: case IrOp::ConstStr:
+            case IrOp::Add: case IrOp::Sub: case IrOp::Mul: case IrOp::Pow:
+            case IrOp::Neg: case IrOp::Not:
+            case IrOp::Eq: case IrOp::Ne: case IrOp::Lt: case IrOp::Le: case IrOp::Gt: case IrOp::Ge:
+            case IrOp::StrEq: case IrOp::StrNe: case IrOp::Concat: case IrOp::ToStr:
+            case IrOp::ArrayLen:
+                return true;
+            case IrOp::Div: case IrOp::Mod:
+                // Sólo si no puede abortar: el bucle podría no ejecutarse nunca
+                return isConst(edit.resolve(inst.b)) && edit.pool[edit.resolve(inst.b)].imm != 0;
+            case IrOp::LoadGlobal:
+                return !loop.hasCalls && !loop.storedGlobals.count(inst.imm);
+            default:
+                return false;
+        }
+    }
+
+    void hoistInvariants(const IrLoop &loop) {
+        bool changed = true;
+        while (changed) {
+            changed = false;
+            for (uint32_t block : loop.blocks) {
+                std::vector<uint32_t> list = edit.lists[block];
+                for (uint32_t id : list) {
+                    IrInst &inst = edit.pool[id];
+                    if (edit.resolve(id) != id || !isHoistable(loop, inst)) continue;
+                    bool invariant = true;
+                    edit.forEachOperand(inst, [&](uint32_t &v) {
+                        if (!definedOutside(loop, edit.resolve(v))) invariant = false;
+                    });
+                    if (!invariant) continue;
+                    auto &from = edit.lists[block];
+                    from.erase(std::find(from.begin(), from.end(), id));
+                    auto &to = edit.lists[loop.preheader];
+                    to.insert(to.end() - 1, id);
+                    blockOf[id] = loop.preheader;
+                    stats.hoisted++;
+                    changed = true;
+                }
+            }
+        }
+    }
+
+    std::vector<InductionVariable> findInductionVariables(const IrLoop &loop) {
+        std::vector<InductionVariable> ivs;
+        const auto &preds = edit.preds[loop.header];
+        if (loop.latch == kNoBlock || preds.size() != 2) return ivs;
+        uint32_t pre = preds[0] == loop.preheader ? 0 : 1;
+        uint32_t back = 1 - pre;
+        for (uint32_t id : edit.lists[loop.header]) {
+            const IrInst &phi = edit.pool[id];
+            if (phi.op != IrOp::Phi) break;
+            if (phi.type != IrType::Int || phi.b != 2 || edit.resolve(id) != id) continue;
+            uint32_t init = edit.resolve(edit.operands[phi.a + pre]);
+            uint32_t next = edit.resolve(edit.operands[phi.a + back]);
+            const IrInst &update = edit.pool[next];
+            if (update.op != IrOp::Add && update.op != IrOp::Sub) continue;
+            uint32_t lhs = edit.resolve(update.a), rhs = edit.resolve(update.b);
+            if (update.op == IrOp::Add && lhs != id) std::swap(lhs, rhs);
+            if (lhs != id || !isConst(rhs)) continue;
+            int64_t step = edit.pool[rhs].imm;
+            if (update.op == IrOp::Sub) step = wrapSub(0, step);
+            ivs.push_back({id, init, next, step});
+        }
+        return ivs;
+    }
+
+    // Nueva variable en el encabezado: phi(inicio, actualización)
+    uint32_t addRecurrence(const IrLoop &loop, uint32_t init, uint32_t &update, const InductionVariable &iv,
+                           IrOp op, uint32_t factor) {
+        const auto &preds = edit.preds[loop.header];
+        uint32_t phi = edit.addPhi(loop.header, IrType::Int);
+        track(phi, loop.header);
+        update = insertNear(iv.next, makeIrInst(op, IrType::Int, phi, factor), true);
+        std::vector<uint32_t> values(preds.size());
+        for (size_t k = 0; k < preds.size(); ++k) values[k] = preds[k] == loop.preheader ? init : update;
+        edit.setOperands(phi, values);
+        return phi;
+    }
+
+    void reduceStrength(const IrLoop &loop) {
+        std::vector<InductionVariable> ivs = findInductionVariables(loop);
+        if (ivs.empty()) return;
+        std::map<std::pair<uint32_t, uint32_t>, uint32_t> products, powers;   // (iv, k) -> nueva variable
+
+        for (uint32_t block : loop.blocks) {
+            std::vector<uint32_t> list = edit.lists[block];
+            for (uint32_t id : list) {
+                IrInst inst = edit.pool[id];
+                if ((inst.op != IrOp::Mul && inst.op != IrOp::Pow) || inst.type != IrType::Int) continue;
+                if (edit.resolve(id) != id) continue;
+                uint32_t lhs = edit.resolve(inst.a), rhs = edit.resolve(inst.b);
+                for (const InductionVariable &iv : ivs) {
+                    if (inst.op == IrOp::Mul) {
+                        uint32_t k = lhs == iv.phi ? rhs : rhs == iv.phi ? lhs : kNoValue;
+                        if (k == kNoValue || !definedOutside(loop, k)) continue;
+                        uint32_t &reduced = products[{iv.phi, k}];
+                        if (!reduced) {
+                            uint32_t start = emitInPreheader(loop, makeIrInst(IrOp::Mul, IrType::Int, iv.init, k));
+                            uint32_t stride = isConst(k)
+                                ? emitInPreheader(loop, makeIrConst(wrapMul(iv.step, edit.pool[k].imm)))
+                                : emitInPreheader(loop, makeIrInst(IrOp::Mul, IrType::Int, k,
+                                      emitInPreheader(loop, makeIrConst(iv.step))));
+                            uint32_t update = kNoValue;
+                            reduced = addRecurrence(loop, start, update, iv, IrOp::Add, stride);
+                        }
+                        edit.replace(id, reduced);
+                        stats.reducedMuls++;
+                        break;
+                    }
+                    // k ^ i: el exponente debe seguir siendo no negativo en todas las vueltas
+                    // que puedan ejecutarse, así que se exige un inicio y un paso acotados
+                    if (rhs != iv.phi || !definedOutside(loop, lhs) || !isConst(iv.init)) continue;
+                    int64_t start = edit.pool[iv.init].imm;
+                    if (start < 0 || start > (int64_t(1) << 40) || iv.step < 1 || iv.step > (int64_t(1) << 20)) continue;
+                    uint32_t &reduced = powers[{iv.phi, lhs}];
+                    if (!reduced) {
+                        uint32_t first = emitInPreheader(loop, makeIrInst(IrOp::Pow, IrType::Int, lhs, iv.init));
+                        uint32_t ratio = emitInPreheader(loop, makeIrInst(IrOp::Pow, IrType::Int, lhs,
+                            emitInPreheader(loop, makeIrConst(iv.step))));
+                        uint32_t update = kNoValue;
+                        reduced = addRecurrence(loop, first, update, iv, IrOp::Mul, ratio);
+                    }
+                    edit.replace(id, reduced);
+                    stats.reducedPows++;
+                    break;
+                }
+            }
+        }
+    }
+
+    // x ^ n con 0 <= n <= kMaxExpandedExponent: elevar al cuadrado y multiplicar
+    void expandPowers() {
+        for (uint32_t block = 0; block < edit.lists.size(); ++block) {
+            std::vector<uint32_t> list = edit.lists[block];
+            for (uint32_t id : list) {
+                IrInst inst = edit.pool[id];
+                if (inst.op != IrOp::Pow || edit.resolve(id) != id) continue;
+                uint32_t exponent = edit.resolve(inst.b);
+                if (!isConst(exponent)) continue;
+                int64_t n = edit.pool[exponent].imm;
+                if (n < 0 || n > kMaxExpandedExponent) continue;
+                uint32_t base = edit.resolve(inst.a);
+                uint32_t result = kNoValue;
+                while (n > 0) {
+                    if (n & 1) result = result == kNoValue ? base : insertNear(id, makeIrInst(IrOp::Mul, IrType::Int, result, base), false);
+                    n >>= 1;
+                    if (n > 0) base = insertNear(id, makeIrInst(IrOp::Mul, IrType::Int, base, base), false);
+                }
+                if (result == kNoValue) result = insertNear(id, makeIrConst(1), false);
+                edit.replace(id, result);
+                stats.expandedPows++;
+            }
+        }
+    }
+
+    // Quita las instrucciones puras que quedaron sin usos
+    void removeDeadValues() {
+        std::vector<uint32_t> uses(edit.pool.size(), 0);
+        auto countUses = [&](IrInst &inst, int delta) {
+            edit.forEachOperand(inst, [&](uint32_t &v) {
+                if (v != kNoValue) uses[edit.resolve(v)] += delta;
+            });
+        };
+        for (auto &list : edit.lists) {
+            for (uint32_t id : list) if (edit.resolve(id) == id) countUses(edit.pool[id], 1);
+        }
+        bool changed = true;
+        while (changed) {
+            changed = false;
+            for (auto &list : edit.lists) {
+                for (uint32_t id : list) {
+                    IrInst &inst = edit.pool[id];
+                    if (uses[id] || inst.op == IrOp::Nop || edit.resolve(id) != id) continue;
+                    if (irOpInfo(inst.op).sideEffects || inst.op == IrOp::Param) continue;
+                    countUses(inst, -1);
+                    inst.op = IrOp::Nop;
+                    changed = true;
+                }
+            }
+        }
+    }
+
+    void runFunction(IrFunction &fn) {
+        if (fn.blocks.empty()) return;
+        std::vector<IrLoop> loops = findLoops(fn);
+        edit = IrEdit(fn);
+        blockOf.assign(fn.insts.size(), kNoBlock);
+        for (uint32_t b = 0; b < fn.blocks.size(); ++b) {
+            for (uint32_t i = fn.blocks[b].begin; i < fn.blocks[b].end; ++i) blockOf[i] = b;
+        }
+        expandPowers();
+        for (const IrLoop &loop : loops) {
+            stats.loops++;
+            hoistInvariants(loop);
+            reduceStrength(loop);
+        }
+        removeDeadValues();
+        edit.commit(fn);
+    }
+
+public:
+    LoopStats run(IrModule &module) {
+        stats = LoopStats{};
+        for (auto &fn : module.functions) runFunction(fn);
+        edit = IrEdit();
+        blockOf.clear();
+        return stats;
+    }
+};
+
+#endif // LOOPS_H_
@@ -0,0 +1,522 @@
+#ifndef LOWERING_H_
+#define LOWERING_H_
+
+#include <algorithm>
+#include <cstdint>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "ast.h"
+#include "ir.h"
+
+// Traducción del AST anotado por SemanticAnalyzer a la IR en forma SSA.
+// Las variables locales se convierten en valores SSA directamente durante la
+// traducción (algoritmo de Braun et al.: phis bajo demanda con sellado de
+// bloques); las globales y los elementos de arreglo quedan en memoria.
+class IrLowering {
+    const Program &program;
+    IrModule &module;
+
+    // Estado de la función actual
+    IrEdit edit;
+    uint32_t current = 0;
+    std::unordered_map<uint64_t, uint32_t> currentDef;   // (bloque, variable) -> valor
+    std::vector<uint8_t> sealed;
+    std::vector<std::vector<std::pair<uint32_t, uint32_t>>> incompletePhis;  // por bloque: (variable, phi)
+    std::vector<IrType> tempTypes;                        // variables temporales de && y ||
+
+    struct PendingPhi {
+        uint32_t var, phi, block;
+    };
+    std::vector<PendingPhi> pendingPhis;
+    bool draining = false;
+
+    static IrType irType(const Type &type) {
+        if (type.isArray()) return IrType::Array;
+        switch (type.base) {
+            case TokenKind::KwInteger: return IrType::Int;
+            case TokenKind::KwBoolean: return IrType::Bool;
+            case TokenKind::KwChar: return IrType::Char;
+            case TokenKind::KwString: return IrType::Str;
+            default: return IrType::Void;
+        }
+    }
+
+    static IrType elementType(const Type &type) {
+        Type element;
+        element.base = type.base;
+        return irType(element);
+    }
+
+    // Emisión de instrucciones en el bloque actual
+    uint32_t emit(IrOp op, IrType type, uint32_t a = kNoValue, uint32_t b = kNoValue, uint32_t c = kNoValue, int64_t imm = 0) {
+        return edit.append(current, makeIrInst(op, type, a, b, c, imm));
+    }
+
+    uint32_t emitConst(IrType type, int64_t value) {
+        return emit(IrOp::Const, type, kNoValue, kNoValue, kNoValue, value);
+    }
+
+    uint32_t defaultValue(IrType type) {
+        if (type == IrType::Str) return emit(IrOp::ConstStr, IrType::Str, kNoValue, kNoValue, kNoValue, module.internString(""));
+        return emitConst(type, 0);
+    }
+
+    uint32_t newBlock(bool seal) {
+        uint32_t block = edit.newBlock();
+        sealed.push_back(seal);
+        incompletePhis.emplace_back();
+        return block;
+    }
+
+    void jump(uint32_t target) {
+        if (edit.isTerminated(current)) return;
+        emit(IrOp::Jump, IrType::Void, target);
+        edit.addEdge(current, target);
+    }
+
+    void branch(uint32_t cond, uint32_t ifTrue, uint32_t ifFalse) {
+        emit(IrOp::Branch, IrType::Void, cond, ifTrue, ifFalse);
+        edit.addEdge(current, ifTrue);
+        edit.addEdge(current, ifFalse);
+    }
+
+    // Construcción de SSA
+    static uint64_t defKey(uint32_t block, uint32_t var) {
+        return (static_cast<uint64_t>(block) << 32) | var;
+    }
+
+    IrType varType(uint32_t var) const {
+        if (var < program.symbols.size()) return irType(program.symbols[var].type);
+        return tempTypes[var - program.symbols.size()];
+    }
+
+    uint32_t newTemp(IrType type) {
+        tempTypes.push_back(type);
+        return static_cast<uint32_t>(program.symbols.size() + tempTypes.size() - 1);
+    }
+
+    void writeVariable(uint32_t var, uint32_t block, uint32_t value) {
+        currentDef[defKey(block, var)] = value;
+    }
+
+    // Lectura iterativa: recorre cadenas de bloques con un solo predecesor sin
+    // recursión y difiere los operandos de los phis nuevos a una lista de trabajo,
+    // así la profundidad de pila no crece con el tamaño del programa.
+    uint32_t readVariable(uint32_t var, uint32_t block) {
+        std::vector<uint32_t> chain;
+        uint32_t value;
+        while (true) {
+            auto found = currentDef.find(defKey(block, var));
+            if (found != currentDef.end()) {
+                value = edit.resolve(found->second);
+                break;
+            }
+            if (!sealed[block]) {
+                value = edit.addPhi(block, varType(var));
+                incompletePhis[block].push_back({var, value});
+            } else if (edit.preds[block].size() == 1) {
+                chain.push_back(block);
+                block = edit.preds[block][0];
+                continue;
+            } else if (edit.preds[block].empty()) {
+                // Bloque inalcanzable o lectura sin definición: valor por defecto
+                IrInst inst;
+                inst.op = varType(var) == IrType::Str ? IrOp::ConstStr : IrOp::Const;
+                inst.type = varType(var);
+                inst.imm = inst.op == IrOp::ConstStr ? module.internString("") : 0;
+                value = edit.add(inst);
+                edit.lists[block].insert(edit.lists[block].begin(), value);
+            } else {
+                value = edit.addPhi(block, varType(var));
+                pendingPhis.push_back({var, value, block});
+            }
+            writeVariable(var, block, value);
+            break;
+        }
+        for (uint32_t b : chain) writeVariable(var, b, value);
+        drainPendingPhis();
+        return value;
+    }
+
+    // Completa los operandos de los phis creados en bloques ya sellados.
+    // Los phis triviales se eliminan al confirmar la función (IrEdit::commit).
+    void drainPendingPhis() {
+        if (draining) return;
+        draining = true;
+        while (!pendingPhis.empty()) {
+            PendingPhi pending = pendingPhis.back();
+            pendingPhis.pop_back();
+            setPhiOperands(pending.var, pending.phi, pending.block);
+        }
+        draining = false;
+    }
+
+    void setPhiOperands(uint32_t var, uint32_t phi, uint32_t block) {
+        std::vector<uint32_t> values;
+        values.reserve(edit.preds[block].size());
+        for (uint32_t pred : edit.preds[block]) values.push_back(readVariable(var, pred));
+        edit.setOperands(phi, values);
+    }
+
+    void sealBlock(uint32_t block) {
+        sealed[block] = 1;
+        auto incomplete = std::move(incompletePhis[block]);
+        incompletePhis[block].clear();
+        for (auto &[var, phi] : incomplete) setPhiOperands(var, phi, block);
+        drainPendingPhis();
+    }
+
+    // Expresiones
+    uint32_t lowerExpr(const Expr &e) {
+        switch (e.kind) {
+            case ExprKind::IntLit:
+            case ExprKind::BoolLit:
+            case ExprKind::CharLit:
+                return emitConst(irType(e.type), e.intValue);
+            case ExprKind::StringLit:
+                return emit(IrOp::ConstStr, IrType::Str, kNoValue, kNoValue, kNoValue, module.internString(e.name));
+            case ExprKind::Var:
+                return readVar(e.symbol);
+            case ExprKind::Assign:
+                return lowerAssign(e);
+            case ExprKind::Postfix:
+                return lowerPostfix(e);
+            case ExprKind::Unary: {
+                uint32_t operand = lowerExpr(*e.args[0]);
+                return emit(e.op == TokenKind::LogicalNot ? IrOp::Not : IrOp::Neg, irType(e.type), operand);
+            }
+            case ExprKind::Binary:
+                return lowerBinary(e);
+            case ExprKind::Call: {
+                std::vector<uint32_t> args;
+                args.reserve(e.args.size());
+                for (const auto &arg : e.args) args.push_back(lowerExpr(*arg));
+                uint32_t call = emit(IrOp::Call, irType(e.type), kNoValue, kNoValue, kNoValue, e.symbol);
+                edit.setOperands(call, args);
+                return call;
+            }
+            case ExprKind::Index: {
+                auto [array, index] = lowerElement(e);
+                return emit(IrOp::Load, irType(e.type), array, index);
+            }
+        }
+        return kNoValue;
+    }
+
+    uint32_t readVar(int symbol) {
+        const Symbol &s = program.symbols[symbol];
+        if (s.function < 0) return emit(IrOp::LoadGlobal, irType(s.type), kNoValue, kNoValue, kNoValue, s.index);
+        return readVariable(symbol, current);
+    }
+
+    void writeVar(int symbol, uint32_t value) {
+        const Symbol &s = program.symbols[symbol];
+        if (s.function < 0) {
+            emit(IrOp::StoreGlobal, IrType::Void, value, kNoValue, kNoValue, s.index);
+        } else {
+            writeVariable(symbol, current, value);
+        }
+    }
+
+    // Dirección de un elemento: (arreglo, índice lineal) con verificación de límites.
+    // a[i][j] con dimensiones [d0][d1] se aplana como i * d1 + j.
+    std::pair<uint32_t, uint32_t> lowerElement(const Expr &e) {
+        std::vector<const Expr *> indices;
+        const Expr *root = &e;
+        while (root->kind == ExprKind::Index) {
+            indices.push_back(root->args[1].get());
+            root = root->args[0].get();
+        }
+        std::reverse(indices.begin(), indices.end());
+        uint32_t array = lowerExpr(*root);
+        const Type &arrayType = root->type;
+
+        uint32_t linear = lowerExpr(*indices[0]);
+        for (size_t k = 1; k < indices.size(); ++k) {
+            uint32_t index = lowerExpr(*indices[k]);
+            uint32_t dim = emitConst(IrType::Int, arrayType.dims[k]);
+            emit(IrOp::BoundsCheck, IrType::Void, index, dim);
+            linear = emit(IrOp::Add, IrType::Int, emit(IrOp::Mul, IrType::Int, linear, dim), index);
+        }
+        uint32_t length = emit(IrOp::ArrayLen, IrType::Int, array);
+        emit(IrOp::BoundsCheck, IrType::Void, linear, length);
+        return {array, linear};
+    }
+
+    uint32_t lowerAssign(const Expr &e) {
+        const Expr &target = *e.args[0];
+        if (target.kind == ExprKind::Index) {
+            auto [array, index] = lowerElement(target);
+            uint32_t value = lowerExpr(*e.args[1]);
+            emit(IrOp::Store, IrType::Void, array, index, value);
+            return value;
+        }
+        uint32_t value = lowerExpr(*e.args[1]);
+        writeVar(target.symbol, value);
+        return value;
+    }
+
+    uint32_t lowerPostfix(const Expr &e) {
+        const Expr &target = *e.args[0];
+        IrOp op = e.op == TokenKind::PostfixIncrement ? IrOp::Add : IrOp::Sub;
+        if (target.kind == ExprKind::Index) {
+            auto [array, index] = lowerElement(target);
+            uint32_t old = emit(IrOp::Load, IrType::Int, array, index);
+            uint32_t updated = emit(op, IrType::Int, old, emitConst(IrType::Int, 1));
+            emit(IrOp::Store, IrType::Void, array, index, updated);
+            return old;
+        }
+        uint32_t old = readVar(target.symbol);
+        uint32_t updated = emit(op, IrType::Int, old, emitConst(IrType::Int, 1));
+        writeVar(target.symbol, updated);
+        return old;
+    }
+
+    uint32_t toStr(uint32_t value, const Type &type) {
+        IrType t = irType(type);
+        if (t == IrType::Str) return value;
+        return emit(IrOp::ToStr, IrType::Str, value, kNoValue, kNoValue, static_cast<int64_t>(t));
+    }
+
+    uint32_t lowerBinary(const Expr &e) {
+        if (e.op == TokenKind::LogicalAnd || e.op == TokenKind::LogicalOr) {
+            return lowerShortCircuit(e);
+        }
+        const Expr &lhsExpr = *e.args[0];
+        const Expr &rhsExpr = *e.args[1];
+        uint32_t lhs = lowerExpr(lhsExpr);
+        uint32_t rhs = lowerExpr(rhsExpr);
+        bool strings = lhsExpr.type.isScalar(TokenKind::KwString);
+        IrType type = irType(e.type);
+        switch (e.op) {
+            case TokenKind::Addition:
+                if (type == IrType::Str) {
+                    lhs = toStr(lhs, lhsExpr.type);
+                    rhs = toStr(rhs, rhsExpr.type);
+                    return emit(IrOp::Concat, type, lhs, rhs);
+                }
+                return emit(IrOp::Add, type, lhs, rhs);
+            case TokenKind::Subtraction: return emit(IrOp::Sub, type, lhs, rhs);
+            case TokenKind::Multiplication: return emit(IrOp::Mul, type, lhs, rhs);
+            case TokenKind::Division: return emit(IrOp::Div, type, lhs, rhs);
+            case TokenKind::Modulus: return emit(IrOp::Mod, type, lhs, rhs);
+            case TokenKind::Exponentiation: return emit(IrOp::Pow, type, lhs, rhs);
+            case TokenKind::LessThan: return emit(IrOp::Lt, type, lhs, rhs);
+            case TokenKind::LessThanOrEqual: return emit(IrOp::Le, type, lhs, rhs);
+            case TokenKind::GreaterThan: return emit(IrOp::Gt, type, lhs, rhs);
+            case TokenKind::GreaterThanOrEqual: return emit(IrOp::Ge, type, lhs, rhs);
+            case TokenKind::isEqual: return emit(strings ? IrOp::StrEq : IrOp::Eq, type, lhs, rhs);
+            case TokenKind::NotEqual: return emit(strings ? IrOp::StrNe : IrOp::Ne, type, lhs, rhs);
+            default: return lhs;
+        }
+    }
+
+    // a && b  /  a || b  como flujo de control; el resultado es un phi en el bloque de unión
+    uint32_t lowerShortCircuit(const Expr &e) {
+        bool isAnd = e.op == TokenKind::LogicalAnd;
+        uint32_t temp = newTemp(IrType::Bool);
+        uint32_t lhs = lowerExpr(*e.args[0]);
+        writeVariable(temp, current, lhs);
+        uint32_t rhsBlock = newBlock(false);
+        uint32_t join = newBlock(false);
+        if (isAnd) branch(lhs, rhsBlock, join);
+        else branch(lhs, join, rhsBlock);
+        sealBlock(rhsBlock);
+
+        current = rhsBlock;
+        uint32_t rhs = lowerExpr(*e.args[1]);
+        writeVariable(temp, current, rhs);
+        jump(join);
+        sealBlock(join);
+        current = join;
+        return readVariable(temp, join);
+    }
+
+    // Sentencias
+    void lowerBlock(const std::vector<StmtPtr> &stmts) {
+        for (const auto &s : stmts) if (s) lowerStmt(*s);
+    }
+
+    void lowerVarDecl(const Stmt &s) {
+        const Symbol &symbol = program.symbols[s.symbol];
+        uint32_t value;
+        if (symbol.type.isArray()) {
+            int64_t length = 1;
+            for (int64_t d : symbol.type.dims) length *= d;
+            uint32_t size = emitConst(IrType::Int, length);
+            value = emit(IrOp::NewArray, IrType::Array, size, kNoValue, kNoValue, static_cast<int64_t>(elementType(symbol.type)));
+        } else if (s.expr) {
+            value = lowerExpr(*s.expr);
+        } else {
+            value = defaultValue(irType(symbol.type));
+        }
+        writeVar(s.symbol, value);
+    }
+
+    void lowerStmt(const Stmt &s) {
+        switch (s.kind) {
+            case StmtKind::VarDecl:
+                lowerVarDecl(s);
+                break;
+            case StmtKind::Expr:
+                if (s.expr) lowerExpr(*s.expr);
+                break;
+            case StmtKind::Print: {
+                // Una concatenación se escribe por partes, después de evaluarlas todas
+                // (igual que al armar la cadena), sin reservar las intermedias
+                std::vector<const Expr *> parts;
+                std::vector<uint32_t> values;
+                for (const auto &e : s.exprs) {
+                    parts.clear();
+                    values.clear();
+                    concatParts(*e, parts);
+                    for (const Expr *part : parts) values.push_back(lowerExpr(*part));
+                    for (size_t i = 0; i < parts.size(); ++i) {
+                        emit(IrOp::Print, IrType::Void, values[i], kNoValue, kNoValue,
+                             static_cast<int64_t>(irType(parts[i]->type)));
+                    }
+                }
+                emit(IrOp::PrintLn, IrType::Void);
+                break;
+            }
+            case StmtKind::Return: {
+                uint32_t value = s.expr ? lowerExpr(*s.expr) : kNoValue;
+                emit(IrOp::Return, IrType::Void, value);
+                // Lo que sigue a un return es inalcanzable: bloque sin predecesores
+                current = newBlock(true);
+                break;
+            }
+            case StmtKind::Block:
+                lowerBlock(s.body);
+                break;
+            case StmtKind::If:
+                lowerIf(s);
+                break;
+            case StmtKind::While:
+                lowerLoop(nullptr, s.expr.get(), nullptr, s.body);
+                break;
+            case StmtKind::For:
+                lowerLoop(s.init.get(), s.expr.get(), s.step.get(), s.body);
+                break;
+        }
+    }
+
+    void lowerIf(const Stmt &s) {
+        uint32_t cond = lowerExpr(*s.expr);
+        uint32_t thenBlock = newBlock(false);
+        uint32_t elseBlock = s.elseBody.empty() ? kNoBlock : newBlock(false);
+        uint32_t join = newBlock(false);
+        branch(cond, thenBlock, elseBlock == kNoBlock ? join : elseBlock);
+        sealBlock(thenBlock);
+
+        current = thenBlock;
+        lowerBlock(s.body);
+        jump(join);
+
+        if (elseBlock != kNoBlock) {
+            sealBlock(elseBlock);
+            current = elseBlock;
+            lowerBlock(s.elseBody);
+            jump(join);
+        }
+        sealBlock(join);
+        current = join;
+    }
+
+    // while y for: el bloque previo al encabezado actúa como pre-encabezado
+    void lowerLoop(const Stmt *init, const Expr *cond, const Expr *step, const std::vector<StmtPtr> &body) {
+        if (init) lowerStmt(*init);
+        uint32_t header = newBlock(false);
+        jump(header);
+        current = header;
+        uint32_t condValue = cond ? lowerExpr(*cond) : emitConst(IrType::Bool, 1);
+        uint32_t bodyBlock = newBlock(false);
+        uint32_t exit = newBlock(false);
+        branch(condValue, bodyBlock, exit);
+        sealBlock(bodyBlock);
+
+        current = bodyBlock;
+        lowerBlock(body);
+        if (step) lowerExpr(*step);
+        jump(header);
+        sealBlock(header);
+        sealBlock(exit);
+        current = exit;
+    }
+
+    // Prepara el estado para una nueva función con bloque de entrada sellado
+    void beginFunction() {
+        edit = IrEdit();
+        currentDef.clear();
+        sealed.clear();
+        incompletePhis.clear();
+        tempTypes.clear();
+        pendingPhis.clear();
+        current = newBlock(true);
+    }
+
+    void finishFunction(IrFunction &fn) {
+        if (!edit.isTerminated(current)) {
+            uint32_t value = fn.returnType == IrType::Void ? kNoValue : defaultValue(fn.returnType);
+            emit(IrOp::Return, IrType::Void, value);
+        }
+        // Los bloques vacíos que quedaron tras un return también necesitan terminador
+        for (uint32_t b = 0; b < edit.lists.size(); ++b) {
+            if (!edit.isTerminated(b)) {
+                current = b;
+                uint32_t value = fn.returnType == IrType::Void ? kNoValue : defaultValue(fn.returnType);
+                emit(IrOp::Return, IrType::Void, value);
+            }
+        }
+        edit.commit(fn);
+    }
+
+public:
+    IrLowering(const Program &program, IrModule &module) : program(program), module(module) {}
+
+    void run() {
+        module.functions.clear();
+        module.globals.clear();
+        for (const auto &symbol : program.symbols) {
+            if (symbol.function >= 0) continue;
+            if (module.globals.size() <= static_cast<size_t>(symbol.index)) module.globals.resize(symbol.index + 1);
+            module.globals[symbol.index].name = symbol.name;
+            module.globals[symbol.index].type = irType(symbol.type);
+        }
+
+        for (size_t i = 0; i < program.functions.size(); ++i) {
+            const Function &fn = program.functions[i];
+            IrFunction irFn;
+            irFn.name = fn.name;
+            Type ret;
+            ret.base = fn.returnType.base;
+            for (size_t d = 0; d < fn.returnType.dims.size(); ++d) ret.dims.push_back(0);
+            irFn.returnType = irType(ret);
+
+            beginFunction();
+            for (size_t p = 0; p < fn.params.size(); ++p) {
+                IrType type = irType(program.symbols[fn.params[p].symbol].type);
+                irFn.paramTypes.push_back(type);
+                uint32_t value = emit(IrOp::Param, type, kNoValue, kNoValue, kNoValue, static_cast<int64_t>(p));
+                writeVariable(fn.params[p].symbol, current, value);
+            }
+            lowerBlock(fn.body);
+            finishFunction(irFn);
+            module.functions.push_back(std::move(irFn));
+            if (fn.name == "main") module.mainFunction = static_cast<int>(i);
+        }
+
+        // $init: inicializadores de las globales en orden de declaración
+        IrFunction init;
+        init.name = "$init";
+        beginFunction();
+        for (const auto &g : program.globals) if (g) lowerVarDecl(*g);
+        finishFunction(init);
+        module.initFunction = static_cast<int>(module.functions.size());
+        module.functions.push_back(std::move(init));
+    }
+};
+
+#endif // LOWERING_H_
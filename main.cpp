@@ -1,46 +1,1393 @@
+#include <algorithm>
 #include <iostream>
 #include <fstream>
 #include <string>
 #include <unordered_map>
 #include <optional>
 #include <cctype>
+#include <cerrno>
+#include <csignal>
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <sstream>
 #include <stdlib.h>
+#include <spawn.h>
+#include <sys/wait.h>
+#include <unistd.h>
 
 #include "helper.h"
+#include "driver.h"
 #include "parser.h"
+#include "pipeline.h"
+#include "fold.h"
+#include "sema.h"
+#include "dce.h"
+#include "lowering.h"
+#include "inline.h"
+#include "gvn.h"
+#include "bce.h"
+#include "loops.h"
+#include "vectorize.h"
+#include "vm.h"
+#include "peephole.h"
+#include "interpreter.h"
+#include "x86.h"
+#include "native_runtime.h"
+#include "jit.h"
+#include "cgen.h"
+#include "server.h"
+#include "cache.h"
+#include "report.h"
+#include "benchsuite.h"
 
+// Reemplazo de los operator new/delete globales, que delegan en malloc/free. Con
+// allocationCountingEnabled() cuentan las asignaciones del hilo (para
+// --time-report) y las atribuyen a su fase y sitio si se pidió --alloc-report.
+// Las variantes de arreglos pasan por estas; las alineadas no se cuentan.
+void *operator new(std::size_t size) {
+    if (allocationCountingEnabled()) {
+        AllocationCounters &counters = allocationCounters();
+        counters.count++;
+        counters.bytes += size;
+        if (AllocationTracker *tracker = currentAllocationTracker()) tracker->record(size);
+    }
+    if (void *p = std::malloc(size ? size : 1)) return p;
+    throw std::bad_alloc();
+}
+
+// noinline: si g++ integra un delete en quien llama, -Wmismatched-new-delete ve
+// un free() sobre memoria de operator new y avisa, aunque aquí es correcto
+__attribute__((noinline)) void operator delete(void *p) noexcept {
+    std::free(p);
+}
+
+__attribute__((noinline)) void operator delete(void *p, std::size_t) noexcept {
+    std::free(p);
+}
 
+// Programas de referencia para --bench: recursión y bucles anidados
+static const char *const kBenchmarkFiles[] = {"BENCH_RECURSION.txt", "BENCH_LOOPS.txt"};
 
+// Caminos calientes que no deben asignar memoria (--alloc-check)
+static const char *const kAllocationFreeSites[] = {Parser::kEatTokenSite};
 
-int main() {
-    // Leer archivo de entrada
-    std::ifstream file("pruebaParser.txt"); // Asegúrate de que el archivo exista
+// Llamadas antes de compilar una función con el JIT; los programas cortos no llegan
+static const uint32_t kJitThreshold = 100;
+
+// Aviso de --pipeline en los modos que analizan en secuencia
+static const char *const kPipelineIgnored =
+    "--pipeline no se aplica con --lex-only ni al listar los tokens y la traza del parser "
+    "(sin --run, --emit-asm, --native, --emit-c ni --native-c); se analiza en secuencia.";
+
+
+static bool readSource(const std::string &path, std::string &buffer) {
+    std::ifstream file(path);
     if (!file.is_open()) {
-        //std::cerr << "No se pudo abrir el archivo 'codigo_fuente.txt'." << std::endl;
-        return 1;
+        return false;
+    }
+    buffer.assign((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    return true;
+}
+
+// Milisegundos de una ejecución
+template <typename F>
+static double timeMs(F run) {
+    auto start = std::chrono::steady_clock::now();
+    run();
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+// Hasta dónde llega la compilación (--lex-only, --parse-only o completa)
+enum class CompileStage { Lex, Parse, Full };
+
+// Del árbol sintáctico a la IR optimizada: semántica, plegado, DCE, traducción y
+// las pasadas sobre la IR, cada una medida en report (si no es nulo)
+static bool runPasses(bool verbose, Program &program, IrModule &module, TimeReport *report) {
+    // Análisis semántico sobre el árbol sin plegar: los errores en código que el
+    // plegado descartaría también se informan. Los tamaños de arreglo que no son
+    // literales se verifican en la segunda pasada, ya plegados.
+    SemanticAnalyzer sema;
+    bool ok = true;
+    timedPhase(report, "semántica", [&] { ok = sema.run(program, true); });
+    if (!ok) {
+        return false;
+    }
+
+    // Plegado y propagación de constantes sobre el árbol sintáctico
+    ConstantFolder folder;
+    FoldStats foldStats;
+    timedPhase(report, "plegado", [&] { foldStats = folder.run(program); });
+    if (verbose) {
+        compilerOut() << "INFO FOLD - " << foldStats.foldedExprs << " expresiones plegadas, "
+                  << foldStats.propagatedVars << " constantes propagadas, "
+                  << foldStats.prunedBranches << " ramas podadas, "
+                  << foldStats.removedLoops << " bucles eliminados\n";
+    }
+
+    // Los símbolos y tipos se vuelven a calcular sobre el árbol plegado, que
+    // es el que se traduce a la IR en forma SSA
+    timedPhase(report, "semántica", [&] { ok = sema.run(program); });
+    if (!ok) {
+        return false;
+    }
+
+    // Eliminación de funciones inalcanzables, globales sin uso y código tras return;
+    // los símbolos se vuelven a numerar con una segunda pasada semántica
+    DeadCodeEliminator eliminator;
+    DceStats dceStats;
+    timedPhase(report, "dce", [&] { dceStats = eliminator.run(program); });
+    if (verbose) {
+        compilerOut() << "INFO DCE - " << dceStats.removedFunctions << " funciones inalcanzables, "
+                  << dceStats.removedGlobals << " globales sin uso, "
+                  << dceStats.removedStmts << " sentencias tras return eliminadas\n";
+    }
+    if (eliminator.changed()) {
+        timedPhase(report, "semántica", [&] { ok = sema.run(program); });
+        if (!ok) return false;
+    }
+    timedPhase(report, "traducción a IR", [&] { IrLowering(program, module).run(); });
+
+    // Integración de funciones pequeñas y recursión en cola convertida en bucles
+    Inliner inliner;
+    InlineStats inlineStats;
+    timedPhase(report, "integración", [&] { inlineStats = inliner.run(module); });
+
+    // Numeración global de valores sobre la IR de cada función
+    GlobalValueNumbering gvn;
+    GvnStats gvnStats;
+    timedPhase(report, "gvn", [&] { gvnStats = gvn.run(module); });
+
+    // Verificaciones de límites demostradas por rangos o movidas a la entrada del bucle
+    BoundsCheckEliminator bce;
+    BceStats bceStats;
+    timedPhase(report, "bce", [&] { bceStats = bce.run(module); });
+
+    // Código invariante fuera de los bucles y reducción de fuerza
+    LoopOptimizer loopOptimizer;
+    LoopStats loopStats;
+    timedPhase(report, "bucles", [&] { loopStats = loopOptimizer.run(module); });
+
+    // Bucles elemento a elemento que el backend nativo ejecuta con SIMD
+    LoopVectorizer vectorizer;
+    VectorizeStats vectorStats;
+    timedPhase(report, "vectorización", [&] { vectorStats = vectorizer.run(module); });
+    if (verbose) {
+        compilerOut() << "INFO INLINE - " << inlineStats.inlinedCalls << " llamadas integradas, "
+                  << inlineStats.tailCalls << " llamadas en cola y " << inlineStats.accumulatedCalls
+                  << " con acumulador convertidas en bucles\n";
+        compilerOut() << "INFO GVN - " << gvnStats.redundantValues << " valores redundantes, "
+                  << gvnStats.redundantLoads << " lecturas reutilizadas, "
+                  << gvnStats.redundantChecks << " verificaciones de límites eliminadas\n";
+        compilerOut() << "INFO BCE - " << bceStats.removedChecks << " verificaciones de límites eliminadas, "
+                  << bceStats.hoistedChecks << " movidas a la entrada de " << bceStats.guardedLoops << " bucles\n";
+        compilerOut() << "INFO LOOP - " << loopStats.loops << " bucles, " << loopStats.hoisted
+                  << " instrucciones invariantes movidas, " << loopStats.reducedMuls << " multiplicaciones y "
+                  << loopStats.reducedPows << " potencias reducidas, " << loopStats.expandedPows
+                  << " potencias expandidas\n";
+        compilerOut() << "INFO VEC - " << vectorStats.loops << " bucles vectorizables, "
+                  << vectorStats.reductions << " acumuladores\n";
     }
+    return true;
+}
 
-    // Leer el contenido del archivo en un buffer
-    std::string buffer((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
-    file.close();
+// Corre las pasadas; con verbose termina con la línea INFO TIME, y con
+// --time-report suma sus medidas al informe del hilo
+static bool compileProgram(bool verbose, Program &program, IrModule &module) {
+    TimeReport *active = currentTimeReport();
+    TimeReport passes(active && active->detailed());
+    bool ok = runPasses(verbose, program, module, verbose || active ? &passes : nullptr);
+    if (ok && verbose) compilerOut() << "INFO TIME - " << passes.summary() << '\n';
+    if (active) active->merge(passes);
+    return ok;
+}
 
-    // Instanciar el archivo fuente con el contenido del archivo .txt
-    SourceFile sourceFile{"codigo_fuente.txt", buffer};
+// Análisis léxico, sintáctico y semántico, plegado de constantes y traducción a la IR.
+// Con verbose se imprimen los tokens, la traza del parser y las estadísticas.
+// Con stopAfter Lex o Parse sólo se informan los errores de esa etapa. Con
+// pipelined (ver DriverOptions::pipelineApplies) el lexer corre en otro hilo
+// mientras el parser consume sus tokens.
+static bool compileToIr(const SourceFile &sourceFile, bool verbose, Program &program, IrModule &module,
+                        CompileStage stopAfter = CompileStage::Full, bool pipelined = false) {
+    TimeReport *report = currentTimeReport();
+    if (pipelined) {
+        bool parsed;
+        {
+            ScopedPhase phase(report, "léxico y sintáctico");
+            PipelinedLexer lexer(sourceFile);
+            Parser parser(lexer, false);
+            parser.setProfile(currentRuleProfile());
+            parsed = parser.parse();
+            lexer.finish();
+            if (AllocationTracker *allocations = currentAllocationTracker()) allocations->tokens += lexer.tokenCount();
+            if (parsed) program = std::move(parser.getProgram());
+        }
+        if (!parsed) return false;
+        if (stopAfter == CompileStage::Parse) return true;
+        return compileProgram(verbose, program, module);
+    }
 
-    std::cout << "INFO SCAN - Start scanning...\n";
-    
     // Crear el lexer usando el archivo fuente
-    Lexer lexer(sourceFile);  // Instancia del lexer principal
+    Lexer lexer = [&] {
+        ScopedPhase phase(report, "léxico");
+        return Lexer(sourceFile);  // Instancia del lexer principal
+    }();
+    if (AllocationTracker *allocations = currentAllocationTracker()) allocations->tokens += lexer.tokenCount();
 
     // Imprimir la lista de tokens del lexer
-    lexer.printTokens();
+    if (verbose) timedPhase(report, "lista de tokens", [&] { lexer.printTokens(); });
+    if (stopAfter == CompileStage::Lex) return lexer.getErrorCount() == 0;
 
     // Crear una copia del lexer para usar en el parser
-    Lexer lexerCopy = lexer; // Creamos una copia del lexer original
+    Lexer lexerCopy = [&] {
+        ScopedPhase phase(report, "copia del lexer");
+        return lexer; // Creamos una copia del lexer original
+    }();
 
     // Instanciar el parser con la copia del lexer
-    Parser parser(lexerCopy); // Pasamos la copia al parser
-    parser.parse(); // Ejecutar el parser para analizar la sintaxis del código fuente
+    Parser parser(lexerCopy, verbose); // Pasamos la copia al parser
+    parser.setProfile(currentRuleProfile());
+    bool parsed = true;
+    timedPhase(report, "sintáctico", [&] { parsed = parser.parse(); });
+    if (!parsed) { // Ejecutar el parser para analizar la sintaxis del código fuente
+        return false;
+    }
+    if (stopAfter == CompileStage::Parse) return true;
+    program = std::move(parser.getProgram());
+    return compileProgram(verbose, program, module);
+}
+
+// Ejecuta el cc del sistema con estos argumentos y espera a que termine. No pasa
+// por el shell: las rutas (que pueden venir de un cliente del servidor) llegan
+// tal cual, con comillas o espacios incluidos.
+static bool runCc(const std::vector<std::string> &args) {
+    std::vector<char *> argv;
+    argv.push_back(const_cast<char *>("cc"));
+    for (const std::string &arg : args) argv.push_back(const_cast<char *>(arg.c_str()));
+    argv.push_back(nullptr);
+    pid_t pid;
+    if (posix_spawnp(&pid, "cc", nullptr, nullptr, argv.data(), environ) != 0) return false;
+    int status = 0;
+    while (waitpid(pid, &status, 0) < 0) {
+        if (errno != EINTR) return false;
+    }
+    return WIFEXITED(status) && WEXITSTATUS(status) == 0;
+}
+
+// Una ruta que empieza con '-' se leería como opción de cc
+static std::string ccPath(const std::string &path) {
+    return !path.empty() && path[0] == '-' ? "./" + path : path;
+}
+
+// Genera el ensamblador, escribe el runtime junto a él y enlaza con el cc del sistema
+static bool buildNative(const IrModule &module, const std::string &output, uint32_t vectorLanes) {
+    std::string asmPath = output + ".s";
+    std::string runtimePath = output + ".rt.c";
+    {
+        std::ofstream asmFile(asmPath);
+        X86Generator(module, asmFile, vectorLanes).run();
+        std::ofstream runtimeFile(runtimePath);
+        runtimeFile << kNativeRuntimeSource;
+        if (!asmFile || !runtimeFile) {
+            compilerErr() << "No se pudo escribir '" << asmPath << "'." << std::endl;
+            return false;
+        }
+    }
+    bool linked = runCc({"-O2", "-o", ccPath(output), ccPath(asmPath), ccPath(runtimePath)});
+    std::remove(runtimePath.c_str());
+    if (!linked) {
+        compilerErr() << "Error al ensamblar y enlazar '" << asmPath << "'." << std::endl;
+        return false;
+    }
+    return true;
+}
+
+// Traduce el programa a C (runtime incluido en el mismo archivo) y lo compila con cc -O2
+static bool buildC(const Program &program, const std::string &output) {
+    std::string sourcePath = output + ".c";
+    {
+        std::ofstream sourceFile(sourcePath);
+        sourceFile << kNativeRuntimeSource;
+        CGenerator(program, sourceFile).run();
+        if (!sourceFile) {
+            compilerErr() << "No se pudo escribir '" << sourcePath << "'." << std::endl;
+            return false;
+        }
+    }
+    if (!runCc({"-O2", "-o", ccPath(output), ccPath(sourcePath)})) {
+        compilerErr() << "Error al compilar '" << sourcePath << "'." << std::endl;
+        return false;
+    }
+    return true;
+}
+
+// Ejecuta el bytecode en la VM; con jit, las funciones y bucles calientes pasan a
+// código nativo tras callThreshold llamadas (y diez veces más vueltas de bucle)
+static bool runVm(const IrModule &module, const BcModule &bytecode, OutputBuffer &out, bool jit, uint32_t callThreshold,
+                  Arena *arena = nullptr) {
+    VirtualMachine vm(bytecode, out, arena);
+#ifdef BM_JIT_AVAILABLE
+    std::unique_ptr<JitCompiler> compiler;
+    if (jit) {
+        compiler.reset(new JitCompiler(module, bytecode, vm));
+        if (compiler->available()) vm.setTierUp(compiler.get(), callThreshold, callThreshold * 10);
+        else compilerErr() << "No se pudo reservar memoria ejecutable; se usa sólo la VM." << std::endl;
+    }
+#else
+    (void)module;
+    (void)callThreshold;
+    if (jit) compilerErr() << "El JIT no está disponible en esta plataforma; se usa sólo la VM." << std::endl;
+#endif
+    return vm.run();
+}
+
+// Ejecuta cada programa de referencia compilado a C (la referencia), con la VM y
+// el JIT y con el intérprete del AST; los demás tiempos se dan relativos a C
+static int runBenchmarks() {
+    static const char *const kExecutable = "./.bench_c";
+    OutputBuffer discard(OutputBuffer::kDiscard);
+    for (const char *path : kBenchmarkFiles) {
+        std::string buffer;
+        if (!readSource(path, buffer)) {
+            std::cerr << "No se pudo abrir el archivo '" << path << "'." << std::endl;
+            return 1;
+        }
+        SourceFile sourceFile{path, buffer};
+        Program program;
+        IrModule module;
+        BcModule bytecode;
+        if (!compileToIr(sourceFile, false, program, module) || !BytecodeCompiler(module).compile(bytecode)) {
+            return 1;
+        }
+        BytecodePeephole().run(bytecode);
+
+        bool ok = buildC(program, kExecutable);
+        std::remove((std::string(kExecutable) + ".c").c_str());
+        if (!ok) return 1;
+        double cMs = timeMs([&] { ok = std::system((std::string(kExecutable) + " > /dev/null").c_str()) == 0; });
+        std::remove(kExecutable);
+        double jitMs = timeMs([&] { ok = runVm(module, bytecode, discard, true, kJitThreshold) && ok; });
+        double vmMs = timeMs([&] { ok = runVm(module, bytecode, discard, false, 0) && ok; });
+        double treeMs = timeMs([&] { ok = TreeWalker(program, discard).run() && ok; });
+        if (!ok) return 1;
+
+        auto relative = [cMs](double ms) { return cMs > 0 ? ms / cMs : 0; };
+        std::cout << "INFO BENCH - " << path << ": C " << cMs << " ms (referencia), JIT " << jitMs
+                  << " ms (" << relative(jitMs) << "x), VM " << vmMs << " ms (" << relative(vmMs)
+                  << "x), árbol " << treeMs << " ms (" << relative(treeMs) << "x)\n";
+    }
+    return 0;
+}
+
+// Pares de operaciones más frecuentes al ejecutar los programas en la VM (sin
+// JIT ni superinstrucciones), para elegir qué fusionar; sin archivos usa los de
+// --bench. Al final compara con lo que se ejecuta después del peephole.
+static int reportOpPairs(std::vector<std::string> paths) {
+    static const size_t kTopPairs = 20;
+    if (paths.empty()) paths.assign(std::begin(kBenchmarkFiles), std::end(kBenchmarkFiles));
+    OutputBuffer discard(OutputBuffer::kDiscard);
+    BcProfile profile, fusedProfile;
+    for (const std::string &path : paths) {
+        std::string buffer;
+        if (!readSource(path, buffer)) {
+            std::cerr << "No se pudo abrir el archivo '" << path << "'." << std::endl;
+            return 1;
+        }
+        SourceFile sourceFile{path, buffer};
+        Program program;
+        IrModule module;
+        BcModule bytecode;
+        if (!compileToIr(sourceFile, false, program, module) || !BytecodeCompiler(module).compile(bytecode)) {
+            return 1;
+        }
+        VirtualMachine vm(bytecode, discard);
+        profile.last = -1;
+        vm.setProfile(&profile);
+        vm.run();
+
+        BytecodePeephole().run(bytecode);
+        VirtualMachine fusedVm(bytecode, discard);
+        fusedProfile.last = -1;
+        fusedVm.setProfile(&fusedProfile);
+        fusedVm.run();
+    }
+
+    std::vector<std::pair<uint64_t, std::pair<int, int>>> pairs;
+    for (int a = 0; a < BcProfile::kNumOps; ++a) {
+        for (int b = 0; b < BcProfile::kNumOps; ++b) {
+            if (profile.pairs[a][b]) pairs.push_back({profile.pairs[a][b], {a, b}});
+        }
+    }
+    std::sort(pairs.begin(), pairs.end(), [](const auto &x, const auto &y) { return x.first > y.first; });
+    const uint64_t total = profile.total();
+    std::cout << "INFO OPS - " << total << " instrucciones ejecutadas en " << paths.size() << " programas\n";
+    for (size_t i = 0; i < pairs.size() && i < kTopPairs; ++i) {
+        std::cout << "INFO OPS - " << bcOpName(static_cast<BcOp>(pairs[i].second.first)) << " -> "
+                  << bcOpName(static_cast<BcOp>(pairs[i].second.second)) << ": " << pairs[i].first << " ("
+                  << 100.0 * static_cast<double>(pairs[i].first) / static_cast<double>(total) << "%)\n";
+    }
+    const uint64_t fusedTotal = fusedProfile.total();
+    std::cout << "INFO OPS - con superinstrucciones: " << fusedTotal << " instrucciones ("
+              << (total ? 100.0 * static_cast<double>(total - fusedTotal) / static_cast<double>(total) : 0.0)
+              << "% menos)\n";
+    return 0;
+}
+
+// Compila el texto hasta el bytecode optimizado, como --run sin ejecutarlo, con
+// los mensajes descartados: lo que mide --bench-suite
+static void compileForBench(const SourceFile &sourceFile) {
+    std::ostream discard(nullptr);
+    CompilerStreams saved = compilerStreams();
+    compilerStreams() = CompilerStreams{&discard, &discard};
+    Program program;
+    IrModule module;
+    BcModule bytecode;
+    if (compileToIr(sourceFile, false, program, module) && BytecodeCompiler(module).compile(bytecode)) {
+        BytecodePeephole().run(bytecode);
+    }
+    compilerStreams() = saved;
+}
+
+// Modo --bench-suite: compila cada programa del corpus (los ejemplos del
+// repositorio, los programas generados y las entradas lentas de
+// bench_regressions/) primero sin medir y después options.runs veces, y compara
+// la mediana con la de la referencia, escalada por la calibración de esta
+// máquina. Con --bench-update escribe la referencia en vez de comparar. Devuelve
+// 1 si algún programa quedó más lento que la referencia más su umbral.
+static int runBenchSuite(const BenchSuiteOptions &options) {
+    static const double kMinSampleMs = 20.0;  // los programas cortos se repiten hasta llegar
+    std::vector<std::pair<std::string, std::string>> corpus;
+    for (const char *path : kBenchSuiteFiles) {
+        std::string buffer;
+        if (!readSource(path, buffer)) {
+            std::cerr << "No se pudo abrir el archivo '" << path << "'." << std::endl;
+            return 1;
+        }
+        corpus.emplace_back(path, std::move(buffer));
+    }
+    for (auto &program : generatedBenchPrograms()) corpus.push_back(std::move(program));
+    std::vector<std::string> slowInputs;
+    expandGlob(std::string(kBenchRegressionsDir) + "/*.txt", slowInputs);
+    for (const std::string &path : slowInputs) {
+        std::string buffer;
+        if (path.find('*') == std::string::npos && readSource(path, buffer)) corpus.emplace_back(path, std::move(buffer));
+    }
+
+    JsonValue baseline;
+    bool haveBaseline = false;
+    std::string baselineText;
+    if (readSource(options.baselinePath, baselineText)) {
+        if (!JsonReader(baselineText).read(baseline) || baseline.kind != JsonValue::Kind::Object) {
+            std::cerr << "La referencia '" << options.baselinePath << "' no es JSON válido." << std::endl;
+            return 1;
+        }
+        haveBaseline = true;
+    } else if (!options.update) {
+        std::cerr << "No se pudo abrir la referencia '" << options.baselinePath
+                  << "' (se crea con --bench-update)." << std::endl;
+        return 1;
+    }
+
+    // Calibración antes y después de medir el corpus: vale la más rápida
+    double calibrationMs = benchCalibrationMs();
+    std::vector<BenchResult> results;
+    for (auto &entry : corpus) {
+        BenchResult result;
+        result.name = entry.first;
+        result.bytes = entry.second.size();
+        SourceFile sourceFile{entry.first, std::move(entry.second)};
+        double once = timeMs([&] { compileForBench(sourceFile); });
+        for (unsigned int i = 0; i < options.warmup; ++i) once = timeMs([&] { compileForBench(sourceFile); });
+        if (once < kMinSampleMs) result.repeat = static_cast<unsigned int>(kMinSampleMs / std::max(once, 0.001)) + 1;
+        std::vector<double> samples;
+        for (unsigned int i = 0; i < options.runs; ++i) {
+            double ms = timeMs([&] {
+                for (unsigned int r = 0; r < result.repeat; ++r) compileForBench(sourceFile);
+            });
+            samples.push_back(ms / result.repeat);
+        }
+        result.stats = computeBenchStats(samples);
+        results.push_back(result);
+    }
+    calibrationMs = std::min(calibrationMs, benchCalibrationMs());
+
+    double scale = 1;
+    if (haveBaseline && !options.update) {
+        double reference = baseline.numberOr("calibration_ms", 0);
+        if (reference > 0) scale = calibrationMs / reference;
+        std::cout << "INFO BENCH SUITE - calibración " << fixedDecimals(calibrationMs, 3) << " ms (referencia "
+                  << fixedDecimals(reference, 3) << " ms, factor " << fixedDecimals(scale, 3) << ")\n";
+    }
+    const double fileThreshold = haveBaseline ? baseline.numberOr("threshold_pct", kBenchDefaultThresholdPct)
+                                              : kBenchDefaultThresholdPct;
+    const JsonValue *references = haveBaseline ? baseline.get("benchmarks") : nullptr;
+    unsigned int regressions = 0;
+    for (const BenchResult &result : results) {
+        std::cout << "INFO BENCH SUITE - " << result.name << " (" << result.bytes << " bytes): mediana "
+                  << fixedDecimals(result.stats.medianMs, 3) << " ms, p90 " << fixedDecimals(result.stats.p90Ms, 3)
+                  << " ms, p99 " << fixedDecimals(result.stats.p99Ms, 3) << " ms, mínimo "
+                  << fixedDecimals(result.stats.minMs, 3) << " ms";
+        const JsonValue *reference = nullptr;
+        for (size_t b = 0; references && b < references->items.size(); ++b) {
+            const JsonValue *name = references->items[b].get("name");
+            if (name && name->string == result.name) reference = &references->items[b];
+        }
+        if (options.update || !reference || reference->numberOr("median_ms", 0) <= 0) {
+            std::cout << (options.update ? "\n" : "; sin referencia\n");
+            continue;
+        }
+        double referenceMs = reference->numberOr("median_ms", 0) * scale;
+        double threshold = options.thresholdPct >= 0 ? options.thresholdPct
+                                                     : reference->numberOr("threshold_pct", fileThreshold);
+        double change = 100.0 * (result.stats.medianMs / referenceMs - 1);
+        std::cout << "; referencia " << fixedDecimals(referenceMs, 3) << " ms (" << (change >= 0 ? "+" : "")
+                  << fixedDecimals(change, 1) << "%, umbral " << threshold << "%)\n";
+        if (change > threshold) {
+            std::cerr << "ERROR BENCH SUITE - " << result.name << ": la mediana " << fixedDecimals(result.stats.medianMs, 3)
+                      << " ms es " << fixedDecimals(change, 1) << "% más lenta que la referencia "
+                      << fixedDecimals(referenceMs, 3) << " ms (umbral " << threshold << "%)" << std::endl;
+            regressions++;
+        }
+    }
+
+    if (options.update) {
+        std::ofstream file(options.baselinePath);
+        writeBenchBaseline(file, results, calibrationMs,
+                           options.thresholdPct >= 0 ? options.thresholdPct : fileThreshold,
+                           haveBaseline ? &baseline : nullptr);
+        if (!file) {
+            std::cerr << "No se pudo escribir '" << options.baselinePath << "'." << std::endl;
+            return 1;
+        }
+        std::cout << "INFO BENCH SUITE - referencia escrita en '" << options.baselinePath << "' (calibración "
+                  << calibrationMs << " ms)\n";
+        return 0;
+    }
+    std::cout << "INFO BENCH SUITE - " << results.size() << " programas, " << regressions << " regresiones\n";
+    if (regressions) {
+        std::cerr << "ERROR BENCH SUITE - REGRESIÓN DE RENDIMIENTO: " << regressions
+                  << " programas más lentos que la referencia" << std::endl;
+        return 1;
+    }
+    return 0;
+}
+
+// Opciones de la línea de comandos que afectan a cada archivo
+struct DriverOptions {
+    bool emitIr = false;
+    bool emitBytecode = false;
+    bool run = false;
+    bool emitAsm = false;
+    bool native = false;
+    bool emitC = false;
+    bool nativeC = false;
+    bool jit = false;
+    bool lineBuffered = false;
+    bool pipeline = false;
+    CompileStage stopAfter = CompileStage::Full;
+    uint32_t jitThreshold = kJitThreshold;
+    uint32_t vectorLanes = 2;
+    std::string output = "b.out";
+    CompileCache *cache = nullptr;  // --cache-dir
+    bool timeReport = false;        // --time-report: cada hilo del grupo mide en su propio informe
+    bool parseProfile = false;      // --parse-profile: ídem con el perfil de reglas del parser
+    bool allocReport = false;       // --alloc-report: ídem con el seguimiento de asignaciones
+
+    // Al ejecutar o generar código, la salida estándar queda sólo para el resultado
+    bool verbose() const {
+        return !run && !emitAsm && !native && !emitC && !nativeC;
+    }
+
+    // El lexer en otro hilo no sirve para listar todos los tokens antes de la
+    // traza del parser (verbose), ni cuando no hay parser que consuma los tokens
+    bool pipelineApplies() const {
+        return pipeline && !verbose() && stopAfter != CompileStage::Lex;
+    }
+
+    // Las opciones que cambian los mensajes o el código de un archivo (para las
+    // cachés; la de disco agrega el hash del ejecutable)
+    std::string resultKey() const {
+        std::string key;
+        for (bool flag : {emitIr, emitBytecode, run, emitAsm, native, emitC, nativeC}) key += flag ? '1' : '0';
+        key += std::to_string(static_cast<int>(stopAfter)) + ',' + std::to_string(vectorLanes);
+        key += '\0';
+        return key;
+    }
+};
+
+// Un archivo de entrada: lo que produce la compilación (en un hilo del grupo si
+// hay varios archivos) y los mensajes capturados para imprimirlos en orden
+struct CompileJob {
+    std::string path;
+    std::string directory;  // --serve: directorio del cliente, para las rutas relativas
+    Arena *arena = nullptr;  // arena prestada a la VM (--stream la reutiliza entre programas)
+    std::string *programOutput = nullptr;  // salida del programa en memoria (--serve), en vez de la consola
+    // Caché en disco: la clave del texto, y la entrada si estaba o los mensajes para guardarla
+    std::string cacheKey;
+    std::unique_ptr<CacheEntry> cacheHit;
+    std::string compileOut, compileErr;
+    std::ostringstream out, err;
+    Program program;
+    IrModule module;
+    BcModule bytecode;
+    bool ok = false;
+};
+
+// Compila el texto y escribe lo que se emite como texto (IR, bytecode,
+// ensamblador, C) en compilerOut(). Se puede llamar en paralelo.
+static void compileSource(CompileJob &job, const SourceFile &sourceFile, const DriverOptions &options) {
+    bool verbose = options.verbose();
+    if (verbose) compilerOut() << "INFO SCAN - Start scanning...\n";
+    if (!compileToIr(sourceFile, verbose, job.program, job.module, options.stopAfter, options.pipelineApplies())) {
+        return;
+    }
+    job.ok = true;
+    if (options.stopAfter != CompileStage::Full) return;
+
+    TimeReport *report = currentTimeReport();
+    if (options.emitIr) timedPhase(report, "impresión de IR", [&] { printIr(job.module, compilerOut()); });
+    if (options.emitAsm) {
+        timedPhase(report, "ensamblador", [&] { X86Generator(job.module, compilerOut(), options.vectorLanes).run(); });
+    }
+    if (options.emitC) {
+        timedPhase(report, "traducción a C", [&] {
+            compilerOut() << kNativeRuntimeSource;
+            CGenerator(job.program, compilerOut()).run();
+        });
+    }
+    if (options.run || options.emitBytecode) {
+        bool compiled = true;
+        timedPhase(report, "bytecode", [&] { compiled = BytecodeCompiler(job.module).compile(job.bytecode); });
+        if (!compiled) {
+            job.ok = false;
+            return;
+        }
+        PeepholeStats peephole;
+        timedPhase(report, "peephole", [&] { peephole = BytecodePeephole().run(job.bytecode); });
+        if (verbose) {
+            compilerOut() << "INFO PEEPHOLE - superinstrucciones: " << peephole.compareJumps << " comparación + salto, "
+                      << peephole.increments << " incrementos, " << peephole.moves << " copias, "
+                      << peephole.calls << " llamada + retorno\n";
+        }
+        if (options.emitBytecode) {
+            timedPhase(report, "impresión de bytecode", [&] { printBytecode(job.bytecode, compilerOut()); });
+        }
+    }
+}
+
+// Lee el archivo del trabajo y lo compila. Con la caché en disco, si el mismo
+// texto ya se compiló con las mismas opciones, sólo repite sus mensajes y toma el
+// bytecode guardado; si no, compila juntando los mensajes para guardarlos.
+// Con --jit no se usa: el JIT necesita la IR, que no se guarda.
+static void compileJob(CompileJob &job, const DriverOptions &options) {
+    std::string buffer;
+    bool read = false;
+    timedPhase(currentTimeReport(), "lectura", [&] { read = readSource(resolvePath(job.directory, job.path), buffer); });
+    if (!read) {
+        compilerErr() << "No se pudo abrir el archivo '" << job.path << "'." << std::endl;
+        return;
+    }
+    if (!options.cache || options.jit) {
+        compileSource(job, SourceFile{job.path, std::move(buffer)}, options);
+        return;
+    }
+    std::unique_ptr<CacheEntry> entry(new CacheEntry);
+    bool hit;
+    {
+        ScopedPhase phase(currentTimeReport(), "caché");
+        job.cacheKey = CompileCache::key(buffer, options.resultKey());
+        hit = options.cache->lookup(job.cacheKey, *entry) &&
+              (entry->bytecode.empty() || deserializeBytecode(entry->bytecode, job.bytecode));
+    }
+    if (hit) {
+        compilerOut() << entry->out;
+        compilerErr() << entry->err;
+        job.ok = entry->ok;
+        job.cacheHit = std::move(entry);
+        return;
+    }
+    std::ostringstream out, err;
+    CompilerStreams &streams = compilerStreams();
+    CompilerStreams saved = streams;
+    streams = CompilerStreams{&out, &err};
+    compileSource(job, SourceFile{job.path, std::move(buffer)}, options);
+    streams = saved;
+    job.compileOut = out.str();
+    job.compileErr = err.str();
+    compilerOut() << job.compileOut;
+    compilerErr() << job.compileErr;
+}
+
+// Los mensajes sin la línea INFO TIME: al repetirlos desde una caché, los tiempos
+// de aquella compilación no son los de ésta
+static std::string withoutTimeLines(const std::string &messages) {
+    static const char kTimeLine[] = "INFO TIME - ";
+    std::string result;
+    for (size_t begin = 0, end; begin < messages.size(); begin = end) {
+        end = messages.find('\n', begin);
+        end = end == std::string::npos ? messages.size() : end + 1;
+        if (messages.compare(begin, sizeof(kTimeLine) - 1, kTimeLine) != 0) result.append(messages, begin, end - begin);
+    }
+    return result;
+}
+
+// Guarda en la caché lo compilado: mensajes, bytecode y el ejecutable ya enlazado
+static void storeInCache(const CompileJob &job, const DriverOptions &options) {
+    CacheRecord record;
+    record.ok = job.ok;
+    record.out = withoutTimeLines(job.compileOut);
+    record.err = job.compileErr;
+    if (job.ok && options.stopAfter == CompileStage::Full) {
+        if (options.run) record.bytecode = serializeBytecode(job.bytecode);
+        if ((options.native || options.nativeC) && !readSource(options.output, record.executable)) return;
+    }
+    options.cache->store(job.cacheKey, record);
+}
+
+// Escribe el ejecutable guardado en la caché donde lo habría dejado el enlazador
+static bool writeCachedExecutable(const CacheEntry &entry, const std::string &output) {
+    {
+        std::ofstream file(output, std::ios::binary | std::ios::trunc);
+        file.write(entry.executable.data(), static_cast<std::streamsize>(entry.executable.size()));
+        if (!file) {
+            compilerErr() << "No se pudo escribir '" << output << "'." << std::endl;
+            return false;
+        }
+    }
+    chmod(output.c_str(), 0755);
+    return true;
+}
+
+// Lo que usa la consola o el sistema y se hace en orden, en el hilo principal:
+// enlazar los ejecutables y correr el programa
+static void finishJob(CompileJob &job, const DriverOptions &options) {
+    bool linked = true;
+    if (job.ok && options.stopAfter == CompileStage::Full && (options.native || options.nativeC)) {
+        ScopedPhase phase(currentTimeReport(), "enlace");
+        if (job.cacheHit) {
+            linked = writeCachedExecutable(*job.cacheHit, options.output);
+        } else {
+            if (options.native && !buildNative(job.module, options.output, options.vectorLanes)) linked = false;
+            if (options.nativeC && !buildC(job.program, options.output)) linked = false;
+        }
+    }
+    // Un enlace fallido puede ser del entorno (cc), no del programa: eso no se guarda
+    if (!job.cacheKey.empty() && !job.cacheHit && linked) storeInCache(job, options);
+    job.ok = job.ok && linked;
+    if (!job.ok || options.stopAfter != CompileStage::Full) return;
+    if (options.run) {
+        // La salida del programa va directo al descriptor: lo anterior ya tiene que estar escrito
+        std::cout.flush();
+        std::unique_ptr<OutputBuffer> out(job.programOutput ? new OutputBuffer(*job.programOutput)
+                                                            : new OutputBuffer(STDOUT_FILENO, options.lineBuffered));
+        ScopedPhase phase(currentTimeReport(), "ejecución");
+        job.ok = runVm(job.module, job.bytecode, *out, options.jit, options.jitThreshold, job.arena);
+    }
+}
+
+// Mensajes capturados del trabajo, con el nombre del archivo delante de cada error
+static void printJobMessages(const CompileJob &job, std::ostream &out = std::cout, std::ostream &err = std::cerr) {
+    out << job.out.str();
+    std::istringstream errors(job.err.str());
+    for (std::string line; std::getline(errors, line);) err << job.path << ": " << line << '\n';
+}
+
+// Imprime los mensajes de compilación del trabajo y lo termina; los errores de
+// ejecución (y de enlace) se imprimen después con el mismo prefijo
+static void finishPrintedJob(CompileJob &job, const DriverOptions &options, std::ostream &out = std::cout,
+                             std::ostream &err = std::cerr) {
+    printJobMessages(job, out, err);
+    job.out.str("");
+    job.err.str("");
+    CompilerStreams &streams = compilerStreams();
+    CompilerStreams saved = streams;
+    streams.err = &job.err;
+    finishJob(job, options);
+    streams = saved;
+    printJobMessages(job, out, err);
+}
+
+// Compila cada archivo en el grupo de hilos e imprime sus mensajes en el orden de
+// las entradas, con el nombre del archivo delante de cada error; devuelve la
+// cantidad de archivos con errores
+static size_t compileAll(const std::vector<std::string> &inputs, const DriverOptions &options, unsigned int threads) {
+    std::vector<std::unique_ptr<CompileJob>> jobs;
+    for (const std::string &path : inputs) {
+        jobs.emplace_back(new CompileJob);
+        jobs.back()->path = path;
+    }
+    size_t failed = 0;
+    std::vector<TimeReport> reports(options.timeReport ? jobs.size() : 0, TimeReport(true));
+    std::vector<std::unique_ptr<RuleProfile>> profiles;
+    for (size_t i = 0; options.parseProfile && i < jobs.size(); ++i) {
+        profiles.emplace_back(new RuleProfile(static_cast<uint16_t>(i + 1)));
+    }
+    std::vector<std::unique_ptr<AllocationTracker>> allocations;
+    for (size_t i = 0; options.allocReport && i < jobs.size(); ++i) allocations.emplace_back(new AllocationTracker);
+    ThreadPool(threads).run(
+        jobs.size(),
+        [&](size_t i) {
+            CompilerStreams &streams = compilerStreams();
+            streams.out = &jobs[i]->out;
+            streams.err = &jobs[i]->err;
+            currentTimeReport() = options.timeReport ? &reports[i] : nullptr;
+            currentRuleProfile() = options.parseProfile ? profiles[i].get() : nullptr;
+            currentAllocationTracker() = options.allocReport ? allocations[i].get() : nullptr;
+            compileJob(*jobs[i], options);
+            streams = CompilerStreams{};
+            currentTimeReport() = nullptr;
+            currentRuleProfile() = nullptr;
+            currentAllocationTracker() = nullptr;
+        },
+        [&](size_t i) {
+            CompileJob &job = *jobs[i];
+            if (options.timeReport) currentTimeReport()->merge(reports[i]);
+            if (options.parseProfile) {
+                currentRuleProfile()->merge(*profiles[i]);
+                profiles[i].reset();
+            }
+            if (options.allocReport) {
+                currentAllocationTracker()->merge(*allocations[i]);
+                allocations[i].reset();
+            }
+            finishPrintedJob(job, options);
+            if (!job.ok) failed++;
+            jobs[i].reset();
+        });
+    return failed;
+}
+
+// ¿El '$' en la posición dada cierra el programa que empieza al principio del
+// texto? Dentro de una cadena o un comentario el lexer no se detiene en él.
+static bool endsProgram(const std::string &text, size_t dollar) {
+    std::ostringstream discard;
+    CompilerStreams saved = compilerStreams();
+    compilerStreams() = CompilerStreams{&discard, &discard};
+    SourceFile prefix{"", text.substr(0, dollar + 1)};
+    Lexer lexer(prefix);
+    compilerStreams() = saved;
+    return lexer.reachedEndMarker();
+}
+
+// Modo --stream: lee de la entrada estándar (o de un archivo) muchos programas
+// terminados en '$' y compila (y ejecuta) cada uno apenas llega su '$', con su
+// resultado escrito antes de leer el siguiente. Cada programa tiene su propio
+// lexer y parser; la arena de la VM se reutiliza entre ejecuciones.
+static int runStream(const std::string &path, const DriverOptions &options) {
+    std::ifstream file;
+    std::istream *in = &std::cin;
+    if (path != "-") {
+        file.open(path);
+        if (!file.is_open()) {
+            std::cerr << "No se pudo abrir el archivo '" << path << "'." << std::endl;
+            return 1;
+        }
+        in = &file;
+    }
+    const std::string name = path == "-" ? "<stdin>" : path;
+    Arena arena;
+    unsigned int programs = 0, failed = 0;
+    auto compileProgram = [&](std::string text) {
+        if (text.find_first_not_of(" \t\r\n") == std::string::npos) return;
+        CompileJob job;
+        job.path = name + "#" + std::to_string(++programs);
+        job.arena = &arena;
+        arena.reset();
+        CompilerStreams &streams = compilerStreams();
+        streams.out = &job.out;
+        streams.err = &job.err;
+        compileSource(job, SourceFile{job.path, std::move(text)}, options);
+        streams = CompilerStreams{};
+        finishPrintedJob(job, options);
+        if (!job.ok) failed++;
+        std::cout.flush();
+    };
+
+    std::string pending;  // texto recibido que todavía no cierra un programa
+    size_t scanned = 0;   // hasta dónde se buscó '$' en pending
+    for (std::string line; std::getline(*in, line);) {
+        pending += line;
+        pending += '\n';
+        for (size_t dollar; (dollar = pending.find('$', scanned)) != std::string::npos;) {
+            if (!endsProgram(pending, dollar)) {
+                scanned = dollar + 1;
+                continue;
+            }
+            compileProgram(pending.substr(0, dollar + 1));
+            // El resto de la línea del '$', si está en blanco, no cuenta para el siguiente
+            size_t next = dollar + 1;
+            size_t newline = pending.find('\n', next);
+            if (newline != std::string::npos && pending.find_first_not_of(" \t\r", next) == newline) next = newline + 1;
+            pending.erase(0, next);
+            scanned = 0;
+        }
+    }
+    compileProgram(std::move(pending));
+    if (options.verbose()) {
+        std::cout << "INFO STREAM - " << programs << " programas, " << failed << " con errores\n";
+    }
+    return failed ? 1 : 0;
+}
+
+// Opción que cambia cómo se compila cada archivo (con su valor, si lleva);
+// false si args[i] no es una de ellas
+static bool parseCompileOption(const std::vector<std::string> &args, size_t &i, DriverOptions &options) {
+    const std::string &arg = args[i];
+    bool hasValue = i + 1 < args.size();
+    if (arg == "--emit-ir") options.emitIr = true;
+    else if (arg == "--emit-bytecode") options.emitBytecode = true;
+    else if (arg == "--run") options.run = true;
+    else if (arg == "--emit-asm") options.emitAsm = true;
+    else if (arg == "--native") options.native = true;
+    else if (arg == "--emit-c") options.emitC = true;
+    else if (arg == "--native-c") options.nativeC = true;
+    else if (arg == "--jit") options.run = options.jit = true;
+    else if (arg == "--jit-threshold" && hasValue) options.jitThreshold = static_cast<uint32_t>(std::strtoul(args[++i].c_str(), nullptr, 10));
+    else if (arg == "--line-buffered") options.lineBuffered = true;
+    else if (arg == "--avx2") options.vectorLanes = 4;
+    else if (arg == "--no-simd") options.vectorLanes = 0;
+    else if (arg == "--lex-only") options.stopAfter = CompileStage::Lex;
+    else if (arg == "--parse-only") options.stopAfter = CompileStage::Parse;
+    else if (arg == "--pipeline") options.pipeline = true;
+    else if (arg == "-o" && hasValue) options.output = args[++i];
+    else return false;
+    return true;
+}
+
+static std::string currentDirectory() {
+    std::unique_ptr<char, decltype(&free)> cwd(getcwd(nullptr, 0), &free);
+    return cwd ? std::string(cwd.get()) : std::string(".");
+}
+
+// Lo que el servidor guarda de cada archivo compilado: mientras el archivo y las
+// opciones no cambien, el pedido siguiente reutiliza los mensajes (sin la línea
+// INFO TIME de aquella compilación), la IR y el bytecode
+struct CachedCompile {
+    FileStamp stamp;
+    std::string out, err;
+    bool ok = false;
+    IrModule module;
+    BcModule bytecode;
+};
+
+// Estado que el servidor mantiene caliente entre pedidos
+struct ServerState {
+    static const size_t kMaxCachedFiles = 1024;
+
+    int listener = -1;
+    std::vector<pid_t> children;  // procesos de --run que todavía no terminaron
+    std::unordered_map<std::string, CachedCompile> cache;
+    Arena arena;
+    uint64_t requests = 0;
+    uint64_t hits = 0;
+    uint64_t micros = 0;
+};
+
+// Un archivo de un pedido: el trabajo y cómo se vuelve a guardar en la caché
+struct ServedFile {
+    CompileJob job;
+    std::string key;
+    FileStamp stamp;
+    std::string out, err;  // mensajes de la compilación, para la caché
+    bool cacheable = false;
+    bool hit = false;
+    bool compiled = false;
+};
+
+// Segunda mitad de un pedido, con los archivos ya compilados: mensajes, enlace y
+// ejecución de cada uno, en orden, y la respuesta al cliente (después de warnings)
+static void answerRequest(std::vector<std::unique_ptr<ServedFile>> &files, const DriverOptions &options,
+                          const std::string &warnings, int client) {
+    std::ostringstream out, err;
+    err << warnings;
+    CompilerStreams &streams = compilerStreams();
+    streams = CompilerStreams{&out, &err};
+    size_t failed = 0;
+    for (auto &file : files) {
+        CompileJob &job = file->job;
+        std::string programOutput;
+        job.programOutput = &programOutput;
+        if (job.arena) job.arena->reset();
+        if (files.size() > 1) {
+            finishPrintedJob(job, options, out, err);
+        } else {
+            out << job.out.str();
+            err << job.err.str();
+            finishJob(job, options);
+        }
+        job.programOutput = nullptr;
+        out << programOutput;
+        if (!job.ok) failed++;
+    }
+    streams = CompilerStreams{};
+    if (files.size() > 1 && options.verbose()) {
+        out << "INFO DRIVER - " << files.size() << " archivos, " << failed << " con errores\n";
+    }
+    sendStrings(client, {failed ? "1" : "0", out.str(), err.str()});
+}
+
+// Atiende un pedido de --client: las opciones y archivos de la línea de comandos
+// (el archivo "-" es el texto que el cliente leyó de su entrada estándar) se
+// compilan como lo haría el driver, con las rutas relativas al directorio del
+// cliente, y la respuesta se manda por client. La ejecución de --run pasa en un
+// proceso hijo que responde por su cuenta: un programa que no termina no detiene
+// al servidor.
+static void serveRequest(ServerState &state, const std::vector<std::string> &request, int client, bool &shutdown) {
+    const std::string &cwd = request[0];
+    const std::string &stdinSource = request[1];
+    const std::vector<std::string> args(request.begin() + 2, request.end());
+    auto reject = [&](const std::string &message) { sendStrings(client, {"1", "", message + '\n'}); };
+    DriverOptions options;
+    std::vector<std::string> inputs;
+    for (size_t i = 0; i < args.size(); ++i) {
+        const std::string &arg = args[i];
+        if (parseCompileOption(args, i, options)) continue;
+        if (arg == "-j" && i + 1 < args.size()) ++i;  // el servidor atiende de a un archivo
+        else if (arg == "--shutdown") shutdown = true;
+        else if (arg == "-") inputs.push_back(arg);
+        else if (arg[0] == '-') {
+            // Las demás opciones son del driver (modos, caché en disco, informes)
+            return reject("La opción '" + arg + "' no está disponible a través del servidor.");
+        }
+        else expandGlob(arg, inputs, cwd);
+    }
+    if (shutdown) {
+        sendStrings(client, {"0", "", ""});
+        return;
+    }
+    if (inputs.empty()) inputs.push_back("pruebaParser.txt");
+    if (inputs.size() > 1 && (options.native || options.nativeC)) {
+        return reject("--native y --native-c aceptan un solo archivo de entrada.");
+    }
+    options.output = resolvePath(cwd, options.output);
+    std::string warnings;
+    if (options.pipeline && !options.pipelineApplies()) warnings = std::string(kPipelineIgnored) + '\n';
+
+    // Compilación (o la caché caliente) de cada archivo, en el servidor
+    const std::string keyPrefix = options.resultKey();
+    CompilerStreams &streams = compilerStreams();
+    std::vector<std::unique_ptr<ServedFile>> files;
+    for (const std::string &path : inputs) {
+        files.emplace_back(new ServedFile);
+        ServedFile &file = *files.back();
+        CompileJob &job = file.job;
+        job.path = path == "-" ? "<stdin>" : path;
+        job.directory = cwd;
+        job.arena = &state.arena;
+
+        // La CGenerator de --native-c necesita el AST, que no se guarda
+        file.cacheable = !options.nativeC;
+        if (path == "-") file.key = keyPrefix + "-" + '\0' + stdinSource;
+        else if (fileStamp(resolvePath(cwd, path), file.stamp)) file.key = keyPrefix + resolvePath(cwd, path);
+        else file.cacheable = false;
+        auto cached = file.cacheable ? state.cache.find(file.key) : state.cache.end();
+        file.hit = cached != state.cache.end() && cached->second.stamp == file.stamp;
+        if (file.hit) {
+            CachedCompile &entry = cached->second;
+            job.out << entry.out;
+            job.err << entry.err;
+            job.ok = entry.ok;
+            job.module = std::move(entry.module);
+            job.bytecode = std::move(entry.bytecode);
+            state.hits++;
+        } else {
+            streams = CompilerStreams{&job.out, &job.err};
+            if (path == "-") compileSource(job, SourceFile{job.path, stdinSource}, options);
+            else compileJob(job, options);
+            streams = CompilerStreams{};
+            file.out = job.out.str();
+            file.err = job.err.str();
+        }
+        file.compiled = job.ok;
+    }
+
+    // Ejecución en un hijo, que tiene su copia de lo compilado y responde al cliente
+    pid_t child = options.run ? fork() : -1;
+    if (child == 0) {
+        close(state.listener);
+        answerRequest(files, options, warnings, client);
+        _exit(0);
+    }
+    if (child < 0) answerRequest(files, options, warnings, client);
+    if (child > 0) state.children.push_back(child);
+
+    for (auto &file : files) {
+        if (!file->cacheable) continue;
+        if (!file->hit && state.cache.size() >= ServerState::kMaxCachedFiles) state.cache.clear();
+        CachedCompile &entry = state.cache[file->key];
+        entry.stamp = file->stamp;
+        entry.ok = file->compiled;
+        if (!file->hit) {
+            entry.out = withoutTimeLines(file->out);
+            entry.err = std::move(file->err);
+        }
+        entry.module = std::move(file->job.module);
+        entry.bytecode = std::move(file->job.bytecode);
+    }
+}
 
+// Modo --serve: escucha en un socket Unix y atiende los pedidos de --client de a
+// uno, sin pagar en cada uno el arranque del proceso. Entre pedidos quedan
+// calientes la tabla de palabras clave, la arena de la VM y la caché de archivos
+// ya compilados. Cada conexión tiene un límite de espera, y los programas de
+// --run corren en procesos hijos. Termina con un pedido --shutdown.
+static int runServer(std::string socketPath) {
+    static const int kClientTimeoutSeconds = 10;
+    if (socketPath[0] != '/') socketPath = currentDirectory() + '/' + socketPath;
+    ServerState state;
+    state.listener = listenUnix(socketPath);
+    if (state.listener < 0) {
+        std::cerr << "No se pudo escuchar en el socket '" << socketPath << "'." << std::endl;
+        return 1;
+    }
+    signal(SIGPIPE, SIG_IGN);  // un cliente que se va no debe terminar el servidor
+    std::cout.flush();         // lo pendiente no debe repetirse en la salida de los hijos
+    for (bool shutdown = false; !shutdown;) {
+        int client = accept(state.listener, nullptr, nullptr);
+        auto &children = state.children;
+        children.erase(std::remove_if(children.begin(), children.end(),
+                                      [](pid_t pid) { return waitpid(pid, nullptr, WNOHANG) != 0; }),
+                       children.end());
+        if (client < 0) {
+            if (errno == EINTR) continue;
+            break;
+        }
+        setSocketTimeout(client, kClientTimeoutSeconds);
+        std::vector<std::string> request;
+        if (receiveStrings(client, request) && request.size() >= 2) {
+            auto start = std::chrono::steady_clock::now();
+            serveRequest(state, request, client, shutdown);
+            state.micros += static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(
+                std::chrono::steady_clock::now() - start).count());
+            state.requests++;
+        }
+        close(client);
+    }
+    close(state.listener);
+    unlink(socketPath.c_str());
+    // Un programa que no terminó no sobrevive al servidor
+    for (pid_t pid : state.children) {
+        kill(pid, SIGKILL);
+        waitpid(pid, nullptr, 0);
+    }
+    std::cout << "INFO SERVE - " << state.requests << " pedidos, " << state.hits << " archivos desde la caché, "
+              << (state.requests ? state.micros / state.requests : 0) << " us por pedido en promedio\n";
     return 0;
 }
+
+// Modo --client: manda la línea de comandos (y el directorio actual, y la entrada
+// estándar si algún archivo es "-") al servidor y reproduce su respuesta
+static int runClient(const std::string &socketPath, const std::vector<std::string> &args) {
+    std::vector<std::string> request{currentDirectory(), ""};
+    if (std::find(args.begin(), args.end(), "-") != args.end()) {
+        std::ostringstream text;
+        text << std::cin.rdbuf();
+        request[1] = text.str();
+    }
+    request.insert(request.end(), args.begin(), args.end());
+    int fd = connectUnix(socketPath);
+    if (fd < 0) {
+        std::cerr << "No hay un servidor escuchando en '" << socketPath << "'." << std::endl;
+        return 1;
+    }
+    std::vector<std::string> response;
+    bool answered = sendStrings(fd, request) && receiveStrings(fd, response) && response.size() == 3;
+    close(fd);
+    if (!answered) {
+        std::cerr << "El servidor cerró la conexión sin responder." << std::endl;
+        return 1;
+    }
+    writeAll(STDOUT_FILENO, response[1].data(), response[1].size());
+    writeAll(STDERR_FILENO, response[2].data(), response[2].size());
+    return std::atoi(response[0].c_str());
+}
+
+// --time-report: la tabla va a la salida de errores (la estándar puede ser la del
+// programa); con --time-report-json también el JSON, a un archivo o a "-"
+static void printTimeReport(const TimeReport &report, const std::string &jsonPath) {
+    std::cerr << "INFO TIME REPORT\n";
+    report.printTable(std::cerr);
+    if (jsonPath.empty()) return;
+    if (jsonPath == "-") {
+        report.printJson(std::cout);
+        return;
+    }
+    std::ofstream file(jsonPath);
+    report.printJson(file);
+    if (!file) std::cerr << "No se pudo escribir '" << jsonPath << "'." << std::endl;
+}
+
+// --parse-profile: la tabla de reglas a la salida de errores; con --parse-trace,
+// los eventos en el formato de Chrome a un archivo
+static void printRuleProfile(const RuleProfile &profile, const std::string &tracePath) {
+    std::cerr << "INFO PARSE PROFILE\n";
+    profile.printTable(std::cerr);
+    if (tracePath.empty()) return;
+    std::ofstream file(tracePath);
+    profile.printChromeTrace(file);
+    if (!file) std::cerr << "No se pudo escribir '" << tracePath << "'." << std::endl;
+}
+
+// --alloc-report: las asignaciones por fase y por sitio a la salida de errores.
+// Con check (--alloc-check), además verifica que los caminos de
+// kAllocationFreeSites no hayan asignado memoria; devuelve false si alguno lo hizo.
+static bool printAllocationReport(const AllocationTracker &tracker, bool report, bool check) {
+    if (report) {
+        std::cerr << "INFO ALLOC REPORT - ";
+        tracker.printTable(std::cerr);
+    }
+    if (!check) return true;
+    bool ok = true;
+    for (const char *site : kAllocationFreeSites) {
+        uint64_t count = tracker.siteAllocations(site);
+        if (count == 0) {
+            std::cerr << "INFO ALLOC CHECK - '" << site << "' no asignó memoria\n";
+            continue;
+        }
+        std::cerr << "ERROR ALLOC CHECK - '" << site << "' hizo " << count
+                  << " asignaciones y no debería hacer ninguna" << std::endl;
+        ok = false;
+    }
+    return ok;
+}
+
+int main(int argc, char *argv[]) {
+    std::vector<std::string> args;
+    if (!expandResponseFiles(std::vector<std::string>(argv + 1, argv + argc), args)) return 1;
+
+    DriverOptions options;
+    options.lineBuffered = isatty(STDOUT_FILENO);
+    unsigned int threads = 0;
+    std::vector<std::string> inputs;
+    bool opPairs = false;
+    bool stream = false;
+    std::string cacheDir;
+    uint64_t cacheMegabytes = 256;
+    bool cacheStats = false;
+    std::string timeReportJson;
+    std::string parseTrace;
+    bool allocReport = false;
+    bool allocCheck = false;
+    bool benchSuite = false;
+    BenchSuiteOptions suite;
+    for (size_t i = 0; i < args.size(); ++i) {
+        if (parseCompileOption(args, i, options)) continue;
+        const std::string &arg = args[i];
+        bool hasValue = i + 1 < args.size();
+        if (arg == "-j" && hasValue) threads = static_cast<unsigned int>(std::strtoul(args[++i].c_str(), nullptr, 10));
+        else if (arg == "--serve" && hasValue) return runServer(args[i + 1]);
+        else if (arg == "--client" && hasValue) {
+            std::vector<std::string> forwarded(args.begin(), args.begin() + i);
+            forwarded.insert(forwarded.end(), args.begin() + i + 2, args.end());
+            return runClient(args[i + 1], forwarded);
+        }
+        else if (arg == "--bench") return runBenchmarks();
+        else if (arg == "--bench-suite") benchSuite = true;
+        else if (arg == "--bench-baseline" && hasValue) suite.baselinePath = args[++i];
+        else if (arg == "--bench-update") suite.update = true;
+        else if (arg == "--bench-runs" && hasValue) {
+            suite.runs = std::max(1u, static_cast<unsigned int>(std::strtoul(args[++i].c_str(), nullptr, 10)));
+        }
+        else if (arg == "--bench-warmup" && hasValue) {
+            suite.warmup = static_cast<unsigned int>(std::strtoul(args[++i].c_str(), nullptr, 10));
+        }
+        else if (arg == "--bench-threshold" && hasValue) suite.thresholdPct = std::strtod(args[++i].c_str(), nullptr);
+        else if (arg == "--op-pairs") opPairs = true;
+        else if (arg == "--stream") stream = true;
+        else if (arg == "--cache-dir" && hasValue) cacheDir = args[++i];
+        else if (arg == "--cache-size" && hasValue) cacheMegabytes = std::strtoull(args[++i].c_str(), nullptr, 10);
+        else if (arg == "--cache-stats") cacheStats = true;
+        else if (arg == "--time-report") options.timeReport = true;
+        else if (arg == "--time-report-json" && hasValue) {
+            timeReportJson = args[++i];
+            options.timeReport = true;
+        }
+        else if (arg == "--parse-profile") options.parseProfile = true;
+        else if (arg == "--parse-trace" && hasValue) {
+            parseTrace = args[++i];
+            options.parseProfile = true;
+        }
+        else if (arg == "--alloc-report") allocReport = options.allocReport = true;
+        else if (arg == "--alloc-check") allocCheck = options.allocReport = true;
+        else expandGlob(arg, inputs);
+    }
+    if (benchSuite) return runBenchSuite(suite);
+    allocationCountingEnabled() = options.timeReport || options.allocReport;
+    if (options.pipeline && !options.pipelineApplies()) std::cerr << kPipelineIgnored << std::endl;
+    TimeReport timeReport(true);
+    if (options.timeReport) currentTimeReport() = &timeReport;
+    RuleProfile ruleProfile;
+    if (options.parseProfile) currentRuleProfile() = &ruleProfile;
+    std::unique_ptr<AllocationTracker> allocations(options.allocReport ? new AllocationTracker : nullptr);
+    currentAllocationTracker() = allocations.get();
+    // Los informes se imprimen sin medir: sus asignaciones no son de la compilación
+    auto printReports = [&]() {
+        currentAllocationTracker() = nullptr;
+        if (options.timeReport) printTimeReport(timeReport, timeReportJson);
+        if (options.parseProfile) printRuleProfile(ruleProfile, parseTrace);
+        return !allocations || printAllocationReport(*allocations, allocReport, allocCheck);
+    };
+    if (cacheDir.empty()) {
+        if (const char *dir = std::getenv("BM_CACHE_DIR")) cacheDir = dir;
+    }
+    std::unique_ptr<CompileCache> cache;
+    if (!cacheDir.empty()) {
+        cache.reset(new CompileCache(cacheDir, cacheMegabytes << 20));
+        if (!cache->open()) {
+            std::cerr << "No se pudo usar el directorio de caché '" << cacheDir << "'." << std::endl;
+            return 1;
+        }
+        options.cache = cache.get();
+    }
+    if (cacheStats) {
+        if (!cache) {
+            std::cerr << "--cache-stats necesita --cache-dir (o BM_CACHE_DIR)." << std::endl;
+            return 1;
+        }
+        CacheStats stats = cache->loadStats();
+        uint64_t lookups = stats.hits + stats.misses;
+        std::cout << "INFO CACHE - " << stats.hits << " aciertos, " << stats.misses << " fallos ("
+                  << (lookups ? 100 * stats.hits / lookups : 0) << "% de aciertos), " << stats.entries
+                  << " entradas, " << stats.bytes << " bytes\n";
+        return 0;
+    }
+    if (opPairs) return reportOpPairs(inputs);
+    if (stream) {
+        if (inputs.size() > 1 || options.native || options.nativeC) {
+            std::cerr << "--stream lee un solo archivo (o la entrada estándar) y no genera ejecutables." << std::endl;
+            return 1;
+        }
+        int status = runStream(inputs.empty() ? "-" : inputs[0], options);
+        return printReports() ? status : 1;
+    }
+    if (inputs.empty()) inputs.push_back("pruebaParser.txt");
+
+    if (inputs.size() > 1 && (options.native || options.nativeC)) {
+        std::cerr << "--native y --native-c aceptan un solo archivo de entrada." << std::endl;
+        return 1;
+    }
+
+    int status;
+    if (inputs.size() == 1) {
+        // Un solo archivo: todo en el hilo principal y los mensajes directo a la consola
+        CompileJob job;
+        job.path = inputs[0];
+        compileJob(job, options);
+        finishJob(job, options);
+        status = job.ok ? 0 : 1;
+    } else {
+        size_t failed = compileAll(inputs, options, threads);
+        if (options.verbose()) {
+            std::cout << "INFO DRIVER - " << inputs.size() << " archivos, " << failed << " con errores\n";
+        }
+        status = failed ? 1 : 0;
+    }
+    if (cache) {
+        if (options.verbose()) {
+            std::cout << "INFO CACHE - " << cache->sessionHits() << " aciertos, " << cache->sessionMisses()
+                      << " fallos\n";
+        }
+        cache->saveStats();
+    }
+    return printReports() ? status : 1;
+}
@@ -0,0 +1,258 @@
+#ifndef NATIVE_RUNTIME_H_
+#define NATIVE_RUNTIME_H_
+
+// Runtime en C para los ejecutables nativos. El compilador lo escribe junto al
+// código generado y lo compila con cc; por eso vive aquí como texto y no como
+// un archivo aparte que haya que encontrar en tiempo de ejecución.
+//
+// Convenciones (las mismas de runtime.h): cadenas {longitud, bytes} y arreglos
+// {longitud, elementos de 8 bytes} en una arena; la salida se acumula en un
+// buffer y se escribe con write(2) al llenarse y al terminar, y además en cada
+// fin de línea si la salida es una terminal.
+static const char *const kNativeRuntimeSource = R"RUNTIME(
+#include <signal.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+typedef struct { int64_t length; char data[]; } BmStr;
+typedef struct { int64_t length; int64_t data[]; } BmArray;
+
+/* Salida */
+static char bm_out[1 << 16];
+static size_t bm_out_len;
+static int bm_line_buffered;
+
+static void bm_write_all(int fd, const char *p, size_t n) {
+    while (n > 0) {
+        ssize_t written = write(fd, p, n);
+        if (written <= 0) return;
+        p += written;
+        n -= (size_t)written;
+    }
+}
+
+void bm_flush(void) {
+    bm_write_all(1, bm_out, bm_out_len);
+    bm_out_len = 0;
+}
+
+static void bm_write(const char *p, size_t n) {
+    if (n > sizeof(bm_out) - bm_out_len) {
+        bm_flush();
+        if (n > sizeof(bm_out)) {
+            bm_write_all(1, p, n);
+            return;
+        }
+    }
+    memcpy(bm_out + bm_out_len, p, n);
+    bm_out_len += n;
+}
+
+/* Dos dígitos por división, como formatInt de runtime.h */
+static char *bm_format_int(int64_t value, char *end) {
+    static const char pairs[] =
+        "00010203040506070809101112131415161718192021222324252627282930313233343536373839"
+        "40414243444546474849505152535455565758596061626364656667686970717273747576777879"
+        "8081828384858687888990919293949596979899";
+    uint64_t magnitude = value < 0 ? 0 - (uint64_t)value : (uint64_t)value;
+    char *p = end;
+    while (magnitude >= 100) {
+        const char *pair = pairs + (magnitude % 100) * 2;
+        magnitude /= 100;
+        *--p = pair[1];
+        *--p = pair[0];
+    }
+    if (magnitude >= 10) {
+        *--p = pairs[magnitude * 2 + 1];
+        *--p = pairs[magnitude * 2];
+    } else {
+        *--p = (char)('0' + magnitude);
+    }
+    if (value < 0) *--p = '-';
+    return p;
+}
+
+/* Errores de ejecución */
+static void bm_fail(const char *message, size_t length) {
+    bm_flush();
+    bm_write_all(2, "Runtime Error: ", 15);
+    bm_write_all(2, message, length);
+    bm_write_all(2, "\n", 1);
+    _exit(1);
+}
+
+void bm_div_zero(void) {
+    bm_fail("division by zero", 16);
+}
+
+void bm_bounds_error(int64_t index) {
+    char buffer[64];
+    char digits[24];
+    char *begin = bm_format_int(index, digits + sizeof(digits));
+    size_t n = (size_t)(digits + sizeof(digits) - begin);
+    memcpy(buffer, "array index ", 12);
+    memcpy(buffer + 12, begin, n);
+    memcpy(buffer + 12 + n, " out of bounds", 14);
+    bm_fail(buffer, 26 + n);
+}
+
+static void bm_stack_overflow(int signal) {
+    (void)signal;
+    bm_fail("stack overflow", 14);
+}
+
+/* Arena */
+static char *bm_arena_ptr;
+static char *bm_arena_end;
+
+static void *bm_alloc(size_t bytes) {
+    bytes = (bytes + 7) & ~(size_t)7;
+    if ((size_t)(bm_arena_end - bm_arena_ptr) < bytes) {
+        size_t size = bytes > (1u << 20) ? bytes : (1u << 20);
+        bm_arena_ptr = (char *)malloc(size);
+        if (!bm_arena_ptr) bm_fail("out of memory", 13);
+        bm_arena_end = bm_arena_ptr + size;
+    }
+    void *result = bm_arena_ptr;
+    bm_arena_ptr += bytes;
+    return result;
+}
+
+static BmStr *bm_new_str(const char *text, size_t length) {
+    BmStr *s = (BmStr *)bm_alloc(sizeof(BmStr) + length + 1);
+    s->length = (int64_t)length;
+    memcpy(s->data, text, length);
+    s->data[length] = '\0';
+    return s;
+}
+
+/* Cadenas */
+BmStr *bm_concat(const BmStr *a, const BmStr *b) {
+    BmStr *s = (BmStr *)bm_alloc(sizeof(BmStr) + (size_t)(a->length + b->length) + 1);
+    s->length = a->length + b->length;
+    memcpy(s->data, a->data, (size_t)a->length);
+    memcpy(s->data + a->length, b->data, (size_t)b->length);
+    s->data[s->length] = '\0';
+    return s;
+}
+
+/* Cadenas cortas compartidas (booleanos, caracteres, enteros chicos y la vacía):
+   se arman una sola vez fuera de la arena en lugar de en cada conversión */
+typedef struct { int64_t length; char data[8]; } BmShortStr;
+static BmShortStr bm_bool_strs[2] = {{5, "false"}, {4, "true"}};
+static BmShortStr bm_char_strs[256];
+static BmShortStr bm_small_int_strs[256];
+static BmShortStr bm_empty_str;
+
+BmStr *bm_int_to_str(int64_t value) {
+    if ((uint64_t)value < 256) {
+        BmShortStr *s = &bm_small_int_strs[value];
+        if (!s->length) {
+            char digits[4];
+            char *begin = bm_format_int(value, digits + sizeof(digits));
+            s->length = digits + sizeof(digits) - begin;
+            memcpy(s->data, begin, (size_t)s->length);
+        }
+        return (BmStr *)s;
+    }
+    char digits[24];
+    char *begin = bm_format_int(value, digits + sizeof(digits));
+    return bm_new_str(begin, (size_t)(digits + sizeof(digits) - begin));
+}
+
+BmStr *bm_bool_to_str(int64_t value) {
+    return (BmStr *)&bm_bool_strs[value != 0];
+}
+
+BmStr *bm_char_to_str(int64_t value) {
+    BmShortStr *s = &bm_char_strs[(unsigned char)value];
+    s->length = 1;
+    s->data[0] = (char)value;
+    return (BmStr *)s;
+}
+
+int64_t bm_str_eq(const BmStr *a, const BmStr *b) {
+    return a->length == b->length && memcmp(a->data, b->data, (size_t)a->length) == 0;
+}
+
+/* Arreglos: los de cadenas empiezan con la cadena vacía */
+BmArray *bm_new_array(int64_t length, int64_t strings) {
+    if (length < 0) bm_fail("negative array size", 19);
+    BmArray *array = (BmArray *)bm_alloc(sizeof(BmArray) + sizeof(int64_t) * (size_t)length);
+    array->length = length;
+    int64_t fill = strings ? (int64_t)(intptr_t)&bm_empty_str : 0;
+    for (int64_t i = 0; i < length; ++i) array->data[i] = fill;
+    return array;
+}
+
+/* Potencia entera con la convención de runtime.h para exponentes negativos */
+int64_t bm_pow(int64_t base, int64_t exp) {
+    if (exp < 0) {
+        if (base == 1) return 1;
+        if (base == -1) return (exp & 1) ? -1 : 1;
+        return 0;
+    }
+    uint64_t result = 1, b = (uint64_t)base;
+    while (exp > 0) {
+        if (exp & 1) result *= b;
+        b *= b;
+        exp >>= 1;
+    }
+    return (int64_t)result;
+}
+
+/* print */
+void bm_print_int(int64_t value) {
+    char digits[24];
+    char *begin = bm_format_int(value, digits + sizeof(digits));
+    bm_write(begin, (size_t)(digits + sizeof(digits) - begin));
+}
+
+void bm_print_bool(int64_t value) {
+    if (value) bm_write("true", 4);
+    else bm_write("false", 5);
+}
+
+void bm_print_char(int64_t value) {
+    if (bm_out_len == sizeof(bm_out)) bm_flush();
+    bm_out[bm_out_len++] = (char)value;
+}
+
+void bm_print_str(const BmStr *s) {
+    bm_write(s->data, (size_t)s->length);
+}
+
+void bm_println(void) {
+    bm_print_char('\n');
+    if (bm_line_buffered) bm_flush();
+}
+
+/* Generados por el compilador */
+void bm_init_globals(void);
+void bm_main(void);
+
+int main(void) {
+    /* Pila alternativa para informar el desborde de la pila en lugar de abortar */
+    static char alternate[1 << 16];
+    stack_t stack;
+    stack.ss_sp = alternate;
+    stack.ss_size = sizeof(alternate);
+    stack.ss_flags = 0;
+    sigaltstack(&stack, 0);
+    struct sigaction action;
+    memset(&action, 0, sizeof(action));
+    action.sa_handler = bm_stack_overflow;
+    action.sa_flags = SA_ONSTACK;
+    sigaction(SIGSEGV, &action, 0);
+    bm_line_buffered = isatty(1);
+
+    bm_init_globals();
+    bm_main();
+    bm_flush();
+    return 0;
+}
+)RUNTIME";
+
+#endif // NATIVE_RUNTIME_H_
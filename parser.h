@@ -2,34 +2,63 @@
 #define PARSER_H_
 
 #include "lexer.h"
+#include "ast.h"
+#include "report.h"
+#include "ruleprofile.h"
 #include <iostream>
 #include <string>
 #include <set>
 
 class Parser {
 private:
-    Lexer &lexer;
+    TokenSource &lexer;
     Token currentToken;
     std::string debugPrefix;
+    Program ast;
+    unsigned int errorCount = 0;
+    bool tracing;
+    RuleProfile *profile = nullptr;
+    uint32_t tokensConsumed = 0;
+
+    // Salida de la traza de reglas (descartada si la traza está desactivada)
+    std::ostream &trace() {
+        thread_local std::ostream discard(nullptr);
+        return tracing ? compilerOut() : discard;
+    }
 
      // Función para realizar la recuperación por pánico
     void panicRecoveryForRule(const std::set<TokenKind> &followSet) {
-        std::cout << debugPrefix << "Entering panic recovery mode." << std::endl; // Nuevo mensaje
+        AllocationSite site(parserRuleSite(ParserRule::PanicRecovery));
+        trace() << debugPrefix << "Entering panic recovery mode." << '\n'; // Nuevo mensaje
+        if (profile) profile->enter(ParserRule::PanicRecovery, tokensConsumed);
         while (currentToken.kind != TokenKind::Eof && followSet.find(currentToken.kind) == followSet.end()) {
             eatToken();
         }
-        std::cout << debugPrefix << "Exiting panic recovery mode." << std::endl; // Nuevo mensaje
+        if (profile) profile->exit(ParserRule::PanicRecovery, tokensConsumed);
+        trace() << debugPrefix << "Exiting panic recovery mode." << '\n'; // Nuevo mensaje
     }
 
 
+    // Pasa al token siguiente. Sin traza no asigna memoria: el token se mueve desde
+    // el lexer (--alloc-check lo comprueba con el sitio kEatTokenSite).
     void eatToken() {
-        std::cout << debugPrefix << "Eating token: " << currentToken.kindToString() << " [ " << currentToken.value.value_or("") << " ]" << std::endl;
-        currentToken = lexer.getToken();
-        std::cout << debugPrefix << "Next token: " << currentToken.kindToString() << " [ " << currentToken.value.value_or("") << " ]" << std::endl;
+        if (tracing) traceToken("Eating token: ");
+        {
+            AllocationSite site(kEatTokenSite);
+            currentToken = lexer.getToken();
+        }
+        tokensConsumed++;
+        if (tracing) traceToken("Next token: ");
+    }
+
+    void traceToken(const char *what) {
+        AllocationSite site("parser: traza");
+        trace() << debugPrefix << what << currentToken.kindToString() << " [ " << currentToken.value.value_or("") << " ]" << '\n';
     }
 
     void reportError(const std::string &message) {
-        std::cerr << "Syntax Error at line " << currentToken.location.line << ", col " << currentToken.location.col << ": " << message << std::endl;
+        errorCount++;
+        compilerErr() << "Syntax Error at line " << currentToken.location.line << ", col " << currentToken.location.col << ": " << message << std::endl;
     }
 
 
@@ -53,10 +82,39 @@ private:
         }
     }
 
+    // Entrada y salida de una regla: las líneas Entering/Exiting de la traza y los
+    // eventos del perfil. La salida ocurre en todos los caminos, también en los
+    // return false de un error. Con --alloc-report, las asignaciones hechas
+    // mientras corre la regla se atribuyen a su sitio.
+    class RuleScope {
+        Parser &parser;
+        ParserRule rule;
+        AllocationSite site;
+
+    public:
+        RuleScope(Parser &parser, ParserRule rule) : parser(parser), rule(rule), site(parserRuleSite(rule)) {
+            if (parser.tracing) {
+                parser.trace() << parser.debugPrefix << "Entering " << parserRuleName(rule) << " rule" << '\n';
+                parser.increaseDebugPrefix();
+            }
+            if (parser.profile) parser.profile->enter(rule, parser.tokensConsumed);
+        }
+
+        ~RuleScope() {
+            if (parser.profile) parser.profile->exit(rule, parser.tokensConsumed);
+            if (parser.tracing) {
+                parser.decreaseDebugPrefix();
+                parser.trace() << parser.debugPrefix << "Exiting " << parserRuleName(rule) << " rule" << '\n';
+            }
+        }
+
+        RuleScope(const RuleScope &) = delete;
+        RuleScope &operator=(const RuleScope &) = delete;
+    };
+
     // Grammar Rules
     bool program() {
-        std::cout << debugPrefix << "Entering program rule" << std::endl;
-        increaseDebugPrefix();
+        RuleScope scope(*this, ParserRule::Program);
         if (!declaration()) {
             panicRecoveryForRule({TokenKind::Eof});
         }
@@ -65,256 +123,250 @@ private:
                 panicRecoveryForRule({TokenKind::Eof});
             }
         }
-        decreaseDebugPrefix();
-        std::cout << debugPrefix << "Exiting program rule" << std::endl;
         return true;
     }
 
     bool declaration() {
-        std::cout << debugPrefix << "Entering declaration rule" << std::endl;
-        increaseDebugPrefix();
+        RuleScope scope(*this, ParserRule::Declaration);
         bool result;
         if (currentToken.kind == TokenKind::KwFunction) {
-            result = function();
+            Function fn;
+            result = function(fn);
+            if (result) ast.functions.push_back(std::move(fn));
         } else if (isType(currentToken.kind)) {
-            result = varDecl();
+            StmtPtr decl;
+            result = varDecl(decl);
+            if (decl) ast.globals.push_back(std::move(decl));
         } else {
             reportError("Expected function or variable declaration.");
             result = false;
             panicRecoveryForRule({TokenKind::KwFunction, TokenKind::KwInteger, TokenKind::KwBoolean, TokenKind::KwChar, TokenKind::KwString, TokenKind::KwVoid, TokenKind::Eof});
         }
-        decreaseDebugPrefix();
-        std::cout << debugPrefix << "Exiting declaration rule" << std::endl;
         return result;
     }
 
     
-    bool function() {
-        std::cout << debugPrefix << "Entering function rule" << std::endl;
-        increaseDebugPrefix();
+    bool function(Function &fn) {
+        RuleScope scope(*this, ParserRule::Function);
+        fn.location = currentToken.location;
         eatToken(); // consume 'function'
-        if (!type()) {
+        if (!type(fn.returnType)) {
             panicRecoveryForRule({TokenKind::Identifier});
         }
+        fn.name = currentToken.value.value_or("");
         if (!expectToken(TokenKind::Identifier, "Expected function name.", {TokenKind::LeftParenthesis})) {
-            decreaseDebugPrefix();
             return false;
         }
         if (!expectToken(TokenKind::LeftParenthesis, "Expected '('.", {TokenKind::RightParenthesis})) {
-            decreaseDebugPrefix();
             return false;
         }
-        if (!params()) {
+        if (!params(fn.params)) {
             panicRecoveryForRule({TokenKind::RightParenthesis});
         }
         if (!expectToken(TokenKind::RightParenthesis, "Expected ')'.", {TokenKind::LeftBrace})) {
-            decreaseDebugPrefix();
             return false;
         }
         if (!expectToken(TokenKind::LeftBrace, "Expected '{'.", {TokenKind::KwIf, TokenKind::KwFor, TokenKind::KwWhile, TokenKind::KwReturn, TokenKind::KwPrint, TokenKind::RightBrace})) {
-            decreaseDebugPrefix();
             return false;
         }
-        if (!stmntList()) {
+        if (!stmntList(fn.body)) {
             panicRecoveryForRule({TokenKind::RightBrace});
         }
         if (!expectToken(TokenKind::RightBrace, "Expected '}'.", {TokenKind::KwFunction, TokenKind::KwInteger, TokenKind::KwBoolean, TokenKind::KwChar, TokenKind::KwString, TokenKind::KwVoid, TokenKind::Eof})) {
-            decreaseDebugPrefix();
             return false;
         }
-        decreaseDebugPrefix();
-        std::cout << debugPrefix << "Exiting function rule" << std::endl;
         return true;
     }
 
-    bool type() {
-        std::cout << debugPrefix << "Entering type rule" << std::endl;
-        increaseDebugPrefix();
+    bool type(TypeSpec &out) {
+        RuleScope scope(*this, ParserRule::Type);
         if (isType(currentToken.kind)) {
+            out.base = currentToken.kind;
             eatToken();
-            if (!typePrime()) return false;
-            decreaseDebugPrefix();
-            std::cout << debugPrefix << "Exiting type rule" << std::endl;
+            if (!typePrime(out)) return false;
             return true;
         }
         reportError("Expected type.");
-        decreaseDebugPrefix();
         return false;
     }
 
-    bool typePrime() {
-        std::cout << debugPrefix << "Entering typePrime rule" << std::endl;
-        increaseDebugPrefix();
+    bool typePrime(TypeSpec &out) {
+        RuleScope scope(*this, ParserRule::TypePrime);
         while (currentToken.kind == TokenKind::LeftBracket) {
             eatToken(); // consume '['
+            ExprPtr size;
             if (currentToken.kind != TokenKind::RightBracket) {
-                if (!expression()) {
-                    decreaseDebugPrefix();
+                if (!expression(size)) {
                     return false;
                 }
             }
+            out.dims.push_back(std::move(size));
             if (!expectToken(TokenKind::RightBracket, "Expected ']' after array size expression.")) return false;
         }
-        decreaseDebugPrefix();
-        std::cout << debugPrefix << "Exiting typePrime rule" << std::endl;
         return true;
     }
 
 
-    bool params() {
-        std::cout << debugPrefix << "Entering params rule" << std::endl;
-        increaseDebugPrefix();
+    bool params(std::vector<Param> &out) {
+        RuleScope scope(*this, ParserRule::Params);
         if (isType(currentToken.kind)) {
-            if (!type()) {
+            Param param;
+            if (!type(param.type)) {
                 panicRecoveryForRule({TokenKind::Identifier});
             }
+            param.name = currentToken.value.value_or("");
+            param.location = currentToken.location;
             if (!expectToken(TokenKind::Identifier, "Expected parameter name.", {TokenKind::CommaSymbol, TokenKind::RightParenthesis})) {
-                decreaseDebugPrefix();
                 return false;
             }
-            if (!paramsPrime()) {
+            if (!typePrime(param.type)) {
+                panicRecoveryForRule({TokenKind::CommaSymbol, TokenKind::RightParenthesis});
+            }
+            out.push_back(std::move(param));
+            if (!paramsPrime(out)) {
                 panicRecoveryForRule({TokenKind::RightParenthesis});
             }
         }
-        decreaseDebugPrefix();
-        std::cout << debugPrefix << "Exiting params rule" << std::endl;
         return true; // epsilon
     }
 
-    bool paramsPrime() {
-        std::cout << debugPrefix << "Entering paramsPrime rule" << std::endl;
-        increaseDebugPrefix();
+    bool paramsPrime(std::vector<Param> &out) {
+        RuleScope scope(*this, ParserRule::ParamsPrime);
         while (currentToken.kind == TokenKind::CommaSymbol) {
             eatToken();
-            if (!type()) {
+            Param param;
+            if (!type(param.type)) {
                 panicRecoveryForRule({TokenKind::Identifier});
             }
+            param.name = currentToken.value.value_or("");
+            param.location = currentToken.location;
             if (!expectToken(TokenKind::Identifier, "Expected parameter name.", {TokenKind::CommaSymbol, TokenKind::RightParenthesis})) {
-                decreaseDebugPrefix();
                 return false;
             }
+            if (!typePrime(param.type)) {
+                panicRecoveryForRule({TokenKind::CommaSymbol, TokenKind::RightParenthesis});
+            }
+            out.push_back(std::move(param));
         }
-        decreaseDebugPrefix();
-        std::cout << debugPrefix << "Exiting paramsPrime rule" << std::endl;
         return true;
     }
 
-    bool varDecl() {
-        std::cout << debugPrefix << "Entering varDecl rule" << std::endl;
-        increaseDebugPrefix();
-        if (!type()) {
+    bool varDecl(StmtPtr &out) {
+        RuleScope scope(*this, ParserRule::VarDecl);
+        StmtPtr decl = makeStmt(StmtKind::VarDecl, currentToken.location);
+        if (!type(decl->declType)) {
             panicRecoveryForRule({TokenKind::Identifier});
         }
+        decl->name = currentToken.value.value_or("");
         if (!expectToken(TokenKind::Identifier, "Expected variable name.", {TokenKind::Assign, TokenKind::SemiColonSymbol})) {
-            decreaseDebugPrefix();
             return false;
         }
+        // Dimensiones después del nombre: int a[10];
+        if (!typePrime(decl->declType)) {
+            panicRecoveryForRule({TokenKind::SemiColonSymbol});
+        }
         if (currentToken.kind == TokenKind::Assign) {
             eatToken();
-            if (!expression()) {
+            if (!expression(decl->expr)) {
                 panicRecoveryForRule({TokenKind::SemiColonSymbol});
             }
         }
+        out = std::move(decl);
         if (!expectToken(TokenKind::SemiColonSymbol, "Expected ';' after variable declaration.", {TokenKind::KwFunction, TokenKind::KwInteger, TokenKind::KwBoolean, TokenKind::KwChar, TokenKind::KwString, TokenKind::KwVoid, TokenKind::Eof})) {
-            decreaseDebugPrefix();
             return false;
         }
-        decreaseDebugPrefix();
-        std::cout << debugPrefix << "Exiting varDecl rule" << std::endl;
         return true;
     }
 
-    bool varDeclPrime() {
-        std::cout << debugPrefix << "Entering varDeclPrime rule" << std::endl;
-        increaseDebugPrefix();
+    bool varDeclPrime(ExprPtr &init) {
+        RuleScope scope(*this, ParserRule::VarDeclPrime);
         if (currentToken.kind == TokenKind::Assign) {
             eatToken();
-            if (!expression()) return false;
+            if (!expression(init)) return false;
         }
         if (!expectToken(TokenKind::SemiColonSymbol, "Expected ';' after variable declaration.")) return false;
-        decreaseDebugPrefix();
-        std::cout << debugPrefix << "Exiting varDeclPrime rule" << std::endl;
         return true;
     }
 
-    bool stmntList() {
-        std::cout << debugPrefix << "Entering stmntList rule" << std::endl;
-        increaseDebugPrefix();
+    bool stmntList(std::vector<StmtPtr> &out) {
+        RuleScope scope(*this, ParserRule::StmntList);
         while (currentToken.kind != TokenKind::RightBrace && currentToken.kind != TokenKind::Eof) {
-            if (!stmnt()) {
+            StmtPtr statement;
+            bool ok = stmnt(statement);
+            if (statement) out.push_back(std::move(statement));
+            if (!ok) {
                 panicRecoveryForRule({TokenKind::RightBrace, TokenKind::KwIf, TokenKind::KwFor, TokenKind::KwWhile, TokenKind::KwReturn, TokenKind::KwPrint});
             }
         }
-        decreaseDebugPrefix();
-        std::cout << debugPrefix << "Exiting stmntList rule" << std::endl;
         return true;
     }
 
-    bool stmnt() {
-        std::cout << debugPrefix << "Entering stmnt rule" << std::endl;
-        increaseDebugPrefix();
+    bool stmnt(StmtPtr &out) {
+        RuleScope scope(*this, ParserRule::Stmnt);
         bool result;
         switch (currentToken.kind) {
             case TokenKind::KwIf:
-                result = ifStmnt();
+                result = ifStmnt(out);
                 break;
             case TokenKind::KwFor:
-                result = forStmnt();
+                result = forStmnt(out);
                 break;
             case TokenKind::KwWhile:
-                result = whileStmnt();
+                result = whileStmnt(out);
                 break;
             case TokenKind::KwReturn:
-                result = returnStmnt();
+                result = returnStmnt(out);
                 break;
             case TokenKind::KwPrint:
-                result = printStmnt();
+                result = printStmnt(out);
                 break;
             case TokenKind::LeftBrace:
+                out = makeStmt(StmtKind::Block, currentToken.location);
                 eatToken();
-                result = stmntList() && expectToken(TokenKind::RightBrace, "Expected '}' at end of block.", {TokenKind::KwIf, TokenKind::KwFor, TokenKind::KwWhile, TokenKind::KwReturn, TokenKind::KwPrint, TokenKind::RightBrace});
+                result = stmntList(out->body) && expectToken(TokenKind::RightBrace, "Expected '}' at end of block.", {TokenKind::KwIf, TokenKind::KwFor, TokenKind::KwWhile, TokenKind::KwReturn, TokenKind::KwPrint, TokenKind::RightBrace});
                 break;
             default:
                 if (isType(currentToken.kind)) {
-                    result = varDecl();
+                    result = varDecl(out);
                 } else {
-                    result = exprStmnt();
+                    result = exprStmnt(out);
                 }
                 break;
         }
-        decreaseDebugPrefix();
-        std::cout << debugPrefix << "Exiting stmnt rule" << std::endl;
         return result;
     }
 
 
-    bool ifStmnt() {
-        std::cout << debugPrefix << "Entering ifStmnt rule" << std::endl;
-        increaseDebugPrefix();
+    bool ifStmnt(StmtPtr &out) {
+        RuleScope scope(*this, ParserRule::IfStmnt);
 
         // Manejo del "if"
+        out = makeStmt(StmtKind::If, currentToken.location);
+        Stmt *current = out.get(); // último if de la cadena "else if"
         eatToken(); // consume 'if'
         if (!expectToken(TokenKind::LeftParenthesis, "Expected '('.")) return false;
-        if (!expression()) return false;
+        if (!expression(current->expr)) return false;
         if (!expectToken(TokenKind::RightParenthesis, "Expected ')'.")) return false;
 
         if (!expectToken(TokenKind::LeftBrace, "Expected '{'.")) return false;
-        if (!stmntList()) return false;
+        if (!stmntList(current->body)) return false;
         if (!expectToken(TokenKind::RightBrace, "Expected '}'.")) return false;
 
         // Manejo de los bloques "else if"
         while (currentToken.kind == TokenKind::KwElse) {
             Token lookaheadToken = lexer.peekToken();
             if (lookaheadToken.kind == TokenKind::KwIf) {
+                current->elseBody.push_back(makeStmt(StmtKind::If, lookaheadToken.location));
+                current = current->elseBody.back().get();
                 eatToken(); // consume 'else'
                 eatToken(); // consume 'if'
 
                 if (!expectToken(TokenKind::LeftParenthesis, "Expected '('.")) return false;
-                if (!expression()) return false;
+                if (!expression(current->expr)) return false;
                 if (!expectToken(TokenKind::RightParenthesis, "Expected ')'.")) return false;
 
                 if (!expectToken(TokenKind::LeftBrace, "Expected '{'.")) return false;
-                if (!stmntList()) return false;
+                if (!stmntList(current->body)) return false;
                 if (!expectToken(TokenKind::RightBrace, "Expected '}'.")) return false;
             } else {
                 break;
@@ -325,37 +377,34 @@ private:
         if (currentToken.kind == TokenKind::KwElse) {
             eatToken(); // consume 'else'
             if (!expectToken(TokenKind::LeftBrace, "Expected '{'.")) return false;
-            if (!stmntList()) return false;
+            if (!stmntList(current->elseBody)) return false;
             if (!expectToken(TokenKind::RightBrace, "Expected '}'.")) return false;
         }
-
-        decreaseDebugPrefix();
-        std::cout << debugPrefix << "Exiting ifStmnt rule" << std::endl;
         return true;
     }
 
 
-    bool forStmnt() {
-        std::cout << debugPrefix << "Entering forStmnt rule" << std::endl;
-        increaseDebugPrefix();
+    bool forStmnt(StmtPtr &out) {
+        RuleScope scope(*this, ParserRule::ForStmnt);
+        out = makeStmt(StmtKind::For, currentToken.location);
         eatToken(); // consume 'for'
 
         if (!expectToken(TokenKind::LeftParenthesis, "Expected '('.")) return false;
 
         // Parte de inicialización: Puede ser VarDecl o ExprStmnt
         if (isType(currentToken.kind)) {
-            if (!varDecl()) return false; // Declaración de variable
+            if (!varDecl(out->init)) return false; // Declaración de variable
         } else {
-            if (!exprStmnt()) return false; // Sentencia de expresión (puede ser vacía)
+            if (!exprStmnt(out->init)) return false; // Sentencia de expresión (puede ser vacía)
         }
 
         // Parte de condición
-        if (!expression()) return false;
+        if (!expression(out->expr)) return false;
         if (!expectToken(TokenKind::SemiColonSymbol, "Expected ';' after condition.")) return false;
 
         // Parte de incremento (exprStmnt), esta no debe terminar con ';' dentro del `for`
         if (currentToken.kind != TokenKind::RightParenthesis) {
-            if (!expression()) return false; // Procesa la expresión de incremento
+            if (!expression(out->step)) return false; // Procesa la expresión de incremento
         }
 
         if (!expectToken(TokenKind::RightParenthesis, "Expected ')' after increment.")) return false;
@@ -363,102 +412,92 @@ private:
         // Manejo del cuerpo del bucle
         if (currentToken.kind == TokenKind::LeftBrace) {
             eatToken(); // consume '{'
-            if (!stmntList()) return false; // Procesa la lista de sentencias
+            if (!stmntList(out->body)) return false; // Procesa la lista de sentencias
             if (!expectToken(TokenKind::RightBrace, "Expected '}' at end of block.")) return false;
         } else {
             // Si no hay un bloque con `{}`, entonces debe ser una sentencia simple.
-            if (!stmnt()) return false;
+            StmtPtr single;
+            bool ok = stmnt(single);
+            if (single) out->body.push_back(std::move(single));
+            if (!ok) return false;
         }
-
-        decreaseDebugPrefix();
-        std::cout << debugPrefix << "Exiting forStmnt rule" << std::endl;
         return true;
     }
 
-    bool whileStmnt() {
-        std::cout << debugPrefix << "Entering whileStmnt rule" << std::endl;
-        increaseDebugPrefix();
+    bool whileStmnt(StmtPtr &out) {
+        RuleScope scope(*this, ParserRule::WhileStmnt);
 
+        out = makeStmt(StmtKind::While, currentToken.location);
         eatToken(); // consume 'while'
         
         if (!expectToken(TokenKind::LeftParenthesis, "Expected '(' after 'while'.")) return false;
-        if (!expression()) return false; // condición del bucle
+        if (!expression(out->expr)) return false; // condición del bucle
         if (!expectToken(TokenKind::RightParenthesis, "Expected ')' after while condition.")) return false;
 
         if (currentToken.kind == TokenKind::LeftBrace) {
             eatToken(); // consume '{'
-            if (!stmntList()) return false; // Procesa la lista de sentencias dentro del bloque
+            if (!stmntList(out->body)) return false; // Procesa la lista de sentencias dentro del bloque
             if (!expectToken(TokenKind::RightBrace, "Expected '}' at end of block.")) return false;
         } else {
             // Si no hay un bloque con `{}`, entonces debe ser una sentencia simple.
-            if (!stmnt()) return false;
+            StmtPtr single;
+            bool ok = stmnt(single);
+            if (single) out->body.push_back(std::move(single));
+            if (!ok) return false;
         }
-
-        decreaseDebugPrefix();
-        std::cout << debugPrefix << "Exiting whileStmnt rule" << std::endl;
         return true;
     }
 
 
-    bool returnStmnt() {
-        std::cout << debugPrefix << "Entering returnStmnt rule" << std::endl;
-        increaseDebugPrefix();
+    bool returnStmnt(StmtPtr &out) {
+        RuleScope scope(*this, ParserRule::ReturnStmnt);
+        out = makeStmt(StmtKind::Return, currentToken.location);
         eatToken(); // consume 'return'
         if (currentToken.kind != TokenKind::SemiColonSymbol) {
-            if (!expression()) return false;
+            if (!expression(out->expr)) return false;
         }
         if (!expectToken(TokenKind::SemiColonSymbol, "Expected ';' after return statement.")) return false;
-        decreaseDebugPrefix();
-        std::cout << debugPrefix << "Exiting returnStmnt rule" << std::endl;
         return true;
     }
 
-    bool printStmnt() {
-        std::cout << debugPrefix << "Entering printStmnt rule" << std::endl;
-        increaseDebugPrefix();
+    bool printStmnt(StmtPtr &out) {
+        RuleScope scope(*this, ParserRule::PrintStmnt);
+        out = makeStmt(StmtKind::Print, currentToken.location);
         eatToken(); // consume 'print'
         if (!expectToken(TokenKind::LeftParenthesis, "Expected '('.")) return false;
-        if (!exprList()) return false;
+        if (!exprList(out->exprs)) return false;
         if (!expectToken(TokenKind::RightParenthesis, "Expected ')'.")) return false;
         if (!expectToken(TokenKind::SemiColonSymbol, "Expected ';' after print statement.")) return false;
-        decreaseDebugPrefix();
-        std::cout << debugPrefix << "Exiting printStmnt rule" << std::endl;
         return true;
     }
 
-    bool exprStmnt() {
-        std::cout << debugPrefix << "Entering exprStmnt rule" << std::endl;
-        increaseDebugPrefix();
+    bool exprStmnt(StmtPtr &out) {
+        RuleScope scope(*this, ParserRule::ExprStmnt);
         if (currentToken.kind == TokenKind::SemiColonSymbol) {
             eatToken();
-            decreaseDebugPrefix();
-            std::cout << debugPrefix << "Exiting exprStmnt rule" << std::endl;
             return true;
         }
-        if (!expression()) return false;
+        out = makeStmt(StmtKind::Expr, currentToken.location);
+        if (!expression(out->expr)) return false;
         if (!expectToken(TokenKind::SemiColonSymbol, "Expected ';' after expression.")) return false;
-        decreaseDebugPrefix();
-        std::cout << debugPrefix << "Exiting exprStmnt rule" << std::endl;
         return true;
     }
 
-    bool exprList() {
-        std::cout << debugPrefix << "Entering exprList rule" << std::endl;
-        increaseDebugPrefix();
-        if (!expression()) return false;
+    bool exprList(std::vector<ExprPtr> &out) {
+        RuleScope scope(*this, ParserRule::ExprList);
+        out.emplace_back();
+        if (!expression(out.back())) return false;
         while (currentToken.kind == TokenKind::CommaSymbol) {
             eatToken();
-            if (!expression()) return false;
+            out.emplace_back();
+            if (!expression(out.back())) return false;
         }
-        decreaseDebugPrefix();
-        std::cout << debugPrefix << "Exiting exprList rule" << std::endl;
         return true;
     } 
 
     // Updated expression rule following the provided grammar
-    bool expression() {
-        std::cout << debugPrefix << "Entering expression rule" << std::endl;
-        increaseDebugPrefix();
+    bool expression(ExprPtr &out) {
+        RuleScope scope(*this, ParserRule::Expression);
 
         // Verificar si el token actual es un identificador
         if (currentToken.kind == TokenKind::Identifier) {
@@ -466,208 +505,240 @@ private:
 
             // Si después del identificador hay un operador '=', es una asignación
             if (lookaheadToken.kind == TokenKind::Assign) {
+                out = makeExpr(ExprKind::Assign, lookaheadToken.location);
+                ExprPtr target = makeExpr(ExprKind::Var, currentToken.location);
+                target->name = currentToken.value.value_or("");
+                out->args.push_back(std::move(target));
+                out->args.emplace_back();
                 eatToken(); // consumir el identificador
                 eatToken(); // consumir el '='
 
-                if (!expression()) {
-                    decreaseDebugPrefix();
+                if (!expression(out->args[1])) {
                     return false; // falló el análisis del lado derecho de la asignación
                 }
-                decreaseDebugPrefix();
-                std::cout << debugPrefix << "Exiting expression rule" << std::endl;
                 return true;
             }
         }
 
         // Si no es una asignación, debe ser un OrExpr
-        if (!orExpr()) {
-            decreaseDebugPrefix();
+        if (!orExpr(out)) {
             return false;
         }
 
-        decreaseDebugPrefix();
-        std::cout << debugPrefix << "Exiting expression rule" << std::endl;
+        // Asignación a un elemento de arreglo: a[i] = Expression
+        if (currentToken.kind == TokenKind::Assign && out->kind == ExprKind::Index) {
+            ExprPtr assign = makeExpr(ExprKind::Assign, currentToken.location);
+            assign->args.push_back(std::move(out));
+            assign->args.emplace_back();
+            out = std::move(assign);
+            eatToken(); // consumir el '='
+            if (!expression(out->args[1])) {
+                return false;
+            }
+        }
         return true;
     }
 
 
-    bool orExpr() {
-        std::cout << debugPrefix << "Entering orExpr rule" << std::endl;
-        increaseDebugPrefix();
-        if (!andExpr()) {
-            decreaseDebugPrefix();
+    bool orExpr(ExprPtr &out) {
+        RuleScope scope(*this, ParserRule::OrExpr);
+        if (!andExpr(out)) {
             return false;
         }
         while (currentToken.kind == TokenKind::LogicalOr) {
+            TokenKind op = currentToken.kind;
+            SourceLocation location = currentToken.location;
             eatToken();
-            if (!andExpr()) {
-                decreaseDebugPrefix();
+            ExprPtr rhs;
+            if (!andExpr(rhs)) {
                 return false;
             }
+            out = makeBinary(op, location, std::move(out), std::move(rhs));
         }
-        decreaseDebugPrefix();
-        std::cout << debugPrefix << "Exiting orExpr rule" << std::endl;
         return true;
     }
 
-    bool andExpr() {
-        std::cout << debugPrefix << "Entering andExpr rule" << std::endl;
-        increaseDebugPrefix();
-        if (!eqExpr()) {
-            decreaseDebugPrefix();
+    bool andExpr(ExprPtr &out) {
+        RuleScope scope(*this, ParserRule::AndExpr);
+        if (!eqExpr(out)) {
             return false;
         }
         while (currentToken.kind == TokenKind::LogicalAnd) {
+            TokenKind op = currentToken.kind;
+            SourceLocation location = currentToken.location;
             eatToken();
-            if (!eqExpr()) {
-                decreaseDebugPrefix();
+            ExprPtr rhs;
+            if (!eqExpr(rhs)) {
                 return false;
             }
+            out = makeBinary(op, location, std::move(out), std::move(rhs));
         }
-        decreaseDebugPrefix();
-        std::cout << debugPrefix << "Exiting andExpr rule" << std::endl;
         return true;
     }
 
-    bool eqExpr() {
-        std::cout << debugPrefix << "Entering eqExpr rule" << std::endl;
-        increaseDebugPrefix();
-        if (!relExpr()) {
-            decreaseDebugPrefix();
+    bool eqExpr(ExprPtr &out) {
+        RuleScope scope(*this, ParserRule::EqExpr);
+        if (!relExpr(out)) {
             return false;
         }
         while (currentToken.kind == TokenKind::isEqual || currentToken.kind == TokenKind::NotEqual) {
+            TokenKind op = currentToken.kind;
+            SourceLocation location = currentToken.location;
             eatToken();
-            if (!relExpr()) {
-                decreaseDebugPrefix();
+            ExprPtr rhs;
+            if (!relExpr(rhs)) {
                 return false;
             }
+            out = makeBinary(op, location, std::move(out), std::move(rhs));
         }
-        decreaseDebugPrefix();
-        std::cout << debugPrefix << "Exiting eqExpr rule" << std::endl;
         return true;
     }
 
-    bool relExpr() {
-        std::cout << debugPrefix << "Entering relExpr rule" << std::endl;
-        increaseDebugPrefix();
-        if (!expr()) {
-            decreaseDebugPrefix();
+    bool relExpr(ExprPtr &out) {
+        RuleScope scope(*this, ParserRule::RelExpr);
+        if (!expr(out)) {
             return false;
         }
         while (currentToken.kind == TokenKind::LessThan ||
                currentToken.kind == TokenKind::LessThanOrEqual ||
                currentToken.kind == TokenKind::GreaterThan ||
                currentToken.kind == TokenKind::GreaterThanOrEqual) {
+            TokenKind op = currentToken.kind;
+            SourceLocation location = currentToken.location;
             eatToken();
-            if (!expr()) {
-                decreaseDebugPrefix();
+            ExprPtr rhs;
+            if (!expr(rhs)) {
                 return false;
             }
+            out = makeBinary(op, location, std::move(out), std::move(rhs));
         }
-        decreaseDebugPrefix();
-        std::cout << debugPrefix << "Exiting relExpr rule" << std::endl;
         return true;
     }
 
-    bool expr() {
-        std::cout << debugPrefix << "Entering expr rule" << std::endl;
-        increaseDebugPrefix();
-        if (!term()) {
-            decreaseDebugPrefix();
+    bool expr(ExprPtr &out) {
+        RuleScope scope(*this, ParserRule::Expr);
+        if (!term(out)) {
             return false;
         }
         while (currentToken.kind == TokenKind::Addition || currentToken.kind == TokenKind::Subtraction) {
+            TokenKind op = currentToken.kind;
+            SourceLocation location = currentToken.location;
             eatToken();
-            if (!term()) {
-                decreaseDebugPrefix();
+            ExprPtr rhs;
+            if (!term(rhs)) {
                 return false;
             }
+            out = makeBinary(op, location, std::move(out), std::move(rhs));
         }
-        decreaseDebugPrefix();
-        std::cout << debugPrefix << "Exiting expr rule" << std::endl;
         return true;
     }
 
-    bool term() {
-        std::cout << debugPrefix << "Entering term rule" << std::endl;
-        increaseDebugPrefix();
-        if (!unary()) {
-            decreaseDebugPrefix();
+    bool term(ExprPtr &out) {
+        RuleScope scope(*this, ParserRule::Term);
+        if (!expo(out)) {
             return false;
         }
         while (currentToken.kind == TokenKind::Multiplication ||
                currentToken.kind == TokenKind::Division ||
                currentToken.kind == TokenKind::Modulus) {
+            TokenKind op = currentToken.kind;
+            SourceLocation location = currentToken.location;
+            eatToken();
+            ExprPtr rhs;
+            if (!expo(rhs)) {
+                return false;
+            }
+            out = makeBinary(op, location, std::move(out), std::move(rhs));
+        }
+        return true;
+    }
+
+    // Exponenciación: asociativa a la derecha, entre term y unary
+    bool expo(ExprPtr &out) {
+        RuleScope scope(*this, ParserRule::Expo);
+        if (!unary(out)) {
+            return false;
+        }
+        if (currentToken.kind == TokenKind::Exponentiation) {
+            SourceLocation location = currentToken.location;
             eatToken();
-            if (!unary()) {
-                decreaseDebugPrefix();
+            ExprPtr rhs;
+            if (!expo(rhs)) {
                 return false;
             }
+            out = makeBinary(TokenKind::Exponentiation, location, std::move(out), std::move(rhs));
         }
-        decreaseDebugPrefix();
-        std::cout << debugPrefix << "Exiting term rule" << std::endl;
         return true;
     }
 
-    bool unary() {
-        std::cout << debugPrefix << "Entering unary rule" << std::endl;
-        increaseDebugPrefix();
+    bool unary(ExprPtr &out) {
+        RuleScope scope(*this, ParserRule::Unary);
         if (currentToken.kind == TokenKind::Subtraction || currentToken.kind == TokenKind::LogicalNot) {
+            out = makeExpr(ExprKind::Unary, currentToken.location);
+            out->op = currentToken.kind;
+            out->args.emplace_back();
             eatToken();
-            if (!unary()) {
-                decreaseDebugPrefix();
+            if (!unary(out->args[0])) {
                 return false;
             }
         } else {
-            if (!factor()) {
-                decreaseDebugPrefix();
+            if (!factor(out)) {
                 return false;
             }
         }
-        decreaseDebugPrefix();
-        std::cout << debugPrefix << "Exiting unary rule" << std::endl;
         return true;
     }
 
-    bool factor() {
-        std::cout << debugPrefix << "Entering factor rule" << std::endl;
-        increaseDebugPrefix();
+    bool factor(ExprPtr &out) {
+        RuleScope scope(*this, ParserRule::Factor);
 
         if (currentToken.kind == TokenKind::Identifier) {
+            out = makeExpr(ExprKind::Var, currentToken.location);
+            out->name = currentToken.value.value_or("");
             eatToken(); // consume el identificador
 
             // Verificar si hay un incremento o decremento después del identificador
+            TokenKind postfixOp = TokenKind::Unknown;
+            SourceLocation postfixLocation = currentToken.location;
             if (currentToken.kind == TokenKind::PostfixIncrement || currentToken.kind == TokenKind::PostfixDecrement) {
+                postfixOp = currentToken.kind;
                 eatToken(); // consume el '++' o '--'
             }
 
             if (currentToken.kind == TokenKind::LeftParenthesis) {
+                out->kind = ExprKind::Call;
                 eatToken(); // consume '('
                 if (currentToken.kind != TokenKind::RightParenthesis) {
-                    if (!exprList()) {
-                        decreaseDebugPrefix();
+                    if (!exprList(out->args)) {
                         return false;
                     }
                 }
                 if (!expectToken(TokenKind::RightParenthesis, "Expected ')' after function call.")) {
-                    decreaseDebugPrefix();
                     return false;
                 }
             } else if (currentToken.kind == TokenKind::LeftBracket) {
                 // Manejo del acceso al arreglo
                 while (currentToken.kind == TokenKind::LeftBracket) {
+                    ExprPtr index = makeExpr(ExprKind::Index, currentToken.location);
+                    index->args.push_back(std::move(out));
+                    index->args.emplace_back();
+                    out = std::move(index);
                     eatToken(); // consume '['
-                    if (!expression()) {
-                        decreaseDebugPrefix();
+                    if (!expression(out->args[1])) {
                         return false;
                     }
                     if (!expectToken(TokenKind::RightBracket, "Expected ']' after array index.")) {
-                        decreaseDebugPrefix();
                         return false;
                     }
                 }
             }
+
+            if (postfixOp != TokenKind::Unknown) {
+                ExprPtr postfix = makeExpr(ExprKind::Postfix, postfixLocation);
+                postfix->op = postfixOp;
+                postfix->args.push_back(std::move(out));
+                out = std::move(postfix);
+            }
         } else if (
             currentToken.kind == TokenKind::Number ||
             currentToken.kind == TokenKind::CharVal ||
@@ -675,45 +746,85 @@ private:
             currentToken.kind == TokenKind::KwTrue ||
             currentToken.kind == TokenKind::KwFalse
         ) {
+            out = makeLiteral(currentToken);
             eatToken();
         } else if (currentToken.kind == TokenKind::LeftParenthesis) {
             eatToken(); // consume '('
-            if (!expression()) {
-                decreaseDebugPrefix();
+            if (!expression(out)) {
                 return false;
             }
             if (!expectToken(TokenKind::RightParenthesis, "Expected ')' after expression.")) {
-                decreaseDebugPrefix();
                 return false;
             }
         } else {
             reportError("Expected factor.");
-            decreaseDebugPrefix();
             return false;
         }
-
-        decreaseDebugPrefix();
-        std::cout << debugPrefix << "Exiting factor rule" << std::endl;
         return true;
     }
 
 
+    ExprPtr makeBinary(TokenKind op, SourceLocation location, ExprPtr lhs, ExprPtr rhs) {
+        ExprPtr e = makeExpr(ExprKind::Binary, location);
+        e->op = op;
+        e->args.push_back(std::move(lhs));
+        e->args.push_back(std::move(rhs));
+        return e;
+    }
+
+    ExprPtr makeLiteral(const Token &token) {
+        const std::string &text = token.value.value_or("");
+        switch (token.kind) {
+            case TokenKind::Number:
+                return makeIntLit(token.location, std::strtoll(text.c_str(), nullptr, 10));
+            case TokenKind::CharVal:
+                return makeIntLit(token.location, decodeCharLiteral(text), ExprKind::CharLit);
+            case TokenKind::KwTrue:
+                return makeIntLit(token.location, 1, ExprKind::BoolLit);
+            case TokenKind::KwFalse:
+                return makeIntLit(token.location, 0, ExprKind::BoolLit);
+            default: {
+                ExprPtr e = makeExpr(ExprKind::StringLit, token.location);
+                e->name = text;
+                return e;
+            }
+        }
+    }
+
     bool isType(TokenKind kind) {
         return kind == TokenKind::KwInteger || kind == TokenKind::KwBoolean || kind == TokenKind::KwChar || kind == TokenKind::KwString || kind == TokenKind::KwVoid;
     }
 
 public:
-    explicit Parser(Lexer &lexer) : lexer(lexer), debugPrefix("") {
+    // Sitio de asignaciones del paso de un token, que no debe asignar memoria
+    static constexpr const char *kEatTokenSite = "parser: eatToken";
+
+    explicit Parser(TokenSource &lexer, bool tracing = true) : lexer(lexer), debugPrefix(""), tracing(tracing) {
         eatToken();
     }
 
-    void parse() {
-        std::cout << "Starting parse" << std::endl;
-        if (program()) {
-            std::cout << "Parsing completed successfully." << std::endl;
-        } else {
-            std::cout << "Parsing failed." << std::endl;
+    bool parse() {
+        trace() << "Starting parse" << '\n';
+        if (program() && errorCount == 0) {
+            trace() << "Parsing completed successfully." << '\n';
+            return true;
         }
+        trace() << "Parsing failed." << '\n';
+        return false;
+    }
+
+    unsigned int getErrorCount() const {
+        return errorCount;
+    }
+
+    // Perfil por regla (--parse-profile); se llama antes de parse()
+    void setProfile(RuleProfile *ruleProfile) {
+        profile = ruleProfile;
+    }
+
+    // Árbol sintáctico construido durante parse()
+    Program &getProgram() {
+        return ast;
     }
 };
 
@@ -0,0 +1,120 @@
+#ifndef PEEPHOLE_H_
+#define PEEPHOLE_H_
+
+#include <cstdint>
+#include <vector>
+
+#include "vm.h"
+
+// Estadísticas del peephole sobre el bytecode
+struct PeepholeStats {
+    unsigned int compareJumps = 0;   // comparación + salto condicional
+    unsigned int increments = 0;     // LoadGlobal + Add/Sub + StoreGlobal, y Add + Mov
+    unsigned int moves = 0;          // Mov + Mov y Mov + Loop (copias de phis)
+    unsigned int calls = 0;          // Call + Ret / RetVoid
+};
+
+// Fusiona secuencias frecuentes del bytecode en superinstrucciones. Los pares
+// elegidos son los que más se ejecutan según --op-pairs sobre los programas de
+// prueba: comparación + salto (i < n), Add + Mov (el ++ de un contador y la
+// copia de su phi), las copias de phis antes del salto hacia atrás, el ++/-- de
+// una global y la llamada cuyo resultado se devuelve tal cual.
+// La superinstrucción reemplaza el código de la primera instrucción y toma los
+// demás operandos de las siguientes, que quedan en su lugar: las posiciones del
+// código no cambian, así que los saltos, blockStart y la entrada al código nativo
+// siguen valiendo. Sólo se fusiona si ninguna de las instrucciones absorbidas es
+// destino de un salto.
+class BytecodePeephole {
+    PeepholeStats stats;
+
+    static bool isJump(BcOp op) {
+        return op == BcOp::Jmp || op == BcOp::Loop || op == BcOp::JmpIfTrue || op == BcOp::JmpIfFalse;
+    }
+
+    static BcOp fusedCompare(BcOp compare, BcOp jump) {
+        bool onTrue = jump == BcOp::JmpIfTrue;
+        switch (compare) {
+            case BcOp::Lt: return onTrue ? BcOp::LtJmpIfTrue : BcOp::LtJmpIfFalse;
+            case BcOp::Le: return onTrue ? BcOp::LeJmpIfTrue : BcOp::LeJmpIfFalse;
+            case BcOp::Gt: return onTrue ? BcOp::GtJmpIfTrue : BcOp::GtJmpIfFalse;
+            case BcOp::Ge: return onTrue ? BcOp::GeJmpIfTrue : BcOp::GeJmpIfFalse;
+            case BcOp::Eq: return onTrue ? BcOp::EqJmpIfTrue : BcOp::EqJmpIfFalse;
+            case BcOp::Ne: return onTrue ? BcOp::NeJmpIfTrue : BcOp::NeJmpIfFalse;
+            default: return compare;
+        }
+    }
+
+    // Cantidad de instrucciones que absorbe la superinstrucción que empieza en i (0 si ninguna)
+    unsigned int fuse(const BcModule &module, BcFunction &fn, size_t i) {
+        BcInst &first = fn.code[i];
+        const BcInst &second = fn.code[i + 1];
+        switch (first.op) {
+            case BcOp::Lt: case BcOp::Le: case BcOp::Gt: case BcOp::Ge: case BcOp::Eq: case BcOp::Ne:
+                if ((second.op != BcOp::JmpIfTrue && second.op != BcOp::JmpIfFalse) || second.a != first.a) return 0;
+                first.op = fusedCompare(first.op, second.op);
+                stats.compareJumps++;
+                return 1;
+            case BcOp::Add:
+                if (second.op != BcOp::Mov) return 0;
+                first.op = BcOp::AddMov;
+                stats.increments++;
+                return 1;
+            case BcOp::Mov:
+                if (second.op == BcOp::Mov) first.op = BcOp::MovMov;
+                else if (second.op == BcOp::Loop) first.op = BcOp::MovLoop;
+                else return 0;
+                stats.moves++;
+                return 1;
+            case BcOp::LoadGlobal: {
+                if (i + 2 >= fn.code.size()) return 0;
+                const BcInst &store = fn.code[i + 2];
+                if ((second.op != BcOp::Add && second.op != BcOp::Sub) || store.op != BcOp::StoreGlobal ||
+                    store.k() != first.k() || store.a != second.a) {
+                    return 0;
+                }
+                first.op = second.op == BcOp::Add ? BcOp::GlobalAdd : BcOp::GlobalSub;
+                stats.increments++;
+                return 2;
+            }
+            case BcOp::Call:
+                // Si el llamado devolviera un valor que se descarta, su Ret escribiría en el
+                // marco de quien llamó a esta función: sólo se fusiona con llamados void
+                if (second.op == BcOp::Ret && first.aux && second.a == first.a) {
+                    first.op = BcOp::CallRet;
+                } else if (second.op == BcOp::RetVoid && !module.functions[first.k()].returnsValue) {
+                    first.op = BcOp::CallRetVoid;
+                } else {
+                    return 0;
+                }
+                stats.calls++;
+                return 1;
+            default:
+                return 0;
+        }
+    }
+
+    void runFunction(const BcModule &module, BcFunction &fn) {
+        std::vector<char> target(fn.code.size() + 1, 0);
+        for (const BcInst &inst : fn.code) {
+            if (isJump(inst.op)) target[inst.k()] = 1;
+        }
+        for (uint32_t start : fn.blockStart) {
+            if (start < target.size()) target[start] = 1;
+        }
+        for (size_t i = 0; i + 1 < fn.code.size(); ++i) {
+            if (target[i + 1]) continue;
+            // LoadGlobal + Add + StoreGlobal necesita además que la tercera no sea destino
+            if (fn.code[i].op == BcOp::LoadGlobal && i + 2 < fn.code.size() && target[i + 2]) continue;
+            i += fuse(module, fn, i);
+        }
+    }
+
+public:
+    PeepholeStats run(BcModule &module) {
+        stats = PeepholeStats{};
+        for (auto &fn : module.functions) runFunction(module, fn);
+        return stats;
+    }
+};
+
+#endif // PEEPHOLE_H_
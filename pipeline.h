@@ -0,0 +1,202 @@
+#ifndef PIPELINE_H_
+#define PIPELINE_H_
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "lexer.h"
+
+// Lote de tokens con los mensajes que el lexer escribió al producirlos
+struct TokenBatch {
+    std::vector<Token> tokens;
+    std::string out, err;
+};
+
+// Cola de un productor y un consumidor, sin locks, de lotes de tokens. Es un
+// anillo de kSlots lotes: el productor llena el lote en tail y lo publica
+// avanzando tail; el consumidor lee el lote en head y lo devuelve avanzando head.
+// Con el anillo lleno el productor espera, así que la memoria no depende del
+// tamaño de la entrada.
+class TokenQueue {
+public:
+    static const size_t kBatchSize = 512;
+    static const size_t kSlots = 8;
+
+private:
+    TokenBatch slots[kSlots];
+    std::atomic<size_t> head{0};   // lo avanza sólo el consumidor
+    std::atomic<size_t> tail{0};   // lo avanza sólo el productor
+    std::atomic<bool> cancelled{false};
+
+public:
+    TokenQueue() {
+        for (auto &slot : slots) slot.tokens.reserve(kBatchSize);
+    }
+
+    // Productor: lote libre para llenar, o nullptr si el consumidor abandonó
+    TokenBatch *acquireBatch() {
+        size_t t = tail.load(std::memory_order_relaxed);
+        while (t - head.load(std::memory_order_acquire) == kSlots) {
+            if (cancelled.load(std::memory_order_relaxed)) return nullptr;
+            std::this_thread::yield();
+        }
+        TokenBatch &batch = slots[t % kSlots];
+        batch.tokens.clear();
+        batch.out.clear();
+        batch.err.clear();
+        return &batch;
+    }
+
+    void publishBatch() {
+        tail.store(tail.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+
+    // Consumidor: siguiente lote publicado (espera hasta que haya uno)
+    TokenBatch &frontBatch() {
+        size_t h = head.load(std::memory_order_relaxed);
+        while (tail.load(std::memory_order_acquire) == h) std::this_thread::yield();
+        return slots[h % kSlots];
+    }
+
+    void releaseBatch() {
+        head.store(head.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+
+    // El consumidor no va a leer más: libera al productor si está esperando
+    void cancel() {
+        cancelled.store(true, std::memory_order_relaxed);
+    }
+
+    // Lotes publicados que el consumidor no llegó a leer (con el productor ya terminado)
+    template <typename F>
+    void forEachPending(F visit) {
+        for (size_t h = head.load(std::memory_order_acquire); h != tail.load(std::memory_order_acquire); ++h) {
+            visit(slots[h % kSlots]);
+        }
+    }
+};
+
+// Lexer en un hilo aparte: analiza el texto en lotes de tokens que el parser
+// consume mientras se produce el resto, de modo que el análisis sintáctico (y sus
+// errores) empiezan con el primer lote. Los mensajes del lexer viajan con el lote
+// en el que se produjeron y se pasan a compilerOut()/compilerErr() del consumidor
+// al tomar ese lote, antes de los del parser sobre esos tokens. Si el parser
+// abandona antes del final, el lexer sigue hasta el final sólo por sus mensajes,
+// que se escriben en finish() como las asignaciones de --alloc-report.
+class PipelinedLexer : public TokenSource {
+    Lexer lexer;
+    TokenQueue queue;
+    std::ostringstream lexerOut, lexerErr;
+    std::thread producer;
+    TokenBatch *batch = nullptr;  // lote que se está consumiendo
+    size_t position = 0;
+    size_t produced = 0;
+    bool finished = false;
+    AllocationTracker *consumerAllocations = currentAllocationTracker();
+    std::unique_ptr<AllocationTracker> lexerAllocations;
+
+    void produce() {
+        CompilerStreams &streams = compilerStreams();
+        streams.out = &lexerOut;
+        streams.err = &lexerErr;
+        currentAllocationTracker() = lexerAllocations.get();
+        bool done = false;
+        while (!done) {
+            TokenBatch *next = queue.acquireBatch();
+            if (!next) break;
+            while (next->tokens.size() < TokenQueue::kBatchSize) {
+                next->tokens.push_back(lexer.getNextToken());
+                produced++;
+                if (next->tokens.back().kind == TokenKind::Eof) {
+                    done = true;
+                    break;
+                }
+            }
+            takeMessages(next->out, lexerOut);
+            takeMessages(next->err, lexerErr);
+            queue.publishBatch();
+        }
+        // Sin consumidor: el resto del texto sólo se analiza por sus mensajes
+        while (!done) {
+            produced++;
+            done = lexer.getNextToken().kind == TokenKind::Eof;
+        }
+    }
+
+    static void takeMessages(std::string &target, std::ostringstream &messages) {
+        if (messages.tellp() <= 0) return;
+        target = messages.str();
+        messages.str("");
+    }
+
+    // Token siguiente, sin consumirlo; el Eof final se queda en su lugar
+    Token &front() {
+        if (batch && position == batch->tokens.size()) {
+            queue.releaseBatch();
+            batch = nullptr;
+        }
+        if (!batch) {
+            batch = &queue.frontBatch();
+            position = 0;
+            compilerOut() << batch->out;
+            compilerErr() << batch->err;
+        }
+        return batch->tokens[position];
+    }
+
+public:
+    explicit PipelinedLexer(const SourceFile &source) : lexer(source, false) {
+        if (consumerAllocations) {
+            lexerAllocations.reset(new AllocationTracker);
+            lexerAllocations->phase = consumerAllocations->phase;
+        }
+        producer = std::thread([this] { produce(); });
+    }
+
+    ~PipelinedLexer() override {
+        finish();
+    }
+
+    Token getToken() override {
+        Token &token = front();
+        if (token.kind == TokenKind::Eof) return token;
+        position++;
+        return std::move(token);
+    }
+
+    Token peekToken() override {
+        return front();
+    }
+
+    // Espera al hilo del lexer y escribe los mensajes que el parser no llegó a tomar
+    void finish() {
+        if (finished) return;
+        finished = true;
+        queue.cancel();
+        producer.join();
+        if (batch) queue.releaseBatch();
+        queue.forEachPending([](const TokenBatch &pending) {
+            compilerOut() << pending.out;
+            compilerErr() << pending.err;
+        });
+        compilerOut() << lexerOut.str();
+        compilerErr() << lexerErr.str();
+        if (lexerAllocations) consumerAllocations->merge(*lexerAllocations);
+    }
+
+    unsigned int getErrorCount() const {
+        return lexer.getErrorCount();
+    }
+
+    // Tokens producidos (el Eof incluido); completo después de finish()
+    size_t tokenCount() const {
+        return produced;
+    }
+};
+
+#endif // PIPELINE_H_
@@ -0,0 +1,218 @@
+#ifndef REGALLOC_H_
+#define REGALLOC_H_
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <queue>
+#include <vector>
+
+#include "ir.h"
+
+// Intervalo de vida de un valor SSA en el orden lineal de la IR (índices de instrucción)
+struct LiveInterval {
+    uint32_t value;
+    uint32_t start;
+    uint32_t end;
+};
+
+// Intervalos de vida: [definición, último uso], extendidos hasta el final de cada
+// bloque donde el valor está vivo a la salida; los parámetros, al menos hasta el
+// último parámetro. La vida se propaga hacia atrás desde
+// cada uso sólo hasta el bloque que define el valor, así que el costo es proporcional
+// al tamaño de la información de vida (sin conjuntos por bloque).
+// Un phi se usa al final de cada predecesor (ahí se copian sus operandos) y su
+// registro destino se escribe también en esos puntos.
+inline std::vector<LiveInterval> computeLiveIntervals(const IrFunction &fn) {
+    const uint32_t n = static_cast<uint32_t>(fn.insts.size());
+    std::vector<uint32_t> defBlock(n, 0), start(n, 0), end(n, 0);
+    for (uint32_t b = 0; b < fn.blocks.size(); ++b) {
+        for (uint32_t i = fn.blocks[b].begin; i < fn.blocks[b].end; ++i) {
+            defBlock[i] = b;
+            // Los phis se definen al entrar al bloque y los parámetros al entrar a la función
+            if (fn.insts[i].op == IrOp::Phi) start[i] = fn.blocks[b].begin;
+            else if (fn.insts[i].op == IrOp::Param) start[i] = 0;
+            else start[i] = i;
+            end[i] = start[i];
+        }
+    }
+    // El prólogo copia todos los parámetros a la vez desde los registros de
+    // argumento: aun sin usos, ninguno puede ceder su registro a otro parámetro
+    uint32_t lastParam = 0;
+    for (uint32_t i = 0; i < n; ++i) {
+        if (fn.insts[i].op == IrOp::Param) lastParam = i;
+    }
+    for (uint32_t i = 0; i < n; ++i) {
+        if (fn.insts[i].op == IrOp::Param) end[i] = lastParam;
+    }
+
+    std::vector<uint32_t> visited(fn.blocks.size(), 0);
+    std::vector<uint32_t> worklist;
+    auto markUse = [&](uint32_t v, uint32_t block, uint32_t pos) {
+        if (v == kNoValue) return;
+        end[v] = std::max(end[v], pos);
+        if (block == defBlock[v]) return;
+        worklist.push_back(block);
+        while (!worklist.empty()) {
+            uint32_t x = worklist.back();
+            worklist.pop_back();
+            if (visited[x] == v + 1) continue;
+            visited[x] = v + 1;
+            const uint32_t *preds = fn.predsOf(x);
+            for (uint32_t k = 0; k < fn.blocks[x].predCount; ++k) {
+                uint32_t p = preds[k];
+                end[v] = std::max(end[v], fn.blocks[p].end - 1);
+                if (p != defBlock[v] && visited[p] != v + 1) worklist.push_back(p);
+            }
+        }
+    };
+
+    for (uint32_t b = 0; b < fn.blocks.size(); ++b) {
+        const IrBlock &block = fn.blocks[b];
+        const uint32_t *preds = fn.predsOf(b);
+        for (uint32_t i = block.begin; i < block.end; ++i) {
+            const IrInst &inst = fn.insts[i];
+            if (inst.op == IrOp::Phi) {
+                for (uint32_t k = 0; k < inst.b && k < block.predCount; ++k) {
+                    uint32_t predEnd = fn.blocks[preds[k]].end - 1;
+                    markUse(fn.operands[inst.a + k], preds[k], predEnd);
+                    end[i] = std::max(end[i], predEnd);
+                }
+                continue;
+            }
+            fn.forEachOperand(inst, [&](uint32_t v) { markUse(v, b, i); });
+        }
+    }
+
+    std::vector<LiveInterval> intervals;
+    for (uint32_t i = 0; i < n; ++i) {
+        if (fn.insts[i].type != IrType::Void) intervals.push_back({i, start[i], end[i]});
+    }
+    std::stable_sort(intervals.begin(), intervals.end(),
+                     [](const LiveInterval &a, const LiveInterval &b) { return a.start < b.start; });
+    return intervals;
+}
+
+// Resultado de la asignación: registro por valor (kNoValue si no produce resultado
+// o si quedó en memoria, en cuyo caso spillSlot indica su posición en el marco)
+struct RegisterAssignment {
+    std::vector<uint32_t> reg;
+    std::vector<uint32_t> spillSlot;
+    uint32_t numRegs = 0;
+    uint32_t numSpillSlots = 0;
+};
+
+// Banco de registros físicos: los índices [0, callerSaved) no sobreviven a una
+// llamada y los siguientes calleeSaved sí (el llamado los preserva).
+struct RegisterBank {
+    uint32_t callerSaved = 0;
+    uint32_t calleeSaved = 0;
+};
+
+// Asignación por barrido lineal sin límite de registros: reutiliza un registro en
+// cuanto termina el intervalo que lo ocupaba. Los parámetros quedan fijos en los
+// registros 0..n-1, que es donde el llamador deja los argumentos.
+inline RegisterAssignment allocateRegisters(const IrFunction &fn) {
+    RegisterAssignment result;
+    result.reg.assign(fn.insts.size(), kNoValue);
+    const uint32_t numParams = static_cast<uint32_t>(fn.paramTypes.size());
+    result.numRegs = numParams;
+
+    using Active = std::pair<uint32_t, uint32_t>;  // (fin, registro)
+    std::priority_queue<Active, std::vector<Active>, std::greater<Active>> active;
+    std::priority_queue<uint32_t, std::vector<uint32_t>, std::greater<uint32_t>> freeRegs;
+
+    for (const LiveInterval &interval : computeLiveIntervals(fn)) {
+        // Un registro cuyo último uso es esta misma instrucción puede reutilizarse:
+        // todas las instrucciones leen sus operandos antes de escribir el resultado.
+        while (!active.empty() && active.top().first <= interval.start) {
+            freeRegs.push(active.top().second);
+            active.pop();
+        }
+        const IrInst &inst = fn.insts[interval.value];
+        uint32_t reg;
+        if (inst.op == IrOp::Param) {
+            reg = static_cast<uint32_t>(inst.imm);
+        } else if (!freeRegs.empty()) {
+            reg = freeRegs.top();
+            freeRegs.pop();
+        } else {
+            reg = result.numRegs++;
+        }
+        result.reg[interval.value] = reg;
+        active.push({interval.end, reg});
+    }
+    return result;
+}
+
+// Barrido lineal de Poletto y Sarkar con un número fijo de registros. Un intervalo
+// que cruza una instrucción para la que isCall es verdadero sólo puede ocupar un
+// registro preservado por el llamado. Si no hay registro libre se envía a memoria
+// el intervalo que termina más tarde (el actual u otro activo de la misma clase).
+template <typename IsCall>
+inline RegisterAssignment allocateRegisters(const IrFunction &fn, const RegisterBank &bank, IsCall isCall) {
+    RegisterAssignment result;
+    result.reg.assign(fn.insts.size(), kNoValue);
+    result.spillSlot.assign(fn.insts.size(), kNoValue);
+    const uint32_t numRegs = bank.callerSaved + bank.calleeSaved;
+    result.numRegs = numRegs;
+
+    std::vector<uint32_t> calls;
+    for (uint32_t i = 0; i < fn.insts.size(); ++i) {
+        if (isCall(fn.insts[i])) calls.push_back(i);
+    }
+    auto crossesCall = [&](const LiveInterval &interval) {
+        auto next = std::upper_bound(calls.begin(), calls.end(), interval.start);
+        return next != calls.end() && *next < interval.end;
+    };
+    auto spill = [&](uint32_t value) {
+        result.reg[value] = kNoValue;
+        result.spillSlot[value] = result.numSpillSlots++;
+    };
+
+    const std::vector<LiveInterval> intervals = computeLiveIntervals(fn);
+    std::vector<const LiveInterval *> active;
+    std::vector<uint8_t> busy(numRegs, 0);
+    for (const LiveInterval &interval : intervals) {
+        for (size_t k = 0; k < active.size();) {
+            if (active[k]->end <= interval.start) {
+                busy[result.reg[active[k]->value]] = 0;
+                active[k] = active.back();
+                active.pop_back();
+            } else {
+                ++k;
+            }
+        }
+
+        // Los que no cruzan llamadas prefieren registros volátiles: no hay que salvarlos
+        const uint32_t first = crossesCall(interval) ? bank.callerSaved : 0;
+        uint32_t reg = kNoValue;
+        for (uint32_t r = first; r < numRegs; ++r) {
+            if (!busy[r]) {
+                reg = r;
+                break;
+            }
+        }
+        if (reg == kNoValue) {
+            size_t victim = active.size();
+            for (size_t k = 0; k < active.size(); ++k) {
+                if (result.reg[active[k]->value] < first) continue;
+                if (victim == active.size() || active[k]->end > active[victim]->end) victim = k;
+            }
+            if (victim == active.size() || active[victim]->end <= interval.end) {
+                spill(interval.value);
+                continue;
+            }
+            reg = result.reg[active[victim]->value];
+            spill(active[victim]->value);
+            active[victim] = active.back();
+            active.pop_back();
+        }
+        busy[reg] = 1;
+        result.reg[interval.value] = reg;
+        active.push_back(&interval);
+    }
+    return result;
+}
+
+#endif // REGALLOC_H_
@@ -0,0 +1,381 @@
+#ifndef REPORT_H_
+#define REPORT_H_
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <ostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <sys/resource.h>
+#include <time.h>
+
+// Asignaciones de memoria del hilo actual: las cuentan los operator new
+// reemplazados en main.cpp, sólo si allocationCountingEnabled()
+struct AllocationCounters {
+    uint64_t count = 0;
+    uint64_t bytes = 0;
+};
+
+inline AllocationCounters &allocationCounters() {
+    thread_local AllocationCounters counters;
+    return counters;
+}
+
+// Si operator new cuenta las asignaciones (--time-report, --alloc-report,
+// --alloc-check). Se fija al empezar, antes de crear hilos; si no, cada
+// asignación cuesta sólo leer este valor.
+inline bool &allocationCountingEnabled() {
+    static bool enabled = false;
+    return enabled;
+}
+
+// Asignaciones de un sitio del código dentro de una fase
+struct AllocationSiteStats {
+    const char *phase = nullptr;
+    const char *site = nullptr;
+    uint64_t count = 0;
+    uint64_t bytes = 0;
+};
+
+// Asignaciones del hilo por fase (la de ScopedPhase en curso) y por sitio (el de
+// AllocationSite en curso: una regla del parser, el paso de un token, ...), para
+// --alloc-report. record() se llama desde operator new y no puede asignar
+// memoria: los pares fase/sitio van en un arreglo fijo y los que no entran se
+// suman en uno solo.
+class AllocationTracker {
+public:
+    static const size_t kMaxSites = 256;
+
+    const char *phase = nullptr;
+    const char *site = nullptr;
+    uint64_t tokens = 0;  // tokens analizados, para las cifras por token
+
+private:
+    AllocationSiteStats sites[kMaxSites];
+    size_t used = 0;
+    size_t last = 0;  // el último par usado: casi siempre es el siguiente
+    AllocationSiteStats others;
+
+    // Los nombres son literales: basta comparar punteros salvo al juntar hilos
+    static bool sameName(const char *a, const char *b) {
+        return a == b || (a && b && std::strcmp(a, b) == 0);
+    }
+
+    AllocationSiteStats &slot(const char *phaseName, const char *siteName) {
+        if (last < used && sites[last].phase == phaseName && sites[last].site == siteName) return sites[last];
+        for (size_t i = 0; i < used; ++i) {
+            if (sameName(sites[i].phase, phaseName) && sameName(sites[i].site, siteName)) {
+                last = i;
+                return sites[i];
+            }
+        }
+        if (used == kMaxSites) return others;
+        sites[used].phase = phaseName;
+        sites[used].site = siteName;
+        last = used;
+        return sites[used++];
+    }
+
+    static std::string name(const char *text, const char *missing) {
+        return text ? text : missing;
+    }
+
+public:
+    AllocationTracker() {
+        others.phase = others.site = "(otros)";
+    }
+
+    void record(size_t bytes) {
+        AllocationSiteStats &stats = slot(phase, site);
+        stats.count++;
+        stats.bytes += bytes;
+    }
+
+    // Suma las asignaciones de otro hilo (un archivo de -j, el lexer de --pipeline)
+    void merge(const AllocationTracker &other) {
+        for (size_t i = 0; i < other.used; ++i) {
+            const AllocationSiteStats &stats = other.sites[i];
+            AllocationSiteStats &into = slot(stats.phase, stats.site);
+            into.count += stats.count;
+            into.bytes += stats.bytes;
+        }
+        others.count += other.others.count;
+        others.bytes += other.others.bytes;
+        tokens += other.tokens;
+    }
+
+    // Asignaciones de un sitio sumadas en todas las fases
+    uint64_t siteAllocations(const char *siteName) const {
+        uint64_t count = 0;
+        for (size_t i = 0; i < used; ++i) {
+            if (sameName(sites[i].site, siteName)) count += sites[i].count;
+        }
+        return count;
+    }
+
+    // Una tabla por fase y otra por sitio (de más a menos asignaciones), con las
+    // asignaciones por token. Asigna memoria: el hilo no debe estar midiéndose.
+    void printTable(std::ostream &out) const;
+};
+
+// Rellena con espacios hasta width columnas; %-Ns de printf cuenta bytes y los
+// nombres con acentos quedarían corridos
+inline std::string padRight(const std::string &text, size_t width) {
+    size_t columns = 0;
+    for (char c : text) columns += (static_cast<unsigned char>(c) & 0xC0) != 0x80;
+    return text + std::string(columns < width ? width - columns : 0, ' ');
+}
+
+inline void AllocationTracker::printTable(std::ostream &out) const {
+    std::vector<AllocationSiteStats> all(sites, sites + used);
+    if (others.count) all.push_back(others);
+    std::vector<AllocationSiteStats> phases;
+    for (const AllocationSiteStats &stats : all) {
+        auto it = std::find_if(phases.begin(), phases.end(),
+                               [&](const AllocationSiteStats &p) { return sameName(p.phase, stats.phase); });
+        if (it == phases.end()) it = phases.insert(phases.end(), AllocationSiteStats{stats.phase, nullptr, 0, 0});
+        it->count += stats.count;
+        it->bytes += stats.bytes;
+    }
+    std::sort(all.begin(), all.end(),
+              [](const AllocationSiteStats &a, const AllocationSiteStats &b) { return a.count > b.count; });
+
+    auto perToken = [&](uint64_t count) {
+        return tokens ? static_cast<double>(count) / static_cast<double>(tokens) : 0.0;
+    };
+    char numbers[96];
+    out << tokens << " tokens\n";
+    std::snprintf(numbers, sizeof(numbers), "%14s %14s %10s\n", "asignaciones", "bytes", "por token");
+    out << padRight("fase", 22) << ' ' << numbers;
+    for (const AllocationSiteStats &stats : phases) {
+        std::snprintf(numbers, sizeof(numbers), "%14llu %14llu %10.3f\n", static_cast<unsigned long long>(stats.count),
+                      static_cast<unsigned long long>(stats.bytes), perToken(stats.count));
+        out << padRight(name(stats.phase, "(sin fase)"), 22) << ' ' << numbers;
+    }
+    std::snprintf(numbers, sizeof(numbers), "%14s %14s %10s\n", "asignaciones", "bytes", "por token");
+    out << padRight("sitio", 28) << ' ' << padRight("fase", 22) << ' ' << numbers;
+    for (const AllocationSiteStats &stats : all) {
+        std::snprintf(numbers, sizeof(numbers), "%14llu %14llu %10.3f\n", static_cast<unsigned long long>(stats.count),
+                      static_cast<unsigned long long>(stats.bytes), perToken(stats.count));
+        out << padRight(name(stats.site, "(sin sitio)"), 28) << ' ' << padRight(name(stats.phase, "(sin fase)"), 22)
+            << ' ' << numbers;
+    }
+}
+
+// Seguimiento del hilo actual (nullptr si no se pidió --alloc-report)
+inline AllocationTracker *&currentAllocationTracker() {
+    thread_local AllocationTracker *tracker = nullptr;
+    return tracker;
+}
+
+// Atribuye a un sitio las asignaciones hechas mientras existe (los sitios se
+// anidan: vale el más interno). Sin --alloc-report sólo lee un puntero del hilo.
+class AllocationSite {
+    AllocationTracker *tracker;
+    const char *previous = nullptr;
+
+public:
+    explicit AllocationSite(const char *name) : tracker(currentAllocationTracker()) {
+        if (!tracker) return;
+        previous = tracker->site;
+        tracker->site = name;
+    }
+
+    AllocationSite(const AllocationSite &) = delete;
+    AllocationSite &operator=(const AllocationSite &) = delete;
+
+    ~AllocationSite() {
+        if (tracker) tracker->site = previous;
+    }
+};
+
+// Medidas de una fase (sumadas si la fase se repite o hay varios archivos)
+struct PhaseTiming {
+    std::string name;
+    unsigned int calls = 0;
+    double wallMs = 0;
+    double cpuMs = 0;
+    uint64_t allocations = 0;
+    uint64_t bytes = 0;
+    long peakRssDeltaKb = 0;  // cuánto subió el pico de memoria residente del proceso
+};
+
+// Tiempos por fase, en el orden en que cada fase aparece por primera vez. Sin
+// detailed sólo se mide el tiempo de pared (lo que usa la línea INFO TIME); con
+// detailed (--time-report) también el tiempo de CPU del hilo, las asignaciones y
+// el pico de memoria residente.
+class TimeReport {
+    bool detail;
+    std::vector<PhaseTiming> phases;
+
+    static void writeJsonString(std::ostream &out, const std::string &s) {
+        out << '"';
+        for (char c : s) {
+            if (c == '"' || c == '\\') out << '\\';
+            out << c;
+        }
+        out << '"';
+    }
+
+public:
+    explicit TimeReport(bool detailed = false) : detail(detailed) {}
+
+    bool detailed() const {
+        return detail;
+    }
+
+    void add(const PhaseTiming &timing) {
+        for (PhaseTiming &phase : phases) {
+            if (phase.name != timing.name) continue;
+            phase.calls += timing.calls;
+            phase.wallMs += timing.wallMs;
+            phase.cpuMs += timing.cpuMs;
+            phase.allocations += timing.allocations;
+            phase.bytes += timing.bytes;
+            phase.peakRssDeltaKb += timing.peakRssDeltaKb;
+            return;
+        }
+        phases.push_back(timing);
+    }
+
+    void merge(const TimeReport &other) {
+        for (const PhaseTiming &phase : other.phases) add(phase);
+    }
+
+    const std::vector<PhaseTiming> &getPhases() const {
+        return phases;
+    }
+
+    // "plegado 0.01 ms, semántica 0.02 ms, ..." para la línea INFO TIME
+    std::string summary() const {
+        std::ostringstream out;
+        for (size_t i = 0; i < phases.size(); ++i) {
+            out << (i ? ", " : "") << phases[i].name << ' ' << phases[i].wallMs << " ms";
+        }
+        return out.str();
+    }
+
+    void printTable(std::ostream &out) const {
+        PhaseTiming total;
+        char line[160];
+        std::snprintf(line, sizeof(line), "%-22s %7s %11s %11s %12s %14s %10s\n", "fase", "veces", "pared ms",
+                      "CPU ms", "asignaciones", "bytes", "RSS +KiB");
+        out << line;
+        auto printRow = [&](const PhaseTiming &phase) {
+            std::string name = padRight(phase.name, 22);
+            std::snprintf(line, sizeof(line), "%s %7u %11.3f %11.3f %12llu %14llu %10ld\n", name.c_str(), phase.calls,
+                          phase.wallMs, phase.cpuMs, static_cast<unsigned long long>(phase.allocations),
+                          static_cast<unsigned long long>(phase.bytes), phase.peakRssDeltaKb);
+            out << line;
+        };
+        for (const PhaseTiming &phase : phases) {
+            printRow(phase);
+            total.calls += phase.calls;
+            total.wallMs += phase.wallMs;
+            total.cpuMs += phase.cpuMs;
+            total.allocations += phase.allocations;
+            total.bytes += phase.bytes;
+            total.peakRssDeltaKb += phase.peakRssDeltaKb;
+        }
+        total.name = "total";
+        printRow(total);
+        out << "pico de memoria residente: " << peakRssKb() << " KiB\n";
+    }
+
+    void printJson(std::ostream &out) const {
+        out << "{\n  \"phases\": [\n";
+        for (size_t i = 0; i < phases.size(); ++i) {
+            const PhaseTiming &phase = phases[i];
+            out << "    {\"name\": ";
+            writeJsonString(out, phase.name);
+            out << ", \"calls\": " << phase.calls << ", \"wall_ms\": " << phase.wallMs << ", \"cpu_ms\": "
+                << phase.cpuMs << ", \"allocations\": " << phase.allocations << ", \"bytes\": " << phase.bytes
+                << ", \"peak_rss_delta_kb\": " << phase.peakRssDeltaKb << "}" << (i + 1 < phases.size() ? "," : "")
+                << "\n";
+        }
+        out << "  ],\n  \"peak_rss_kb\": " << peakRssKb() << "\n}\n";
+    }
+
+    static double threadCpuMs() {
+        timespec now;
+        clock_gettime(CLOCK_THREAD_CPUTIME_ID, &now);
+        return static_cast<double>(now.tv_sec) * 1000.0 + static_cast<double>(now.tv_nsec) / 1e6;
+    }
+
+    static long peakRssKb() {
+        rusage usage;
+        getrusage(RUSAGE_SELF, &usage);
+        return usage.ru_maxrss;
+    }
+};
+
+// Informe del hilo actual (nullptr si no se pidió --time-report): lo usan las
+// fases que no reciben uno, como la lectura del archivo o el análisis léxico
+inline TimeReport *&currentTimeReport() {
+    thread_local TimeReport *report = nullptr;
+    return report;
+}
+
+// Mide la fase desde su construcción hasta su destrucción y, con --alloc-report,
+// le atribuye las asignaciones del hilo. Con report nulo y sin seguimiento de
+// asignaciones no hace nada, así que puede quedar en el código siempre.
+class ScopedPhase {
+    TimeReport *report;
+    const char *name;
+    AllocationTracker *tracker;
+    const char *previousPhase = nullptr;
+    std::chrono::steady_clock::time_point wallStart;
+    double cpuStart = 0;
+    AllocationCounters allocationsStart;
+    long rssStart = 0;
+
+public:
+    ScopedPhase(TimeReport *report, const char *name)
+        : report(report), name(name), tracker(currentAllocationTracker()) {
+        if (tracker) {
+            previousPhase = tracker->phase;
+            tracker->phase = name;
+        }
+        if (!report) return;
+        if (report->detailed()) {
+            cpuStart = TimeReport::threadCpuMs();
+            allocationsStart = allocationCounters();
+            rssStart = TimeReport::peakRssKb();
+        }
+        wallStart = std::chrono::steady_clock::now();
+    }
+
+    ScopedPhase(const ScopedPhase &) = delete;
+    ScopedPhase &operator=(const ScopedPhase &) = delete;
+
+    ~ScopedPhase() {
+        if (tracker) tracker->phase = previousPhase;
+        if (!report) return;
+        PhaseTiming timing;
+        timing.wallMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - wallStart).count();
+        if (report->detailed()) {
+            const AllocationCounters &now = allocationCounters();
+            timing.cpuMs = TimeReport::threadCpuMs() - cpuStart;
+            timing.allocations = now.count - allocationsStart.count;
+            timing.bytes = now.bytes - allocationsStart.bytes;
+            timing.peakRssDeltaKb = TimeReport::peakRssKb() - rssStart;
+        }
+        // El nombre se copia después de medir: su asignación no cuenta para la fase
+        timing.name = name;
+        timing.calls = 1;
+        report->add(timing);
+    }
+};
+
+// Ejecuta run() como una fase del informe
+template <typename F>
+inline void timedPhase(TimeReport *report, const char *name, F run) {
+    ScopedPhase phase(report, name);
+    run();
+}
+
+#endif // REPORT_H_
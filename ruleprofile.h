@@ -0,0 +1,191 @@
+#ifndef RULEPROFILE_H_
+#define RULEPROFILE_H_
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <ostream>
+#include <vector>
+
+// Reglas de la gramática tal como las nombra la traza del parser, más la
+// recuperación por pánico, que se mide como una regla más
+#define BM_PARSER_RULES(X) \
+    X(Program, "program") X(Declaration, "declaration") X(Function, "function") X(Type, "type") \
+    X(TypePrime, "typePrime") X(Params, "params") X(ParamsPrime, "paramsPrime") X(VarDecl, "varDecl") \
+    X(VarDeclPrime, "varDeclPrime") X(StmntList, "stmntList") X(Stmnt, "stmnt") X(IfStmnt, "ifStmnt") \
+    X(ForStmnt, "forStmnt") X(WhileStmnt, "whileStmnt") X(ReturnStmnt, "returnStmnt") \
+    X(PrintStmnt, "printStmnt") X(ExprStmnt, "exprStmnt") X(ExprList, "exprList") X(Expression, "expression") \
+    X(OrExpr, "orExpr") X(AndExpr, "andExpr") X(EqExpr, "eqExpr") X(RelExpr, "relExpr") X(Expr, "expr") \
+    X(Term, "term") X(Expo, "expo") X(Unary, "unary") X(Factor, "factor") X(PanicRecovery, "panic recovery")
+
+enum class ParserRule : uint8_t {
+#define BM_PARSER_RULE_ENUM(name, text) name,
+    BM_PARSER_RULES(BM_PARSER_RULE_ENUM)
+#undef BM_PARSER_RULE_ENUM
+};
+
+inline const char *parserRuleName(ParserRule rule) {
+    static const char *const names[] = {
+#define BM_PARSER_RULE_NAME(name, text) text,
+        BM_PARSER_RULES(BM_PARSER_RULE_NAME)
+#undef BM_PARSER_RULE_NAME
+    };
+    return names[static_cast<int>(rule)];
+}
+
+// La regla como sitio de asignaciones (--alloc-report)
+inline const char *parserRuleSite(ParserRule rule) {
+    static const char *const sites[] = {
+#define BM_PARSER_RULE_SITE(name, text) "parser: " text,
+        BM_PARSER_RULES(BM_PARSER_RULE_SITE)
+#undef BM_PARSER_RULE_SITE
+    };
+    return sites[static_cast<int>(rule)];
+}
+
+// Entrada o salida de una regla: 16 bytes por evento
+struct RuleEvent {
+    uint64_t nanoseconds;  // desde el origen del perfil
+    uint32_t tokens;       // tokens consumidos hasta ese momento
+    uint16_t thread;       // archivo de origen al juntar perfiles de varios archivos
+    ParserRule rule;
+    bool enter;
+};
+
+// Totales de una regla. El tiempo inclusivo cuenta el de las reglas que llama
+// (y se suma en cada nivel de una recursión); el exclusivo, sólo el propio.
+struct RuleStats {
+    uint64_t calls = 0;
+    uint64_t tokens = 0;
+    uint64_t inclusiveNs = 0;
+    uint64_t exclusiveNs = 0;
+};
+
+// Perfil del parser por regla (--parse-profile). Los totales se acumulan al
+// salir de cada regla; los eventos, para exportarlos en el formato de eventos de
+// Chrome (--parse-trace), se guardan hasta kMaxEvents y después sólo se cuentan.
+class RuleProfile {
+    struct Frame {
+        ParserRule rule;
+        uint64_t start;
+        uint32_t tokens;
+        uint64_t childNs;
+    };
+
+    static const size_t kNumRules = static_cast<size_t>(ParserRule::PanicRecovery) + 1;
+    static const size_t kMaxEvents = 1 << 22;
+
+    std::chrono::steady_clock::time_point origin = std::chrono::steady_clock::now();
+    RuleStats stats[kNumRules];
+    std::vector<Frame> stack;
+    std::vector<RuleEvent> events;
+    uint64_t droppedEvents = 0;
+    uint16_t thread = 0;
+
+    uint64_t now() const {
+        return static_cast<uint64_t>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - origin).count());
+    }
+
+    void record(uint64_t time, uint32_t tokens, ParserRule rule, bool enter) {
+        if (events.size() < kMaxEvents) events.push_back({time, tokens, thread, rule, enter});
+        else droppedEvents++;
+    }
+
+public:
+    explicit RuleProfile(uint16_t thread = 0) : thread(thread) {}
+
+    void enter(ParserRule rule, uint32_t tokens) {
+        uint64_t time = now();
+        stack.push_back({rule, time, tokens, 0});
+        record(time, tokens, rule, true);
+    }
+
+    void exit(ParserRule rule, uint32_t tokens) {
+        uint64_t time = now();
+        Frame frame = stack.back();
+        stack.pop_back();
+        uint64_t inclusive = time - frame.start;
+        RuleStats &s = stats[static_cast<size_t>(rule)];
+        s.calls++;
+        s.tokens += tokens - frame.tokens;
+        s.inclusiveNs += inclusive;
+        s.exclusiveNs += inclusive - std::min(inclusive, frame.childNs);
+        if (!stack.empty()) stack.back().childNs += inclusive;
+        record(time, tokens, rule, false);
+    }
+
+    // Suma otro perfil (el de otro archivo) con sus eventos en la misma escala de tiempo
+    void merge(const RuleProfile &other) {
+        for (size_t r = 0; r < kNumRules; ++r) {
+            stats[r].calls += other.stats[r].calls;
+            stats[r].tokens += other.stats[r].tokens;
+            stats[r].inclusiveNs += other.stats[r].inclusiveNs;
+            stats[r].exclusiveNs += other.stats[r].exclusiveNs;
+        }
+        int64_t shift = std::chrono::duration_cast<std::chrono::nanoseconds>(other.origin - origin).count();
+        for (const RuleEvent &event : other.events) {
+            if (events.size() == kMaxEvents) {
+                droppedEvents++;
+                continue;
+            }
+            RuleEvent moved = event;
+            moved.nanoseconds = static_cast<uint64_t>(static_cast<int64_t>(event.nanoseconds) + shift);
+            events.push_back(moved);
+        }
+        droppedEvents += other.droppedEvents;
+    }
+
+    const RuleStats &getStats(ParserRule rule) const {
+        return stats[static_cast<size_t>(rule)];
+    }
+
+    // Tabla ordenada por tiempo exclusivo
+    void printTable(std::ostream &out) const {
+        std::vector<size_t> order;
+        for (size_t r = 0; r < kNumRules; ++r) {
+            if (stats[r].calls) order.push_back(r);
+        }
+        std::sort(order.begin(), order.end(),
+                  [&](size_t a, size_t b) { return stats[a].exclusiveNs > stats[b].exclusiveNs; });
+        char line[128];
+        std::snprintf(line, sizeof(line), "%-16s %12s %12s %12s %12s\n", "regla", "llamadas", "tokens",
+                      "incl. ms", "excl. ms");
+        out << line;
+        for (size_t r : order) {
+            const RuleStats &s = stats[r];
+            std::snprintf(line, sizeof(line), "%-16s %12llu %12llu %12.3f %12.3f\n",
+                          parserRuleName(static_cast<ParserRule>(r)), static_cast<unsigned long long>(s.calls),
+                          static_cast<unsigned long long>(s.tokens), static_cast<double>(s.inclusiveNs) / 1e6,
+                          static_cast<double>(s.exclusiveNs) / 1e6);
+            out << line;
+        }
+        if (droppedEvents) out << "(" << droppedEvents << " eventos no guardados para la traza)\n";
+    }
+
+    // Formato de eventos de Chrome (chrome://tracing, Perfetto): un par B/E por llamada
+    void printChromeTrace(std::ostream &out) const {
+        out << "{\"displayTimeUnit\": \"ns\", \"traceEvents\": [\n";
+        char line[160];
+        for (size_t i = 0; i < events.size(); ++i) {
+            const RuleEvent &event = events[i];
+            std::snprintf(line, sizeof(line),
+                          "{\"name\": \"%s\", \"ph\": \"%c\", \"ts\": %.3f, \"pid\": 1, \"tid\": %u, "
+                          "\"args\": {\"tokens\": %u}}%s\n",
+                          parserRuleName(event.rule), event.enter ? 'B' : 'E',
+                          static_cast<double>(event.nanoseconds) / 1000.0, static_cast<unsigned int>(event.thread),
+                          event.tokens, i + 1 < events.size() ? "," : "");
+            out << line;
+        }
+        out << "]}\n";
+    }
+};
+
+// Perfil del hilo actual (nullptr si no se pidió --parse-profile), como currentTimeReport()
+inline RuleProfile *&currentRuleProfile() {
+    thread_local RuleProfile *profile = nullptr;
+    return profile;
+}
+
+#endif // RULEPROFILE_H_
@@ -0,0 +1,226 @@
+#ifndef RUNTIME_H_
+#define RUNTIME_H_
+
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <unistd.h>
+
+// Soporte de ejecución compartido por los motores de B-minor: arena de memoria,
+// representación de cadenas y arreglos, salida de print y la semántica de la
+// aritmética entera.
+
+// Error de ejecución (división por cero, índice fuera de rango, desborde de pila)
+struct RuntimeError : std::runtime_error {
+    explicit RuntimeError(const std::string &message) : std::runtime_error(message) {}
+};
+
+// Arena de asignación por bloques: se libera todo junto al terminar la ejecución
+class Arena {
+    std::vector<std::unique_ptr<char[]>> chunks;
+    char *ptr = nullptr;
+    char *end = nullptr;
+    size_t chunkSize;
+    size_t firstChunkSize = 0;
+    size_t totalBytes = 0;
+
+public:
+    explicit Arena(size_t chunkSize = 1 << 20) : chunkSize(chunkSize) {}
+
+    void *allocate(size_t bytes) {
+        bytes = (bytes + 7) & ~static_cast<size_t>(7);
+        if (static_cast<size_t>(end - ptr) < bytes) {
+            size_t size = bytes > chunkSize ? bytes : chunkSize;
+            chunks.emplace_back(new char[size]);
+            if (chunks.size() == 1) firstChunkSize = size;
+            ptr = chunks.back().get();
+            end = ptr + size;
+        }
+        void *result = ptr;
+        ptr += bytes;
+        totalBytes += bytes;
+        return result;
+    }
+
+    size_t bytesAllocated() const {
+        return totalBytes;
+    }
+
+    // Libera todo salvo el primer bloque, que se reutiliza desde el principio
+    // (para ejecutar varios programas seguidos sin volver a pedir memoria)
+    void reset() {
+        if (chunks.size() > 1) chunks.resize(1);
+        ptr = chunks.empty() ? nullptr : chunks[0].get();
+        end = ptr ? ptr + firstChunkSize : nullptr;
+        totalBytes = 0;
+    }
+};
+
+// Cadena inmutable en la arena
+struct BmString {
+    uint32_t length;
+    char data[1];
+};
+
+// Arreglo en la arena: todos los elementos ocupan 8 bytes (enteros o punteros)
+struct BmArray {
+    int64_t length;
+    int64_t data[1];
+};
+
+inline BmString *newString(Arena &arena, const char *text, size_t length) {
+    auto *s = static_cast<BmString *>(arena.allocate(sizeof(BmString) + length));
+    s->length = static_cast<uint32_t>(length);
+    std::memcpy(s->data, text, length);
+    s->data[length] = '\0';
+    return s;
+}
+
+inline BmString *concatStrings(Arena &arena, const BmString *a, const BmString *b) {
+    auto *s = static_cast<BmString *>(arena.allocate(sizeof(BmString) + a->length + b->length));
+    s->length = a->length + b->length;
+    std::memcpy(s->data, a->data, a->length);
+    std::memcpy(s->data + a->length, b->data, b->length);
+    s->data[s->length] = '\0';
+    return s;
+}
+
+inline bool stringsEqual(const BmString *a, const BmString *b) {
+    return a->length == b->length && std::memcmp(a->data, b->data, a->length) == 0;
+}
+
+// Escribe el entero en decimal al final de buf (24 bytes) y devuelve el inicio.
+// Saca dos dígitos por división usando una tabla de pares "00".."99".
+inline char *formatInt(int64_t value, char *bufEnd) {
+    static const char kDigitPairs[] =
+        "00010203040506070809101112131415161718192021222324252627282930313233343536373839"
+        "40414243444546474849505152535455565758596061626364656667686970717273747576777879"
+        "8081828384858687888990919293949596979899";
+    uint64_t magnitude = value < 0 ? 0 - static_cast<uint64_t>(value) : static_cast<uint64_t>(value);
+    char *p = bufEnd;
+    while (magnitude >= 100) {
+        const char *pair = kDigitPairs + (magnitude % 100) * 2;
+        magnitude /= 100;
+        *--p = pair[1];
+        *--p = pair[0];
+    }
+    if (magnitude >= 10) {
+        *--p = kDigitPairs[magnitude * 2 + 1];
+        *--p = kDigitPairs[magnitude * 2];
+    } else {
+        *--p = static_cast<char>('0' + magnitude);
+    }
+    if (value < 0) *--p = '-';
+    return p;
+}
+
+// Salida de print: un buffer grande que se vuelca con write(2) sólo al llenarse,
+// al pedirlo (flush al terminar o antes de informar un error) y, en modo por
+// líneas (el de las terminales), en cada fin de línea. Con kDiscard no escribe
+// nada; con una cadena como destino (el servidor de compilación) la va llenando.
+class OutputBuffer {
+    static const size_t kCapacity = 1 << 16;
+    std::unique_ptr<char[]> data;
+    size_t used = 0;
+    int fd;
+    bool lineBuffered;
+    std::string *sink = nullptr;
+
+    void drain(const char *p, size_t n) {
+        if (sink) {
+            sink->append(p, n);
+            return;
+        }
+        if (fd < 0) return;
+        while (n > 0) {
+            ssize_t written = ::write(fd, p, n);
+            if (written < 0 && errno == EINTR) continue;
+            if (written <= 0) return;
+            p += written;
+            n -= static_cast<size_t>(written);
+        }
+    }
+
+public:
+    static const int kDiscard = -1;
+
+    explicit OutputBuffer(int fd, bool lineBuffered = false)
+        : data(new char[kCapacity]), fd(fd), lineBuffered(lineBuffered) {}
+    explicit OutputBuffer(std::string &sink)
+        : data(new char[kCapacity]), fd(kDiscard), lineBuffered(false), sink(&sink) {}
+    OutputBuffer(const OutputBuffer &) = delete;
+    OutputBuffer &operator=(const OutputBuffer &) = delete;
+    ~OutputBuffer() { flush(); }
+
+    void write(const char *p, size_t n) {
+        if (n > kCapacity - used) {
+            flush();
+            if (n > kCapacity) {
+                drain(p, n);
+                return;
+            }
+        }
+        std::memcpy(data.get() + used, p, n);
+        used += n;
+    }
+
+    void put(char c) {
+        if (used == kCapacity) flush();
+        data[used++] = c;
+    }
+
+    void writeInt(int64_t value) {
+        char digits[24];
+        char *begin = formatInt(value, digits + sizeof(digits));
+        write(begin, static_cast<size_t>(digits + sizeof(digits) - begin));
+    }
+
+    void newline() {
+        put('\n');
+        if (lineBuffered) flush();
+    }
+
+    void flush() {
+        drain(data.get(), used);
+        used = 0;
+    }
+};
+
+// Aritmética entera con semántica de complemento a dos (sin comportamiento indefinido)
+inline int64_t wrapAdd(int64_t a, int64_t b) { return static_cast<int64_t>(static_cast<uint64_t>(a) + static_cast<uint64_t>(b)); }
+inline int64_t wrapSub(int64_t a, int64_t b) { return static_cast<int64_t>(static_cast<uint64_t>(a) - static_cast<uint64_t>(b)); }
+inline int64_t wrapMul(int64_t a, int64_t b) { return static_cast<int64_t>(static_cast<uint64_t>(a) * static_cast<uint64_t>(b)); }
+
+inline int64_t checkedDiv(int64_t a, int64_t b) {
+    if (b == 0) throw RuntimeError("division by zero");
+    if (b == -1) return wrapSub(0, a);
+    return a / b;
+}
+
+inline int64_t checkedMod(int64_t a, int64_t b) {
+    if (b == 0) throw RuntimeError("division by zero");
+    if (b == -1) return 0;
+    return a % b;
+}
+
+// Potencia entera: misma convención que checkedPow para exponentes negativos
+inline int64_t wrapPow(int64_t base, int64_t exp) {
+    if (exp < 0) {
+        if (base == 1) return 1;
+        if (base == -1) return (exp & 1) ? -1 : 1;
+        return 0;
+    }
+    uint64_t result = 1, b = static_cast<uint64_t>(base);
+    while (exp > 0) {
+        if (exp & 1) result *= b;
+        b *= b;
+        exp >>= 1;
+    }
+    return static_cast<int64_t>(result);
+}
+
+#endif // RUNTIME_H_
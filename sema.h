@@ -0,0 +1,390 @@
+#ifndef SEMA_H_
+#define SEMA_H_
+
+#include <algorithm>
+#include <iostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "ast.h"
+
+// Análisis semántico: resuelve nombres a símbolos, calcula el tipo de cada
+// expresión y verifica las reglas de tipos de B-minor. Deja el AST anotado
+// (Expr::type, Expr::symbol, Stmt::symbol, Param::symbol) para las etapas siguientes.
+class SemanticAnalyzer {
+    Program *program = nullptr;
+    std::vector<std::unordered_map<std::string, int>> scopes;
+    std::unordered_map<std::string, int> functionIndex;
+    std::vector<Type> returnTypes;
+    std::vector<std::vector<Type>> paramTypes;
+    int currentFunction = -1;
+    int localCount = 0;
+    int globalCount = 0;
+    unsigned int errorCount = 0;
+    bool deferArraySizes = false;
+
+    // Tamaño de una dimensión que se verifica después del plegado de constantes
+    static const int64_t kDeferredSize = -1;
+
+    void reportError(const SourceLocation &location, const std::string &message) {
+        errorCount++;
+        compilerErr() << "Semantic Error at line " << location.line << ", col " << location.col << ": " << message << std::endl;
+    }
+
+    static Type scalar(TokenKind base) {
+        Type t;
+        t.base = base;
+        return t;
+    }
+
+    // Convierte el tipo declarado en un tipo semántico; las dimensiones deben ser literales
+    Type resolveType(const TypeSpec &spec, const SourceLocation &location, bool isParam) {
+        Type t;
+        t.base = spec.base;
+        for (size_t i = 0; i < spec.dims.size(); ++i) {
+            const ExprPtr &dim = spec.dims[i];
+            int64_t size = 0;
+            if (dim) {
+                if (deferArraySizes && dim->kind != ExprKind::IntLit) {
+                    size = kDeferredSize;
+                } else if (dim->kind != ExprKind::IntLit || dim->intValue <= 0) {
+                    reportError(dim->location, "Array size must be a positive integer constant.");
+                } else {
+                    size = dim->intValue;
+                }
+            } else if (!(isParam && i == 0)) {
+                reportError(location, "Array size required.");
+            }
+            t.dims.push_back(size);
+        }
+        return t;
+    }
+
+    int declareVariable(const std::string &name, const Type &type, const SourceLocation &location) {
+        auto &scope = scopes.back();
+        if (scope.count(name)) {
+            reportError(location, "Redeclaration of '" + name + "'.");
+        }
+        if (type.base == TokenKind::KwVoid) {
+            reportError(location, "Variable '" + name + "' cannot be void.");
+        }
+        Symbol symbol;
+        symbol.name = name;
+        symbol.type = type;
+        symbol.function = currentFunction;
+        symbol.index = currentFunction < 0 ? globalCount++ : localCount++;
+        int id = static_cast<int>(program->symbols.size());
+        program->symbols.push_back(std::move(symbol));
+        scope[name] = id;
+        return id;
+    }
+
+    int lookup(const std::string &name) const {
+        for (auto it = scopes.rbegin(); it != scopes.rend(); ++it) {
+            auto found = it->find(name);
+            if (found != it->end()) return found->second;
+        }
+        return -1;
+    }
+
+    // Compatibilidad de argumentos: un parámetro 'int a[]' acepta cualquier longitud externa
+    // (y un tamaño todavía sin plegar, cualquier otro)
+    static bool compatible(const Type &param, const Type &arg) {
+        if (param.base != arg.base || param.dims.size() != arg.dims.size()) return false;
+        for (size_t i = 0; i < param.dims.size(); ++i) {
+            if (param.dims[i] == kDeferredSize || arg.dims[i] == kDeferredSize) continue;
+            if (param.dims[i] != arg.dims[i] && !(i == 0 && param.dims[i] == 0)) return false;
+        }
+        return true;
+    }
+
+    bool isLvalue(const Expr &e) const {
+        return e.kind == ExprKind::Var || e.kind == ExprKind::Index;
+    }
+
+    Type checkExpr(Expr &e, bool allowArray = false) {
+        Type t;
+        switch (e.kind) {
+            case ExprKind::IntLit:
+            case ExprKind::BoolLit:
+            case ExprKind::CharLit:
+            case ExprKind::StringLit:
+                t = literalType(e.kind);
+                break;
+
+            case ExprKind::Var:
+                e.symbol = lookup(e.name);
+                if (e.symbol < 0) {
+                    reportError(e.location, "Undeclared variable '" + e.name + "'.");
+                    t = scalar(TokenKind::KwInteger);
+                } else {
+                    t = program->symbols[e.symbol].type;
+                }
+                if (t.isArray() && !allowArray) {
+                    reportError(e.location, "Array '" + e.name + "' used as a value.");
+                }
+                break;
+
+            case ExprKind::Assign: {
+                Type target = checkExpr(*e.args[0]);
+                Type value = checkExpr(*e.args[1]);
+                if (!isLvalue(*e.args[0])) {
+                    reportError(e.location, "Invalid assignment target.");
+                } else if (target != value) {
+                    reportError(e.location, "Cannot assign " + value.toString() + " to " + target.toString() + ".");
+                }
+                t = target;
+                break;
+            }
+
+            case ExprKind::Postfix:
+                t = checkExpr(*e.args[0]);
+                if (!isLvalue(*e.args[0]) || !t.isScalar(TokenKind::KwInteger)) {
+                    reportError(e.location, "'++' and '--' require an integer variable.");
+                }
+                t = scalar(TokenKind::KwInteger);
+                break;
+
+            case ExprKind::Unary: {
+                Type operand = checkExpr(*e.args[0]);
+                if (e.op == TokenKind::LogicalNot) {
+                    if (!operand.isScalar(TokenKind::KwBoolean)) reportError(e.location, "'!' requires a boolean operand.");
+                    t = scalar(TokenKind::KwBoolean);
+                } else {
+                    if (!operand.isScalar(TokenKind::KwInteger)) reportError(e.location, "Unary '-' requires an integer operand.");
+                    t = scalar(TokenKind::KwInteger);
+                }
+                break;
+            }
+
+            case ExprKind::Binary:
+                t = checkBinary(e);
+                break;
+
+            case ExprKind::Call: {
+                auto found = functionIndex.find(e.name);
+                for (auto &arg : e.args) checkExpr(*arg, true);
+                if (found == functionIndex.end()) {
+                    reportError(e.location, "Undeclared function '" + e.name + "'.");
+                    t = scalar(TokenKind::KwInteger);
+                    break;
+                }
+                e.symbol = found->second;
+                Function &fn = program->functions[e.symbol];
+                if (fn.params.size() != e.args.size()) {
+                    reportError(e.location, "Function '" + e.name + "' expects " + std::to_string(fn.params.size()) +
+                                " arguments, got " + std::to_string(e.args.size()) + ".");
+                } else {
+                    for (size_t i = 0; i < e.args.size(); ++i) {
+                        const Type &param = paramTypes[e.symbol][i];
+                        if (!compatible(param, e.args[i]->type)) {
+                            reportError(e.args[i]->location, "Argument " + std::to_string(i + 1) + " of '" + e.name +
+                                        "' must be " + param.toString() + ".");
+                        }
+                    }
+                }
+                t = returnTypes[e.symbol];
+                break;
+            }
+
+            case ExprKind::Index: {
+                Type base = checkExpr(*e.args[0], true);
+                Type index = checkExpr(*e.args[1]);
+                if (!index.isScalar(TokenKind::KwInteger)) reportError(e.args[1]->location, "Array index must be an integer.");
+                if (!base.isArray()) {
+                    reportError(e.location, "Indexing a non-array value.");
+                    t = scalar(TokenKind::KwInteger);
+                } else {
+                    t = base;
+                    t.dims.erase(t.dims.begin());
+                }
+                if (t.isArray() && !allowArray) {
+                    reportError(e.location, "Partial array indexing is not supported.");
+                }
+                break;
+            }
+        }
+        e.type = t;
+        return t;
+    }
+
+    Type checkBinary(Expr &e) {
+        Type lhs = checkExpr(*e.args[0]);
+        Type rhs = checkExpr(*e.args[1]);
+        bool intOperands = lhs.isScalar(TokenKind::KwInteger) && rhs.isScalar(TokenKind::KwInteger);
+        switch (e.op) {
+            case TokenKind::Addition:
+                // Concatenación: string + escalar o escalar + string
+                if ((lhs.isScalar(TokenKind::KwString) && !rhs.isArray()) || (rhs.isScalar(TokenKind::KwString) && !lhs.isArray())) {
+                    return scalar(TokenKind::KwString);
+                }
+                [[fallthrough]];
+            case TokenKind::Subtraction:
+            case TokenKind::Multiplication:
+            case TokenKind::Division:
+            case TokenKind::Modulus:
+            case TokenKind::Exponentiation:
+                if (!intOperands) reportError(e.location, "Arithmetic operators require integer operands.");
+                return scalar(TokenKind::KwInteger);
+            case TokenKind::LessThan:
+            case TokenKind::LessThanOrEqual:
+            case TokenKind::GreaterThan:
+            case TokenKind::GreaterThanOrEqual:
+                if (!intOperands && !(lhs.isScalar(TokenKind::KwChar) && rhs.isScalar(TokenKind::KwChar))) {
+                    reportError(e.location, "Relational operators require integer or char operands.");
+                }
+                return scalar(TokenKind::KwBoolean);
+            case TokenKind::isEqual:
+            case TokenKind::NotEqual:
+                if (lhs != rhs || lhs.isArray() || lhs.base == TokenKind::KwVoid) {
+                    reportError(e.location, "Cannot compare " + lhs.toString() + " with " + rhs.toString() + ".");
+                }
+                return scalar(TokenKind::KwBoolean);
+            case TokenKind::LogicalAnd:
+            case TokenKind::LogicalOr:
+                if (!lhs.isScalar(TokenKind::KwBoolean) || !rhs.isScalar(TokenKind::KwBoolean)) {
+                    reportError(e.location, "Logical operators require boolean operands.");
+                }
+                return scalar(TokenKind::KwBoolean);
+            default:
+                reportError(e.location, "Unknown binary operator.");
+                return scalar(TokenKind::KwInteger);
+        }
+    }
+
+    void checkCondition(Expr *cond, const SourceLocation &location) {
+        if (!cond) return;
+        if (!checkExpr(*cond).isScalar(TokenKind::KwBoolean)) {
+            reportError(location, "Condition must be boolean.");
+        }
+    }
+
+    void checkVarDecl(Stmt &s) {
+        Type type = resolveType(s.declType, s.location, false);
+        if (s.expr) {
+            Type init = checkExpr(*s.expr);
+            if (type.isArray()) {
+                reportError(s.location, "Arrays cannot have an initializer.");
+            } else if (init != type) {
+                reportError(s.location, "Cannot initialize " + type.toString() + " '" + s.name + "' with " + init.toString() + ".");
+            }
+        }
+        s.symbol = declareVariable(s.name, type, s.location);
+    }
+
+    void checkBlock(std::vector<StmtPtr> &stmts) {
+        scopes.emplace_back();
+        for (auto &s : stmts) if (s) checkStmt(*s);
+        scopes.pop_back();
+    }
+
+    void checkStmt(Stmt &s) {
+        switch (s.kind) {
+            case StmtKind::VarDecl:
+                checkVarDecl(s);
+                break;
+            case StmtKind::Expr:
+                if (s.expr) checkExpr(*s.expr);
+                break;
+            case StmtKind::Print:
+                for (auto &e : s.exprs) {
+                    if (e && checkExpr(*e).base == TokenKind::KwVoid) reportError(e->location, "Cannot print a void value.");
+                }
+                break;
+            case StmtKind::Return: {
+                const Type &expected = returnTypes[currentFunction];
+                Type actual = s.expr ? checkExpr(*s.expr) : scalar(TokenKind::KwVoid);
+                if (actual != expected) {
+                    reportError(s.location, "Return type mismatch: expected " + expected.toString() + ", got " + actual.toString() + ".");
+                }
+                break;
+            }
+            case StmtKind::Block:
+                checkBlock(s.body);
+                break;
+            case StmtKind::If:
+                checkCondition(s.expr.get(), s.location);
+                checkBlock(s.body);
+                checkBlock(s.elseBody);
+                break;
+            case StmtKind::While:
+                checkCondition(s.expr.get(), s.location);
+                checkBlock(s.body);
+                break;
+            case StmtKind::For:
+                scopes.emplace_back();
+                if (s.init) checkStmt(*s.init);
+                checkCondition(s.expr.get(), s.location);
+                if (s.step) checkExpr(*s.step);
+                checkBlock(s.body);
+                scopes.pop_back();
+                break;
+        }
+    }
+
+public:
+    // Con deferSizes, los tamaños de arreglo que no son literales se aceptan sin
+    // verificar: es la pasada previa al plegado, que puede reducirlos a literales
+    bool run(Program &target, bool deferSizes = false) {
+        program = &target;
+        deferArraySizes = deferSizes;
+        program->symbols.clear();
+        scopes.assign(1, {});
+        functionIndex.clear();
+        returnTypes.clear();
+        paramTypes.clear();
+        errorCount = 0;
+        globalCount = 0;
+        currentFunction = -1;
+
+        // Firmas primero: las funciones pueden llamarse antes de su declaración
+        for (size_t i = 0; i < program->functions.size(); ++i) {
+            Function &fn = program->functions[i];
+            if (functionIndex.count(fn.name)) {
+                reportError(fn.location, "Redefinition of function '" + fn.name + "'.");
+            }
+            functionIndex[fn.name] = static_cast<int>(i);
+            Type ret = resolveType(fn.returnType, fn.location, false);
+            if (ret.isArray()) reportError(fn.location, "Functions cannot return arrays.");
+            returnTypes.push_back(ret);
+            paramTypes.emplace_back();
+            for (const auto &param : fn.params) {
+                paramTypes.back().push_back(resolveType(param.type, param.location, true));
+            }
+        }
+
+        for (auto &g : program->globals) {
+            if (g) checkVarDecl(*g);
+        }
+
+        for (size_t i = 0; i < program->functions.size(); ++i) {
+            Function &fn = program->functions[i];
+            currentFunction = static_cast<int>(i);
+            localCount = 0;
+            scopes.emplace_back();
+            for (size_t p = 0; p < fn.params.size(); ++p) {
+                fn.params[p].symbol = declareVariable(fn.params[p].name, paramTypes[i][p], fn.params[p].location);
+            }
+            checkBlock(fn.body);
+            scopes.pop_back();
+        }
+        currentFunction = -1;
+        return errorCount == 0;
+    }
+
+    unsigned int getErrorCount() const {
+        return errorCount;
+    }
+
+    // Número de variables locales (incluye parámetros) de cada función
+    static std::vector<int> countLocals(const Program &program) {
+        std::vector<int> counts(program.functions.size(), 0);
+        for (const auto &symbol : program.symbols) {
+            if (symbol.function >= 0) counts[symbol.function] = std::max(counts[symbol.function], symbol.index + 1);
+        }
+        return counts;
+    }
+};
+
+#endif // SEMA_H_
@@ -0,0 +1,140 @@
+#ifndef SERVER_H_
+#define SERVER_H_
+
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+// Comunicación del servidor de compilación (--serve) con sus clientes (--client)
+// por un socket Unix local. Cada conexión lleva un pedido y su respuesta, ambos
+// como listas de cadenas: la cantidad y luego cada cadena precedida de su
+// longitud, en enteros de 32 bits en el orden del host (los dos extremos corren
+// en la misma máquina).
+
+inline bool writeAll(int fd, const char *p, size_t n) {
+    while (n > 0) {
+        ssize_t written = ::write(fd, p, n);
+        if (written < 0 && errno == EINTR) continue;
+        if (written <= 0) return false;
+        p += written;
+        n -= static_cast<size_t>(written);
+    }
+    return true;
+}
+
+inline bool readAll(int fd, char *p, size_t n) {
+    while (n > 0) {
+        ssize_t got = ::read(fd, p, n);
+        if (got < 0 && errno == EINTR) continue;
+        if (got <= 0) return false;
+        p += got;
+        n -= static_cast<size_t>(got);
+    }
+    return true;
+}
+
+inline bool sendStrings(int fd, const std::vector<std::string> &strings) {
+    std::string message;
+    auto putLength = [&](size_t n) {
+        uint32_t length = static_cast<uint32_t>(n);
+        message.append(reinterpret_cast<const char *>(&length), sizeof(length));
+    };
+    putLength(strings.size());
+    for (const std::string &s : strings) {
+        putLength(s.size());
+        message += s;
+    }
+    return writeAll(fd, message.data(), message.size());
+}
+
+inline bool receiveStrings(int fd, std::vector<std::string> &strings) {
+    static const uint32_t kMaxStrings = 1u << 16;
+    static const uint32_t kMaxLength = 1u << 30;
+    uint32_t count;
+    if (!readAll(fd, reinterpret_cast<char *>(&count), sizeof(count)) || count > kMaxStrings) return false;
+    strings.assign(count, std::string());
+    for (std::string &s : strings) {
+        uint32_t length;
+        if (!readAll(fd, reinterpret_cast<char *>(&length), sizeof(length)) || length > kMaxLength) return false;
+        s.resize(length);
+        if (length && !readAll(fd, &s[0], length)) return false;
+    }
+    return true;
+}
+
+// Límite de espera al leer y escribir en el socket: un extremo que deja de
+// responder a mitad de un mensaje no bloquea al otro para siempre
+inline void setSocketTimeout(int fd, int seconds) {
+    timeval timeout;
+    timeout.tv_sec = seconds;
+    timeout.tv_usec = 0;
+    ::setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    ::setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+}
+
+// Llena la dirección del socket; false si la ruta no entra en sun_path
+inline bool unixAddress(const std::string &path, sockaddr_un &address) {
+    std::memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    if (path.empty() || path.size() >= sizeof(address.sun_path)) return false;
+    std::memcpy(address.sun_path, path.c_str(), path.size());
+    return true;
+}
+
+// Socket que escucha en la ruta (reemplaza un socket viejo que haya quedado); -1 si falla
+inline int listenUnix(const std::string &path) {
+    sockaddr_un address;
+    if (!unixAddress(path, address)) return -1;
+    int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) return -1;
+    struct stat info;
+    if (::stat(path.c_str(), &info) == 0 && S_ISSOCK(info.st_mode)) ::unlink(path.c_str());
+    if (::bind(fd, reinterpret_cast<sockaddr *>(&address), sizeof(address)) != 0 || ::listen(fd, 64) != 0) {
+        ::close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+// Conexión con el servidor que escucha en la ruta; -1 si no hay ninguno
+inline int connectUnix(const std::string &path) {
+    sockaddr_un address;
+    if (!unixAddress(path, address)) return -1;
+    int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) return -1;
+    if (::connect(fd, reinterpret_cast<sockaddr *>(&address), sizeof(address)) != 0) {
+        ::close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+// Identifica la versión de un archivo para la caché del servidor: si la fecha de
+// modificación o el tamaño cambian, hay que volver a compilarlo
+struct FileStamp {
+    int64_t seconds = 0;
+    int64_t nanoseconds = 0;
+    int64_t size = -1;
+
+    bool operator==(const FileStamp &other) const {
+        return seconds == other.seconds && nanoseconds == other.nanoseconds && size == other.size;
+    }
+};
+
+inline bool fileStamp(const std::string &path, FileStamp &stamp) {
+    struct stat info;
+    if (::stat(path.c_str(), &info) != 0 || !S_ISREG(info.st_mode)) return false;
+    stamp.seconds = static_cast<int64_t>(info.st_mtim.tv_sec);
+    stamp.nanoseconds = static_cast<int64_t>(info.st_mtim.tv_nsec);
+    stamp.size = static_cast<int64_t>(info.st_size);
+    return true;
+}
+
+#endif // SERVER_H_
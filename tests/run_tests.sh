@@ -0,0 +1,107 @@
+#!/usr/bin/env bash
+# Pruebas diferenciales: cada tests/*.bm corre con la VM (--run), con el JIT
+# desde la primera llamada, con el backend x86 (--native) y con el backend C
+# (--native-c). La salida (stdout y stderr) de cada uno debe ser igual a la del
+# .out de al lado, y el código de salida igual al de --run.
+#
+#   tests/run_tests.sh [compilador]       sin compilador, compila main.cpp con g++
+#   tests/run_tests.sh --update [comp.]   reescribe los .out con la salida de --run
+#
+# Cada corrida tiene un límite de tiempo: un bucle que no termina cuenta como fallo.
+
+set -u
+
+TESTS_DIR="$(cd "$(dirname "$0")" && pwd)"
+REPO_DIR="$(dirname "$TESTS_DIR")"
+TIMEOUT_SECONDS=10
+
+update=0
+if [ "${1:-}" = "--update" ]; then
+    update=1
+    shift
+fi
+
+work="$(mktemp -d)"
+trap 'rm -rf "$work"' EXIT
+
+compiler="${1:-}"
+if [ -z "$compiler" ]; then
+    compiler="$work/bminor"
+    echo "Compilando main.cpp..."
+    if ! g++ -std=c++17 -O2 -pthread "$REPO_DIR/main.cpp" -o "$compiler"; then
+        echo "No se pudo compilar main.cpp." >&2
+        exit 2
+    fi
+fi
+
+# El backend x86 y el JIT generan código x86-64; en otra arquitectura sólo
+# quedan la VM y el backend C
+backends=("--run" "--jit --jit-threshold 0" "--native" "--native-c")
+if [ "$(uname -m)" != "x86_64" ]; then
+    backends=("--run" "--native-c")
+fi
+
+# Corre el programa con un backend: deja la salida en $work/out y devuelve su código
+run_backend() {
+    local backend="$1" program="$2"
+    case "$backend" in
+        --native | --native-c)
+            rm -f "$work/prog"
+            if ! timeout "$TIMEOUT_SECONDS" "$compiler" "$backend" "$program" -o "$work/prog" > "$work/out" 2>&1; then
+                echo "(no se pudo compilar con $backend)" >> "$work/out"
+                return 125
+            fi
+            timeout "$TIMEOUT_SECONDS" "$work/prog" > "$work/out" 2>&1
+            ;;
+        *)
+            # shellcheck disable=SC2086
+            timeout "$TIMEOUT_SECONDS" "$compiler" $backend "$program" > "$work/out" 2>&1
+            ;;
+    esac
+}
+
+passed=0
+failed=0
+for program in "$TESTS_DIR"/*.bm; do
+    name="$(basename "$program" .bm)"
+    expected="${program%.bm}.out"
+
+    run_backend "--run" "$program"
+    reference=$?
+    if [ "$update" = 1 ]; then
+        cp "$work/out" "$expected"
+        echo "actualizado $name"
+        continue
+    fi
+    if [ ! -f "$expected" ]; then
+        echo "FALLO $name: falta $(basename "$expected") (tests/run_tests.sh --update lo genera)"
+        failed=$((failed + 1))
+        continue
+    fi
+
+    ok=1
+    for backend in "${backends[@]}"; do
+        run_backend "$backend" "$program"
+        status=$?
+        if [ "$status" = 124 ]; then
+            echo "FALLO $name [$backend]: tiempo agotado (${TIMEOUT_SECONDS} s)"
+            ok=0
+        elif ! diff -u "$expected" "$work/out" > "$work/diff"; then
+            echo "FALLO $name [$backend]: salida distinta"
+            sed 's/^/    /' "$work/diff"
+            ok=0
+        elif [ "$status" != "$reference" ]; then
+            echo "FALLO $name [$backend]: código de salida $status, --run terminó con $reference"
+            ok=0
+        fi
+    done
+    if [ "$ok" = 1 ]; then
+        passed=$((passed + 1))
+    else
+        failed=$((failed + 1))
+    fi
+done
+
+[ "$update" = 1 ] && exit 0
+echo "$passed pasaron, $failed fallaron"
+[ "$failed" = 0 ]
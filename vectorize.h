@@ -0,0 +1,154 @@
+#ifndef VECTORIZE_H_
+#define VECTORIZE_H_
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+#include "ir.h"
+#include "loops.h"
+
+// Estadísticas de la vectorización de bucles
+struct VectorizeStats {
+    unsigned int loops = 0;         // bucles marcados como vectorizables
+    unsigned int reductions = 0;    // acumuladores que pasan a sumas por carril
+};
+
+// Marca los bucles que el backend nativo puede ejecutar con SIMD. Sólo se aceptan
+// bucles contados de dos bloques (encabezado con i < n y un cuerpo sin saltos)
+// cuyo cuerpo trabaja elemento a elemento: lecturas y escrituras de a[i] con el
+// contador como índice (ya sin verificaciones de límites) y +, -, *, negación
+// sobre enteros. Como cada vuelta sólo toca su propio elemento, no hay
+// dependencias entre vueltas aunque los arreglos coincidan. Los phis del
+// encabezado deben ser el contador, inducciones lineales (phi + paso invariante)
+// o acumuladores (phi + valor del cuerpo, sin otros usos).
+// La IR no cambia: el plan queda en IrFunction::vectorLoops y el backend ejecuta
+// el bucle escalar tal cual después de las vueltas vectoriales.
+class LoopVectorizer {
+    static const uint32_t kMaxBodySize = 48;
+
+    VectorizeStats stats;
+    const IrFunction *fn = nullptr;
+
+    bool definedOutside(const IrLoop &loop, uint32_t v) const {
+        return !loop.contains[fn->blockOf(v)];
+    }
+
+    bool isInt(uint32_t v) const {
+        return v != kNoValue && fn->insts[v].type == IrType::Int;
+    }
+
+    // phi + x (o x + phi): devuelve x, o kNoValue si la actualización no es una suma
+    uint32_t addendOf(uint32_t update, uint32_t phi) const {
+        const IrInst &inst = fn->insts[update];
+        if (inst.op != IrOp::Add || inst.type != IrType::Int) return kNoValue;
+        if (inst.a == phi) return inst.b;
+        if (inst.b == phi) return inst.a;
+        return kNoValue;
+    }
+
+    bool analyze(const IrLoop &loop, IrVectorLoop &plan) {
+        if (loop.blocks.size() != 2 || loop.latch == kNoBlock) return false;
+        const uint32_t header = loop.header, body = loop.latch;
+        const IrBlock &headerBlock = fn->blocks[header];
+        const IrBlock &bodyBlock = fn->blocks[body];
+        if (headerBlock.predCount != 2 || bodyBlock.end - bodyBlock.begin > kMaxBodySize) return false;
+        if (fn->terminator(body).op != IrOp::Jump) return false;
+
+        // Encabezado: phis, la comparación del contador y el branch al cuerpo
+        const IrInst &branch = fn->terminator(header);
+        const uint32_t compare = headerBlock.end - 2;
+        if (branch.op != IrOp::Branch || branch.b != body || branch.a != compare) return false;
+        const IrInst &cond = fn->insts[compare];
+        if (cond.op == IrOp::Lt) {
+            plan.counter = cond.a;
+            plan.bound = cond.b;
+        } else if (cond.op == IrOp::Gt) {
+            plan.counter = cond.b;
+            plan.bound = cond.a;
+        } else {
+            return false;
+        }
+        if (!isInt(plan.bound) || !definedOutside(loop, plan.bound)) return false;
+
+        std::unordered_map<uint32_t, uint32_t> uses;
+        for (uint32_t b : loop.blocks) {
+            for (uint32_t i = fn->blocks[b].begin; i < fn->blocks[b].end; ++i) {
+                fn->forEachOperand(fn->insts[i], [&](uint32_t v) { if (v != kNoValue) uses[v]++; });
+            }
+        }
+
+        const uint32_t fromBody = fn->predsOf(header)[0] == body ? 0 : 1;
+        bool hasCounter = false;
+        for (uint32_t i = headerBlock.begin; i < compare; ++i) {
+            const IrInst &phi = fn->insts[i];
+            if (phi.op != IrOp::Phi || phi.type != IrType::Int || phi.b != 2) return false;
+            uint32_t update = fn->operands[phi.a + fromBody];
+            if (update == kNoValue || fn->blockOf(update) != body) return false;
+            uint32_t step = addendOf(update, i);
+            if (step == kNoValue) return false;
+            bool invariant = fn->insts[step].op == IrOp::Const || definedOutside(loop, step);
+            if (i == plan.counter) {
+                if (fn->insts[step].op != IrOp::Const || fn->insts[step].imm != 1) return false;
+                hasCounter = true;
+            } else if (invariant) {
+                plan.inductions.push_back(i);
+            } else {
+                // El acumulador sólo se usa en su suma, y la suma sólo en el phi
+                if (uses[i] != 1 || uses[update] != 1) return false;
+                plan.reductions.push_back(i);
+            }
+        }
+        if (!hasCounter) return false;
+
+        for (uint32_t i = bodyBlock.begin; i + 1 < bodyBlock.end; ++i) {
+            const IrInst &inst = fn->insts[i];
+            switch (inst.op) {
+                case IrOp::Nop:
+                case IrOp::Const:
+                    break;
+                case IrOp::Add:
+                case IrOp::Sub:
+                case IrOp::Mul:
+                    if (inst.type != IrType::Int || !isInt(inst.a) || !isInt(inst.b)) return false;
+                    break;
+                case IrOp::Neg:
+                    if (inst.type != IrType::Int || !isInt(inst.a)) return false;
+                    break;
+                case IrOp::Load:
+                    if (inst.type != IrType::Int || inst.b != plan.counter || !definedOutside(loop, inst.a)) return false;
+                    break;
+                case IrOp::Store:
+                    if (inst.b != plan.counter || !definedOutside(loop, inst.a) || !isInt(inst.c)) return false;
+                    break;
+                default:
+                    return false;
+            }
+        }
+        plan.preheader = loop.preheader;
+        plan.header = header;
+        plan.body = body;
+        return true;
+    }
+
+public:
+    VectorizeStats run(IrModule &module) {
+        stats = VectorizeStats{};
+        for (auto &function : module.functions) {
+            function.vectorLoops.clear();
+            if (function.blocks.empty()) continue;
+            fn = &function;
+            for (const IrLoop &loop : findLoops(function)) {
+                IrVectorLoop plan;
+                if (!analyze(loop, plan)) continue;
+                stats.loops++;
+                stats.reductions += static_cast<unsigned int>(plan.reductions.size());
+                function.vectorLoops.push_back(std::move(plan));
+            }
+        }
+        fn = nullptr;
+        return stats;
+    }
+};
+
+#endif // VECTORIZE_H_
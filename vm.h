@@ -0,0 +1,849 @@
+#ifndef VM_H_
+#define VM_H_
+
+#include <algorithm>
+#include <cstdint>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "helper.h"
+#include "ir.h"
+#include "regalloc.h"
+#include "runtime.h"
+
+// Bytecode de registros y máquina virtual.
+//
+// El compilador traduce la IR en SSA a instrucciones de tres registros: cada
+// valor SSA recibe un registro del marco (barrido lineal en regalloc.h) y los
+// phis se resuelven con copias paralelas al final de los predecesores.
+// La VM usa despacho directo por hilos (goto computado) cuando el compilador lo
+// soporta; con BM_VM_SWITCH_DISPATCH, o fuera de GCC/Clang, usa un switch.
+
+#if defined(__GNUC__) && !defined(BM_VM_SWITCH_DISPATCH)
+#define BM_VM_THREADED 1
+#endif
+
+// Lista de operaciones: X(nombre)
+#define BM_BYTECODE_OPS(X) \
+    X(Mov)          /* a = b */ \
+    X(LoadK)        /* a = constants[k] */ \
+    X(LoadStr)      /* a = strings[k] */ \
+    X(Add) X(Sub) X(Mul) X(Div) X(Mod) X(Pow) \
+    X(Neg) X(Not)   /* a = op b */ \
+    X(Eq) X(Ne) X(Lt) X(Le) X(Gt) X(Ge) \
+    X(StrEq) X(StrNe) \
+    X(Concat)       /* a = b + c (cadenas) */ \
+    X(ToStr)        /* a = cadena(b), aux = IrType de b */ \
+    X(LoadGlobal)   /* a = globals[k] */ \
+    X(StoreGlobal)  /* globals[k] = a */ \
+    X(NewArray)     /* a = arreglo de longitud b, aux = IrType del elemento */ \
+    X(ArrayLen)     /* a = longitud de b */ \
+    X(BoundsCheck)  /* error si a no está en [0, b) */ \
+    X(Load)         /* a = b[c] */ \
+    X(Store)        /* a[b] = c */ \
+    X(Call)         /* a = functions[k](argumentos desde frameSize) */ \
+    X(Print)        /* imprime a, aux = IrType */ \
+    X(PrintLn) \
+    X(Jmp)          /* salta a k */ \
+    X(Loop)         /* salta hacia atrás a k (cabecera de un bucle) */ \
+    X(JmpIfTrue)    /* si a salta a k */ \
+    X(JmpIfFalse)   /* si !a salta a k */ \
+    X(Ret)          /* devuelve a */ \
+    X(RetVoid) \
+    /* Superinstrucciones (peephole.h): ocupan el lugar de la primera instrucción \
+       y leen el resto de las siguientes, que quedan en el código */ \
+    X(LtJmpIfTrue) X(LtJmpIfFalse) X(LeJmpIfTrue) X(LeJmpIfFalse) \
+    X(GtJmpIfTrue) X(GtJmpIfFalse) X(GeJmpIfTrue) X(GeJmpIfFalse) \
+    X(EqJmpIfTrue) X(EqJmpIfFalse) X(NeJmpIfTrue) X(NeJmpIfFalse) \
+    X(AddMov)       /* Add; Mov */ \
+    X(MovMov)       /* Mov; Mov */ \
+    X(MovLoop)      /* Mov; Loop */ \
+    X(GlobalAdd)    /* LoadGlobal; Add; StoreGlobal */ \
+    X(GlobalSub)    /* LoadGlobal; Sub; StoreGlobal */ \
+    X(CallRet)      /* Call; Ret: el llamado vuelve directamente a quien llamó */ \
+    X(CallRetVoid)  /* Call; RetVoid */
+
+enum class BcOp : uint8_t {
+#define BM_BYTECODE_ENUM(name) name,
+    BM_BYTECODE_OPS(BM_BYTECODE_ENUM)
+#undef BM_BYTECODE_ENUM
+};
+
+inline const char *bcOpName(BcOp op) {
+    static const char *const names[] = {
+#define BM_BYTECODE_NAME(name) #name,
+        BM_BYTECODE_OPS(BM_BYTECODE_NAME)
+#undef BM_BYTECODE_NAME
+    };
+    return names[static_cast<int>(op)];
+}
+
+// Instrucción de 8 bytes: tres registros de 16 bits, o un registro y un inmediato k de 32 bits
+struct BcInst {
+    BcOp op;
+    uint8_t aux = 0;
+    uint16_t a = 0;
+    uint16_t b = 0;
+    uint16_t c = 0;
+
+    uint32_t k() const { return static_cast<uint32_t>(b) | (static_cast<uint32_t>(c) << 16); }
+    void setK(uint32_t value) {
+        b = static_cast<uint16_t>(value & 0xFFFF);
+        c = static_cast<uint16_t>(value >> 16);
+    }
+};
+
+struct BcFunction {
+    std::string name;
+    std::vector<BcInst> code;
+    std::vector<int64_t> constants;
+    uint32_t numParams = 0;
+    uint32_t frameSize = 0;   // registros propios; los argumentos salientes van a continuación
+    uint32_t stackNeed = 0;   // frameSize + máximo de argumentos salientes
+    bool returnsValue = false;
+    // Correspondencia con la IR, para entrar al código nativo a mitad de un bucle
+    std::vector<uint32_t> valueRegs;   // registro de cada valor SSA (kNoValue si no tiene)
+    std::vector<uint32_t> blockStart;  // primera instrucción de cada bloque
+};
+
+// Perfil dinámico: veces que se ejecutó cada operación y cada par consecutivo
+// (la anterior en la misma función, o la última antes de una llamada o retorno)
+struct BcProfile {
+#define BM_BYTECODE_COUNT(name) +1
+    static const int kNumOps = 0 BM_BYTECODE_OPS(BM_BYTECODE_COUNT);
+#undef BM_BYTECODE_COUNT
+    uint64_t ops[kNumOps] = {};
+    uint64_t pairs[kNumOps][kNumOps] = {};
+    int last = -1;
+
+    void record(BcOp op) {
+        int k = static_cast<int>(op);
+        ops[k]++;
+        if (last >= 0) pairs[last][k]++;
+        last = k;
+    }
+
+    uint64_t total() const {
+        uint64_t sum = 0;
+        for (uint64_t count : ops) sum += count;
+        return sum;
+    }
+};
+
+struct BcModule {
+    std::vector<BcFunction> functions;
+    std::vector<std::string> strings;
+    std::vector<IrType> globals;
+    int initFunction = -1;
+    int mainFunction = -1;
+};
+
+// Traducción de la IR a bytecode
+class BytecodeCompiler {
+    const IrModule &module;
+    unsigned int errorCount = 0;
+
+    // Estado de la función actual
+    const IrFunction *fn = nullptr;
+    BcFunction *out = nullptr;
+    RegisterAssignment regs;
+    uint32_t scratch = 0;
+    uint32_t currentBlock = 0;
+    std::vector<uint32_t> blockStart;
+    std::vector<std::pair<uint32_t, uint32_t>> fixups;  // (instrucción, bloque destino)
+    std::unordered_map<int64_t, uint32_t> constantIndex;  // valor -> posición en out->constants
+
+    void reportError(const std::string &message) {
+        compilerErr() << "Bytecode Error: " << message << std::endl;
+        errorCount++;
+    }
+
+    uint16_t reg(uint32_t value) const {
+        return static_cast<uint16_t>(regs.reg[value]);
+    }
+
+    void emit(BcOp op, uint32_t a = 0, uint32_t b = 0, uint32_t c = 0, uint8_t aux = 0) {
+        BcInst inst;
+        inst.op = op;
+        inst.aux = aux;
+        inst.a = static_cast<uint16_t>(a);
+        inst.b = static_cast<uint16_t>(b);
+        inst.c = static_cast<uint16_t>(c);
+        out->code.push_back(inst);
+    }
+
+    void emitK(BcOp op, uint32_t a, uint32_t k, uint8_t aux = 0) {
+        BcInst inst;
+        inst.op = op;
+        inst.aux = aux;
+        inst.a = static_cast<uint16_t>(a);
+        inst.setK(k);
+        out->code.push_back(inst);
+    }
+
+    void emitJump(BcOp op, uint32_t a, uint32_t block) {
+        // Los bloques están en orden inverso de post-orden: sólo las aristas de
+        // retorno de un bucle saltan hacia atrás
+        if (op == BcOp::Jmp && block <= currentBlock) op = BcOp::Loop;
+        fixups.push_back({static_cast<uint32_t>(out->code.size()), block});
+        emitK(op, a, 0);
+    }
+
+    uint32_t constant(int64_t value) {
+        auto inserted = constantIndex.emplace(value, static_cast<uint32_t>(out->constants.size()));
+        if (inserted.second) out->constants.push_back(value);
+        return inserted.first->second;
+    }
+
+    // Copias paralelas de los phis de 'to' para la arista from -> to, en secuencia.
+    // Los ciclos se rompen con el registro auxiliar.
+    void emitPhiCopies(uint32_t from, uint32_t to) {
+        const IrBlock &block = fn->blocks[to];
+        const uint32_t *preds = fn->predsOf(to);
+        uint32_t k = 0;
+        while (k < block.predCount && preds[k] != from) ++k;
+        std::vector<std::pair<uint32_t, uint32_t>> moves;  // (destino, origen)
+        for (uint32_t i = block.begin; i < block.end && fn->insts[i].op == IrOp::Phi; ++i) {
+            const IrInst &phi = fn->insts[i];
+            if (k >= phi.b) continue;
+            uint32_t source = fn->operands[phi.a + k];
+            if (source == kNoValue || regs.reg[source] == regs.reg[i]) continue;
+            moves.push_back({regs.reg[i], regs.reg[source]});
+        }
+        while (!moves.empty()) {
+            bool progress = false;
+            for (size_t m = 0; m < moves.size(); ++m) {
+                bool blocked = false;
+                for (const auto &other : moves) {
+                    if (other.second == moves[m].first) {
+                        blocked = true;
+                        break;
+                    }
+                }
+                if (blocked) continue;
+                emit(BcOp::Mov, moves[m].first, moves[m].second);
+                moves.erase(moves.begin() + m);
+                progress = true;
+                break;
+            }
+            if (progress) continue;
+            // Todo lo pendiente forma ciclos: salvar un destino en el auxiliar
+            uint32_t saved = moves[0].first;
+            emit(BcOp::Mov, scratch, saved);
+            for (auto &move : moves) {
+                if (move.second == saved) move.second = scratch;
+            }
+        }
+    }
+
+    bool hasPhis(uint32_t block) const {
+        const IrBlock &b = fn->blocks[block];
+        return b.begin < b.end && fn->insts[b.begin].op == IrOp::Phi;
+    }
+
+    void compileInst(uint32_t block, uint32_t id) {
+        const IrInst &inst = fn->insts[id];
+        switch (inst.op) {
+            case IrOp::Nop:
+            case IrOp::Param:
+            case IrOp::Phi:
+                break;
+            case IrOp::Const:
+                emitK(BcOp::LoadK, reg(id), constant(inst.imm));
+                break;
+            case IrOp::ConstStr:
+                emitK(BcOp::LoadStr, reg(id), static_cast<uint32_t>(inst.imm));
+                break;
+            case IrOp::Add: emit(BcOp::Add, reg(id), reg(inst.a), reg(inst.b)); break;
+            case IrOp::Sub: emit(BcOp::Sub, reg(id), reg(inst.a), reg(inst.b)); break;
+            case IrOp::Mul: emit(BcOp::Mul, reg(id), reg(inst.a), reg(inst.b)); break;
+            case IrOp::Div: emit(BcOp::Div, reg(id), reg(inst.a), reg(inst.b)); break;
+            case IrOp::Mod: emit(BcOp::Mod, reg(id), reg(inst.a), reg(inst.b)); break;
+            case IrOp::Pow: emit(BcOp::Pow, reg(id), reg(inst.a), reg(inst.b)); break;
+            case IrOp::Neg: emit(BcOp::Neg, reg(id), reg(inst.a)); break;
+            case IrOp::Not: emit(BcOp::Not, reg(id), reg(inst.a)); break;
+            case IrOp::Eq: emit(BcOp::Eq, reg(id), reg(inst.a), reg(inst.b)); break;
+            case IrOp::Ne: emit(BcOp::Ne, reg(id), reg(inst.a), reg(inst.b)); break;
+            case IrOp::Lt: emit(BcOp::Lt, reg(id), reg(inst.a), reg(inst.b)); break;
+            case IrOp::Le: emit(BcOp::Le, reg(id), reg(inst.a), reg(inst.b)); break;
+            case IrOp::Gt: emit(BcOp::Gt, reg(id), reg(inst.a), reg(inst.b)); break;
+            case IrOp::Ge: emit(BcOp::Ge, reg(id), reg(inst.a), reg(inst.b)); break;
+            case IrOp::StrEq: emit(BcOp::StrEq, reg(id), reg(inst.a), reg(inst.b)); break;
+            case IrOp::StrNe: emit(BcOp::StrNe, reg(id), reg(inst.a), reg(inst.b)); break;
+            case IrOp::Concat: emit(BcOp::Concat, reg(id), reg(inst.a), reg(inst.b)); break;
+            case IrOp::ToStr:
+                emit(BcOp::ToStr, reg(id), reg(inst.a), 0, static_cast<uint8_t>(inst.imm));
+                break;
+            case IrOp::LoadGlobal:
+                emitK(BcOp::LoadGlobal, reg(id), static_cast<uint32_t>(inst.imm));
+                break;
+            case IrOp::StoreGlobal:
+                emitK(BcOp::StoreGlobal, reg(inst.a), static_cast<uint32_t>(inst.imm));
+                break;
+            case IrOp::NewArray:
+                emit(BcOp::NewArray, reg(id), reg(inst.a), 0, static_cast<uint8_t>(inst.imm));
+                break;
+            case IrOp::ArrayLen: emit(BcOp::ArrayLen, reg(id), reg(inst.a)); break;
+            case IrOp::BoundsCheck: emit(BcOp::BoundsCheck, reg(inst.a), reg(inst.b)); break;
+            case IrOp::Load: emit(BcOp::Load, reg(id), reg(inst.a), reg(inst.b)); break;
+            case IrOp::Store: emit(BcOp::Store, reg(inst.a), reg(inst.b), reg(inst.c)); break;
+            case IrOp::Call: {
+                // Los argumentos se copian justo después del marco: ahí empieza el del llamado
+                for (uint32_t i = 0; i < inst.b; ++i) {
+                    uint32_t arg = fn->operands[inst.a + i];
+                    if (arg != kNoValue) emit(BcOp::Mov, out->frameSize + i, reg(arg));
+                }
+                out->stackNeed = std::max(out->stackNeed, out->frameSize + inst.b);
+                bool hasResult = inst.type != IrType::Void;
+                emitK(BcOp::Call, hasResult ? reg(id) : 0, static_cast<uint32_t>(inst.imm), hasResult);
+                break;
+            }
+            case IrOp::Print:
+                emit(BcOp::Print, reg(inst.a), 0, 0, static_cast<uint8_t>(inst.imm));
+                break;
+            case IrOp::PrintLn: emit(BcOp::PrintLn); break;
+            case IrOp::Jump:
+                emitPhiCopies(block, inst.a);
+                if (inst.a != block + 1) emitJump(BcOp::Jmp, 0, inst.a);
+                break;
+            case IrOp::Branch: {
+                // Una arista hacia un bloque con phis necesita sus propias copias:
+                // la rama falsa salta a un tramo auxiliar emitido después.
+                bool trueCopies = hasPhis(inst.b);
+                bool falseCopies = hasPhis(inst.c);
+                if (!trueCopies && !falseCopies && inst.c == block + 1) {
+                    emitJump(BcOp::JmpIfTrue, reg(inst.a), inst.b);
+                    break;
+                }
+                size_t branchAt = out->code.size();
+                if (falseCopies) emitK(BcOp::JmpIfFalse, reg(inst.a), 0);
+                else emitJump(BcOp::JmpIfFalse, reg(inst.a), inst.c);
+                emitPhiCopies(block, inst.b);
+                if (inst.b != block + 1 || falseCopies) emitJump(BcOp::Jmp, 0, inst.b);
+                if (falseCopies) {
+                    out->code[branchAt].setK(static_cast<uint32_t>(out->code.size()));
+                    emitPhiCopies(block, inst.c);
+                    if (inst.c != block + 1) emitJump(BcOp::Jmp, 0, inst.c);
+                }
+                break;
+            }
+            case IrOp::Return:
+                if (inst.a == kNoValue) emit(BcOp::RetVoid);
+                else emit(BcOp::Ret, reg(inst.a));
+                break;
+        }
+    }
+
+    void compileFunction(const IrFunction &irFn, BcFunction &bcFn) {
+        fn = &irFn;
+        out = &bcFn;
+        bcFn.name = irFn.name;
+        bcFn.numParams = static_cast<uint32_t>(irFn.paramTypes.size());
+        bcFn.returnsValue = irFn.returnType != IrType::Void;
+        regs = allocateRegisters(irFn);
+        scratch = regs.numRegs;
+        bcFn.frameSize = regs.numRegs + 1;
+        bcFn.stackNeed = bcFn.frameSize;
+        if (bcFn.frameSize + 256 > 0xFFFF) {
+            reportError("function '" + irFn.name + "' needs too many registers");
+            return;
+        }
+
+        blockStart.assign(irFn.blocks.size(), 0);
+        fixups.clear();
+        constantIndex.clear();
+        for (uint32_t b = 0; b < irFn.blocks.size(); ++b) {
+            blockStart[b] = static_cast<uint32_t>(bcFn.code.size());
+            currentBlock = b;
+            for (uint32_t i = irFn.blocks[b].begin; i < irFn.blocks[b].end; ++i) compileInst(b, i);
+        }
+        for (const auto &fixup : fixups) bcFn.code[fixup.first].setK(blockStart[fixup.second]);
+        bcFn.valueRegs = regs.reg;
+        bcFn.blockStart = blockStart;
+    }
+
+public:
+    explicit BytecodeCompiler(const IrModule &module) : module(module) {}
+
+    bool compile(BcModule &result) {
+        result.functions.assign(module.functions.size(), BcFunction{});
+        result.strings = module.strings;
+        result.globals.clear();
+        for (const auto &global : module.globals) result.globals.push_back(global.type);
+        result.initFunction = module.initFunction;
+        result.mainFunction = module.mainFunction;
+        for (size_t i = 0; i < module.functions.size(); ++i) {
+            compileFunction(module.functions[i], result.functions[i]);
+        }
+        return errorCount == 0;
+    }
+
+    unsigned int getErrorCount() const {
+        return errorCount;
+    }
+};
+
+// Listado legible del bytecode
+inline void printBytecode(const BcModule &module, std::ostream &out) {
+    for (const auto &fn : module.functions) {
+        out << "function " << fn.name << " (params " << fn.numParams << ", frame " << fn.frameSize << ")\n";
+        for (size_t i = 0; i < fn.code.size(); ++i) {
+            const BcInst &inst = fn.code[i];
+            out << "  " << i << ": " << bcOpName(inst.op);
+            switch (inst.op) {
+                case BcOp::LoadK: out << " r" << inst.a << ", " << fn.constants[inst.k()]; break;
+                case BcOp::LoadStr: out << " r" << inst.a << ", \"" << module.strings[inst.k()] << "\""; break;
+                case BcOp::LoadGlobal:
+                case BcOp::StoreGlobal: out << " r" << inst.a << ", @" << inst.k(); break;
+                case BcOp::Call:
+                case BcOp::CallRet:
+                case BcOp::CallRetVoid: out << " r" << inst.a << ", " << module.functions[inst.k()].name; break;
+                case BcOp::GlobalAdd:
+                case BcOp::GlobalSub: out << " r" << inst.a << ", @" << inst.k(); break;
+                case BcOp::Jmp:
+                case BcOp::Loop: out << " " << inst.k(); break;
+                case BcOp::JmpIfTrue:
+                case BcOp::JmpIfFalse: out << " r" << inst.a << ", " << inst.k(); break;
+                case BcOp::Ret:
+                case BcOp::Print: out << " r" << inst.a; break;
+                case BcOp::RetVoid:
+                case BcOp::PrintLn: break;
+                case BcOp::Mov:
+                case BcOp::MovMov:
+                case BcOp::MovLoop:
+                case BcOp::Neg:
+                case BcOp::Not:
+                case BcOp::ToStr:
+                case BcOp::NewArray:
+                case BcOp::ArrayLen:
+                case BcOp::BoundsCheck: out << " r" << inst.a << ", r" << inst.b; break;
+                default: out << " r" << inst.a << ", r" << inst.b << ", r" << inst.c; break;
+            }
+            out << "\n";
+        }
+    }
+}
+
+// Segundo nivel de ejecución: compila a código nativo las funciones y los bucles
+// calientes (jit.h). La VM lo consulta al agotarse los contadores de cada función.
+class VmTierUp {
+public:
+    virtual ~VmTierUp() {}
+
+    // Entrada nativa de la función, o nullptr si la VM no puede llamarla directamente
+    virtual const void *compileFunction(uint32_t function) = 0;
+    // Entrada nativa en la cabecera del bucle que empieza en la instrucción pc, o nullptr
+    virtual const void *compileLoop(uint32_t function, uint32_t pc) = 0;
+    // Ejecutan código nativo; stackTop es la primera ranura libre de la pila de la VM
+    virtual int64_t callFunction(const void *entry, const int64_t *args, uint32_t count, int64_t *stackTop) = 0;
+    virtual int64_t enterLoop(const void *entry, int64_t *base, int64_t *stackTop) = 0;
+};
+
+// Máquina virtual: pila de registros contigua (los marcos se solapan en los
+// argumentos) y una pila de marcos de llamada aparte. Cadenas y arreglos viven
+// en una arena que se libera al destruir la VM, o en una que se le presta.
+class VirtualMachine {
+    // Instrucción preparada: dirección del manejador (despacho directo) y operandos
+    struct VmInst {
+        const void *handler;
+        BcInst bc;
+    };
+
+    struct VmFunction {
+        std::vector<VmInst> code;
+        const int64_t *constants;
+        uint32_t index;
+        uint32_t numParams;
+        uint32_t frameSize;
+        uint32_t stackNeed;
+        bool returnsValue;
+        // Niveles de ejecución: llamadas y vueltas de bucle restantes antes de
+        // compilar (0 = sin JIT) y entrada nativa una vez compilada
+        mutable uint32_t callBudget;
+        mutable uint32_t loopBudget;
+        mutable const void *native;
+    };
+
+    struct Frame {
+        const VmInst *returnIp;
+        int64_t *base;
+        const VmFunction *function;
+        uint16_t dest;
+    };
+
+    const BcModule &module;
+    OutputBuffer &out;
+    Arena ownArena;
+    Arena &arena;
+    std::vector<VmFunction> functions;
+    std::vector<const BmString *> strings;
+    std::vector<int64_t> globals;
+    std::unique_ptr<int64_t[]> stack;  // sin inicializar: las páginas se tocan al usarlas
+    int64_t *stackEnd = nullptr;
+    std::vector<Frame> frames;
+    const BmString *emptyString;
+    // Cadenas cortas compartidas: ToStr de booleanos, caracteres y enteros chicos
+    // no reserva memoria nueva en cada ejecución
+    static const int kSmallInts = 256;
+    const BmString *boolStrings[2];
+    const BmString *charStrings[256] = {};
+    const BmString *smallIntStrings[kSmallInts] = {};
+    VmTierUp *tierUp = nullptr;
+    BcProfile *profile = nullptr;
+
+    static const size_t kStackSlots = 1 << 22;
+
+    static int64_t fromPointer(const void *p) { return static_cast<int64_t>(reinterpret_cast<intptr_t>(p)); }
+    static const BmString *asString(int64_t v) { return reinterpret_cast<const BmString *>(static_cast<intptr_t>(v)); }
+    static BmArray *asArray(int64_t v) { return reinterpret_cast<BmArray *>(static_cast<intptr_t>(v)); }
+
+    // Bucle de ejecución desde base (argumentos ya copiados); devuelve el valor de retorno.
+    // Con table != nullptr sólo devuelve la tabla de manejadores. La versión con
+    // kProfile cuenta cada operación en profile; la normal no paga nada por ello.
+    template <bool kProfile>
+    int64_t execute(int function, int64_t *base, const void *const **table) {
+#ifdef BM_VM_THREADED
+        static const void *const handlers[] = {
+#define BM_BYTECODE_LABEL(name) &&op_##name,
+            BM_BYTECODE_OPS(BM_BYTECODE_LABEL)
+#undef BM_BYTECODE_LABEL
+        };
+        if (table) {
+            *table = handlers;
+            return 0;
+        }
+#define VM_CASE(name) op_##name:
+#define VM_DISPATCH() do { if (kProfile) profile->record(ip->bc.op); goto *ip->handler; } while (0)
+#else
+        if (table) return 0;
+#define VM_CASE(name) case BcOp::name:
+#define VM_DISPATCH() goto dispatch
+#endif
+#define VM_NEXT() do { ++ip; VM_DISPATCH(); } while (0)
+#define R(x) base[ip->bc.x]
+
+        const VmFunction *current = &functions[function];
+        const size_t entryDepth = frames.size();
+        if (base + current->stackNeed > stackEnd) throw RuntimeError("stack overflow");
+        const VmInst *code = current->code.data();
+        const VmInst *ip = code;
+        int64_t result = 0;
+
+#ifdef BM_VM_THREADED
+        VM_DISPATCH();
+#else
+    dispatch:
+        if (kProfile) profile->record(ip->bc.op);
+        switch (ip->bc.op) {
+#endif
+        VM_CASE(Mov) R(a) = R(b); VM_NEXT();
+        VM_CASE(LoadK) R(a) = current->constants[ip->bc.k()]; VM_NEXT();
+        VM_CASE(LoadStr) R(a) = fromPointer(strings[ip->bc.k()]); VM_NEXT();
+        VM_CASE(Add) R(a) = wrapAdd(R(b), R(c)); VM_NEXT();
+        VM_CASE(Sub) R(a) = wrapSub(R(b), R(c)); VM_NEXT();
+        VM_CASE(Mul) R(a) = wrapMul(R(b), R(c)); VM_NEXT();
+        VM_CASE(Div) R(a) = checkedDiv(R(b), R(c)); VM_NEXT();
+        VM_CASE(Mod) R(a) = checkedMod(R(b), R(c)); VM_NEXT();
+        VM_CASE(Pow) R(a) = wrapPow(R(b), R(c)); VM_NEXT();
+        VM_CASE(Neg) R(a) = wrapSub(0, R(b)); VM_NEXT();
+        VM_CASE(Not) R(a) = !R(b); VM_NEXT();
+        VM_CASE(Eq) R(a) = R(b) == R(c); VM_NEXT();
+        VM_CASE(Ne) R(a) = R(b) != R(c); VM_NEXT();
+        VM_CASE(Lt) R(a) = R(b) < R(c); VM_NEXT();
+        VM_CASE(Le) R(a) = R(b) <= R(c); VM_NEXT();
+        VM_CASE(Gt) R(a) = R(b) > R(c); VM_NEXT();
+        VM_CASE(Ge) R(a) = R(b) >= R(c); VM_NEXT();
+        VM_CASE(StrEq) R(a) = stringsEqual(asString(R(b)), asString(R(c))); VM_NEXT();
+        VM_CASE(StrNe) R(a) = !stringsEqual(asString(R(b)), asString(R(c))); VM_NEXT();
+        VM_CASE(Concat) R(a) = fromPointer(concatStrings(arena, asString(R(b)), asString(R(c)))); VM_NEXT();
+        VM_CASE(ToStr) R(a) = fromPointer(toString(R(b), static_cast<IrType>(ip->bc.aux))); VM_NEXT();
+        VM_CASE(LoadGlobal) R(a) = globals[ip->bc.k()]; VM_NEXT();
+        VM_CASE(StoreGlobal) globals[ip->bc.k()] = R(a); VM_NEXT();
+        VM_CASE(NewArray) R(a) = fromPointer(newArray(R(b), static_cast<IrType>(ip->bc.aux))); VM_NEXT();
+        VM_CASE(ArrayLen) R(a) = asArray(R(b))->length; VM_NEXT();
+        VM_CASE(BoundsCheck)
+            if (static_cast<uint64_t>(R(a)) >= static_cast<uint64_t>(R(b))) {
+                throw RuntimeError("array index " + std::to_string(R(a)) + " out of bounds");
+            }
+            VM_NEXT();
+        VM_CASE(Load) R(a) = asArray(R(b))->data[R(c)]; VM_NEXT();
+        VM_CASE(Store) asArray(R(a))->data[R(b)] = R(c); VM_NEXT();
+        VM_CASE(CallRet)
+        VM_CASE(CallRetVoid)
+        VM_CASE(Call) {
+            const VmFunction *callee = &functions[ip->bc.k()];
+            int64_t *calleeBase = base + current->frameSize;
+            if (callee->callBudget && --callee->callBudget == 0) {
+                callee->native = tierUp->compileFunction(callee->index);
+            }
+            if (callee->native) {
+                int64_t value = tierUp->callFunction(callee->native, calleeBase, callee->numParams, calleeBase);
+                if (ip->bc.op == BcOp::Call) {
+                    if (ip->bc.aux) R(a) = value;
+                    VM_NEXT();
+                }
+                result = value;
+                if (ip->bc.op == BcOp::CallRet) goto return_value;
+                goto return_void;
+            }
+            if (calleeBase + callee->stackNeed > stackEnd) throw RuntimeError("stack overflow");
+            // Con CallRet no hay marco propio: el retorno del llamado es el de esta función
+            if (ip->bc.op == BcOp::Call) frames.push_back({ip + 1, base, current, ip->bc.a});
+            base = calleeBase;
+            current = callee;
+            code = callee->code.data();
+            ip = code;
+            VM_DISPATCH();
+        }
+        VM_CASE(Print) print(R(a), static_cast<IrType>(ip->bc.aux)); VM_NEXT();
+        VM_CASE(PrintLn) out.newline(); VM_NEXT();
+        VM_CASE(Jmp) ip = code + ip->bc.k(); VM_DISPATCH();
+        VM_CASE(Loop)
+        loop_back:
+            ip = code + ip->bc.k();
+            if (current->loopBudget && --current->loopBudget == 0) {
+                // Bucle caliente: el resto de esta llamada sigue en código nativo
+                const void *entry = tierUp->compileLoop(current->index, static_cast<uint32_t>(ip - code));
+                if (entry) {
+                    result = tierUp->enterLoop(entry, base, base + current->stackNeed);
+                    if (current->returnsValue) goto return_value;
+                    goto return_void;
+                }
+            }
+            VM_DISPATCH();
+        VM_CASE(JmpIfTrue)
+            if (R(a)) ip = code + ip->bc.k(); else ++ip;
+            VM_DISPATCH();
+        VM_CASE(JmpIfFalse)
+            if (!R(a)) ip = code + ip->bc.k(); else ++ip;
+            VM_DISPATCH();
+#define VM_COMPARE_JUMP(name, op) \
+        VM_CASE(name##JmpIfTrue) \
+            R(a) = R(b) op R(c); \
+            ip = base[ip[1].bc.a] ? code + ip[1].bc.k() : ip + 2; \
+            VM_DISPATCH(); \
+        VM_CASE(name##JmpIfFalse) \
+            R(a) = R(b) op R(c); \
+            ip = base[ip[1].bc.a] ? ip + 2 : code + ip[1].bc.k(); \
+            VM_DISPATCH();
+        VM_COMPARE_JUMP(Lt, <)
+        VM_COMPARE_JUMP(Le, <=)
+        VM_COMPARE_JUMP(Gt, >)
+        VM_COMPARE_JUMP(Ge, >=)
+        VM_COMPARE_JUMP(Eq, ==)
+        VM_COMPARE_JUMP(Ne, !=)
+#undef VM_COMPARE_JUMP
+        VM_CASE(AddMov)
+            R(a) = wrapAdd(R(b), R(c));
+            base[ip[1].bc.a] = base[ip[1].bc.b];
+            ip += 2;
+            VM_DISPATCH();
+        VM_CASE(MovMov)
+            R(a) = R(b);
+            base[ip[1].bc.a] = base[ip[1].bc.b];
+            ip += 2;
+            VM_DISPATCH();
+        VM_CASE(MovLoop)
+            R(a) = R(b);
+            ++ip;
+            goto loop_back;
+        VM_CASE(GlobalAdd)
+        VM_CASE(GlobalSub) {
+            const BcInst &update = ip[1].bc;
+            R(a) = globals[ip->bc.k()];
+            base[update.a] = ip->bc.op == BcOp::GlobalAdd ? wrapAdd(base[update.b], base[update.c])
+                                                          : wrapSub(base[update.b], base[update.c]);
+            globals[ip[2].bc.k()] = base[ip[2].bc.a];
+            ip += 3;
+            VM_DISPATCH();
+        }
+        VM_CASE(Ret)
+            result = R(a);
+        return_value: {
+            if (frames.size() == entryDepth) return result;
+            Frame frame = frames.back();
+            frames.pop_back();
+            frame.base[frame.dest] = result;
+            base = frame.base;
+            current = frame.function;
+            code = current->code.data();
+            ip = frame.returnIp;
+            VM_DISPATCH();
+        }
+        VM_CASE(RetVoid)
+        return_void: {
+            if (frames.size() == entryDepth) return 0;
+            Frame frame = frames.back();
+            frames.pop_back();
+            base = frame.base;
+            current = frame.function;
+            code = current->code.data();
+            ip = frame.returnIp;
+            VM_DISPATCH();
+        }
+#ifndef BM_VM_THREADED
+        }
+        return result;
+#endif
+#undef R
+#undef VM_NEXT
+#undef VM_DISPATCH
+#undef VM_CASE
+    }
+
+    int64_t execute(int function, int64_t *base) {
+        return profile ? execute<true>(function, base, nullptr) : execute<false>(function, base, nullptr);
+    }
+
+public:
+    // Sin arena propia usa la dada, que debe seguir viva mientras exista la VM
+    VirtualMachine(const BcModule &module, OutputBuffer &out, Arena *sharedArena = nullptr)
+        : module(module), out(out), arena(sharedArena ? *sharedArena : ownArena) {
+        const void *const *handlers = nullptr;
+        execute<false>(0, nullptr, &handlers);
+        emptyString = newString(arena, "", 0);
+        boolStrings[0] = newString(arena, "false", 5);
+        boolStrings[1] = newString(arena, "true", 4);
+        for (const auto &text : module.strings) strings.push_back(newString(arena, text.data(), text.size()));
+        for (const auto &fn : module.functions) {
+            VmFunction prepared;
+            prepared.constants = fn.constants.data();
+            prepared.index = static_cast<uint32_t>(functions.size());
+            prepared.numParams = fn.numParams;
+            prepared.frameSize = fn.frameSize;
+            prepared.stackNeed = fn.stackNeed;
+            prepared.returnsValue = fn.returnsValue;
+            prepared.callBudget = 0;
+            prepared.loopBudget = 0;
+            prepared.native = nullptr;
+            for (const BcInst &inst : fn.code) {
+                prepared.code.push_back({handlers ? handlers[static_cast<int>(inst.op)] : nullptr, inst});
+            }
+            functions.push_back(std::move(prepared));
+        }
+        for (IrType type : module.globals) globals.push_back(type == IrType::Str ? fromPointer(emptyString) : 0);
+        stack.reset(new int64_t[kStackSlots]);
+        stackEnd = stack.get() + kStackSlots;
+    }
+
+    // Activa el JIT: una función se compila tras callThreshold llamadas y un bucle
+    // tras loopThreshold vueltas dentro de una misma función
+    void setTierUp(VmTierUp *compiler, uint32_t callThreshold, uint32_t loopThreshold) {
+        tierUp = compiler;
+        for (auto &fn : functions) {
+            fn.callBudget = compiler ? std::max<uint32_t>(callThreshold, 1) : 0;
+            fn.loopBudget = compiler ? std::max<uint32_t>(loopThreshold, 1) : 0;
+            fn.native = nullptr;
+        }
+    }
+
+    // Cuenta las operaciones ejecutadas en profile (nullptr lo desactiva); sin JIT,
+    // que ejecutaría parte del programa fuera de la VM
+    void setProfile(BcProfile *target) {
+        const void *const *handlers = nullptr;
+        if (target) execute<true>(0, nullptr, &handlers);
+        else execute<false>(0, nullptr, &handlers);
+        profile = target;
+        for (auto &fn : functions) {
+            for (auto &inst : fn.code) inst.handler = handlers ? handlers[static_cast<int>(inst.bc.op)] : nullptr;
+        }
+        if (target) setTierUp(nullptr, 0, 0);
+    }
+
+    // Ejecuta los inicializadores de las globales y luego main.
+    // Devuelve false si hubo un error de ejecución.
+    bool run() {
+        frames.clear();
+        frames.reserve(1024);
+        try {
+            if (module.initFunction >= 0) execute(module.initFunction, stack.get());
+            if (module.mainFunction >= 0) execute(module.mainFunction, stack.get());
+        } catch (const RuntimeError &error) {
+            out.flush();
+            compilerErr() << "Runtime Error: " << error.what() << std::endl;
+            return false;
+        }
+        out.flush();
+        return true;
+    }
+
+    size_t arenaBytes() const {
+        return arena.bytesAllocated();
+    }
+
+    // Servicios para el código nativo (jit.h). Los errores se informan con RuntimeError.
+
+    // Llamada desde código nativo a una función que sigue interpretada; base es
+    // la primera ranura libre de la pila de la VM
+    int64_t callInterpreted(uint32_t function, const int64_t *args, int64_t *base) {
+        const VmFunction &fn = functions[function];
+        if (fn.callBudget && --fn.callBudget == 0) fn.native = tierUp->compileFunction(function);
+        if (base + fn.stackNeed > stackEnd) throw RuntimeError("stack overflow");
+        for (uint32_t i = 0; i < fn.numParams; ++i) base[i] = args[i];
+        return execute(static_cast<int>(function), base);
+    }
+
+    const BmString *toString(int64_t value, IrType type) {
+        char buffer[24];
+        switch (type) {
+            case IrType::Str: return asString(value);
+            case IrType::Bool: return boolStrings[value != 0];
+            case IrType::Char: {
+                const BmString *&cached = charStrings[static_cast<unsigned char>(value)];
+                if (!cached) {
+                    buffer[0] = static_cast<char>(value);
+                    cached = newString(arena, buffer, 1);
+                }
+                return cached;
+            }
+            default: {
+                bool small = static_cast<uint64_t>(value) < kSmallInts;
+                if (small && smallIntStrings[value]) return smallIntStrings[value];
+                char *begin = formatInt(value, buffer + sizeof(buffer));
+                const BmString *result = newString(arena, begin, buffer + sizeof(buffer) - begin);
+                if (small) smallIntStrings[value] = result;
+                return result;
+            }
+        }
+    }
+
+    const BmString *concat(const BmString *a, const BmString *b) {
+        return concatStrings(arena, a, b);
+    }
+
+    void print(int64_t value, IrType type) {
+        switch (type) {
+            case IrType::Str: out.write(asString(value)->data, asString(value)->length); break;
+            case IrType::Bool: value ? out.write("true", 4) : out.write("false", 5); break;
+            case IrType::Char: out.put(static_cast<char>(value)); break;
+            case IrType::Array: out.write("<array>", 7); break;
+            default: out.writeInt(value); break;
+        }
+    }
+
+    void printLine() {
+        out.newline();
+    }
+
+    BmArray *newArray(int64_t length, IrType element) {
+        if (length < 0) throw RuntimeError("negative array size");
+        auto *array = static_cast<BmArray *>(arena.allocate(sizeof(BmArray) + sizeof(int64_t) * static_cast<size_t>(length)));
+        array->length = length;
+        int64_t fill = element == IrType::Str ? fromPointer(emptyString) : 0;
+        for (int64_t i = 0; i < length; ++i) array->data[i] = fill;
+        return array;
+    }
+
+    const BmString *stringConstant(uint32_t index) const {
+        return strings[index];
+    }
+
+    int64_t *globalData() {
+        return globals.data();
+    }
+};
+
+#endif // VM_H_
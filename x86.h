@@ -0,0 +1,1011 @@
+#ifndef X86_H_
+#define X86_H_
+
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "ir.h"
+#include "regalloc.h"
+
+// Generación de código x86-64 (ABI System V) a partir de la IR.
+//
+// X86FunctionCompiler selecciona instrucciones y asigna registros una sola vez;
+// el ensamblador que recibe como parámetro decide la salida: texto AT&T para
+// ensamblar con las herramientas de GNU (X86TextAssembler, aquí) o bytes de
+// máquina para el JIT (X86Encoder, en jit.h).
+//
+// Cada función usa un marco con %rbp; los valores SSA viven en los registros que
+// asigna el barrido lineal (regalloc.h) o en ranuras del marco si no alcanzan.
+// %rax, %rcx y %rdx quedan como temporales. Las operaciones sobre cadenas, la
+// impresión y los errores de ejecución llaman a funciones del runtime. Los bucles
+// que marca LoopVectorizer ejecutan antes del bucle escalar vueltas con SSE2 o
+// AVX2 en los registros %xmm/%ymm, que nada más usa.
+
+// Registros con su número de codificación
+enum X86Reg { RAX, RCX, RDX, RBX, RSP, RBP, RSI, RDI, R8, R9, R10, R11, R12, R13, R14, R15 };
+
+inline const char *x86RegName(int reg) {
+    static const char *const names[] = {"%rax", "%rcx", "%rdx", "%rbx", "%rsp", "%rbp", "%rsi", "%rdi",
+                                        "%r8", "%r9", "%r10", "%r11", "%r12", "%r13", "%r14", "%r15"};
+    return names[reg];
+}
+
+// Condiciones con su código de instrucción (jcc/setcc); la inversa difiere en el bit 0
+enum class X86Cond : uint8_t { B = 2, AE = 3, E = 4, NE = 5, L = 12, GE = 13, LE = 14, G = 15 };
+
+inline X86Cond invertCondition(X86Cond cond) {
+    return static_cast<X86Cond>(static_cast<uint8_t>(cond) ^ 1);
+}
+
+inline const char *x86CondName(X86Cond cond) {
+    switch (cond) {
+        case X86Cond::B: return "b";
+        case X86Cond::AE: return "ae";
+        case X86Cond::E: return "e";
+        case X86Cond::NE: return "ne";
+        case X86Cond::L: return "l";
+        case X86Cond::GE: return "ge";
+        case X86Cond::LE: return "le";
+        default: return "g";
+    }
+}
+
+enum class X86Alu : uint8_t { Add, Sub, Cmp, Xor };
+
+// Operaciones SIMD sobre carriles de 64 bits (MulLow multiplica las mitades bajas
+// de 32 bits de cada carril, como pmuludq)
+enum class X86VecOp : uint8_t { Add, Sub, MulLow, Xor, ShiftLeft, ShiftRight };
+
+// Operando: registro, memoria [base + índice*8 + desplazamiento] o inmediato
+struct X86Operand {
+    enum Kind : uint8_t { Reg, Mem, Imm };
+    Kind kind = Reg;
+    int8_t reg = RAX;    // registro, o base de Mem
+    int8_t index = -1;   // registro índice de Mem (escala 8) o -1
+    int64_t value = 0;   // desplazamiento de Mem o valor de Imm
+
+    static X86Operand r(int reg) {
+        X86Operand op;
+        op.reg = static_cast<int8_t>(reg);
+        return op;
+    }
+    static X86Operand mem(int base, int32_t disp) {
+        X86Operand op;
+        op.kind = Mem;
+        op.reg = static_cast<int8_t>(base);
+        op.value = disp;
+        return op;
+    }
+    static X86Operand element(int base, int index) {
+        X86Operand op = mem(base, 8);
+        op.index = static_cast<int8_t>(index);
+        return op;
+    }
+    static X86Operand imm(int64_t value) {
+        X86Operand op;
+        op.kind = Imm;
+        op.value = value;
+        return op;
+    }
+
+    bool isReg() const { return kind == Reg; }
+    bool isMem() const { return kind == Mem; }
+    bool isImm() const { return kind == Imm; }
+    bool fitsImm32() const { return value >= INT32_MIN && value <= INT32_MAX; }
+
+    bool operator==(const X86Operand &other) const {
+        return kind == other.kind && reg == other.reg && index == other.index && value == other.value;
+    }
+    bool operator!=(const X86Operand &other) const { return !(*this == other); }
+};
+
+// Funciones del runtime que llama el código generado
+enum class X86Helper : uint8_t {
+    Pow, StrEq, Concat, IntToStr, BoolToStr, CharToStr, NewArray,
+    PrintInt, PrintBool, PrintChar, PrintStr, PrintLn,
+    BoundsError, DivZero, StackOverflow, EnterInterpreter,
+    Count
+};
+
+inline const char *x86HelperName(X86Helper helper) {
+    static const char *const names[] = {
+        "bm_pow", "bm_str_eq", "bm_concat", "bm_int_to_str", "bm_bool_to_str", "bm_char_to_str", "bm_new_array",
+        "bm_print_int", "bm_print_bool", "bm_print_char", "bm_print_str", "bm_println",
+        "bm_bounds_error", "bm_div_zero", "bm_stack_overflow", "bm_enter_interpreter",
+    };
+    return names[static_cast<int>(helper)];
+}
+
+// Ensamblador de texto (sintaxis AT&T) para as/cc
+class X86TextAssembler {
+    std::ostream &out;
+    uint32_t function = 0;
+
+    static std::string vec(int reg, bool wide) {
+        return (wide ? "%ymm" : "%xmm") + std::to_string(reg);
+    }
+
+    static std::string text(const X86Operand &op) {
+        switch (op.kind) {
+            case X86Operand::Reg: return x86RegName(op.reg);
+            case X86Operand::Imm: return "$" + std::to_string(op.value);
+            default: break;
+        }
+        std::string result = op.value ? std::to_string(op.value) : "";
+        result += "(";
+        result += x86RegName(op.reg);
+        if (op.index >= 0) {
+            result += ",";
+            result += x86RegName(op.index);
+            result += ",8";
+        }
+        return result + ")";
+    }
+
+    std::string labelName(uint32_t label) const {
+        return ".L" + std::to_string(function) + "_" + std::to_string(label);
+    }
+
+    void emit(const std::string &instruction) {
+        out << "\t" << instruction << "\n";
+    }
+
+public:
+    explicit X86TextAssembler(std::ostream &out) : out(out) {}
+
+    void beginFunction(uint32_t index) {
+        function = index;
+    }
+
+    void bind(uint32_t label) {
+        out << labelName(label) << ":\n";
+    }
+
+    void mov(const X86Operand &dst, const X86Operand &src) {
+        if (src.isImm() && !src.fitsImm32()) emit("movabsq " + text(src) + ", " + text(dst));
+        else emit("movq " + text(src) + ", " + text(dst));
+    }
+
+    void alu(X86Alu op, const X86Operand &dst, const X86Operand &src) {
+        static const char *const names[] = {"addq", "subq", "cmpq", "xorq"};
+        emit(std::string(names[static_cast<int>(op)]) + " " + text(src) + ", " + text(dst));
+    }
+
+    void imul(int dst, const X86Operand &src) { emit("imulq " + text(src) + ", " + x86RegName(dst)); }
+    void neg(int reg) { emit(std::string("negq ") + x86RegName(reg)); }
+    void cqo() { emit("cqto"); }
+    void idiv(int reg) { emit(std::string("idivq ") + x86RegName(reg)); }
+    void test(int a, int b) { emit(std::string("testq ") + x86RegName(b) + ", " + x86RegName(a)); }
+
+    // %rax = condición ? 1 : 0
+    void setcc(X86Cond cond) {
+        emit(std::string("set") + x86CondName(cond) + " %al");
+        emit("movzbl %al, %eax");
+    }
+
+    void lea(int dst, const X86Operand &mem) { emit("leaq " + text(mem) + ", " + x86RegName(dst)); }
+    void push(const X86Operand &op) { emit("pushq " + text(op)); }
+    void pop(int reg) { emit(std::string("popq ") + x86RegName(reg)); }
+    void jmp(uint32_t label) { emit("jmp " + labelName(label)); }
+    void jcc(X86Cond cond, uint32_t label) { emit(std::string("j") + x86CondName(cond) + " " + labelName(label)); }
+    void ret() { emit("ret"); }
+
+    void callHelper(X86Helper helper) { emit(std::string("call ") + x86HelperName(helper)); }
+    void callFunction(uint32_t index) { emit("call bm_fn_" + std::to_string(index)); }
+
+    void loadGlobal(int reg, uint32_t index) { emit("movq bm_g" + std::to_string(index) + "(%rip), " + x86RegName(reg)); }
+    // Puede usar %rcx como temporal
+    void storeGlobal(uint32_t index, int reg) { emit(std::string("movq ") + x86RegName(reg) + ", bm_g" + std::to_string(index) + "(%rip)"); }
+    void loadString(int reg, uint32_t index) { emit("leaq .Lstr" + std::to_string(index) + "(%rip), " + x86RegName(reg)); }
+
+    // SIMD: SSE2 con registros %xmm (dos carriles; dst debe coincidir con a) o
+    // AVX2 con registros %ymm (wide, cuatro carriles y tres operandos)
+    void vecLoad(int dst, const X86Operand &mem, bool wide) {
+        emit(std::string(wide ? "vmovdqu " : "movdqu ") + text(mem) + ", " + vec(dst, wide));
+    }
+
+    void vecStore(const X86Operand &mem, int src, bool wide) {
+        emit(std::string(wide ? "vmovdqu " : "movdqu ") + vec(src, wide) + ", " + text(mem));
+    }
+
+    void vecMove(int dst, int src, bool wide) {
+        emit(std::string(wide ? "vmovdqa " : "movdqa ") + vec(src, wide) + ", " + vec(dst, wide));
+    }
+
+    void vecAlu(X86VecOp op, int dst, int a, int b, bool wide) {
+        static const char *const names[] = {"paddq", "psubq", "pmuludq", "pxor"};
+        std::string name = names[static_cast<int>(op)];
+        if (wide) emit("v" + name + " " + vec(b, true) + ", " + vec(a, true) + ", " + vec(dst, true));
+        else emit(name + " " + vec(b, false) + ", " + vec(dst, false));
+    }
+
+    void vecShift(X86VecOp op, int dst, int a, uint8_t bits, bool wide) {
+        std::string name = op == X86VecOp::ShiftLeft ? "psllq" : "psrlq";
+        std::string amount = "$" + std::to_string(bits) + ", ";
+        if (wide) emit("v" + name + " " + amount + vec(a, true) + ", " + vec(dst, true));
+        else emit(name + " " + amount + vec(dst, false));
+    }
+
+    // El valor de un registro general en todos los carriles
+    void vecBroadcast(int dst, int reg, bool wide) {
+        if (wide) {
+            emit(std::string("vmovq ") + x86RegName(reg) + ", " + vec(dst, false));
+            emit("vpbroadcastq " + vec(dst, false) + ", " + vec(dst, true));
+        } else {
+            emit(std::string("movq ") + x86RegName(reg) + ", " + vec(dst, false));
+            emit("punpcklqdq " + vec(dst, false) + ", " + vec(dst, false));
+        }
+    }
+
+    // Primer carril a un registro general
+    void vecExtract(int reg, int src, bool wide) {
+        emit(std::string(wide ? "vmovq " : "movq ") + vec(src, false) + ", " + x86RegName(reg));
+    }
+
+    // Suma de todos los carriles de src; modifica src y scratch
+    void vecSum(int reg, int src, int scratch, bool wide) {
+        if (wide) {
+            emit("vextracti128 $1, " + vec(src, true) + ", " + vec(scratch, false));
+            emit("vpaddq " + vec(src, false) + ", " + vec(scratch, false) + ", " + vec(scratch, false));
+            emit("vpshufd $0x4e, " + vec(scratch, false) + ", " + vec(src, false));
+            emit("vpaddq " + vec(src, false) + ", " + vec(scratch, false) + ", " + vec(scratch, false));
+        } else {
+            emit("pshufd $0x4e, " + vec(src, false) + ", " + vec(scratch, false));
+            emit("paddq " + vec(src, false) + ", " + vec(scratch, false));
+        }
+        vecExtract(reg, scratch, wide);
+    }
+
+    void vzeroupper() { emit("vzeroupper"); }
+
+    // Los ejecutables detectan el desborde de pila con una señal: no hace falta código
+    static constexpr bool kChecksStack = false;
+    void stackCheck(uint32_t) {}
+};
+
+// Traducción de una función de la IR con cualquiera de los ensambladores
+template <typename Assembler>
+class X86FunctionCompiler {
+    Assembler &as;
+    const IrFunction *fn = nullptr;
+    RegisterAssignment regs;
+    std::vector<int> savedRegs;
+    std::vector<uint32_t> useCount;
+    size_t frameBytes = 0;
+    uint32_t nextLabel = 0;
+    bool condPending = false;
+    X86Cond pendingCond = X86Cond::NE;  // comparación fusionada con el branch siguiente
+    uint32_t retLabel = 0, boundsLabel = 0, divZeroLabel = 0, overflowLabel = 0;
+    uint32_t vectorLanes = 0;           // 0: sin SIMD, 2: SSE2, 4: AVX2
+
+    static int allocatable(uint32_t index) {
+        static const int regs[] = {RSI, RDI, R8, R9, R10, R11, RBX, R12, R13, R14, R15};
+        return regs[index];
+    }
+
+    static int argumentReg(size_t index) {
+        static const int regs[] = {RDI, RSI, RDX, RCX, R8, R9};
+        return regs[index];
+    }
+
+    X86Operand loc(uint32_t value) const {
+        if (regs.reg[value] != kNoValue) return X86Operand::r(allocatable(regs.reg[value]));
+        return X86Operand::mem(RBP, -8 * static_cast<int32_t>(savedRegs.size() + 1 + regs.spillSlot[value]));
+    }
+
+    uint32_t newLabel() {
+        return nextLabel++;
+    }
+
+    void move(const X86Operand &dst, const X86Operand &src) {
+        if (dst == src) return;
+        if (dst.isMem() && (src.isMem() || (src.isImm() && !src.fitsImm32()))) {
+            as.mov(X86Operand::r(RCX), src);
+            as.mov(dst, X86Operand::r(RCX));
+            return;
+        }
+        as.mov(dst, src);
+    }
+
+    // Movimientos simultáneos en secuencia; los ciclos se rompen con %rax
+    void parallelMove(std::vector<std::pair<X86Operand, X86Operand>> moves) {
+        for (size_t m = 0; m < moves.size();) {
+            if (moves[m].first == moves[m].second) moves.erase(moves.begin() + m);
+            else ++m;
+        }
+        while (!moves.empty()) {
+            bool progress = false;
+            for (size_t m = 0; m < moves.size(); ++m) {
+                bool blocked = false;
+                for (const auto &other : moves) {
+                    if (other.second == moves[m].first) {
+                        blocked = true;
+                        break;
+                    }
+                }
+                if (blocked) continue;
+                move(moves[m].first, moves[m].second);
+                moves.erase(moves.begin() + m);
+                progress = true;
+                break;
+            }
+            if (progress) continue;
+            X86Operand saved = moves[0].first;
+            move(X86Operand::r(RAX), saved);
+            for (auto &m : moves) {
+                if (m.second == saved) m.second = X86Operand::r(RAX);
+            }
+        }
+    }
+
+    // Llamada con la convención System V: seis argumentos en registros y el resto
+    // en la pila, que se mantiene alineada a 16 bytes
+    template <typename CallEmitter>
+    void emitCall(const std::vector<X86Operand> &args, CallEmitter call) {
+        size_t stackArgs = args.size() > 6 ? args.size() - 6 : 0;
+        size_t padding = stackArgs % 2;
+        if (padding) as.alu(X86Alu::Sub, X86Operand::r(RSP), X86Operand::imm(8));
+        for (size_t i = args.size(); i-- > 6;) as.push(args[i]);
+        std::vector<std::pair<X86Operand, X86Operand>> moves;
+        for (size_t i = 0; i < args.size() && i < 6; ++i) moves.push_back({X86Operand::r(argumentReg(i)), args[i]});
+        parallelMove(moves);
+        call();
+        if (stackArgs + padding) as.alu(X86Alu::Add, X86Operand::r(RSP), X86Operand::imm(static_cast<int64_t>(8 * (stackArgs + padding))));
+    }
+
+    void callHelper(X86Helper helper, const std::vector<X86Operand> &args) {
+        emitCall(args, [&] { as.callHelper(helper); });
+    }
+
+    void emitPhiCopies(uint32_t from, uint32_t to) {
+        const IrBlock &block = fn->blocks[to];
+        const uint32_t *preds = fn->predsOf(to);
+        uint32_t k = 0;
+        while (k < block.predCount && preds[k] != from) ++k;
+        std::vector<std::pair<X86Operand, X86Operand>> moves;
+        for (uint32_t i = block.begin; i < block.end && fn->insts[i].op == IrOp::Phi; ++i) {
+            const IrInst &phi = fn->insts[i];
+            if (k >= phi.b || fn->operands[phi.a + k] == kNoValue) continue;
+            moves.push_back({loc(i), loc(fn->operands[phi.a + k])});
+        }
+        parallelMove(moves);
+    }
+
+    bool hasPhis(uint32_t block) const {
+        const IrBlock &b = fn->blocks[block];
+        return b.begin < b.end && fn->insts[b.begin].op == IrOp::Phi;
+    }
+
+    // Operación de dos operandos: dst = a op b
+    void emitBinary(X86Alu op, bool multiply, uint32_t id, const IrInst &inst) {
+        X86Operand dst = loc(id), a = loc(inst.a), b = loc(inst.b);
+        int target = dst.isReg() && dst != b ? static_cast<int>(dst.reg) : static_cast<int>(RAX);
+        move(X86Operand::r(target), a);
+        if (multiply) as.imul(target, b);
+        else as.alu(op, X86Operand::r(target), b);
+        move(dst, X86Operand::r(target));
+    }
+
+    static X86Cond conditionOf(IrOp op) {
+        switch (op) {
+            case IrOp::Eq: return X86Cond::E;
+            case IrOp::Ne: return X86Cond::NE;
+            case IrOp::Lt: return X86Cond::L;
+            case IrOp::Le: return X86Cond::LE;
+            case IrOp::Gt: return X86Cond::G;
+            default: return X86Cond::GE;
+        }
+    }
+
+    // Una comparación cuyo único uso es el branch que la sigue no materializa el booleano
+    bool fusesWithBranch(uint32_t id) const {
+        uint32_t next = id + 1;
+        if (next >= fn->insts.size() || useCount[id] != 1) return false;
+        const IrInst &branch = fn->insts[next];
+        return branch.op == IrOp::Branch && branch.a == id && fn->blockOf(next) == fn->blockOf(id);
+    }
+
+    void emitDivision(uint32_t id, const IrInst &inst) {
+        uint32_t normal = newLabel(), done = newLabel();
+        as.mov(X86Operand::r(RAX), loc(inst.a));
+        as.mov(X86Operand::r(RCX), loc(inst.b));
+        as.test(RCX, RCX);
+        as.jcc(X86Cond::E, divZeroLabel);
+        // x / -1 se calcula aparte: idiv falla con INT64_MIN / -1
+        as.alu(X86Alu::Cmp, X86Operand::r(RCX), X86Operand::imm(-1));
+        as.jcc(X86Cond::NE, normal);
+        if (inst.op == IrOp::Div) as.neg(RAX);
+        else as.mov(X86Operand::r(RAX), X86Operand::imm(0));
+        as.jmp(done);
+        as.bind(normal);
+        as.cqo();
+        as.idiv(RCX);
+        if (inst.op == IrOp::Mod) as.mov(X86Operand::r(RAX), X86Operand::r(RDX));
+        as.bind(done);
+        move(loc(id), X86Operand::r(RAX));
+    }
+
+    // Registros SIMD: %xmm14 y %xmm15 quedan como temporales
+    static const int kVectorRegs = 14;
+    static const int kVectorTemp = 14, kVectorScratch = 15;
+
+    bool vectorWide() const {
+        return vectorLanes == 4;
+    }
+
+    void loadScalar(int reg, uint32_t value) {
+        const IrInst &inst = fn->insts[value];
+        as.mov(X86Operand::r(reg), inst.op == IrOp::Const ? X86Operand::imm(inst.imm) : loc(value));
+    }
+
+    // dst = a op b; con SSE2 la operación es sobre dst
+    void vecBinary(X86VecOp op, int dst, int a, int b) {
+        bool wide = vectorWide();
+        if (!wide && dst != a) {
+            if (dst == b && op != X86VecOp::Sub) std::swap(a, b);
+            if (dst == b) {
+                as.vecMove(kVectorScratch, b, false);
+                b = kVectorScratch;
+            }
+            as.vecMove(dst, a, false);
+        }
+        as.vecAlu(op, dst, wide ? a : dst, b, wide);
+    }
+
+    void vecShift(X86VecOp op, int dst, int a, uint8_t bits) {
+        bool wide = vectorWide();
+        if (!wide && dst != a) as.vecMove(dst, a, false);
+        as.vecShift(op, dst, wide ? a : dst, bits, wide);
+    }
+
+    // Producto de 64 bits por carril con productos de 32 x 32:
+    // lo(a) * lo(b) + ((hi(a) * lo(b) + lo(a) * hi(b)) << 32); dst distinto de a y b
+    void vecMultiply(int dst, int a, int b) {
+        vecShift(X86VecOp::ShiftRight, kVectorTemp, a, 32);
+        vecBinary(X86VecOp::MulLow, kVectorTemp, kVectorTemp, b);
+        vecShift(X86VecOp::ShiftRight, kVectorScratch, b, 32);
+        vecBinary(X86VecOp::MulLow, kVectorScratch, kVectorScratch, a);
+        vecBinary(X86VecOp::Add, kVectorTemp, kVectorTemp, kVectorScratch);
+        vecShift(X86VecOp::ShiftLeft, kVectorTemp, kVectorTemp, 32);
+        vecBinary(X86VecOp::MulLow, dst, a, b);
+        vecBinary(X86VecOp::Add, dst, dst, kVectorTemp);
+    }
+
+    const IrVectorLoop *vectorLoopAt(uint32_t preheader) const {
+        if (!vectorLanes) return nullptr;
+        for (const IrVectorLoop &loop : fn->vectorLoops) {
+            if (loop.preheader == preheader) return &loop;
+        }
+        return nullptr;
+    }
+
+    // Vueltas vectoriales en el paso del pre-encabezado al encabezado, con los phis
+    // ya copiados: avanzan el contador, las inducciones y los acumuladores de a
+    // vectorLanes elementos mientras queden al menos tantos, y el bucle escalar
+    // hace el resto. %rcx lleva el contador y %rdx las vueltas que faltan.
+    void emitVectorLoop(const IrVectorLoop &plan) {
+        const bool wide = vectorWide();
+        const int64_t lanes = vectorLanes;
+        const IrBlock &body = fn->blocks[plan.body];
+        const uint32_t fromBody = fn->predsOf(plan.header)[0] == plan.body ? 0 : 1;
+        auto updateOf = [&](uint32_t phi) { return fn->operands[fn->insts[phi].a + fromBody]; };
+        auto inLoop = [&](uint32_t v) {
+            uint32_t b = fn->blockOf(v);
+            return b == plan.header || b == plan.body;
+        };
+
+        // Usos dentro del cuerpo: las sumas de las inducciones sólo se calculan si
+        // algo más que su phi las usa
+        std::unordered_map<uint32_t, uint32_t> lastUse, uses;
+        for (uint32_t i = body.begin; i + 1 < body.end; ++i) {
+            fn->forEachOperand(fn->insts[i], [&](uint32_t v) {
+                lastUse[v] = i;
+                uses[v]++;
+            });
+        }
+        std::vector<uint32_t> inductions = plan.inductions;
+        if (uses.count(plan.counter)) inductions.push_back(plan.counter);
+        std::unordered_map<uint32_t, uint32_t> reductionOf;     // suma -> acumulador
+        for (uint32_t phi : plan.reductions) reductionOf[updateOf(phi)] = phi;
+        auto skipped = [&](uint32_t id) {
+            const IrInst &inst = fn->insts[id];
+            if (inst.op == IrOp::Nop || inst.op == IrOp::Const || inst.op == IrOp::Store) return true;
+            return !reductionOf.count(id) && !uses.count(id);
+        };
+
+        // Registros: invariantes replicados, acumuladores e inducciones fijos;
+        // los valores del cuerpo, desde su definición hasta su último uso
+        std::unordered_map<uint32_t, int> reg, stepReg;
+        std::vector<uint32_t> invariants;
+        int pinned = 0;
+        for (uint32_t phi : plan.reductions) reg[phi] = pinned++;
+        for (uint32_t phi : inductions) {
+            reg[phi] = pinned++;
+            stepReg[phi] = pinned++;
+        }
+        for (uint32_t i = body.begin; i + 1 < body.end; ++i) {
+            const IrInst &inst = fn->insts[i];
+            if (inst.op == IrOp::Load || (inst.op != IrOp::Store && skipped(i))) continue;
+            fn->forEachOperand(inst, [&](uint32_t v) {
+                if (inst.op == IrOp::Store && v != inst.c) return;
+                if ((!inLoop(v) || fn->insts[v].op == IrOp::Const) && !reg.count(v)) {
+                    reg[v] = pinned++;
+                    invariants.push_back(v);
+                }
+            });
+        }
+        if (pinned > kVectorRegs) return;
+        std::vector<int> freeRegs;
+        for (int r = kVectorRegs - 1; r >= pinned; --r) freeRegs.push_back(r);
+        for (uint32_t i = body.begin; i + 1 < body.end; ++i) {
+            if (reductionOf.count(i)) {
+                reg[i] = reg[reductionOf[i]];
+            } else if (!skipped(i)) {
+                if (freeRegs.empty()) return;
+                reg[i] = freeRegs.back();
+                freeRegs.pop_back();
+            }
+            fn->forEachOperand(fn->insts[i], [&](uint32_t v) {
+                auto found = reg.find(v);
+                if (lastUse[v] != i || found == reg.end() || found->second < pinned) return;
+                freeRegs.push_back(found->second);
+                lastUse[v] = kNoValue;
+            });
+        }
+
+        const X86Operand rax = X86Operand::r(RAX), rcx = X86Operand::r(RCX), rdx = X86Operand::r(RDX);
+        for (uint32_t v : invariants) {
+            loadScalar(RAX, v);
+            as.vecBroadcast(reg[v], RAX, wide);
+        }
+        for (uint32_t phi : plan.reductions) as.vecAlu(X86VecOp::Xor, reg[phi], reg[phi], reg[phi], wide);
+        // Inducciones: p, p + s, p + 2s... en los carriles y lanes * s como avance
+        if (!inductions.empty()) as.alu(X86Alu::Sub, X86Operand::r(RSP), X86Operand::imm(32));
+        for (uint32_t phi : inductions) {
+            uint32_t update = updateOf(phi);
+            const IrInst &add = fn->insts[update];
+            loadScalar(RDX, add.a == phi ? add.b : add.a);
+            as.mov(rax, loc(phi));
+            for (int64_t lane = 0; lane < lanes; ++lane) {
+                as.mov(X86Operand::mem(RSP, static_cast<int32_t>(8 * lane)), rax);
+                as.alu(X86Alu::Add, rax, rdx);
+            }
+            as.vecLoad(reg[phi], X86Operand::mem(RSP, 0), wide);
+            as.alu(X86Alu::Sub, rax, loc(phi));
+            as.vecBroadcast(stepReg[phi], RAX, wide);
+        }
+        if (!inductions.empty()) as.alu(X86Alu::Add, X86Operand::r(RSP), X86Operand::imm(32));
+
+        uint32_t top = newLabel(), done = newLabel();
+        as.mov(rcx, loc(plan.counter));
+        as.alu(X86Alu::Cmp, rcx, loc(plan.bound));
+        as.jcc(X86Cond::GE, done);
+        as.mov(rdx, loc(plan.bound));
+        as.alu(X86Alu::Sub, rdx, rcx);
+        as.bind(top);
+        as.alu(X86Alu::Cmp, rdx, X86Operand::imm(lanes));
+        as.jcc(X86Cond::B, done);
+        for (uint32_t i = body.begin; i + 1 < body.end; ++i) {
+            const IrInst &inst = fn->insts[i];
+            if (inst.op == IrOp::Store) {
+                as.mov(rax, loc(inst.a));
+                as.vecStore(X86Operand::element(RAX, RCX), reg[inst.c], wide);
+                continue;
+            }
+            if (skipped(i)) continue;
+            switch (inst.op) {
+                case IrOp::Load:
+                    as.mov(rax, loc(inst.a));
+                    as.vecLoad(reg[i], X86Operand::element(RAX, RCX), wide);
+                    break;
+                case IrOp::Add:
+                    vecBinary(X86VecOp::Add, reg[i], reg[inst.a], reg[inst.b]);
+                    break;
+                case IrOp::Sub:
+                    vecBinary(X86VecOp::Sub, reg[i], reg[inst.a], reg[inst.b]);
+                    break;
+                case IrOp::Mul:
+                    vecMultiply(reg[i], reg[inst.a], reg[inst.b]);
+                    break;
+                default:    // Neg
+                    as.vecAlu(X86VecOp::Xor, kVectorTemp, kVectorTemp, kVectorTemp, wide);
+                    vecBinary(X86VecOp::Sub, reg[i], kVectorTemp, reg[inst.a]);
+                    break;
+            }
+        }
+        as.alu(X86Alu::Add, rcx, X86Operand::imm(lanes));
+        as.alu(X86Alu::Sub, rdx, X86Operand::imm(lanes));
+        for (uint32_t phi : inductions) vecBinary(X86VecOp::Add, reg[phi], reg[phi], stepReg[phi]);
+        as.jmp(top);
+
+        // Estado para el bucle escalar
+        as.bind(done);
+        move(loc(plan.counter), rcx);
+        for (uint32_t phi : plan.reductions) {
+            as.vecSum(RAX, reg[phi], kVectorScratch, wide);
+            as.alu(X86Alu::Add, loc(phi), rax);
+        }
+        for (uint32_t phi : plan.inductions) {
+            as.vecExtract(RAX, reg[phi], wide);
+            move(loc(phi), rax);
+        }
+        if (wide) as.vzeroupper();
+    }
+
+    void compileInst(uint32_t block, uint32_t id) {
+        const IrInst &inst = fn->insts[id];
+        const X86Operand rax = X86Operand::r(RAX);
+        switch (inst.op) {
+            case IrOp::Nop:
+            case IrOp::Param:
+            case IrOp::Phi:
+                break;
+            case IrOp::Const:
+                move(loc(id), X86Operand::imm(inst.imm));
+                break;
+            case IrOp::ConstStr:
+                as.loadString(RAX, static_cast<uint32_t>(inst.imm));
+                move(loc(id), rax);
+                break;
+            case IrOp::Add: emitBinary(X86Alu::Add, false, id, inst); break;
+            case IrOp::Sub: emitBinary(X86Alu::Sub, false, id, inst); break;
+            case IrOp::Mul: emitBinary(X86Alu::Add, true, id, inst); break;
+            case IrOp::Div:
+            case IrOp::Mod:
+                emitDivision(id, inst);
+                break;
+            case IrOp::Pow:
+                callHelper(X86Helper::Pow, {loc(inst.a), loc(inst.b)});
+                move(loc(id), rax);
+                break;
+            case IrOp::Neg:
+                as.mov(rax, loc(inst.a));
+                as.neg(RAX);
+                move(loc(id), rax);
+                break;
+            case IrOp::Not:
+                as.mov(rax, loc(inst.a));
+                as.alu(X86Alu::Xor, rax, X86Operand::imm(1));
+                move(loc(id), rax);
+                break;
+            case IrOp::Eq:
+            case IrOp::Ne:
+            case IrOp::Lt:
+            case IrOp::Le:
+            case IrOp::Gt:
+            case IrOp::Ge:
+                as.mov(rax, loc(inst.a));
+                as.alu(X86Alu::Cmp, rax, loc(inst.b));
+                if (fusesWithBranch(id)) {
+                    condPending = true;
+                    pendingCond = conditionOf(inst.op);
+                    break;
+                }
+                as.setcc(conditionOf(inst.op));
+                move(loc(id), rax);
+                break;
+            case IrOp::StrEq:
+            case IrOp::StrNe:
+                callHelper(X86Helper::StrEq, {loc(inst.a), loc(inst.b)});
+                if (inst.op == IrOp::StrNe) as.alu(X86Alu::Xor, rax, X86Operand::imm(1));
+                move(loc(id), rax);
+                break;
+            case IrOp::Concat:
+                callHelper(X86Helper::Concat, {loc(inst.a), loc(inst.b)});
+                move(loc(id), rax);
+                break;
+            case IrOp::ToStr:
+                switch (static_cast<IrType>(inst.imm)) {
+                    case IrType::Str: move(loc(id), loc(inst.a)); return;
+                    case IrType::Bool: callHelper(X86Helper::BoolToStr, {loc(inst.a)}); break;
+                    case IrType::Char: callHelper(X86Helper::CharToStr, {loc(inst.a)}); break;
+                    default: callHelper(X86Helper::IntToStr, {loc(inst.a)}); break;
+                }
+                move(loc(id), rax);
+                break;
+            case IrOp::LoadGlobal:
+                as.loadGlobal(RAX, static_cast<uint32_t>(inst.imm));
+                move(loc(id), rax);
+                break;
+            case IrOp::StoreGlobal:
+                as.mov(rax, loc(inst.a));
+                as.storeGlobal(static_cast<uint32_t>(inst.imm), RAX);
+                break;
+            case IrOp::NewArray:
+                callHelper(X86Helper::NewArray, {loc(inst.a), X86Operand::imm(inst.imm == static_cast<int64_t>(IrType::Str))});
+                move(loc(id), rax);
+                break;
+            case IrOp::ArrayLen:
+                as.mov(rax, loc(inst.a));
+                as.mov(rax, X86Operand::mem(RAX, 0));
+                move(loc(id), rax);
+                break;
+            case IrOp::BoundsCheck:
+                as.mov(rax, loc(inst.a));
+                as.alu(X86Alu::Cmp, rax, loc(inst.b));
+                as.jcc(X86Cond::AE, boundsLabel);
+                break;
+            case IrOp::Load:
+                as.mov(rax, loc(inst.a));
+                as.mov(X86Operand::r(RCX), loc(inst.b));
+                as.mov(rax, X86Operand::element(RAX, RCX));
+                move(loc(id), rax);
+                break;
+            case IrOp::Store:
+                as.mov(rax, loc(inst.a));
+                as.mov(X86Operand::r(RCX), loc(inst.b));
+                as.mov(X86Operand::r(RDX), loc(inst.c));
+                as.mov(X86Operand::element(RAX, RCX), X86Operand::r(RDX));
+                break;
+            case IrOp::Call: {
+                std::vector<X86Operand> args;
+                for (uint32_t i = 0; i < inst.b; ++i) {
+                    uint32_t arg = fn->operands[inst.a + i];
+                    args.push_back(arg == kNoValue ? X86Operand::imm(0) : loc(arg));
+                }
+                emitCall(args, [&] { as.callFunction(static_cast<uint32_t>(inst.imm)); });
+                if (inst.type != IrType::Void) move(loc(id), rax);
+                break;
+            }
+            case IrOp::Print:
+                switch (static_cast<IrType>(inst.imm)) {
+                    case IrType::Str: callHelper(X86Helper::PrintStr, {loc(inst.a)}); break;
+                    case IrType::Bool: callHelper(X86Helper::PrintBool, {loc(inst.a)}); break;
+                    case IrType::Char: callHelper(X86Helper::PrintChar, {loc(inst.a)}); break;
+                    default: callHelper(X86Helper::PrintInt, {loc(inst.a)}); break;
+                }
+                break;
+            case IrOp::PrintLn:
+                callHelper(X86Helper::PrintLn, {});
+                break;
+            case IrOp::Jump:
+                emitPhiCopies(block, inst.a);
+                if (const IrVectorLoop *loop = vectorLoopAt(block)) emitVectorLoop(*loop);
+                if (inst.a != block + 1) as.jmp(inst.a);
+                break;
+            case IrOp::Branch: {
+                X86Cond cond = X86Cond::NE;
+                if (condPending) {
+                    cond = pendingCond;
+                    condPending = false;
+                } else {
+                    as.alu(X86Alu::Cmp, loc(inst.a), X86Operand::imm(0));
+                }
+                bool trueCopies = hasPhis(inst.b);
+                bool falseCopies = hasPhis(inst.c);
+                if (!trueCopies && !falseCopies && inst.c == block + 1) {
+                    as.jcc(cond, inst.b);
+                    break;
+                }
+                uint32_t falseLabel = falseCopies ? newLabel() : inst.c;
+                as.jcc(invertCondition(cond), falseLabel);
+                emitPhiCopies(block, inst.b);
+                if (inst.b != block + 1 || falseCopies) as.jmp(inst.b);
+                if (falseCopies) {
+                    as.bind(falseLabel);
+                    emitPhiCopies(block, inst.c);
+                    if (inst.c != block + 1) as.jmp(inst.c);
+                }
+                break;
+            }
+            case IrOp::Return:
+                if (inst.a != kNoValue) as.mov(rax, loc(inst.a));
+                as.jmp(retLabel);
+                break;
+        }
+    }
+
+    // Guardar registros preservados y reservar las ranuras de desborde
+    void emitPrologue() {
+        as.push(X86Operand::r(RBP));
+        as.mov(X86Operand::r(RBP), X86Operand::r(RSP));
+        for (int reg : savedRegs) as.push(X86Operand::r(reg));
+        if (frameBytes) as.alu(X86Alu::Sub, X86Operand::r(RSP), X86Operand::imm(static_cast<int64_t>(frameBytes)));
+        as.stackCheck(overflowLabel);
+    }
+
+public:
+    explicit X86FunctionCompiler(Assembler &as) : as(as) {}
+
+    // Carriles de 64 bits para los bucles de IrFunction::vectorLoops (0, 2 o 4)
+    void setVectorLanes(uint32_t lanes) {
+        vectorLanes = lanes;
+    }
+
+    // Instrucciones que terminan en una llamada (al runtime o a otra función)
+    static bool isCall(const IrInst &inst) {
+        switch (inst.op) {
+            case IrOp::Pow:
+            case IrOp::StrEq:
+            case IrOp::StrNe:
+            case IrOp::Concat:
+            case IrOp::NewArray:
+            case IrOp::Call:
+            case IrOp::Print:
+            case IrOp::PrintLn:
+                return true;
+            case IrOp::ToStr:
+                return inst.imm != static_cast<int64_t>(IrType::Str);
+            default:
+                return false;
+        }
+    }
+
+    static RegisterBank bank() {
+        RegisterBank b;
+        b.callerSaved = 6;
+        b.calleeSaved = 5;
+        return b;
+    }
+
+    // Compila la función. Los puntos de entrada a mitad de ejecución (osrBlocks)
+    // reciben en %rdi un arreglo con los valores vivos, indexado por osrSlots;
+    // sus etiquetas se devuelven en osrLabels.
+    void compile(const IrFunction &function, uint32_t index,
+                 const std::vector<uint32_t> &osrBlocks = {}, const std::vector<uint32_t> *osrSlots = nullptr,
+                 std::vector<uint32_t> *osrLabels = nullptr) {
+        fn = &function;
+        condPending = false;
+        regs = allocateRegisters(function, bank(), isCall);
+        as.beginFunction(index);
+
+        useCount.assign(function.insts.size(), 0);
+        for (const IrInst &inst : function.insts) {
+            function.forEachOperand(inst, [&](uint32_t v) { if (v != kNoValue) useCount[v]++; });
+        }
+        const RegisterBank b = bank();
+        std::vector<uint8_t> used(b.callerSaved + b.calleeSaved, 0);
+        for (uint32_t r : regs.reg) if (r != kNoValue) used[r] = 1;
+        savedRegs.clear();
+        for (uint32_t r = b.callerSaved; r < used.size(); ++r) {
+            if (used[r]) savedRegs.push_back(allocatable(r));
+        }
+        frameBytes = 8 * regs.numSpillSlots;
+        if ((frameBytes + 8 * savedRegs.size()) % 16) frameBytes += 8;
+
+        // Etiquetas: una por bloque y luego las auxiliares
+        nextLabel = static_cast<uint32_t>(function.blocks.size());
+        retLabel = newLabel();
+        boundsLabel = newLabel();
+        divZeroLabel = newLabel();
+        overflowLabel = newLabel();
+
+        emitPrologue();
+
+        // Parámetros desde los registros de argumento o la pila del llamador
+        std::vector<std::pair<X86Operand, X86Operand>> moves;
+        std::vector<std::pair<X86Operand, X86Operand>> stackMoves;
+        for (uint32_t i = 0; i < function.insts.size(); ++i) {
+            const IrInst &inst = function.insts[i];
+            if (inst.op != IrOp::Param || (regs.reg[i] == kNoValue && regs.spillSlot[i] == kNoValue)) continue;
+            size_t p = static_cast<size_t>(inst.imm);
+            if (p < 6) moves.push_back({loc(i), X86Operand::r(argumentReg(p))});
+            else stackMoves.push_back({loc(i), X86Operand::mem(RBP, static_cast<int32_t>(16 + 8 * (p - 6)))});
+        }
+        parallelMove(moves);
+        for (const auto &m : stackMoves) move(m.first, m.second);
+
+        for (uint32_t block = 0; block < function.blocks.size(); ++block) {
+            as.bind(block);
+            for (uint32_t i = function.blocks[block].begin; i < function.blocks[block].end; ++i) compileInst(block, i);
+        }
+
+        as.bind(retLabel);
+        if (savedRegs.empty()) {
+            as.mov(X86Operand::r(RSP), X86Operand::r(RBP));
+        } else {
+            as.lea(RSP, X86Operand::mem(RBP, -8 * static_cast<int32_t>(savedRegs.size())));
+            for (size_t i = savedRegs.size(); i-- > 0;) as.pop(savedRegs[i]);
+        }
+        as.pop(RBP);
+        as.ret();
+
+        // Salidas de error (no regresan)
+        as.bind(boundsLabel);
+        as.mov(X86Operand::r(RDI), X86Operand::r(RAX));
+        as.callHelper(X86Helper::BoundsError);
+        as.bind(divZeroLabel);
+        as.callHelper(X86Helper::DivZero);
+        if (Assembler::kChecksStack) {
+            as.bind(overflowLabel);
+            as.callHelper(X86Helper::StackOverflow);
+        }
+
+        // Entradas a mitad de ejecución: mismo marco, valores vivos desde el arreglo
+        if (osrLabels) osrLabels->clear();
+        if (osrBlocks.empty()) return;
+        const std::vector<LiveInterval> intervals = computeLiveIntervals(function);
+        for (uint32_t block : osrBlocks) {
+            uint32_t entry = newLabel();
+            if (osrLabels) osrLabels->push_back(entry);
+            as.bind(entry);
+            emitPrologue();
+            as.mov(X86Operand::r(RDX), X86Operand::r(RDI));
+            const uint32_t begin = function.blocks[block].begin;
+            for (const LiveInterval &interval : intervals) {
+                bool phiHere = interval.start == begin && function.insts[interval.value].op == IrOp::Phi &&
+                               interval.value >= begin && interval.value < function.blocks[block].end;
+                bool liveIn = interval.start < begin && interval.end >= begin;
+                uint32_t slot = (*osrSlots)[interval.value];
+                if ((!phiHere && !liveIn) || slot == kNoValue) continue;
+                move(loc(interval.value), X86Operand::mem(RDX, 8 * static_cast<int32_t>(slot)));
+            }
+            as.jmp(block);
+        }
+    }
+};
+
+// Módulo completo en texto: funciones, cadenas en .rodata y globales en .bss
+class X86Generator {
+    const IrModule &module;
+    std::ostream &out;
+    uint32_t vectorLanes;
+
+    static std::string escapeString(const std::string &text) {
+        std::string result;
+        for (unsigned char c : text) {
+            if (c == '"' || c == '\\') {
+                result += '\\';
+                result += static_cast<char>(c);
+            } else if (c >= 32 && c < 127) {
+                result += static_cast<char>(c);
+            } else {
+                const char digits[] = "01234567";
+                result += '\\';
+                result += digits[(c >> 6) & 7];
+                result += digits[(c >> 3) & 7];
+                result += digits[c & 7];
+            }
+        }
+        return result;
+    }
+
+public:
+    // Por omisión SSE2, que tiene todo procesador x86-64; AVX2 con vectorLanes = 4
+    X86Generator(const IrModule &module, std::ostream &out, uint32_t vectorLanes = 2)
+        : module(module), out(out), vectorLanes(vectorLanes) {}
+
+    void run() {
+        X86TextAssembler as(out);
+        X86FunctionCompiler<X86TextAssembler> compiler(as);
+        compiler.setVectorLanes(vectorLanes);
+        out << "# Generado por el compilador de B-minor\n";
+        out << "\t.text\n";
+        out << "\t.globl bm_init_globals\n";
+        out << "\t.globl bm_main\n";
+        for (uint32_t i = 0; i < module.functions.size(); ++i) {
+            out << "\n\t.p2align 4\n";
+            out << "\t.type bm_fn_" << i << ", @function\n";
+            out << "# " << module.functions[i].name << "\n";
+            if (static_cast<int>(i) == module.initFunction) out << "bm_init_globals:\n";
+            if (static_cast<int>(i) == module.mainFunction) out << "bm_main:\n";
+            out << "bm_fn_" << i << ":\n";
+            compiler.compile(module.functions[i], i);
+        }
+        if (module.mainFunction < 0) {
+            out << "bm_main:\n\tret\n";
+        }
+
+        out << "\n\t.section .rodata\n";
+        for (size_t i = 0; i < module.strings.size(); ++i) {
+            out << "\t.p2align 3\n";
+            out << ".Lstr" << i << ":\n";
+            out << "\t.quad " << module.strings[i].size() << "\n";
+            out << "\t.ascii \"" << escapeString(module.strings[i]) << "\"\n";
+            out << "\t.byte 0\n";
+        }
+
+        out << "\n\t.bss\n\t.p2align 3\n";
+        for (size_t i = 0; i < module.globals.size(); ++i) {
+            out << "# " << module.globals[i].name << "\n";
+            out << "bm_g" << i << ":\n\t.zero 8\n";
+        }
+        out << "\n\t.section .note.GNU-stack,\"\",@progbits\n";
+    }
+};
+
+#endif // X86_H_